@@ -7,6 +7,11 @@
 #include <duktape/mod/mod.sys.hh>
 #include <duktape/mod/mod.sys.exec.hh>
 #include <duktape/mod/mod.sys.hash.hh>
+#include <duktape/mod/mod.sys.hash.tree.hh>
+#include <duktape/mod/mod.sys.encode.hh>
+#include <duktape/mod/mod.eventloop.hh>
+#include <duktape/mod/mod.promise.hh>
+#include <duktape/mod/mod.coroutine.hh>
 #include <exception>
 #include <stdexcept>
 #include <iostream>
@@ -100,6 +105,11 @@ int main(int argc, const char** argv)
     duktape::mod::system::define_in(js);
     duktape::mod::system::exec::define_in(js);
     duktape::mod::system::hash::define_in(js);
+    duktape::mod::system::hash::tree::define_in(js);
+    duktape::mod::system::encode::define_in(js);
+    duktape::mod::eventloop::define_in(js);
+    duktape::mod::promise::define_in(js);
+    duktape::mod::coroutine::define_in(js);
     js.define("sys.args", args);
     js.define("sys.script", script_path);
     vector<string>().swap(args);
@@ -126,6 +136,7 @@ int main(int argc, const char** argv)
     }
     js.eval<void>(std::move(script_code), script_path);
     if(!eval_code.empty()) js.eval<void>(std::move(eval_code), "(inline eval code)");
+    duktape::mod::eventloop::run_loop(js);
     return 0;
   } catch(duktape::exit_exception& e) {
     return e.exit_code();
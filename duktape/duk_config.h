@@ -2986,6 +2986,16 @@ typedef struct duk_hthread duk_context;
 
 /* __OVERRIDE_DEFINES__ */
 
+/*
+ *  duktape-cc: Execution timeout check (see basic_engine::timeout() and
+ *  basic_engine::instruction_budget()). The heap user data passed to
+ *  duk_create_heap() must be NULL or point to a structure whose first
+ *  member is the check function `int (*)(void *udata)`.
+ */
+#define DUK_USE_INTERRUPT_COUNTER
+#undef DUK_USE_EXEC_TIMEOUT_CHECK
+#define DUK_USE_EXEC_TIMEOUT_CHECK(udata) (((udata) != NULL) && ((*((int (**)(void *)) (udata)))(udata)))
+
 /*
  *  Conditional includes
  */
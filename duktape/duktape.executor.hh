@@ -0,0 +1,404 @@
+/**
+ * @file duktape.executor.hh
+ * @package de.atwillys.cc.duktape
+ * @license MIT
+ * @authors Stefan Wilhelm (stfwi, <cerbero s@atwillys.de>)
+ * @platform linux, bsd, windows
+ * @standard >= c++11
+ * @requires duk_config.h duktape.h duktape.c >= v2.1
+ * @requires Duktape CFLAGS -DDUK_USE_CPP_EXCEPTIONS
+ * @cxxflags -std=c++11 -W -Wall -Wextra -pedantic -fstrict-aliasing
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Duktape ECMA engine C++ wrapper, multi-engine worker thread pool.
+ *
+ * A Duktape heap is single threaded, and `basic_engine` serialises all
+ * accesses with its mutex. To run scripts on several cores, the executor
+ * owns N worker threads, each with its own initialised engine, and
+ * distributes submitted jobs to them.
+ *
+ * -----------------------------------------------------------------------------
+ * License: http://opensource.org/licenses/MIT
+ * Copyright (c) 2014-2017, the authors (see the @authors tag in this file).
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions: The above copyright notice and
+ * this permission notice shall be included in all copies or substantial portions
+ * of the Software. THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef DUKTAPE_EXECUTOR_HH
+#define DUKTAPE_EXECUTOR_HH
+
+// <editor-fold desc="preprocessor" defaultstate="collapsed">
+#include "duktape.hh"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <chrono>
+// </editor-fold>
+
+// <editor-fold desc="forwards" defaultstate="collapsed">
+namespace duktape {
+  namespace detail {
+    template <typename EngineType=::duktape::engine> class basic_executor;
+  }
+
+  using executor = detail::basic_executor<>;
+}
+// </editor-fold>
+
+// <editor-fold desc="executor" defaultstate="collapsed">
+namespace duktape { namespace detail {
+
+  /**
+   * Worker thread pool with one engine per worker thread.
+   *
+   * All engines are prepared with the same initialisation function passed
+   * to the constructor (defining modules, including script files etc), so
+   * that a job can run on any worker. Jobs are assigned round-robin to the
+   * queues of the workers, idle workers steal jobs from the back of other
+   * queues. Results are returned as `std::future`, exceptions thrown in a
+   * job (e.g. `duktape::script_error`) are rethrown by `future::get()`.
+   *
+   * Jobs can have a timeout. A job whose deadline has expired before a
+   * worker picks it up is not run, its future throws `duktape::timeout_error`.
+   * While the job is running, its deadline is set as absolute engine
+   * deadline (`engine::deadline()`), so that all `eval()`/`call()` of the
+   * job together cannot exceed it. Scripts running past the deadline are
+   * aborted with a `duktape::timeout_error`.
+   *
+   * On destruction all jobs still queued are run before the workers are
+   * joined.
+   */
+  template <typename EngineType>
+  class basic_executor
+  {
+  public:
+
+    // <editor-fold desc="types" defaultstate="collapsed">
+    using engine_type = EngineType;
+    using init_function_type = std::function<void(engine_type&)>;
+    using clock_type = std::chrono::steady_clock;
+    using duration_type = std::chrono::milliseconds;
+
+    /**
+     * Worker statistics, see `stats()`.
+     */
+    struct worker_stats
+    {
+      size_t queued;        // Jobs currently waiting in the queue of this worker.
+      uint64_t jobs;        // Jobs started by this worker.
+      uint64_t stolen;      // Thereof taken from the queues of other workers.
+      uint64_t timeouts;    // Jobs not run because their deadline had expired.
+      double busy;          // Seconds spent running jobs.
+      double utilisation;   // `busy` relative to the executor lifetime, 0 to 1.
+    };
+    // </editor-fold>
+
+  private:
+
+    // <editor-fold desc="private types" defaultstate="collapsed">
+    struct job_type
+    {
+      std::function<void(engine_type&)> run;
+      std::function<void(std::exception_ptr)> fail;
+      typename clock_type::time_point deadline;
+    };
+
+    struct worker_type
+    {
+      std::unique_ptr<engine_type> engine;
+      std::deque<job_type> queue;
+      std::mutex mutex;
+      std::thread thread;
+      std::atomic<uint64_t> jobs, stolen, timeouts, busy_ns;
+
+      explicit worker_type() : engine(new engine_type()), queue(), mutex(), thread(),
+        jobs(0), stolen(0), timeouts(0), busy_ns(0)
+      {}
+    };
+    // </editor-fold>
+
+  public:
+
+    // <editor-fold desc="c'tors/d'tor" defaultstate="collapsed">
+    /**
+     * c' tor. Creates `num_workers` engines, initialises them with `init`,
+     * and starts the worker threads. With `num_workers==0` the number of
+     * hardware threads is used. Exceptions thrown in `init` are passed to
+     * the caller.
+     *
+     * @param size_t num_workers
+     * @param init_function_type init
+     */
+    explicit basic_executor(size_t num_workers=0, init_function_type init=init_function_type())
+      : workers_(), wake_mutex_(), wake_(), queued_(0), next_(0), stop_(false), start_(clock_type::now())
+    {
+      if(!num_workers) num_workers = std::max(1u, std::thread::hardware_concurrency());
+      workers_.reserve(num_workers);
+      for(size_t i=0; i<num_workers; ++i) {
+        workers_.emplace_back(new worker_type());
+        if(init) init(*workers_.back()->engine);
+      }
+      try {
+        for(size_t i=0; i<num_workers; ++i) {
+          workers_[i]->thread = std::thread(&basic_executor::work, this, i);
+        }
+      } catch(...) {
+        shutdown();
+        throw;
+      }
+    }
+
+    /**
+     * d' tor. Runs the remaining queued jobs and joins the worker threads.
+     */
+    ~basic_executor()
+    { shutdown(); }
+
+    basic_executor(const basic_executor&) = delete;
+    basic_executor(basic_executor&&) = delete;
+    basic_executor& operator=(const basic_executor&) = delete;
+    // </editor-fold>
+
+  public:
+
+    // <editor-fold desc="getters" defaultstate="collapsed">
+    /**
+     * Returns the number of workers.
+     * @return size_t
+     */
+    size_t size() const noexcept
+    { return workers_.size(); }
+
+    /**
+     * Returns the number of jobs waiting to be started.
+     * @return size_t
+     */
+    size_t queue_depth() const noexcept
+    { return queued_.load(); }
+
+    /**
+     * Returns a snapshot of the statistics of all workers.
+     * @return std::vector<worker_stats>
+     */
+    std::vector<worker_stats> stats()
+    {
+      std::vector<worker_stats> v;
+      const double lifetime = std::chrono::duration<double>(clock_type::now() - start_).count();
+      for(auto& wp: workers_) {
+        worker_type& w = *wp;
+        worker_stats s;
+        { std::lock_guard<std::mutex> lck(w.mutex); s.queued = w.queue.size(); }
+        s.jobs = w.jobs.load();
+        s.stolen = w.stolen.load();
+        s.timeouts = w.timeouts.load();
+        s.busy = double(w.busy_ns.load()) * 1e-9;
+        s.utilisation = (lifetime > 0) ? std::min(1.0, s.busy / lifetime) : 0.0;
+        v.push_back(s);
+      }
+      return v;
+    }
+    // </editor-fold>
+
+    // <editor-fold desc="job submission" defaultstate="collapsed">
+    /**
+     * Queues a call of the (global, canonical named) function `funct` with
+     * the given arguments, returns the future of the converted return value.
+     * Equivalent to `engine::call<ReturnType>(funct, args...)`.
+     *
+     * @param std::string funct
+     * @param Args... args
+     * @return std::future<ReturnType>
+     */
+    template <typename ReturnType=void, typename ...Args>
+    std::future<ReturnType> submit(std::string funct, Args ...args)
+    { return submit_for<ReturnType, Args...>(duration_type::zero(), std::move(funct), args...); }
+
+    /**
+     * Like `submit()`, with a timeout (zero = no timeout) relative to the
+     * time of submission.
+     *
+     * @param duration_type timeout
+     * @param std::string funct
+     * @param Args... args
+     * @return std::future<ReturnType>
+     */
+    template <typename ReturnType=void, typename ...Args>
+    std::future<ReturnType> submit_for(duration_type timeout, std::string funct, Args ...args)
+    { return post([=](engine_type& js) { return js.template call<ReturnType>(funct, args...); }, timeout); }
+
+    /**
+     * Queues the evaluation of `code`, returns the future of the converted
+     * result. Equivalent to `engine::eval<ReturnType>(code, file)`.
+     *
+     * @param std::string code
+     * @param std::string file
+     * @param duration_type timeout
+     * @return std::future<ReturnType>
+     */
+    template <typename ReturnType=void>
+    std::future<ReturnType> eval(std::string code, std::string file="(eval)", duration_type timeout=duration_type::zero())
+    { return post([=](engine_type& js) { return js.template eval<ReturnType>(std::string(code), file); }, timeout); }
+
+    /**
+     * Queues a native function `R fn(engine_type&)`, which is invoked with
+     * the engine of the worker that runs the job.
+     *
+     * @param Fn fn
+     * @param duration_type timeout
+     * @return std::future<R>
+     */
+    template <typename Fn, typename R=typename std::result_of<Fn(engine_type&)>::type>
+    std::future<R> post(Fn fn, duration_type timeout=duration_type::zero())
+    {
+      auto result = std::make_shared<std::promise<R>>();
+      std::future<R> future = result->get_future();
+      job_type job;
+      job.run = [result, fn](engine_type& js) mutable {
+        try {
+          fulfil(*result, fn, js);
+        } catch(...) {
+          result->set_exception(std::current_exception());
+        }
+      };
+      job.fail = [result](std::exception_ptr e) { result->set_exception(e); };
+      job.deadline = (timeout > duration_type::zero()) ? (clock_type::now() + timeout) : clock_type::time_point::max();
+      enqueue(std::move(job));
+      return future;
+    }
+    // </editor-fold>
+
+  private:
+
+    // <editor-fold desc="private auxiliary methods/functions" defaultstate="collapsed">
+    template <typename R, typename Fn>
+    static void fulfil(std::promise<R>& result, Fn& fn, engine_type& js)
+    { result.set_value(fn(js)); }
+
+    template <typename Fn>
+    static void fulfil(std::promise<void>& result, Fn& fn, engine_type& js)
+    { fn(js); result.set_value(); }
+
+    /**
+     * Appends a job to the queue of the next worker (round-robin) and
+     * wakes up one idle worker.
+     */
+    void enqueue(job_type&& job)
+    {
+      worker_type& w = *workers_[next_++ % workers_.size()];
+      {
+        std::lock_guard<std::mutex> lck(w.mutex);
+        w.queue.push_back(std::move(job));
+        ++queued_;
+      }
+      { std::lock_guard<std::mutex> lck(wake_mutex_); }
+      wake_.notify_one();
+    }
+
+    /**
+     * Fetches the next job, first from the front of the own queue, then
+     * from the back of the other queues.
+     */
+    bool take(size_t index, job_type& job)
+    {
+      const size_t n = workers_.size();
+      for(size_t k=0; k<n; ++k) {
+        worker_type& w = *workers_[(index+k) % n];
+        std::lock_guard<std::mutex> lck(w.mutex);
+        if(w.queue.empty()) continue;
+        if(k == 0) {
+          job = std::move(w.queue.front());
+          w.queue.pop_front();
+        } else {
+          job = std::move(w.queue.back());
+          w.queue.pop_back();
+          ++workers_[index]->stolen;
+        }
+        --queued_;
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * Worker thread main loop.
+     */
+    void work(size_t index)
+    {
+      worker_type& w = *workers_[index];
+      for(;;) {
+        job_type job;
+        if(!take(index, job)) {
+          std::unique_lock<std::mutex> lck(wake_mutex_);
+          if(stop_ && !queued_) return;
+          wake_.wait(lck, [this]{ return stop_ || (queued_ > 0); });
+          continue;
+        }
+        const auto t0 = clock_type::now();
+        if(t0 > job.deadline) {
+          ++w.timeouts;
+          job.fail(std::make_exception_ptr(timeout_error("Job deadline expired before execution started.")));
+          continue;
+        }
+        ++w.jobs;
+        if(job.deadline == clock_type::time_point::max()) {
+          job.run(*w.engine);
+        } else {
+          const auto default_deadline = w.engine->deadline();
+          w.engine->deadline(std::min(default_deadline, job.deadline));
+          job.run(*w.engine);
+          w.engine->deadline(default_deadline);
+        }
+        w.busy_ns += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - t0).count());
+      }
+    }
+
+    /**
+     * Signals the workers to exit after the queues are empty and joins them.
+     */
+    void shutdown()
+    {
+      { std::lock_guard<std::mutex> lck(wake_mutex_); stop_ = true; }
+      wake_.notify_all();
+      for(auto& w: workers_) {
+        if(w->thread.joinable()) w->thread.join();
+      }
+    }
+    // </editor-fold>
+
+  private:
+
+    // <editor-fold desc="instance variables" defaultstate="collapsed">
+    std::vector<std::unique_ptr<worker_type>> workers_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_;
+    std::atomic<size_t> next_;
+    bool stop_;
+    const typename clock_type::time_point start_;
+    // </editor-fold>
+  };
+}}
+// </editor-fold>
+
+#endif
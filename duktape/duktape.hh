@@ -59,6 +59,13 @@
 #include <functional>
 #include <type_traits>
 #include <mutex>
+#include <chrono>
+#include <tuple>
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
 
 #ifdef WITH_DUKTAPE_HH_ASSERT
 #include <cassert>
@@ -82,11 +89,21 @@ namespace duktape {
     template <typename R=void> class basic_stack_guard;
     template <typename MutexType=std::recursive_timed_mutex, bool StrictInclude=bool(DEFAULT_STRICT_INCLUDE)> class basic_engine;
     template <typename T> struct conv;
+    template <typename T> class typed_view;
+    template <typename T> struct typed_array;
+    class string_view;
+    class buffer_view;
+    template <typename R=void> class basic_value_blob;
   }
 
   using api = detail::basic_api<>;
   using engine = detail::basic_engine<>;
   using stack_guard = detail::basic_stack_guard<>;
+  template <typename T> using typed_view = detail::typed_view<T>;
+  template <typename T> using typed_array = detail::typed_array<T>;
+  using string_view = detail::string_view;
+  using buffer_view = detail::buffer_view;
+  using value_blob = detail::basic_value_blob<>;
 }
 // </editor-fold>
 
@@ -118,6 +135,13 @@ namespace duktape {
         std::string callstack_;
     };
 
+    template <typename=void>
+    class basic_timeout_error : public std::runtime_error
+    {
+      public:
+        explicit basic_timeout_error(const std::string& msg) : std::runtime_error(msg)  { ; }
+    };
+
     template <typename=void>
     class basic_exit_exception
     {
@@ -141,6 +165,11 @@ namespace duktape {
    */
   using script_error = detail::basic_script_error<>;
 
+  /**
+   * Thrown when a job or script execution exceeded its deadline.
+   */
+  using timeout_error = detail::basic_timeout_error<>;
+
   /**
    * Thown to indicate that the engine shall exit.
    * Not derived from std::exception and only interpreted from wrapper functions
@@ -224,6 +253,43 @@ struct basic_defprop_flags
 
 using defprop_flags = basic_defprop_flags<unsigned>;
 
+/**
+ * Maps arithmetic c++ types to the matching ECMA TypedArray (and the
+ * `DUK_BUFOBJ_*` flag to create one), used for bulk conversions. There
+ * is no typed array for bool, 64 bit integers and long double, for these
+ * `supported` is false.
+ */
+template <typename T, bool Integral=std::is_integral<T>::value, bool Signed=std::is_signed<T>::value, size_t Size=sizeof(T)>
+struct typed_array_traits
+{
+  static constexpr bool supported = false;
+  static constexpr unsigned flags = 0;
+  static constexpr const char* ecma_name() noexcept { return ""; }
+};
+
+#define decl_typed_array_traits(INTEGRAL, SIGNED, SIZE, FLAGS, NAME) \
+template <typename T> struct typed_array_traits<T, INTEGRAL, SIGNED, SIZE> { \
+  static constexpr bool supported = true; \
+  static constexpr unsigned flags = FLAGS; \
+  static constexpr const char* ecma_name() noexcept { return NAME; } \
+}
+decl_typed_array_traits(true, true, 1, DUK_BUFOBJ_INT8ARRAY, "Int8Array");
+decl_typed_array_traits(true, false, 1, DUK_BUFOBJ_UINT8ARRAY, "Uint8Array");
+decl_typed_array_traits(true, true, 2, DUK_BUFOBJ_INT16ARRAY, "Int16Array");
+decl_typed_array_traits(true, false, 2, DUK_BUFOBJ_UINT16ARRAY, "Uint16Array");
+decl_typed_array_traits(true, true, 4, DUK_BUFOBJ_INT32ARRAY, "Int32Array");
+decl_typed_array_traits(true, false, 4, DUK_BUFOBJ_UINT32ARRAY, "Uint32Array");
+decl_typed_array_traits(false, true, 4, DUK_BUFOBJ_FLOAT32ARRAY, "Float32Array");
+decl_typed_array_traits(false, true, 8, DUK_BUFOBJ_FLOAT64ARRAY, "Float64Array");
+#undef decl_typed_array_traits
+
+template <> struct typed_array_traits<bool, true, false, 1>
+{
+  static constexpr bool supported = false;
+  static constexpr unsigned flags = 0;
+  static constexpr const char* ecma_name() noexcept { return ""; }
+};
+
 }}
 // </editor-fold>
 
@@ -612,6 +678,35 @@ namespace duktape { namespace detail {
     ContainerType buffer(index_t index) const
     { return get_buffer<ContainerType>(index); }
 
+    /**
+     * Borrowed (not copied) view of the bytes of a string, plain buffer,
+     * or buffer object at the given index. Returns false and sets
+     * `out_data=nullptr, out_size=0` for all other types. Empty strings
+     * and buffers return true with `out_size==0` (`out_data` may be
+     * nullptr). The data are only valid as long as the value is on
+     * the stack (or otherwise reachable) and not resized.
+     *
+     * @param index_t index
+     * @param const void*& out_data
+     * @param size_t& out_size
+     * @return bool
+     */
+    bool get_data_view(index_t index, const void*& out_data, size_t& out_size) const
+    {
+      duk_size_t size = 0;
+      out_data = nullptr;
+      out_size = 0;
+      if(duk_is_string(ctx_, index)) {
+        out_data = duk_get_lstring(ctx_, index, &size);
+      } else if(duk_is_buffer_data(ctx_, index)) {
+        out_data = duk_get_buffer_data(ctx_, index, &size);
+      } else {
+        return false;
+      }
+      out_size = size_t(size);
+      return true;
+    }
+
     ::duk_c_function get_c_function(index_t index) const
     { return duk_get_c_function(ctx_, index); }
 
@@ -636,8 +731,11 @@ namespace duktape { namespace detail {
     void* get_pointer(index_t index) const
     { return duk_get_pointer(ctx_, index); }
 
+    const char* get_lstring(index_t index, size_t& out_length) const
+    { return duk_get_lstring(ctx_, index, &out_length); }
+
     std::string get_string(index_t index)  const
-    { size_t l; const char* s = duk_get_lstring(ctx_, index, &l); return (s && (l>0))?s:""; }
+    { size_t l; const char* s = duk_get_lstring(ctx_, index, &l); return (s && (l>0)) ? std::string(s, l) : std::string(); }
 
     unsigned get_uint(index_t index) const
     { return duk_get_uint(ctx_, index); }
@@ -871,7 +969,7 @@ namespace duktape { namespace detail {
     { return duk_require_int(ctx_, index); }
 
     std::string require_string(index_t index) const
-    { size_t l; const char* s = duk_require_lstring(ctx_, index, &l); return (s && (l>0))?s:""; }
+    { size_t l; const char* s = duk_require_lstring(ctx_, index, &l); return (s && (l>0)) ? std::string(s, l) : std::string(); }
 
     index_t require_normalize_index(index_t index) const
     { return duk_require_normalize_index(ctx_, index); }
@@ -961,7 +1059,7 @@ namespace duktape { namespace detail {
     { duk_to_undefined(ctx_, index); }
 
     std::string to_string(index_t index) const
-    { size_t l; const char* s = duk_to_lstring(ctx_, index, &l); return (s && (l>0))?s:""; }
+    { size_t l; const char* s = duk_to_lstring(ctx_, index, &l); return (s && (l>0)) ? std::string(s, l) : std::string(); }
 
     std::string safe_to_string(index_t index) const
     { size_t l; const char *s = duk_safe_to_lstring(ctx_, index, &l); return std::string(s, s+l); }
@@ -1421,6 +1519,128 @@ namespace duktape { namespace detail {
       return r;
     }
 
+    /**
+     * Returns the internal class number of the object at the given index
+     * (`DUK_HOBJECT_CLASS_*` in duktape.c, e.g. 6 for Date, 19 to 29 for
+     * buffer objects), or -1 if the value is no object. Read via
+     * `duk_inspect_value()`, so that it cannot be spoofed by replacing
+     * global constructors or prototypes.
+     *
+     * @param index_t index
+     * @return int
+     */
+    int get_internal_class(index_t index)
+    {
+      if(!is_object(index)) return -1;
+      require_stack(2);
+      duk_inspect_value(ctx_, index);
+      duk_get_prop_string(ctx_, -1, "class");
+      const int class_number = duk_get_int_default(ctx_, -1, -1);
+      duk_pop_2(ctx_);
+      return class_number;
+    }
+
+    /**
+     * Returns the `DUK_BUFOBJ_*` type of the buffer object at the given
+     * index, or -1 if the value is no buffer. Plain buffers and Node.js
+     * Buffers are `DUK_BUFOBJ_UINT8ARRAY`. The type is the internal class
+     * of the object (see `get_internal_class()`).
+     *
+     * @param index_t index
+     * @return int
+     */
+    int get_buffer_object_type(index_t index)
+    {
+      if(is_buffer(index)) return DUK_BUFOBJ_UINT8ARRAY;
+      if(!is_buffer_data(index)) return -1;
+      const int class_number = get_internal_class(index);
+      switch(class_number) {
+        case 19: return DUK_BUFOBJ_ARRAYBUFFER;   // DUK_HOBJECT_CLASS_ARRAYBUFFER
+        case 20: return DUK_BUFOBJ_DATAVIEW;      // DUK_HOBJECT_CLASS_DATAVIEW
+        default:                                  // DUK_HOBJECT_CLASS_INT8ARRAY..FLOAT64ARRAY
+          return ((class_number >= 21) && (class_number <= 29)) ? (class_number - 21 + DUK_BUFOBJ_INT8ARRAY) : -1;
+      }
+    }
+
+    /**
+     * Returns true if the value at the given index is a TypedArray with
+     * the element type of `T` (e.g. Float64Array for double, Int32Array
+     * for int, Uint8Array for unsigned char).
+     *
+     * @param index_t index
+     * @return bool
+     */
+    template <typename T>
+    bool is_typed_array(index_t index)
+    {
+      using traits = typed_array_traits<T>;
+      return traits::supported && (get_buffer_object_type(index) == int(traits::flags));
+    }
+
+    /**
+     * Borrowed (not copied) view of the elements of a TypedArray with the
+     * element type of `T`. Returns nullptr and `out_size=0` if the value is
+     * no such array. Same lifetime restrictions as `get_data_view()`.
+     *
+     * @param index_t index
+     * @param size_t& out_size
+     * @return T*
+     */
+    template <typename T>
+    T* get_typed_array(index_t index, size_t& out_size)
+    {
+      out_size = 0;
+      if(!is_typed_array<T>(index)) return nullptr;
+      duk_size_t nbytes = 0;
+      void* p = duk_get_buffer_data(ctx_, index, &nbytes);
+      out_size = size_t(nbytes) / sizeof(T);
+      return out_size ? reinterpret_cast<T*>(p) : nullptr;
+    }
+
+    /**
+     * Push a new TypedArray with the element type of `T` (Float64Array,
+     * Int32Array, ...), and copy `size` elements from `data` into it in
+     * one block. Returns the pointer to the array data.
+     *
+     * @param const T* data
+     * @param size_t size
+     * @return T*
+     */
+    template <typename T>
+    T* push_typed_array(const T* data, size_t size) const
+    {
+      using traits = typed_array_traits<T>;
+      static_assert(traits::supported, "There is no ECMA TypedArray for this element type.");
+      require_stack(2);
+      T* p = reinterpret_cast<T*>(duk_push_fixed_buffer(ctx_, size * sizeof(T)));
+      if(data && size) std::copy(data, data+size, p);
+      duk_push_buffer_object(ctx_, -1, 0, size * sizeof(T), traits::flags);
+      duk_remove(ctx_, -2);
+      return p;
+    }
+
+    /**
+     * Push a TypedArray with the element type of `T` that refers directly
+     * to `data` (zero-copy, using an external buffer). The caller has to
+     * ensure that the memory stays valid as long as the array (or any view
+     * of it) is reachable from the ECMA space.
+     *
+     * @param T* data
+     * @param size_t size
+     * @return void
+     */
+    template <typename T>
+    void push_external_typed_array(T* data, size_t size) const
+    {
+      using traits = typed_array_traits<T>;
+      static_assert(traits::supported, "There is no ECMA TypedArray for this element type.");
+      require_stack(2);
+      duk_push_external_buffer(ctx_);
+      duk_config_buffer(ctx_, -1, reinterpret_cast<void*>(data), duk_size_t(size * sizeof(T)));
+      duk_push_buffer_object(ctx_, -1, 0, size * sizeof(T), traits::flags);
+      duk_remove(ctx_, -2);
+    }
+
     bool is_false(index_t index)
     { return is_boolean(index) && !get_boolean(index); }
 
@@ -1729,6 +1949,204 @@ namespace duktape { namespace detail {
   };
   // </editor-fold>
 
+  // <editor-fold desc="string_view, buffer_view" defaultstate="collapsed">
+  /**
+   * Borrowed (not copied) view of the characters of an ECMA string, meant
+   * for native function arguments. It points directly at the interned
+   * string data of the engine, hence it is only valid as long as the
+   * string is on the stack (normally for the duration of the native call).
+   * Pushing a view creates a new string (copy).
+   */
+  class string_view
+  {
+  public:
+
+    using value_type = char;
+    using size_type = std::size_t;
+    using const_iterator = const char*;
+    static constexpr size_type npos = size_type(-1);
+
+    string_view() noexcept : data_(""), size_(0)
+    {}
+
+    string_view(const char* data, size_type size) noexcept : data_(data ? data : ""), size_(data ? size : 0)
+    {}
+
+    string_view(const char* s) noexcept : data_(s ? s : ""), size_(s ? std::char_traits<char>::length(s) : 0)
+    {}
+
+    string_view(const std::string& s) noexcept : data_(s.data()), size_(s.size())
+    {}
+
+    const char* data() const noexcept
+    { return data_; }
+
+    size_type size() const noexcept
+    { return size_; }
+
+    size_type length() const noexcept
+    { return size_; }
+
+    bool empty() const noexcept
+    { return size_ == 0; }
+
+    const_iterator begin() const noexcept
+    { return data_; }
+
+    const_iterator end() const noexcept
+    { return data_ + size_; }
+
+    char operator[](size_type i) const noexcept
+    { return data_[i]; }
+
+    string_view substr(size_type pos, size_type n=npos) const noexcept
+    { pos = std::min(pos, size_); return string_view(data_+pos, std::min(n, size_-pos)); }
+
+    size_type find(char c, size_type pos=0) const noexcept
+    {
+      for(; pos < size_; ++pos) { if(data_[pos] == c) return pos; }
+      return npos;
+    }
+
+    int compare(const string_view& other) const noexcept
+    {
+      const int r = std::char_traits<char>::compare(data_, other.data_, std::min(size_, other.size_));
+      return (r != 0) ? r : ((size_ < other.size_) ? -1 : ((size_ > other.size_) ? 1 : 0));
+    }
+
+    std::string str() const
+    { return std::string(data_, size_); }
+
+    friend bool operator==(const string_view& a, const string_view& b) noexcept
+    { return a.compare(b) == 0; }
+
+    friend bool operator!=(const string_view& a, const string_view& b) noexcept
+    { return a.compare(b) != 0; }
+
+    friend bool operator<(const string_view& a, const string_view& b) noexcept
+    { return a.compare(b) < 0; }
+
+  private:
+
+    const char* data_;
+    size_type size_;
+  };
+
+  /**
+   * Borrowed (not copied) view of the bytes of a plain buffer or buffer
+   * object (ArrayBuffer, Uint8Array, ...). Same lifetime restrictions as
+   * `string_view`. As native function argument strings are accepted as
+   * well (as their UTF-8 bytes). Pushing a view creates a new buffer (copy).
+   */
+  class buffer_view
+  {
+  public:
+
+    using value_type = unsigned char;
+    using size_type = std::size_t;
+    using const_iterator = const unsigned char*;
+
+    buffer_view() noexcept : data_(nullptr), size_(0)
+    {}
+
+    buffer_view(const void* data, size_type size) noexcept : data_(reinterpret_cast<const unsigned char*>(data)), size_(data ? size : 0)
+    {}
+
+    const unsigned char* data() const noexcept
+    { return data_; }
+
+    size_type size() const noexcept
+    { return size_; }
+
+    bool empty() const noexcept
+    { return size_ == 0; }
+
+    const_iterator begin() const noexcept
+    { return data_; }
+
+    const_iterator end() const noexcept
+    { return data_ + size_; }
+
+    unsigned char operator[](size_type i) const noexcept
+    { return data_[i]; }
+
+  private:
+
+    const unsigned char* data_;
+    size_type size_;
+  };
+
+  template <> struct conv<string_view>
+  {
+    using type = string_view;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "string_view"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return "String"; }
+
+    static bool is(duk_context* ctx, int index)
+    { return api(ctx).is_string(index); }
+
+    static type get(duk_context* ctx, int index)
+    { duk_size_t l = 0; const char* s = duk_get_lstring(ctx, index, &l); return type(s, size_t(l)); }
+
+    static type req(duk_context* ctx, int index)
+    { duk_size_t l = 0; const char* s = duk_require_lstring(ctx, index, &l); return type(s, size_t(l)); }
+
+    static type to(duk_context* ctx, int index) // coerces the stack value in place, the view refers to the new string.
+    { duk_size_t l = 0; const char* s = duk_to_lstring(ctx, index, &l); return type(s, size_t(l)); }
+
+    static void push(duk_context* ctx, const type& val)
+    { duk_push_lstring(ctx, val.data(), duk_size_t(val.size())); }
+  };
+
+  template <> struct conv<buffer_view>
+  {
+    using type = buffer_view;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "buffer_view"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return "Buffer"; }
+
+    static bool is(duk_context* ctx, int index)
+    { return api(ctx).is_buffer_data(index); }
+
+    static type get(duk_context* ctx, int index)
+    { duk_size_t l = 0; const void* p = duk_get_buffer_data(ctx, index, &l); return type(p, size_t(l)); }
+
+    static type req(duk_context* ctx, int index)
+    { duk_size_t l = 0; const void* p = duk_require_buffer_data(ctx, index, &l); return type(p, size_t(l)); }
+
+    static type to(duk_context* ctx, int index)
+    {
+      api stack(ctx);
+      const void* data = nullptr;
+      api::size_t size = 0;
+      if(!stack.get_data_view(index, data, size)) {
+        stack.throw_exception("Buffer or string expected.");
+        return type();
+      }
+      return type(data ? data : "", size);
+    }
+
+    static void push(duk_context* ctx, const type& val)
+    {
+      void* p = duk_push_fixed_buffer(ctx, duk_size_t(val.size()));
+      if(p && !val.empty()) std::copy(val.begin(), val.end(), reinterpret_cast<unsigned char*>(p));
+    }
+  };
+  // </editor-fold>
+
   // <editor-fold desc="conv<std::vector<T>>" defaultstate="collapsed">
   template <typename T> struct conv<std::vector<T>>
   {
@@ -1744,7 +2162,7 @@ namespace duktape { namespace detail {
     { return "Array"; }
 
     static bool is(duk_context* ctx, int index)
-    { return api(ctx).is_array(index); }
+    { api stack(ctx); return stack.is_array(index) || stack.is_typed_array<T>(index); }
 
     static type to(duk_context* ctx, int index)
     { return get_array<false>(ctx, index); }
@@ -1783,11 +2201,18 @@ namespace duktape { namespace detail {
         stack.throw_exception("Not enough stack space (to get an array)");
         return type();
       } else if(!stack.is_array(index)) {
-        stack.throw_exception("Property is no array.");
-        return type();
+        // Matching TypedArrays are copied in one block.
+        if(!stack.is_typed_array<T>(index)) {
+          stack.throw_exception("Property is no array.");
+          return type();
+        }
+        duk_size_t nbytes = 0;
+        const T* data = reinterpret_cast<const T*>(duk_get_buffer_data(ctx, index, &nbytes));
+        return (data && (nbytes >= sizeof(T))) ? type(data, data+size_t(nbytes)/sizeof(T)) : type();
       }
       type ret;
       const api::index_t size = stack.get_length(index);
+      ret.reserve(size_t(size));
       for(auto i = api::index_t(0); i < size; ++i) {
         if(!stack.get_prop_index(index, i)) return type();
         ret.push_back(!StrictReturn ? stack.to<T>(-1) : stack.get<T>(-1));
@@ -1800,93 +2225,950 @@ namespace duktape { namespace detail {
   };
   // </editor-fold>
 
-  // <editor-fold desc="ecma_typename (for debugging use)" defaultstate="collapsed">
+  // <editor-fold desc="typed_view<T>, typed_array<T>" defaultstate="collapsed">
   /**
-   * Javascript type name query. Note: This is a runtime type query and expensive.
-   * Use it only for debugging or in exceptional situations.
-   *
-   * @param duk_context* ctx
-   * @return int index
+   * Non-owning view of the elements of an ECMA TypedArray with matching
+   * element type (Float64Array for double, Int32Array for int, ...). Meant
+   * for native function arguments, e.g. `double sum(typed_view<double>)`
+   * reads a Float64Array without copying it. The view is only valid as
+   * long as the array is on the stack (normally during the native call).
+   * Pushing a view creates a new TypedArray with a copy of the data.
    */
-  template <typename=void>
-  const char* ecma_typename(duk_context* ctx, int index)
+  template <typename T>
+  class typed_view
   {
-    api stack(ctx);
-    if(index < 0 || index > stack.get_top_index()) {
-      return "(invalid stack index)";
-    } else if(stack.is_undefined(index)) {
-      return "undefined";
-    } else if(stack.is_nan(index)) {
-      return "NaN";
-    } else if(stack.is_boolean(index)) {
-      return stack.get_boolean(index) ? "true" : "false";
-    } else if(stack.is_null(index)) {
-      return "null";
-    } else if(stack.is_string(index)) {
-      return "String";
-    } else if(stack.is_number(index)) {
-      return "Number";
-    } else if(stack.is_c_function(index)) {
-      return "Function (native)";
-    } else if(stack.is_function(index)) {
-      return "Function";
-    } else if(stack.is_array(index)) {
-      return "Array";
-    } else if(stack.is_object(index) || stack.is_null(index)) {
-      return "Object";
-    } else if(stack.is_dynamic_buffer(index)) {
-      return "Buffer (dynamic)";
-    } else if(stack.is_buffer(index)) {
-      return "Buffer";
-    } else if(stack.is_pointer(index)) {
-      return "Pointer";
-    } else if(stack.is_thread(index)) {
-      return "Thread";
-    }
-    return "(unrecognised script type)";
-  }
-  // </editor-fold>
+  public:
 
-}}
-// </editor-fold>
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
 
-// <editor-fold desc="function_proxy" defaultstate="collapsed">
-namespace duktape { namespace detail {
-  using native_function_type = int(*)(api&);
-}}
+    typed_view() noexcept : data_(nullptr), size_(0)
+    {}
 
-namespace duktape { namespace detail { namespace {
+    typed_view(T* data, size_type size) noexcept : data_(data), size_(size)
+    {}
 
-  template<unsigned...> struct indices{};
-  template<unsigned N, unsigned... Is> struct indices_gen : indices_gen<N-1, N-1, Is...>{};
-  template<unsigned... Is> struct indices_gen<0, Is...> : indices<Is...>{};
+    typed_view(std::vector<T>& v) noexcept : data_(v.data()), size_(v.size())
+    {}
 
-  template<typename R, unsigned I>
-  R convert_arg(duk_context* ctx)
-  { return std::forward<R>(conv<R>::to(ctx, I)); }
+    T* data() const noexcept
+    { return data_; }
 
-  template<typename R, typename... Args, unsigned... Is, typename std::enable_if<!std::is_void<R>::value>::type* = nullptr >
-  int fn_wrap(R(*fn)(Args...), duk_context* ctx, indices<Is...>)
-  { conv<R>::push(ctx, fn( std::move(convert_arg<Args, Is>(ctx))... )); return 1; }
+    size_type size() const noexcept
+    { return size_; }
 
-  template<typename R, typename... Args, unsigned... Is, typename std::enable_if<std::is_void<R>::value>::type* = nullptr >
-  int fn_wrap(R(*fn)(Args...), duk_context* ctx, indices<Is...>)
-  { fn( std::move(convert_arg<Args, Is>(ctx))... ); (void)ctx; return 0; }
+    bool empty() const noexcept
+    { return size_ == 0; }
 
-  template<typename R, typename... Args, typename std::enable_if<sizeof...(Args) != 1>::type* = nullptr>
-  int function_wrap(R(*fn)(Args...), duk_context* ctx)
-  { return fn_wrap(fn, ctx, indices_gen<sizeof...(Args)>()); }
+    iterator begin() const noexcept
+    { return data_; }
 
-  template<typename R, typename Arg, typename std::enable_if<!std::is_same<std::remove_reference<api>::type,Arg>::value>::type* = nullptr >
-  int function_wrap(R(*fn)(Arg), duk_context* ctx)
-  { return fn_wrap(fn, ctx, indices_gen<1>()); }
+    iterator end() const noexcept
+    { return data_ + size_; }
 
-  template<typename R, typename ApiType, typename std::enable_if<std::is_same<api, ApiType>::value>::type* = nullptr>
-  int function_wrap(int(*fn)(ApiType), duk_context* ctx)
-  { return fn(api(ctx)) ? 1 : 0; }
+    T& operator[](size_type i) const noexcept
+    { return data_[i]; }
 
-  template<typename R, typename ApiType, typename std::enable_if<std::is_same<api&, ApiType>::value>::type* = nullptr>
-  int function_wrap(int(*fn)(ApiType), duk_context* ctx)
+  private:
+
+    T* data_;
+    size_type size_;
+  };
+
+  /**
+   * A `std::vector<T>` that is pushed as ECMA TypedArray (Float64Array for
+   * double, Int32Array for int, ...) with one block copy instead of a plain
+   * Array. Reading accepts matching TypedArrays and plain Arrays.
+   */
+  template <typename T>
+  struct typed_array : public std::vector<T>
+  {
+    using std::vector<T>::vector;
+
+    typed_array() = default;
+
+    typed_array(const std::vector<T>& v) : std::vector<T>(v)
+    {}
+
+    typed_array(std::vector<T>&& v) : std::vector<T>(std::move(v))
+    {}
+  };
+
+  template <typename T> struct conv<typed_view<T>>
+  {
+    using type = typed_view<T>;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "typed_view"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return typed_array_traits<T>::ecma_name(); }
+
+    static bool is(duk_context* ctx, int index)
+    { return api(ctx).is_typed_array<T>(index); }
+
+    static type get(duk_context* ctx, int index)
+    {
+      api::size_t size = 0;
+      T* data = api(ctx).get_typed_array<T>(index, size);
+      return type(data, size);
+    }
+
+    static type req(duk_context* ctx, int index)
+    {
+      api stack(ctx);
+      if(!stack.is_typed_array<T>(index)) {
+        stack.throw_exception(std::string(ecma_name()) + " expected.");
+        return type();
+      }
+      duk_size_t nbytes = 0;
+      T* data = reinterpret_cast<T*>(duk_get_buffer_data(ctx, index, &nbytes));
+      return (nbytes >= sizeof(T)) ? type(data, size_t(nbytes)/sizeof(T)) : type(nullptr, 0);
+    }
+
+    static type to(duk_context* ctx, int index)
+    { return req(ctx, index); }
+
+    static void push(duk_context* ctx, const type& val)
+    { api(ctx).push_typed_array<T>(val.data(), val.size()); }
+  };
+
+  template <typename T> struct conv<typed_array<T>>
+  {
+    using type = typed_array<T>;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "typed_array"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return typed_array_traits<T>::ecma_name(); }
+
+    static bool is(duk_context* ctx, int index)
+    { return conv<std::vector<T>>::is(ctx, index); }
+
+    static type to(duk_context* ctx, int index)
+    { return type(conv<std::vector<T>>::to(ctx, index)); }
+
+    static type get(duk_context* ctx, int index)
+    { return type(conv<std::vector<T>>::get(ctx, index)); }
+
+    static type req(duk_context* ctx, int index)
+    { return type(conv<std::vector<T>>::req(ctx, index)); }
+
+    static void push(duk_context* ctx, const type& val)
+    { api(ctx).push_typed_array<T>(val.data(), val.size()); }
+  };
+  // </editor-fold>
+
+  // <editor-fold desc="conv<std::map<K,V>>, conv<std::unordered_map<K,V>>" defaultstate="collapsed">
+  /**
+   * Maps <--> plain objects. The keys are the property names, `std::string`
+   * keys are put/read directly, other key types (e.g. numbers) are coerced.
+   * Values are converted with their own traits, so nested containers work
+   * as well.
+   */
+  template <typename MapType>
+  struct conv_map
+  {
+    using type = MapType;
+    using key_type = typename MapType::key_type;
+    using mapped_type = typename MapType::mapped_type;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "map"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return "Object"; }
+
+    static bool is(duk_context* ctx, int index)
+    { api stack(ctx); return stack.is_object(index) && (!stack.is_array(index)) && (!stack.is_function(index)); }
+
+    static type to(duk_context* ctx, int index)
+    { return get_map<false>(ctx, index); }
+
+    static type get(duk_context* ctx, int index)
+    { return get_map<true>(ctx, index); }
+
+    static type req(duk_context* ctx, int index)
+    { return get_map<true>(ctx, index); }
+
+    static void push(duk_context* ctx, const type& val)
+    {
+      api stack(ctx);
+      if(!stack.check_stack(4)) {
+        stack.throw_exception("Not enough stack space (to push an object)");
+        return;
+      }
+      const auto object_index = stack.push_object();
+      for(const auto& e : val) {
+        put_entry(stack, object_index, e.first, e.second);
+      }
+    }
+
+  private:
+
+    static void put_entry(api& stack, api::index_t object_index, const std::string& key, const mapped_type& value)
+    {
+      stack.push(value);
+      duk_put_prop_lstring(stack.ctx(), object_index, key.data(), key.size());
+    }
+
+    template <typename K>
+    static void put_entry(api& stack, api::index_t object_index, const K& key, const mapped_type& value)
+    {
+      stack.push(key);
+      stack.push(value);
+      stack.put_prop(object_index);
+    }
+
+    template <bool StrictReturn>
+    static type get_map(duk_context* ctx, int index)
+    {
+      api stack(ctx);
+      if(!stack.check_stack(4)) {
+        stack.throw_exception("Not enough stack space (to get an object)");
+        return type();
+      } else if((!stack.is_object(index)) || stack.is_array(index)) {
+        stack.throw_exception("Property is no object.");
+        return type();
+      }
+      type ret;
+      stack.enumerator(index, api::enum_own_properties_only);
+      while(stack.next(-1, true)) {
+        if(StrictReturn && !stack.is<mapped_type>(-1)) { stack.pop(3); return type(); }
+        mapped_type value = StrictReturn ? stack.get<mapped_type>(-1) : stack.to<mapped_type>(-1);
+        ret.emplace(stack.to<key_type>(-2), std::move(value));
+        stack.pop(2);
+      }
+      stack.pop();
+      return ret;
+    }
+  };
+
+  template <typename K, typename V, typename Compare, typename Alloc>
+  struct conv<std::map<K, V, Compare, Alloc>> : public conv_map<std::map<K, V, Compare, Alloc>>
+  {};
+
+  template <typename K, typename V, typename Hash, typename Equal, typename Alloc>
+  struct conv<std::unordered_map<K, V, Hash, Equal, Alloc>> : public conv_map<std::unordered_map<K, V, Hash, Equal, Alloc>>
+  {};
+  // </editor-fold>
+
+  // <editor-fold desc="conv<std::pair<A,B>>, conv<std::tuple<...>>, conv<std::array<T,N>>" defaultstate="collapsed">
+  /**
+   * Pairs, tuples and fixed size arrays <--> Arrays with exactly the
+   * number of elements of the c++ type.
+   */
+  template <typename TupleType, size_t I=0, size_t N=std::tuple_size<TupleType>::value>
+  struct conv_tuple_elements
+  {
+    using element_type = typename std::tuple_element<I, TupleType>::type;
+
+    static void push(api& stack, api::index_t array_index, const TupleType& val)
+    {
+      stack.push(std::get<I>(val));
+      stack.put_prop_index(array_index, api::array_index_t(I));
+      conv_tuple_elements<TupleType, I+1, N>::push(stack, array_index, val);
+    }
+
+    template <bool StrictReturn>
+    static bool get(api& stack, api::index_t array_index, TupleType& val)
+    {
+      stack.get_prop_index(array_index, api::array_index_t(I));
+      if(StrictReturn && !stack.is<element_type>(-1)) { stack.pop(); return false; }
+      std::get<I>(val) = StrictReturn ? stack.get<element_type>(-1) : stack.to<element_type>(-1);
+      stack.pop();
+      return conv_tuple_elements<TupleType, I+1, N>::template get<StrictReturn>(stack, array_index, val);
+    }
+  };
+
+  template <typename TupleType, size_t N>
+  struct conv_tuple_elements<TupleType, N, N>
+  {
+    static void push(api&, api::index_t, const TupleType&)
+    {}
+
+    template <bool StrictReturn>
+    static bool get(api&, api::index_t, TupleType&)
+    { return true; }
+  };
+
+  template <typename TupleType>
+  struct conv_tuple
+  {
+    using type = TupleType;
+    static constexpr size_t size = std::tuple_size<TupleType>::value;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "tuple"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return "Array"; }
+
+    static bool is(duk_context* ctx, int index)
+    { api stack(ctx); return stack.is_array(index) && (stack.get_length(index) == size); }
+
+    static type to(duk_context* ctx, int index)
+    { return get_tuple<false>(ctx, index); }
+
+    static type get(duk_context* ctx, int index)
+    { return get_tuple<true>(ctx, index); }
+
+    static type req(duk_context* ctx, int index)
+    { return get_tuple<true>(ctx, index); }
+
+    static void push(duk_context* ctx, const type& val)
+    {
+      api stack(ctx);
+      if(!stack.check_stack(4)) {
+        stack.throw_exception("Not enough stack space (to push an array)");
+        return;
+      }
+      const auto array_index = stack.push_array();
+      conv_tuple_elements<type>::push(stack, array_index, val);
+    }
+
+  private:
+
+    template <bool StrictReturn>
+    static type get_tuple(duk_context* ctx, int index)
+    {
+      api stack(ctx);
+      if(!stack.check_stack(4)) {
+        stack.throw_exception("Not enough stack space (to get an array)");
+        return type();
+      } else if(!is(ctx, index)) {
+        stack.throw_exception(std::string("Property is no array of ") + std::to_string(size) + " elements.");
+        return type();
+      }
+      type ret;
+      if(!conv_tuple_elements<type>::template get<StrictReturn>(stack, stack.absindex(index), ret)) return type();
+      return ret;
+    }
+  };
+
+  template <typename A, typename B>
+  struct conv<std::pair<A, B>> : public conv_tuple<std::pair<A, B>>
+  {};
+
+  template <typename... Args>
+  struct conv<std::tuple<Args...>> : public conv_tuple<std::tuple<Args...>>
+  {};
+
+  template <typename T, size_t N>
+  struct conv<std::array<T, N>>
+  {
+    using type = std::array<T, N>;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "array"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return "Array"; }
+
+    static bool is(duk_context* ctx, int index)
+    { api stack(ctx); return stack.is_array(index) && (stack.get_length(index) == N); }
+
+    static type to(duk_context* ctx, int index)
+    { return get_array<false>(ctx, index); }
+
+    static type get(duk_context* ctx, int index)
+    { return get_array<true>(ctx, index); }
+
+    static type req(duk_context* ctx, int index)
+    { return get_array<true>(ctx, index); }
+
+    static void push(duk_context* ctx, const type& val)
+    {
+      api stack(ctx);
+      if(!stack.check_stack(4)) {
+        stack.throw_exception("Not enough stack space (to push an array)");
+        return;
+      }
+      const auto array_index = stack.push_array();
+      for(size_t i = 0; i < N; ++i) {
+        stack.push(val[i]);
+        stack.put_prop_index(array_index, api::array_index_t(i));
+      }
+    }
+
+  private:
+
+    template <bool StrictReturn>
+    static type get_array(duk_context* ctx, int index)
+    {
+      api stack(ctx);
+      if(!stack.check_stack(4)) {
+        stack.throw_exception("Not enough stack space (to get an array)");
+        return type();
+      } else if(!is(ctx, index)) {
+        stack.throw_exception(std::string("Property is no array of ") + std::to_string(N) + " elements.");
+        return type();
+      }
+      type ret{};
+      index = stack.absindex(index);
+      for(size_t i = 0; i < N; ++i) {
+        stack.get_prop_index(index, api::array_index_t(i));
+        if(StrictReturn && !stack.is<T>(-1)) { stack.pop(); return type{}; }
+        ret[i] = StrictReturn ? stack.get<T>(-1) : stack.to<T>(-1);
+        stack.pop();
+      }
+      return ret;
+    }
+  };
+  // </editor-fold>
+
+  // <editor-fold desc="ecma_typename (for debugging use)" defaultstate="collapsed">
+  /**
+   * Javascript type name query. Note: This is a runtime type query and expensive.
+   * Use it only for debugging or in exceptional situations.
+   *
+   * @param duk_context* ctx
+   * @return int index
+   */
+  template <typename=void>
+  const char* ecma_typename(duk_context* ctx, int index)
+  {
+    api stack(ctx);
+    if(index < 0 || index > stack.get_top_index()) {
+      return "(invalid stack index)";
+    } else if(stack.is_undefined(index)) {
+      return "undefined";
+    } else if(stack.is_nan(index)) {
+      return "NaN";
+    } else if(stack.is_boolean(index)) {
+      return stack.get_boolean(index) ? "true" : "false";
+    } else if(stack.is_null(index)) {
+      return "null";
+    } else if(stack.is_string(index)) {
+      return "String";
+    } else if(stack.is_number(index)) {
+      return "Number";
+    } else if(stack.is_c_function(index)) {
+      return "Function (native)";
+    } else if(stack.is_function(index)) {
+      return "Function";
+    } else if(stack.is_array(index)) {
+      return "Array";
+    } else if(stack.is_object(index) || stack.is_null(index)) {
+      return "Object";
+    } else if(stack.is_dynamic_buffer(index)) {
+      return "Buffer (dynamic)";
+    } else if(stack.is_buffer(index)) {
+      return "Buffer";
+    } else if(stack.is_pointer(index)) {
+      return "Pointer";
+    } else if(stack.is_thread(index)) {
+      return "Thread";
+    }
+    return "(unrecognised script type)";
+  }
+  // </editor-fold>
+
+}}
+// </editor-fold>
+
+// <editor-fold desc="value_blob" defaultstate="collapsed">
+namespace duktape { namespace detail {
+
+  /**
+   * Compact binary serialisation ("structured clone") of an ECMA value,
+   * made to pass data between independent engines, e.g. engines running
+   * in different threads. The blob is created with one walk over the
+   * value in the source heap, it does not refer to the source engine and
+   * can be moved/copied freely. Supported are undefined, null, booleans,
+   * numbers, strings, Dates, Arrays, plain buffers, ArrayBuffers, typed
+   * arrays, DataViews, and objects (own enumerable properties). Shared
+   * and circular references are preserved. Functions, threads and
+   * pointers cannot be serialised (`script_error`).
+   *
+   * Buffers of `large_buffer_size` bytes or more are stored as separate,
+   * immutable, shared chunks. Copying a blob (e.g. to fan out the same
+   * data to several engines) does not copy these chunks.
+   *
+   * Types are determined from the internal object classes, not from
+   * (script replaceable) constructors or `valueOf()`. Limitations: Each
+   * buffer object is stored with its own byte range, so typed arrays
+   * that share one ArrayBuffer are decoded as independent buffers (the
+   * sharing is only preserved if the same object is referenced twice).
+   * Strings and arrays of 4GiB/2^32 elements or more are rejected.
+   *
+   * Typical use: `auto blob = js1.eval<duktape::value_blob>("data");` in
+   * one thread, and `js2.define("data", blob);` or `js2.call<void>("f",
+   * blob);` in another.
+   */
+  template <typename R>
+  class basic_value_blob
+  {
+  public:
+
+    using byte_type = unsigned char;
+    using chunk_type = std::shared_ptr<const std::vector<byte_type>>;
+    static constexpr std::size_t large_buffer_size = 64 * 1024;
+    static constexpr unsigned max_depth = 1000;
+
+  public:
+
+    basic_value_blob() = default;
+    basic_value_blob(const basic_value_blob&) = default;
+    basic_value_blob(basic_value_blob&&) = default;
+    basic_value_blob& operator=(const basic_value_blob&) = default;
+    basic_value_blob& operator=(basic_value_blob&&) = default;
+    ~basic_value_blob() = default;
+
+  public:
+
+    /**
+     * Serialises the value at the given stack index.
+     *
+     * @param api& stack
+     * @param api::index_t index
+     * @return basic_value_blob
+     */
+    static basic_value_blob serialize(api& stack, api::index_t index)
+    {
+      basic_value_blob blob;
+      encoder enc(stack, blob);
+      enc.write(stack.absindex(index), 0);
+      return blob;
+    }
+
+    /**
+     * Creates the value in the heap of the given stack and pushes it.
+     * An empty blob is pushed as `undefined`.
+     *
+     * @param api& stack
+     * @return void
+     */
+    void push(api& stack) const
+    {
+      if(data_.empty()) { stack.push_undefined(); return; }
+      stack.require_stack(2);
+      const auto registry = stack.push_array();
+      decoder dec(stack, *this, registry);
+      dec.read(0);
+      stack.remove(registry);
+      if(dec.pos != data_.size()) throw engine_error("value_blob: invalid data (trailing bytes).");
+    }
+
+    /**
+     * Returns true if nothing was serialised.
+     * @return bool
+     */
+    bool empty() const noexcept
+    { return data_.empty(); }
+
+    /**
+     * Total number of bytes of the serialised data, including the
+     * separately stored large buffers.
+     * @return size_t
+     */
+    std::size_t size() const noexcept
+    {
+      std::size_t n = data_.size();
+      for(const auto& c: chunks_) n += c->size();
+      return n;
+    }
+
+    void clear() noexcept
+    { data_.clear(); chunks_.clear(); }
+
+  private:
+
+    enum tag_type : byte_type {
+      tag_undefined=0, tag_null, tag_false, tag_true, tag_int, tag_number, tag_string,
+      tag_date, tag_array, tag_object, tag_buffer, tag_chunk, tag_reference
+    };
+
+    static constexpr byte_type plain_buffer_kind = 0xff;
+    static constexpr int date_class = 6; // DUK_HOBJECT_CLASS_DATE
+    static constexpr const char* time_value_key = "\x82" "Value"; // Internal time value of Dates.
+
+    struct encoder
+    {
+      api& stack;
+      basic_value_blob& blob;
+      std::unordered_map<void*, uint32_t> ids;
+      void* nodejs_buffer_prototype = nullptr;
+      bool nodejs_buffer_prototype_known = false;
+
+      explicit encoder(api& stk, basic_value_blob& b) : stack(stk), blob(b), ids()
+      {}
+
+      void put(const void* p, std::size_t n)
+      { const byte_type* b = reinterpret_cast<const byte_type*>(p); blob.data_.insert(blob.data_.end(), b, b+n); }
+
+      void put_tag(tag_type t)
+      { blob.data_.push_back(byte_type(t)); }
+
+      void put_u32(uint32_t v)
+      { put(&v, sizeof(v)); }
+
+      void put_size(std::size_t n)
+      {
+        if(n > std::size_t(std::numeric_limits<uint32_t>::max())) throw script_error("value_blob: string or array too large to serialize (4GiB or more).");
+        put_u32(uint32_t(n));
+      }
+
+      void put_string(const char* s, duk_size_t n)
+      { put_size(std::size_t(n)); put(s, std::size_t(n)); }
+
+      /**
+       * `DUK_BUFOBJ_*` type of the buffer object at `index`. Node.js Buffers
+       * are Uint8Arrays with the built-in Buffer prototype.
+       */
+      byte_type buffer_kind(api::index_t index)
+      {
+        const int type = stack.get_buffer_object_type(index);
+        if(type < 0) throw script_error("value_blob: cannot serialize this buffer object.");
+        if(type != DUK_BUFOBJ_UINT8ARRAY) return byte_type(type);
+        if(!nodejs_buffer_prototype_known) {
+          stack.push_fixed_buffer(0);
+          stack.push_buffer_object(-1, 0, 0, DUK_BUFOBJ_NODEJS_BUFFER);
+          stack.get_prototype(-1);
+          nodejs_buffer_prototype = duk_get_heapptr(stack.ctx(), -1);
+          nodejs_buffer_prototype_known = true;
+          stack.pop(3);
+        }
+        if(!nodejs_buffer_prototype) return byte_type(type);
+        stack.get_prototype(index);
+        const bool is_nodejs_buffer = (duk_get_heapptr(stack.ctx(), -1) == nodejs_buffer_prototype);
+        stack.pop();
+        return byte_type(is_nodejs_buffer ? DUK_BUFOBJ_NODEJS_BUFFER : type);
+      }
+
+      /**
+       * Reads the internal time value if the object at `index` is a Date.
+       * Only objects with such an internal value are inspected further.
+       */
+      bool get_time_value(api::index_t index, double& t)
+      {
+        stack.get_prop_string(index, time_value_key);
+        const bool has_value = stack.is_number(-1);
+        t = has_value ? stack.get_number(-1) : 0;
+        stack.pop();
+        return has_value && (stack.get_internal_class(index) == date_class);
+      }
+
+      void write(api::index_t index, unsigned depth)
+      {
+        switch(duk_get_type(stack.ctx(), index)) {
+          case DUK_TYPE_UNDEFINED: put_tag(tag_undefined); return;
+          case DUK_TYPE_NULL: put_tag(tag_null); return;
+          case DUK_TYPE_BOOLEAN: put_tag(stack.get_boolean(index) ? tag_true : tag_false); return;
+          case DUK_TYPE_NUMBER: write_number(stack.get_number(index)); return;
+          case DUK_TYPE_STRING: {
+            duk_size_t n = 0;
+            const char* s = duk_get_lstring(stack.ctx(), index, &n);
+            put_tag(tag_string);
+            put_string(s, n);
+            return;
+          }
+          case DUK_TYPE_BUFFER: write_buffer(index, plain_buffer_kind); return;
+          case DUK_TYPE_OBJECT: write_object(index, depth); return;
+          default: throw script_error(std::string("value_blob: cannot serialize values of type ") + ecma_typename(stack.ctx(), index));
+        }
+      }
+
+      void write_number(double d)
+      {
+        // Range check before the cast (NaN, infinities and out of range values are not castable).
+        if((d == d) && (d >= double(std::numeric_limits<int32_t>::min())) && (d <= double(std::numeric_limits<int32_t>::max()))
+          && (double(int32_t(d)) == d) && ((d != 0) || !std::signbit(d))) {
+          const int32_t i = int32_t(d);
+          put_tag(tag_int);
+          put(&i, sizeof(i));
+        } else {
+          put_tag(tag_number);
+          put(&d, sizeof(d));
+        }
+      }
+
+      void write_buffer(api::index_t index, byte_type kind)
+      {
+        duk_size_t n = 0;
+        const void* p = duk_get_buffer_data(stack.ctx(), index, &n);
+        if(n >= large_buffer_size) {
+          put_tag(tag_chunk);
+          blob.data_.push_back(kind);
+          put_u32(uint32_t(blob.chunks_.size()));
+          const byte_type* b = reinterpret_cast<const byte_type*>(p);
+          blob.chunks_.emplace_back(std::make_shared<const std::vector<byte_type>>(b, b+n));
+        } else {
+          put_tag(tag_buffer);
+          blob.data_.push_back(kind);
+          put_size(std::size_t(n));
+          if(n) put(p, std::size_t(n));
+        }
+      }
+
+      void write_object(api::index_t index, unsigned depth)
+      {
+        double time_value = 0;
+        void* heapptr = duk_get_heapptr(stack.ctx(), index);
+        const auto it = ids.find(heapptr);
+        if(it != ids.end()) {
+          put_tag(tag_reference);
+          put_u32(it->second);
+          return;
+        } else if(stack.is_function(index) || stack.is_thread(index)) {
+          throw script_error(std::string("value_blob: cannot serialize values of type ") + ecma_typename(stack.ctx(), index));
+        } else if(depth >= max_depth) {
+          throw script_error("value_blob: maximum nesting depth exceeded.");
+        }
+        ids.emplace(heapptr, uint32_t(ids.size()));
+        stack.require_stack(4);
+        if(stack.is_array(index)) {
+          const auto size = stack.get_length(index);
+          put_tag(tag_array);
+          put_size(std::size_t(size));
+          for(auto i = api::array_index_t(0); i < size; ++i) {
+            stack.get_prop_index(index, i);
+            write(stack.top()-1, depth+1);
+            stack.pop();
+          }
+        } else if(stack.is_buffer_data(index)) {
+          write_buffer(index, buffer_kind(index));
+        } else if(get_time_value(index, time_value)) {
+          put_tag(tag_date);
+          put(&time_value, sizeof(time_value));
+        } else {
+          put_tag(tag_object);
+          const auto count_pos = blob.data_.size();
+          put_u32(0);
+          uint32_t count = 0;
+          stack.enumerator(index, api::enum_own_properties_only);
+          const auto enum_index = stack.top()-1;
+          while(stack.next(enum_index, true)) {
+            duk_size_t n = 0;
+            const char* key = duk_get_lstring(stack.ctx(), -2, &n);
+            put_string(key, n);
+            write(stack.top()-1, depth+1);
+            stack.pop(2);
+            ++count;
+          }
+          stack.pop();
+          std::memcpy(&blob.data_[count_pos], &count, sizeof(count));
+        }
+      }
+    };
+
+    struct decoder
+    {
+      api& stack;
+      const basic_value_blob& blob;
+      api::index_t registry;
+      api::array_index_t num_objects;
+      std::size_t pos;
+
+      explicit decoder(api& stk, const basic_value_blob& b, api::index_t reg) : stack(stk), blob(b), registry(reg), num_objects(0), pos(0)
+      {}
+
+      void get(void* p, std::size_t n)
+      {
+        if(n > blob.data_.size() - pos) throw engine_error("value_blob: invalid data (truncated).");
+        if(n) std::memcpy(p, &blob.data_[pos], n);
+        pos += n;
+      }
+
+      byte_type get_byte()
+      { byte_type b = 0; get(&b, 1); return b; }
+
+      uint32_t get_u32()
+      { uint32_t v = 0; get(&v, sizeof(v)); return v; }
+
+      const char* get_bytes(std::size_t n)
+      {
+        if(n > blob.data_.size() - pos) throw engine_error("value_blob: invalid data (truncated).");
+        const char* p = reinterpret_cast<const char*>(blob.data_.data() + pos);
+        pos += n;
+        return p;
+      }
+
+      void register_top()
+      {
+        stack.dup_top();
+        stack.put_prop_index(registry, num_objects++);
+      }
+
+      void push_buffer(byte_type kind, const void* data, std::size_t n)
+      {
+        void* p = stack.push_fixed_buffer(n);
+        if(n) std::memcpy(p, data, n);
+        if(kind != plain_buffer_kind) {
+          stack.push_buffer_object(-1, 0, n, kind);
+          stack.remove(-2);
+          register_top();
+        }
+      }
+
+      void read(unsigned depth)
+      {
+        if(depth > max_depth) throw engine_error("value_blob: invalid data (nesting depth).");
+        stack.require_stack(4);
+        switch(get_byte()) {
+          case tag_undefined: stack.push_undefined(); return;
+          case tag_null: stack.push_null(); return;
+          case tag_false: stack.push_boolean(false); return;
+          case tag_true: stack.push_boolean(true); return;
+          case tag_int: { int32_t i = 0; get(&i, sizeof(i)); stack.push_int(i); return; }
+          case tag_number: { double d = 0; get(&d, sizeof(d)); stack.push_number(d); return; }
+          case tag_string: {
+            const std::size_t n = get_u32();
+            const char* s = get_bytes(n);
+            duk_push_lstring(stack.ctx(), s, duk_size_t(n));
+            return;
+          }
+          case tag_date: {
+            double t = 0;
+            get(&t, sizeof(t));
+            stack.get_global_string("Date");
+            stack.push_number(t);
+            if((!stack.pnew(1)) || (stack.get_internal_class(-1) != date_class)) {
+              throw engine_error("value_blob: failed to create a Date (global Date constructor replaced?).");
+            }
+            register_top();
+            return;
+          }
+          case tag_buffer: {
+            const byte_type kind = get_byte();
+            const std::size_t n = get_u32();
+            push_buffer(kind, get_bytes(n), n);
+            return;
+          }
+          case tag_chunk: {
+            const byte_type kind = get_byte();
+            const std::size_t i = get_u32();
+            if(i >= blob.chunks_.size()) throw engine_error("value_blob: invalid data (chunk index).");
+            push_buffer(kind, blob.chunks_[i]->data(), blob.chunks_[i]->size());
+            return;
+          }
+          case tag_reference: {
+            const uint32_t id = get_u32();
+            if(id >= num_objects) throw engine_error("value_blob: invalid data (reference).");
+            stack.get_prop_index(registry, id);
+            return;
+          }
+          case tag_array: {
+            const uint32_t size = get_u32();
+            const auto array_index = stack.push_array();
+            register_top();
+            for(uint32_t i = 0; i < size; ++i) {
+              read(depth+1);
+              stack.put_prop_index(array_index, i);
+            }
+            return;
+          }
+          case tag_object: {
+            const uint32_t count = get_u32();
+            const auto object_index = stack.push_object();
+            register_top();
+            for(uint32_t i = 0; i < count; ++i) {
+              const std::size_t n = get_u32();
+              const char* key = get_bytes(n);
+              read(depth+1);
+              duk_put_prop_lstring(stack.ctx(), object_index, key, duk_size_t(n));
+            }
+            return;
+          }
+          default:
+            throw engine_error("value_blob: invalid data (type tag).");
+        }
+      }
+    };
+
+  private:
+
+    std::vector<byte_type> data_;
+    std::vector<chunk_type> chunks_;
+  };
+
+  template <> struct conv<basic_value_blob<>>
+  {
+    using type = basic_value_blob<>;
+
+    static constexpr int nret() noexcept
+    { return 1; }
+
+    static constexpr const char* cc_name() noexcept
+    { return "value_blob"; }
+
+    static constexpr const char* ecma_name() noexcept
+    { return "(any)"; }
+
+    static bool is(duk_context*, int)
+    { return true; }
+
+    static type get(duk_context* ctx, int index)
+    { api stack(ctx); return type::serialize(stack, index); }
+
+    static type req(duk_context* ctx, int index)
+    { return get(ctx, index); }
+
+    static type to(duk_context* ctx, int index)
+    { return get(ctx, index); }
+
+    static void push(duk_context* ctx, const type& val)
+    { api stack(ctx); val.push(stack); }
+  };
+
+}}
+// </editor-fold>
+
+// <editor-fold desc="function_proxy" defaultstate="collapsed">
+namespace duktape { namespace detail {
+  using native_function_type = int(*)(api&);
+}}
+
+namespace duktape { namespace detail { namespace {
+
+  template<unsigned...> struct indices{};
+  template<unsigned N, unsigned... Is> struct indices_gen : indices_gen<N-1, N-1, Is...>{};
+  template<unsigned... Is> struct indices_gen<0, Is...> : indices<Is...>{};
+
+  template<typename R, unsigned I>
+  R convert_arg(duk_context* ctx)
+  { return conv<R>::to(ctx, I); } // Returned values directly initialise the arguments (no extra move).
+
+  template<typename R, typename... Args, unsigned... Is, typename std::enable_if<!std::is_void<R>::value>::type* = nullptr >
+  int fn_wrap(R(*fn)(Args...), duk_context* ctx, indices<Is...>)
+  { conv<R>::push(ctx, fn( convert_arg<Args, Is>(ctx)... )); return 1; }
+
+  template<typename R, typename... Args, unsigned... Is, typename std::enable_if<std::is_void<R>::value>::type* = nullptr >
+  int fn_wrap(R(*fn)(Args...), duk_context* ctx, indices<Is...>)
+  { fn( convert_arg<Args, Is>(ctx)... ); (void)ctx; return 0; }
+
+  template<typename R, typename... Args, typename std::enable_if<sizeof...(Args) != 1>::type* = nullptr>
+  int function_wrap(R(*fn)(Args...), duk_context* ctx)
+  { return fn_wrap(fn, ctx, indices_gen<sizeof...(Args)>()); }
+
+  template<typename R, typename Arg, typename std::enable_if<!std::is_same<std::remove_reference<api>::type,Arg>::value>::type* = nullptr >
+  int function_wrap(R(*fn)(Arg), duk_context* ctx)
+  { return fn_wrap(fn, ctx, indices_gen<1>()); }
+
+  template<typename R, typename ApiType, typename std::enable_if<std::is_same<api, ApiType>::value>::type* = nullptr>
+  int function_wrap(int(*fn)(ApiType), duk_context* ctx)
+  { return fn(api(ctx)) ? 1 : 0; }
+
+  template<typename R, typename ApiType, typename std::enable_if<std::is_same<api&, ApiType>::value>::type* = nullptr>
+  int function_wrap(int(*fn)(ApiType), duk_context* ctx)
   { api stack(ctx); return fn(stack) ? 1 : 0; }
 
   /**
@@ -1961,6 +3243,101 @@ namespace duktape { namespace detail { namespace {
 }}}
 // </editor-fold>
 
+// <editor-fold desc="execution watchdog" defaultstate="collapsed">
+namespace duktape { namespace detail {
+
+  /**
+   * Execution deadline and instruction budget of an engine. A pointer to
+   * this structure is passed as heap user data, Duktape invokes `check`
+   * from its executor interrupt about every `interrupt_interval` executed
+   * instructions (`DUK_USE_EXEC_TIMEOUT_CHECK` in duk_config.h). Once
+   * expired, `check` keeps returning nonzero until the script has unwound
+   * completely, so that `try/catch` in the script cannot resume execution.
+   */
+  template <typename=void>
+  struct basic_exec_watchdog
+  {
+    using clock_type = std::chrono::steady_clock;
+    static constexpr uint64_t interrupt_interval = 256ul * 1024ul; // DUK_HTHREAD_INTCTR_DEFAULT
+    static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+    enum { not_expired=0, deadline_expired, budget_expired };
+
+    int (*check)(void*);                          // Must be the first member.
+    typename clock_type::time_point deadline;
+    uint64_t budget;                              // Remaining interrupts.
+    int expired;
+
+    explicit basic_exec_watchdog() noexcept
+      : check(&check_limits), deadline(clock_type::time_point::max()), budget(unlimited), expired(not_expired)
+    {}
+
+    static int check_limits(void* udata) noexcept
+    {
+      basic_exec_watchdog& w = *reinterpret_cast<basic_exec_watchdog*>(udata);
+      if(w.expired) return 1;
+      if(w.budget != unlimited) {
+        if(!w.budget) w.expired = budget_expired; else --w.budget;
+      }
+      if((!w.expired) && (w.deadline != clock_type::time_point::max()) && (clock_type::now() >= w.deadline)) {
+        w.expired = deadline_expired;
+      }
+      return w.expired != not_expired;
+    }
+
+    /**
+     * Sets the limits of one eval()/call() and restores the previous ones
+     * on destruction. Nested limits can only narrow the enclosing ones,
+     * instructions executed in the nested scope count for the enclosing
+     * budget as well, and an exceeded enclosing limit stays expired after
+     * the nested scope is left. Zero values mean "no limit". The optional
+     * absolute `deadline` applies in addition to the relative `timeout`.
+     */
+    class scope
+    {
+    public:
+      explicit scope(basic_exec_watchdog& w, std::chrono::milliseconds timeout, uint64_t instructions, typename clock_type::time_point deadline=clock_type::time_point::max()) noexcept
+        : w_(w), deadline_(w.deadline), budget_(w.budget), expired_(w.expired), initial_budget_(0)
+      {
+        if(deadline < w.deadline) w.deadline = deadline;
+        if(timeout.count() > 0) {
+          const auto deadline = clock_type::now() + timeout;
+          if(deadline < w.deadline) w.deadline = deadline;
+        }
+        if(instructions > 0) {
+          const uint64_t n = (instructions + interrupt_interval - 1) / interrupt_interval;
+          if(n < w.budget) w.budget = n;
+        }
+        initial_budget_ = w.budget;
+      }
+
+      ~scope() noexcept
+      {
+        const uint64_t used = initial_budget_ - w_.budget;
+        w_.deadline = deadline_;
+        w_.budget = (budget_ == unlimited) ? budget_ : ((used < budget_) ? (budget_ - used) : 0);
+        w_.expired = expired_;
+        if(w_.expired) return;
+        if((budget_ != unlimited) && (used >= budget_)) {
+          w_.expired = budget_expired;
+        } else if((deadline_ != clock_type::time_point::max()) && (clock_type::now() >= deadline_)) {
+          w_.expired = deadline_expired;
+        }
+      }
+
+      scope(const scope&) = delete;
+      scope& operator=(const scope&) = delete;
+
+    private:
+      basic_exec_watchdog& w_;
+      const typename clock_type::time_point deadline_;
+      const uint64_t budget_;
+      const int expired_;
+      uint64_t initial_budget_;
+    };
+  };
+}}
+// </editor-fold>
+
 // <editor-fold desc="engine" defaultstate="collapsed">
 namespace duktape { namespace detail {
 
@@ -1980,6 +3357,20 @@ namespace duktape { namespace detail {
     using stack_guard_type = ::duktape::stack_guard;
     using lock_guard_type = std::lock_guard<MutexType>;
     using defflags = defprop_flags;
+    using duration_type = std::chrono::milliseconds;
+    using watchdog_type = basic_exec_watchdog<>;
+    using time_point_type = typename watchdog_type::clock_type::time_point;
+    using job_hook_type = std::function<void(basic_engine&)>;
+
+    /**
+     * Error of one element of `call_batch()`.
+     */
+    struct batch_error
+    {
+      size_t index;           // Index of the argument set.
+      std::string message;    // Error message (as script_error::what()).
+      std::string callstack;  // Script call stack, if available.
+    };
     // </editor-fold>
 
   public:
@@ -1988,7 +3379,8 @@ namespace duktape { namespace detail {
     /**
      * c' tor
      */
-    explicit basic_engine() : stack_(), define_flags_(defflags::defaults), mutex_()
+    explicit basic_engine() : stack_(), define_flags_(defflags::defaults), mutex_(), watchdog_(),
+      timeout_(duration_type::zero()), deadline_(time_point_type::max()), instruction_budget_(0), job_hook_(), exec_depth_(0)
     { clear(); }
 
     /**
@@ -2036,6 +3428,92 @@ namespace duktape { namespace detail {
     void define_flags(typename defflags::type flags) noexcept
     { define_flags_ = flags; }
 
+    /**
+     * Returns the default execution timeout of eval(), include() and call(),
+     * zero if no timeout is set.
+     * @return duration_type
+     */
+    duration_type timeout() const noexcept
+    { return timeout_; }
+
+    /**
+     * Sets the default execution timeout of each eval(), include() and call().
+     * Running scripts exceeding the timeout are aborted with a
+     * `duktape::timeout_error`. Zero disables the timeout. Native functions
+     * are not interrupted, the timeout is checked when the script continues.
+     * @param duration_type timeout
+     */
+    void timeout(duration_type timeout) noexcept
+    { timeout_ = (timeout.count() > 0) ? timeout : duration_type::zero(); }
+
+    /**
+     * Returns the absolute execution deadline, `time_point_type::max()`
+     * if not set.
+     * @return time_point_type
+     */
+    time_point_type deadline() const noexcept
+    { return deadline_; }
+
+    /**
+     * Sets an absolute (steady clock) deadline for all following eval(),
+     * include() and call(). Unlike the timeout, which restarts with each
+     * call, all calls are checked against the same point in time, so that
+     * a sequence of short calls cannot exceed it. Exceeding scripts are
+     * aborted with a `duktape::timeout_error`, `time_point_type::max()`
+     * disables the deadline.
+     * @param time_point_type deadline
+     */
+    void deadline(time_point_type deadline) noexcept
+    { deadline_ = deadline; }
+
+    /**
+     * Returns the default maximum number of executed instructions of eval(),
+     * include() and call(), zero if unlimited.
+     * @return uint64_t
+     */
+    uint64_t instruction_budget() const noexcept
+    { return instruction_budget_; }
+
+    /**
+     * Sets the default maximum number of executed instructions of each eval(),
+     * include() and call(), zero means unlimited. Exceeding scripts are
+     * aborted with a `duktape::timeout_error`. The budget is checked in steps
+     * of `watchdog_type::interrupt_interval` (256k) instructions.
+     * @param uint64_t instructions
+     */
+    void instruction_budget(uint64_t instructions) noexcept
+    { instruction_budget_ = instructions; }
+
+    /**
+     * Returns the function invoked after each outermost eval(), include(),
+     * call() and call_top(), empty if not set.
+     * @return const job_hook_type&
+     */
+    const job_hook_type& job_hook() const noexcept
+    { return job_hook_; }
+
+    /**
+     * Sets the function invoked after the outermost eval(), include(),
+     * call() or call_top() returned successfully (not for nested calls
+     * from native functions). It runs while the execution limits of that
+     * call are still active, and is used to process pending jobs, e.g. the
+     * reaction queue (microtasks) of the Promise module. Exceptions are
+     * passed to the caller of eval()/call(). Reset by clear().
+     * @param job_hook_type hook
+     */
+    void job_hook(job_hook_type hook)
+    { job_hook_ = std::move(hook); }
+
+    /**
+     * Returns true if the timeout or instruction budget of the running
+     * eval()/call() is exceeded. Native code catching errors with
+     * `duk_pcall()` can use this to distinguish an interrupted script
+     * from a script error.
+     * @return bool
+     */
+    bool limits_exceeded() const noexcept
+    { return watchdog_.expired != watchdog_type::not_expired; }
+
     // </editor-fold>
 
   public:
@@ -2057,7 +3535,13 @@ namespace duktape { namespace detail {
       lock_guard_type lck(mutex_);
       define_flags_ = defflags::defaults;
       if(ctx()) ::duk_destroy_heap(ctx());
+      watchdog_ = watchdog_type();
+      job_hook_ = nullptr;
+      #if defined(DUK_USE_EXEC_TIMEOUT_CHECK)
+      stack().ctx(::duk_create_heap(0, 0, 0, &watchdog_, 0));
+      #else
       stack().ctx(::duk_create_heap(0, 0, 0, 0, 0));
+      #endif
       if(!ctx()) throw engine_error("Failed to create context");
       stack().push_heap_stash();
       stack().push_pointer(this);
@@ -2126,9 +3610,27 @@ namespace duktape { namespace detail {
      */
     template <typename ReturnType=void, bool StrictReturn=false>
     ReturnType eval(std::string&& code, std::string file="(eval)", bool use_strict=false)
+    { return eval<ReturnType, StrictReturn>(std::move(code), std::move(file), use_strict, duration_type::zero()); }
+
+    /**
+     * Evaluate code given as string with an execution timeout and/or instruction
+     * budget (zero values select the engine defaults, see `timeout()` and
+     * `instruction_budget()`). Throws a `duktape::timeout_error` if a limit is
+     * exceeded, a `duktape::script_error` on other errors.
+     * @param std::string code
+     * @param std::string file
+     * @param bool use_strict
+     * @param duration_type timeout
+     * @param uint64_t instruction_budget=0
+     * @return typename ReturnType
+     */
+    template <typename ReturnType=void, bool StrictReturn=false>
+    ReturnType eval(std::string&& code, std::string file, bool use_strict, duration_type timeout, uint64_t instruction_budget=0)
     {
       lock_guard_type lck(mutex_);
       stack_guard_type sg(ctx(), true);
+      typename watchdog_type::scope limits(watchdog_, (timeout.count() > 0) ? timeout : timeout_, instruction_budget ? instruction_budget : instruction_budget_, deadline_);
+      exec_depth_guard depth(exec_depth_);
       stack().require_stack(2);
       stack().push_string(std::move(code));
       stack().push_string(file);
@@ -2141,7 +3643,9 @@ namespace duktape { namespace detail {
         throw;
       }
       if(!ok) {
-        if(stack().top() > 0) {
+        if(watchdog_.expired) {
+          throw_timeout(std::string("in '") + file + "'");
+        } else if(stack().top() > 0) {
           // The stack top index is the error
           stack().swap_top(sg.initial_top());
           sg.initial_top(sg.initial_top()+1);
@@ -2157,7 +3661,9 @@ namespace duktape { namespace detail {
         } else {
           throw script_error(std::string("Unspecified exception evaluating code."));
         }
-      } else if(std::is_void<ReturnType>::value) {
+      }
+      run_jobs();
+      if(std::is_void<ReturnType>::value) {
         return ReturnType();
       } else if(!StrictReturn) {
         return conv<ReturnType>::to(ctx(), -1);
@@ -2194,9 +3700,36 @@ namespace duktape { namespace detail {
      */
     template <typename ReturnType=void, bool StrictReturn=false, typename ...Args>
     ReturnType call(std::string funct, Args ...args)
+    { return call_for<ReturnType, StrictReturn, Args...>(duration_type::zero(), uint64_t(0), std::move(funct), args...); }
+
+    /**
+     * Call a function with an execution timeout (zero selects the engine
+     * default), fetch the (strict) return value. Throws a `duktape::timeout_error`
+     * if the timeout is exceeded.
+     * @param duration_type timeout
+     * @param std::string funct
+     * @return typename ReturnType
+     */
+    template <typename ReturnType=void, bool StrictReturn=false, typename ...Args>
+    ReturnType call_for(duration_type timeout, std::string funct, Args ...args)
+    { return call_for<ReturnType, StrictReturn, Args...>(timeout, uint64_t(0), std::move(funct), args...); }
+
+    /**
+     * Call a function with an execution timeout and instruction budget (zero
+     * values select the engine defaults), fetch the (strict) return value.
+     * Throws a `duktape::timeout_error` if a limit is exceeded.
+     * @param duration_type timeout
+     * @param uint64_t instruction_budget
+     * @param std::string funct
+     * @return typename ReturnType
+     */
+    template <typename ReturnType=void, bool StrictReturn=false, typename ...Args>
+    ReturnType call_for(duration_type timeout, uint64_t instruction_budget, std::string funct, Args ...args)
     {
       lock_guard_type lck(mutex_);
       stack_guard_type sg(ctx(), true);
+      typename watchdog_type::scope limits(watchdog_, (timeout.count() > 0) ? timeout : timeout_, instruction_budget ? instruction_budget : instruction_budget_, deadline_);
+      exec_depth_guard depth(exec_depth_);
       stack().require_stack(6);
       if(!stack().select(funct)) {
         throw script_error(std::string("'") + funct + "' not defined");
@@ -2204,15 +3737,216 @@ namespace duktape { namespace detail {
         throw script_error(std::string("'") + funct + "' is not callable");
       }
       stack().push(args...);
+      return pcall_function<ReturnType, StrictReturn>(sg, int(sizeof...(Args)), funct);
+    }
+
+    /**
+     * Calls the function on the stack below the `nargs` topmost arguments
+     * (the stack layout of `duk_pcall()`), with the limits and error handling
+     * of `call()`. Function and arguments are removed from the stack. Used
+     * for callbacks, where the function is not accessible by name. The
+     * name `funct` is only used in error messages.
+     * @param int nargs
+     * @param std::string funct
+     * @return typename ReturnType
+     */
+    template <typename ReturnType=void, bool StrictReturn=false>
+    ReturnType call_top(int nargs, std::string funct="(callback)")
+    {
+      lock_guard_type lck(mutex_);
+      if((nargs < 0) || (stack().top() < nargs+1)) throw engine_error("BUG: engine::call_top(): Not enough values on the stack.");
+      stack_guard_type sg(ctx(), true);
+      sg.initial_top(sg.initial_top()-nargs-1);
+      typename watchdog_type::scope limits(watchdog_, timeout_, instruction_budget_, deadline_);
+      exec_depth_guard depth(exec_depth_);
+      if(!stack().is_callable(-nargs-1)) {
+        throw script_error(std::string("'") + funct + "' is not callable");
+      }
+      return pcall_function<ReturnType, StrictReturn>(sg, nargs, funct);
+    }
+
+    /**
+     * Calls the function on the stack below the `nargs` topmost arguments
+     * with `duk_pcall()` (`duk_pcall_method()` if `method` is true, `this`
+     * between function and arguments), with the execution limits of
+     * `call_top()`. Unlike `call_top()`, script errors are not thrown, the
+     * result or error value replaces function and arguments on the stack.
+     * Used by native job queues (e.g. Promise reactions) which have to
+     * handle rejections themselves. Exceeded limits are thrown as
+     * `duktape::timeout_error`, the name `funct` is used in its message.
+     * @param int nargs
+     * @param bool method
+     * @param std::string funct
+     * @return bool
+     */
+    bool pcall_top(int nargs, bool method=false, std::string funct="(callback)")
+    {
+      lock_guard_type lck(mutex_);
+      if((nargs < 0) || (stack().top() < nargs+(method ? 2 : 1))) throw engine_error("BUG: engine::pcall_top(): Not enough values on the stack.");
+      typename watchdog_type::scope limits(watchdog_, timeout_, instruction_budget_, deadline_);
+      exec_depth_guard depth(exec_depth_);
+      const bool ok = (method ? stack().pcall_method(nargs) : stack().pcall(nargs)) == 0;
+      if((!ok) && watchdog_.expired) throw_timeout(std::string("in ") + funct);
+      return ok;
+    }
+
+    /**
+     * Calls the function `funct` once for each element in the range `first`
+     * to `last`, and writes the (strict) return values to `out`. Elements
+     * can be `std::tuple`s (one function argument per tuple element) or
+     * single values. The engine is locked and the function is resolved
+     * only once, and all calls use the same stack frame. Errors of single
+     * calls do not abort the batch, they are appended to `errors`, and a
+     * default constructed value is written to `out`. Each call has the
+     * engine default execution limits, exceeding them throws a
+     * `duktape::timeout_error`. The job hook is invoked after the batch.
+     * @param std::string funct
+     * @param InputIterator first
+     * @param InputIterator last
+     * @param OutputIterator out
+     * @param std::vector<batch_error>& errors
+     * @return OutputIterator
+     */
+    template <typename ReturnType, bool StrictReturn=false, typename InputIterator, typename OutputIterator>
+    OutputIterator call_batch(std::string funct, InputIterator first, InputIterator last, OutputIterator out, std::vector<batch_error>& errors)
+    {
+      static_assert(!std::is_void<ReturnType>::value, "call_batch() requires a return type, use call() for void functions.");
+      lock_guard_type lck(mutex_);
+      stack_guard_type sg(ctx(), true);
+      exec_depth_guard depth(exec_depth_);
+      stack().require_stack(4);
+      if(!stack().select(funct)) {
+        throw script_error(std::string("'") + funct + "' not defined");
+      } else if(!stack().is_callable(-1)) {
+        throw script_error(std::string("'") + funct + "' is not callable");
+      }
+      const typename api_type::index_t fn = stack().top()-1;
+      for(size_t index = 0; first != last; ++first, ++index, ++out) {
+        typename watchdog_type::scope limits(watchdog_, timeout_, instruction_budget_, deadline_);
+        stack().dup(fn);
+        const int nargs = push_call_args(*first);
+        bool ok;
+        try {
+          ok = (stack().pcall(nargs) == 0);
+        } catch(const exit_exception&) {
+          stack().gc();
+          throw;
+        }
+        if(!ok) {
+          if(watchdog_.expired) throw_timeout(std::string("calling '") + funct + "' (batch index " + std::to_string(index) + ")");
+          batch_error e{index, std::string(), std::string()};
+          stack().dup_top();
+          e.message = stack().safe_to_string(-1);
+          stack().pop();
+          if(stack().is_object(-1) && stack().get_prop_string(-1, "stack") && !stack().is_undefined(-1)) {
+            e.callstack = stack().to_string(-1);
+          }
+          errors.push_back(std::move(e));
+          *out = ReturnType();
+        } else if(!StrictReturn) {
+          *out = conv<ReturnType>::to(ctx(), -1);
+        } else if(!conv<ReturnType>::is(ctx(), -1)) {
+          errors.push_back(batch_error{index,
+            std::string("Called '") + funct + "' with expected return type '" +
+            conv<ReturnType>::ecma_name() + "' (--> '" + conv<ReturnType>::cc_name() + "'), " +
+            " but '" + stack().get_typename(-1) + "' was returned.", std::string()
+          });
+          *out = ReturnType();
+        } else {
+          *out = conv<ReturnType>::get(ctx(), -1);
+        }
+        stack().top(fn+1);
+      }
+      run_jobs();
+      return out;
+    }
+
+    /**
+     * Calls the function `funct` once for each argument set in `args` (tuples
+     * or single values), returns the (strict) return values in the same
+     * order. See the iterator version for details.
+     * @param std::string funct
+     * @param const std::vector<ArgsType>& args
+     * @param std::vector<batch_error>& errors
+     * @return std::vector<ReturnType>
+     */
+    template <typename ReturnType, bool StrictReturn=false, typename ArgsType>
+    std::vector<ReturnType> call_batch(std::string funct, const std::vector<ArgsType>& args, std::vector<batch_error>& errors)
+    {
+      std::vector<ReturnType> results(args.size());
+      call_batch<ReturnType, StrictReturn>(std::move(funct), args.begin(), args.end(), results.begin(), errors);
+      return results;
+    }
+    // </editor-fold>
+
+  private:
+
+    // <editor-fold desc="private call auxiliaries" defaultstate="collapsed">
+    /**
+     * Counts the nesting of eval()/call() for the job hook.
+     */
+    struct exec_depth_guard
+    {
+      explicit exec_depth_guard(unsigned& depth) noexcept : depth_(depth) { ++depth_; }
+      ~exec_depth_guard() noexcept { --depth_; }
+      exec_depth_guard(const exec_depth_guard&) = delete;
+      exec_depth_guard& operator=(const exec_depth_guard&) = delete;
+      unsigned& depth_;
+    };
+
+    /**
+     * Pushes the elements of a `std::tuple` or a single value as function
+     * arguments, returns the number of arguments.
+     */
+    template <size_t I=0, typename ...Args>
+    typename std::enable_if<(I == sizeof...(Args)), int>::type push_call_args(const std::tuple<Args...>&)
+    { return int(I); }
+
+    template <size_t I=0, typename ...Args>
+    typename std::enable_if<(I < sizeof...(Args)), int>::type push_call_args(const std::tuple<Args...>& args)
+    {
+      if(I == 0) stack().require_stack(int(sizeof...(Args)));
+      stack().push(std::get<I>(args));
+      return push_call_args<I+1, Args...>(args);
+    }
+
+    template <typename T>
+    int push_call_args(const T& arg)
+    { stack().require_stack(1); stack().push(arg); return 1; }
+
+    /**
+     * Invokes the job hook after the outermost eval()/call(), the result
+     * on the stack top is preserved.
+     */
+    void run_jobs()
+    {
+      if((exec_depth_ != 1) || (!job_hook_)) return;
+      stack_guard_type sg(ctx());
+      job_hook_(*this);
+    }
+
+    /**
+     * Invokes `duk_pcall()` for the function and arguments on the stack
+     * top, converts the result or throws the corresponding exception.
+     * @param stack_guard_type& sg
+     * @param int nargs
+     * @param const std::string& funct
+     * @return typename ReturnType
+     */
+    template <typename ReturnType, bool StrictReturn>
+    ReturnType pcall_function(stack_guard_type& sg, int nargs, const std::string& funct)
+    {
       bool ok = false;
       try {
-        ok = (stack().pcall(sizeof...(Args)) == 0);
+        ok = (stack().pcall(nargs) == 0);
       } catch(const exit_exception& e) {
         stack().gc(); // to invoke already possible finalisations before next call stack frame.
         throw e;
       }
       if(!ok) {
-        if(stack().top() > 0) {
+        if(watchdog_.expired) {
+          throw_timeout(std::string("calling '") + funct + "'");
+        } else if(stack().top() > 0) {
           // The stack top index is the error
           stack().swap_top(sg.initial_top());
           sg.initial_top(sg.initial_top()+1);
@@ -2228,7 +3962,9 @@ namespace duktape { namespace detail {
         } else {
           throw script_error(std::string("Unspecified exception calling function '") + funct + "");
         }
-      } else if(std::is_void<ReturnType>::value) {
+      }
+      run_jobs();
+      if(std::is_void<ReturnType>::value) {
         return ReturnType();
       } else if(!StrictReturn) {
         return conv<ReturnType>::to(ctx(), -1);
@@ -2245,6 +3981,8 @@ namespace duktape { namespace detail {
     }
     // </editor-fold>
 
+  public:
+
     // <editor-fold desc="define/undef" defaultstate="collapsed">
 
     /**
@@ -2444,6 +4182,20 @@ namespace duktape { namespace detail {
   private:
 
     // <editor-fold desc="private auxiliary methods/functions" defaultstate="collapsed">
+    /**
+     * Throws the `timeout_error` corresponding to the expired limit.
+     *
+     * @param std::string where
+     */
+    [[noreturn]] void throw_timeout(std::string where)
+    {
+      if(watchdog_.expired == watchdog_type::budget_expired) {
+        throw timeout_error(std::string("Instruction budget exceeded ") + where);
+      } else {
+        throw timeout_error(std::string("Execution timeout ") + where);
+      }
+    }
+
     /**
      * Recursively defines empty parent objects of the given (canonical) name
      * and returns the object key (which is the last part of the given name).
@@ -2516,6 +4268,12 @@ namespace duktape { namespace detail {
     api_type stack_;
     typename defflags::type define_flags_;
     MutexType mutex_;
+    watchdog_type watchdog_;
+    duration_type timeout_;
+    time_point_type deadline_;
+    uint64_t instruction_budget_;
+    job_hook_type job_hook_;
+    unsigned exec_depth_;
     // </editor-fold>
   };
 }}
@@ -0,0 +1,946 @@
+/**
+ * @file duktape/mod/mod.coroutine.hh
+ * @package de.atwillys.cc.duktape
+ * @license MIT
+ * @authors Stefan Wilhelm (stfwi, <cerbero s@atwillys.de>)
+ * @platform linux, bsd, windows
+ * @standard >= c++11
+ * @requires duk_config.h duktape.h duktape.c >= v2.1
+ * @requires Duktape CFLAGS -DDUK_USE_CPP_EXCEPTIONS
+ * @cxxflags -std=c++11 -W -Wall -Wextra -pedantic -fstrict-aliasing
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Duktape ECMA engine C++ wrapper, coroutine scheduler module.
+ *
+ * Runs script functions as cooperative coroutines on Duktape threads
+ * (`coroutine.spawn()`). Blocking operations like `await_read()` and
+ * `await_exec()` suspend the calling coroutine, register the file
+ * descriptors in the event loop (`mod.eventloop.hh`), and other ready
+ * coroutines continue. The coroutine is resumed with the result when
+ * its descriptors are ready, so that scripts can be written sequentially:
+ *
+ *    coroutine.spawn(function() {
+ *      var r = await_exec("make", ["all"]);
+ *      print(r.exitcode);
+ *    });
+ *
+ * Duktape restrictions: Coroutines can only be suspended if no native
+ * function is between the coroutine function and the await call (e.g.
+ * not inside an `Array.prototype.forEach()` callback). The scheduler
+ * runs in the event loop, `duktape::mod::eventloop::run_loop(js)`.
+ * (Windows: no `await_read()` on pipes, no `await_exec()`).
+ *
+ * -----------------------------------------------------------------------------
+ * License: http://opensource.org/licenses/MIT
+ * Copyright (c) 2014-2017, the authors (see the @authors tag in this file).
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions: The above copyright notice and
+ * this permission notice shall be included in all copies or substantial portions
+ * of the Software. THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef DUKTAPE_MOD_COROUTINE_HH
+#define DUKTAPE_MOD_COROUTINE_HH
+
+// <editor-fold desc="preprocessor" defaultstate="collapsed">
+#include "../duktape.hh"
+#include "mod.eventloop.hh"
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <cerrno>
+#include <cstring>
+#if !defined(WINDOWS)
+  #include "mod.sys.exec.hh"
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <signal.h>
+  #include <algorithm>
+#endif
+// </editor-fold>
+
+namespace duktape { namespace detail { namespace coroutine {
+
+  // <editor-fold desc="scheduler state" defaultstate="collapsed">
+  using index_t = ::duktape::api::index_t;
+  using loop_type = ::duktape::detail::eventloop::eventloop;
+  using id_type = uint32_t;
+
+  /**
+   * Pending `await_exec()` of a coroutine.
+   */
+  struct exec_state
+  {
+    int pid = -1;
+    int ifd = -1, ofd = -1, efd = -1;
+    int pfd = -1;                               // Readable on exit of the child, see child_exit_fd().
+    unsigned poll_ms = 1;                       // Fallback termination poll interval.
+    std::string in, out, err;
+    size_t in_pos = 0;
+  };
+
+  /**
+   * Native scheduler state of one engine. The coroutine records
+   * `[thread, task, resume_value, is_error, joiners]` are stored
+   * by id in the "records" object of the hidden heap stash object "coroutine".
+   */
+  struct scheduler_state
+  {
+    id_type next_id = 0;
+    id_type current = 0;                        // Running coroutine, 0: none.
+    bool waiting = false;                       // The current coroutine registered a wait.
+    bool run_scheduled = false;                 // Immediate for run_ready() is pending.
+    size_t count = 0;                           // Number of unfinished coroutines.
+    std::deque<id_type> ready;
+    std::unordered_set<int> fds;                // Descriptors watched for coroutines.
+    std::unordered_map<id_type, exec_state> execs;
+
+    ~scheduler_state() noexcept
+    {
+      #if !defined(WINDOWS)
+      for(auto& e: execs) {
+        for(int fd: {e.second.ifd, e.second.ofd, e.second.efd, e.second.pfd}) { if(fd >= 0) ::close(fd); }
+        if(e.second.pid > 0) {
+          ::duktape::detail::system::exec::kill_child(::pid_t(e.second.pid), SIGKILL);
+          while((::duktape::detail::system::exec::wait_child(::pid_t(e.second.pid), nullptr, 0) < 0) && (errno == EINTR));
+        }
+      }
+      #endif
+    }
+  };
+
+  template <typename=void>
+  scheduler_state* get_scheduler(duktape::api& stack)
+  {
+    scheduler_state* sched = nullptr;
+    stack_guard sg(stack);
+    stack.push_heap_stash();
+    if(stack.get_prop_string_hidden(-1, "coroutine") && stack.is_object(-1) && stack.get_prop_string_hidden(-1, "scheduler")) {
+      sched = reinterpret_cast<scheduler_state*>(stack.get_pointer(-1));
+    }
+    return sched;
+  }
+
+  template <typename=void>
+  duk_ret_t scheduler_finalizer(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    if(stack.get_prop_string_hidden(0, "scheduler")) {
+      scheduler_state* sched = reinterpret_cast<scheduler_state*>(stack.get_pointer(-1));
+      stack.pop();
+      stack.push_pointer(nullptr);
+      stack.put_prop_string(0, "\xff_scheduler");
+      delete sched;
+    }
+    return 0;
+  }
+
+  /**
+   * Pushes the value stored with `key` in the hidden "coroutine" stash object.
+   */
+  template <typename=void>
+  void push_stash_value(duktape::api& stack, const char* key)
+  {
+    stack.push_heap_stash();
+    stack.get_prop_string_hidden(-1, "coroutine");
+    stack.get_prop_string_hidden(-1, key);
+    stack.remove(-2);
+    stack.remove(-2);
+  }
+
+  /**
+   * Returns the scheduler, throws if not called from a coroutine.
+   */
+  template <typename=void>
+  scheduler_state& require_current(duktape::api& stack, const char* fname)
+  {
+    scheduler_state* sched = get_scheduler(stack);
+    if(!sched || !sched->current) {
+      stack.throw_exception(std::string(fname) + "(): Only allowed inside a coroutine (see coroutine.spawn()).");
+    }
+    return *sched;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="scheduling" defaultstate="collapsed">
+  template <typename=void> duk_ret_t run_ready(duk_context *ctx);
+
+  /**
+   * Stores a native event loop callback `fn(arg)` with the id of a timer
+   * or immediate in the callback store of the event loop module.
+   */
+  template <typename=void>
+  void set_loop_callback(duktape::api& stack, loop_type::id_type id, duk_c_function fn, double arg)
+  {
+    stack.require_stack(4);
+    ::duktape::detail::eventloop::push_callbacks(stack);
+    stack.push_array();
+    stack.push_c_function(fn, 1);
+    stack.put_prop_index(-2, 0);
+    stack.push(arg);
+    stack.put_prop_index(-2, 1);
+    stack.put_prop_index(-2, id);
+    stack.pop();
+  }
+
+  /**
+   * Schedules run_ready() as immediate of the event loop, if not yet done.
+   */
+  template <typename=void>
+  void schedule_run(duktape::api& stack, scheduler_state& sched)
+  {
+    if(sched.run_scheduled) return;
+    loop_type* loop = ::duktape::detail::eventloop::get_loop(stack);
+    if(!loop) return;
+    set_loop_callback(stack, loop->set_immediate(), run_ready<>, 0);
+    sched.run_scheduled = true;
+  }
+
+  /**
+   * Marks the coroutine `id` ready, it is resumed with the value at stack
+   * index `value` (thrown in the coroutine if `is_error`). Ignored if the
+   * coroutine does not exist (anymore).
+   */
+  template <typename=void>
+  void wake(duktape::api& stack, scheduler_state& sched, id_type id, index_t value, bool is_error=false)
+  {
+    value = stack.normalize_index(value);
+    stack.require_stack(3);
+    push_stash_value(stack, "records");
+    stack.get_prop_index(-1, id);
+    if(stack.is_array(-1)) {
+      stack.dup(value);
+      stack.put_prop_index(-2, 2);
+      stack.push(is_error);
+      stack.put_prop_index(-2, 3);
+      sched.ready.push_back(id);
+      if(id == sched.current) sched.waiting = true;
+      schedule_run(stack, sched);
+    }
+    stack.pop(2);
+  }
+
+  /**
+   * Wakes the coroutine `id` with a new `Error` object.
+   */
+  template <typename=void>
+  void wake_error(duktape::api& stack, scheduler_state& sched, id_type id, const std::string& message)
+  {
+    ::duk_push_error_object(stack.ctx(), DUK_ERR_ERROR, "%s", message.c_str());
+    wake(stack, sched, id, -1, true);
+    stack.pop();
+  }
+
+  /**
+   * Resumes the coroutine `id` via the ECMAScript trampoline (Duktape
+   * requires an ECMAScript caller for `Duktape.Thread.resume()`).
+   * Finished coroutines wake their joiners. Errors of coroutines without
+   * joiners are thrown (passed to the event loop). If the resume itself
+   * fails (e.g. engine timeout), the coroutine thread is dead: it is
+   * finished as failed, and the error is thrown in any case.
+   */
+  template <typename=void>
+  void resume(duktape::api& stack, scheduler_state& sched, id_type id)
+  {
+    const index_t top = stack.top();
+    stack.require_stack(10);
+    push_stash_value(stack, "records");
+    const index_t records = top;
+    stack.get_prop_index(records, id);
+    const index_t record = top+1;
+    if(!stack.is_array(record)) { stack.top(top); return; }
+    push_stash_value(stack, "resume");
+    stack.get_prop_index(record, 0);
+    stack.get_prop_index(record, 2);
+    stack.get_prop_index(record, 3);
+    stack.push_undefined();
+    stack.put_prop_index(record, 2);
+    sched.current = id;
+    sched.waiting = false;
+    const bool ok = (stack.pcall(3) == 0);
+    sched.current = 0;
+    const index_t outcome = top+2;
+    stack.get_prop_index(record, 1);
+    const index_t task = top+3;
+    if(ok) {
+      stack.get_prop_string(task, "done");
+      const bool done = stack.get<bool>(-1);
+      stack.pop();
+      if(!done) {
+        if(!sched.waiting) {
+          sched.ready.push_back(id); // coroutine.yield()
+          schedule_run(stack, sched);
+        }
+        stack.top(top);
+        return;
+      }
+    } else {
+      stack.dup(outcome);
+      stack.put_prop_string(task, "error");
+      stack.push(true);
+      stack.put_prop_string(task, "failed");
+      stack.push(true);
+      stack.put_prop_string(task, "done");
+    }
+    stack.del_prop_index(records, id);
+    if(sched.count > 0) --sched.count;
+    stack.get_prop_string(task, "failed");
+    const bool failed = stack.get<bool>(-1);
+    stack.pop();
+    stack.get_prop_string(task, failed ? "error" : "result");
+    const index_t result = stack.top()-1;
+    stack.get_prop_index(record, 4);
+    const size_t njoiners = stack.get_length(-1);
+    for(size_t i=0; i<njoiners; ++i) {
+      stack.get_prop_index(-1, duk_uarridx_t(i));
+      const id_type joiner = stack.get<id_type>(-1);
+      stack.pop();
+      wake(stack, sched, joiner, result, failed);
+    }
+    if((!ok) || (failed && !njoiners)) {
+      if(!sched.ready.empty()) schedule_run(stack, sched);
+      stack.dup(result);
+      stack.throw_exception();
+      return;
+    }
+    stack.top(top);
+  }
+
+  /**
+   * Event loop callback: resumes the coroutines ready until now.
+   */
+  template <typename>
+  duk_ret_t run_ready(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    scheduler_state* sched = get_scheduler(stack);
+    if(!sched) return 0;
+    sched->run_scheduled = false;
+    for(size_t n = sched->ready.size(); (n > 0) && (!sched->ready.empty()); --n) {
+      const id_type id = sched->ready.front();
+      sched->ready.pop_front();
+      resume(stack, *sched, id);
+    }
+    return 0;
+  }
+
+  /**
+   * Event loop callback: wakes the coroutine given as argument.
+   */
+  template <typename=void>
+  duk_ret_t timer_wake(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    scheduler_state* sched = get_scheduler(stack);
+    if(!sched) return 0;
+    stack.push_undefined();
+    wake(stack, *sched, stack.get<id_type>(0), -1);
+    return 0;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="fd reading" defaultstate="collapsed">
+  /**
+   * Reads once from `fd` and wakes the coroutine with the data, with
+   * `undefined` at EOF, or with an error.
+   */
+  template <typename=void>
+  void read_and_wake(duktape::api& stack, scheduler_state& sched, id_type id, int fd, size_t max_size)
+  {
+    #if defined(WINDOWS)
+    (void)fd; (void)max_size;
+    wake_error(stack, sched, id, "await_read(): Not supported on this platform.");
+    #else
+    std::string data(max_size, '\0');
+    ssize_t n;
+    while(((n=::read(fd, &data[0], max_size)) < 0) && (errno == EINTR));
+    if(n < 0) {
+      wake_error(stack, sched, id, std::string("await_read(): ") + ::strerror(errno));
+    } else if(n == 0) {
+      stack.push_undefined();
+      wake(stack, sched, id, -1);
+      stack.pop();
+    } else {
+      data.resize(size_t(n));
+      stack.push(data);
+      wake(stack, sched, id, -1);
+      stack.pop();
+    }
+    #endif
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="exec" defaultstate="collapsed">
+  #if !defined(WINDOWS)
+  template <typename=void> void exec_io(duktape::engine& js, id_type id, int fd, unsigned events);
+
+  /**
+   * Event loop callback: checks again if the exec child has terminated.
+   */
+  template <typename=void>
+  duk_ret_t exec_timer(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    exec_io(stack.parent_engine(), stack.get<id_type>(0), -1, 0);
+    return 0;
+  }
+
+  /**
+   * Transfers the available stdio data of the pending exec of the coroutine
+   * `id` (`events` of descriptor `fd`, or none). When the output pipes are
+   * closed and the child has terminated, the coroutine is woken with the
+   * result object. The termination is notified via a descriptor (see
+   * `sys.exec` child_exit_fd()) where supported, otherwise polled with an increasing timer interval
+   * (1ms doubled up to 100ms).
+   */
+  template <typename>
+  void exec_io(duktape::engine& js, id_type id, int fd, unsigned events)
+  {
+    duktape::api& stack = js.stack();
+    scheduler_state* sched = get_scheduler(stack);
+    loop_type* loop = ::duktape::detail::eventloop::get_loop(stack);
+    if(!sched || !loop) return;
+    auto it = sched->execs.find(id);
+    if(it == sched->execs.end()) return;
+    exec_state& x = it->second;
+    const auto close_fd = [&](int& f) {
+      loop->unwatch(f);
+      sched->fds.erase(f);
+      ::close(f);
+      f = -1;
+    };
+    if(fd == x.ifd) {
+      while(x.in_pos < x.in.size()) {
+        ssize_t n;
+        while(((n=::duktape::detail::system::exec::write_nosigpipe(x.ifd, x.in.data()+x.in_pos, x.in.size()-x.in_pos)) < 0) && (errno == EINTR));
+        if(n <= 0) break;
+        x.in_pos += size_t(n);
+      }
+      if((x.in_pos >= x.in.size()) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)) || (events & loop_type::error)) {
+        close_fd(x.ifd);
+      }
+    } else if((fd == x.ofd) || (fd == x.efd)) {
+      std::string& buffer = (fd == x.ofd) ? x.out : x.err;
+      char buf[4096];
+      ssize_t n;
+      for(;;) {
+        while(((n=::read(fd, buf, sizeof(buf))) < 0) && (errno == EINTR));
+        if(n <= 0) break;
+        buffer.append(buf, size_t(n));
+      }
+      if((n == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+        close_fd((fd == x.ofd) ? x.ofd : x.efd);
+      }
+    }
+    if((x.ofd >= 0) || (x.efd >= 0)) return;
+    if(x.ifd >= 0) close_fd(x.ifd);
+    int status = 0;
+    ::pid_t r;
+    while(((r=::duktape::detail::system::exec::wait_child(::pid_t(x.pid), &status, WNOHANG)) < 0) && (errno == EINTR));
+    if(r == 0) {
+      if(x.pfd >= 0) return; // Still watched, not yet exited.
+      const int pfd = ::duktape::detail::system::exec::child_exit_fd(::pid_t(x.pid));
+      if(pfd >= 0) {
+        x.pfd = pfd;
+        loop->watch(pfd, loop_type::readable, [&js, id](int f, unsigned e) { exec_io(js, id, f, e); });
+        sched->fds.insert(pfd);
+        return;
+      }
+      set_loop_callback(stack, loop->set_timer(loop_type::tick_type(x.poll_ms), false), exec_timer<>, double(id));
+      x.poll_ms = std::min(x.poll_ms * 2u, 100u);
+      return;
+    }
+    if(x.pfd >= 0) close_fd(x.pfd);
+    const int exit_code = (r < 0) ? -1 : (WIFSIGNALED(status) ? (128+WTERMSIG(status)) : WEXITSTATUS(status));
+    stack_guard sg(stack);
+    stack.push_object();
+    stack.push(exit_code);
+    stack.put_prop_string(-2, "exitcode");
+    stack.push(x.out);
+    stack.put_prop_string(-2, "stdout");
+    stack.push(x.err);
+    stack.put_prop_string(-2, "stderr");
+    sched->execs.erase(it);
+    wake(stack, *sched, id, -1);
+  }
+  #endif
+  // </editor-fold>
+
+  // <editor-fold desc="native await functions" defaultstate="collapsed">
+  /**
+   * The native parts of the await functions register the wait of the
+   * current coroutine (or wake it immediately). The script wrappers then
+   * yield, the resume value is returned (or thrown) by the wrapper.
+   */
+  template <typename=void>
+  duk_ret_t native_yield(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    require_current(stack, "coroutine.yield");
+    return 0;
+  }
+
+  template <typename=void>
+  duk_ret_t native_sleep(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    scheduler_state& sched = require_current(stack, "coroutine.sleep");
+    loop_type* loop = ::duktape::detail::eventloop::get_loop(stack);
+    double ms = stack.is_number(0) ? stack.get<double>(0) : 0;
+    if(!(ms >= 0)) ms = 0;
+    if(ms > double(std::numeric_limits<int32_t>::max())) ms = double(std::numeric_limits<int32_t>::max());
+    set_loop_callback(stack, loop->set_timer(loop_type::tick_type(ms), false), timer_wake<>, double(sched.current));
+    sched.waiting = true;
+    return 0;
+  }
+
+  template <typename=void>
+  duk_ret_t native_join(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    scheduler_state& sched = require_current(stack, "coroutine.join");
+    if(!stack.is_object(0) || !stack.get_prop_string(0, "id") || !stack.is_number(-1)) {
+      return stack.throw_exception("coroutine.join(): Argument is no coroutine task object.");
+    }
+    const id_type id = stack.get<id_type>(-1);
+    if(id == sched.current) return stack.throw_exception("coroutine.join(): A coroutine cannot join itself.");
+    if(stack.get_prop_string(0, "done") && stack.get<bool>(-1)) {
+      stack.get_prop_string(0, "failed");
+      const bool failed = stack.get<bool>(-1);
+      stack.get_prop_string(0, failed ? "error" : "result");
+      wake(stack, sched, sched.current, -1, failed);
+      return 0;
+    }
+    push_stash_value(stack, "records");
+    stack.get_prop_index(-1, id);
+    if(!stack.is_array(-1)) return stack.throw_exception("coroutine.join(): Unknown coroutine.");
+    stack.get_prop_index(-1, 4);
+    stack.push(double(sched.current));
+    stack.put_prop_index(-2, duk_uarridx_t(stack.get_length(-2)));
+    sched.waiting = true;
+    return 0;
+  }
+
+  template <typename=void>
+  duk_ret_t native_read(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    scheduler_state& sched = require_current(stack, "await_read");
+    const id_type id = sched.current;
+    int fd = -1;
+    if(stack.is_number(0)) {
+      fd = stack.get<int>(0);
+    } else if(stack.is_object(0) && stack.get_prop_string_hidden(0, "fd") && stack.is_number(-1)) {
+      fd = stack.get<int>(-1); // fs.file
+    } else if(stack.is_object(0) && stack.get_prop_string_hidden(0, "ofd") && stack.is_number(-1)) {
+      fd = stack.get<int>(-1); // sys.spawn() process stdout
+      ::duktape::detail::system::exec::process_output* output = ::duktape::detail::system::exec::get_process_output(stack, 0);
+      if(output && !output->out.empty()) {
+        stack.push(output->out);
+        output->out.clear();
+        wake(stack, sched, id, -1);
+        return 0;
+      }
+      if(fd < 0) {
+        stack.push_undefined();
+        wake(stack, sched, id, -1);
+        return 0;
+      }
+    } else {
+      return stack.throw_exception("await_read(): First argument must be a file descriptor, fs.file or sys.spawn() process.");
+    }
+    if(fd < 0) return stack.throw_exception("await_read(): File is not opened.");
+    const double max_size = stack.is_number(1) ? stack.get<double>(1) : 65536.0;
+    if(!(max_size >= 1) || (max_size > double(1u<<30))) return stack.throw_exception("await_read(): Invalid maximum size.");
+    #if defined(WINDOWS)
+    read_and_wake(stack, sched, id, fd, size_t(max_size));
+    #else
+    struct ::stat st;
+    if((::fstat(fd, &st) != 0) || S_ISREG(st.st_mode) || S_ISDIR(st.st_mode)) {
+      read_and_wake(stack, sched, id, fd, size_t(max_size)); // Never blocks (or fails immediately).
+      return 0;
+    }
+    if(sched.fds.count(fd)) return stack.throw_exception("await_read(): The descriptor is already awaited by another coroutine.");
+    duktape::engine& js = stack.parent_engine();
+    loop_type* loop = ::duktape::detail::eventloop::get_loop(stack);
+    loop->watch(fd, loop_type::readable, [&js, id, max_size](int fd, unsigned) {
+      duktape::api& stack = js.stack();
+      scheduler_state* sched = get_scheduler(stack);
+      ::duktape::detail::eventloop::get_loop(stack)->unwatch(fd);
+      if(!sched) return;
+      sched->fds.erase(fd);
+      stack_guard sg(stack);
+      read_and_wake(stack, *sched, id, fd, size_t(max_size));
+    });
+    sched.fds.insert(fd);
+    sched.waiting = true;
+    #endif
+    return 0;
+  }
+
+  template <typename=void>
+  duk_ret_t native_exec(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    scheduler_state& sched = require_current(stack, "await_exec");
+    #if defined(WINDOWS)
+    return stack.throw_exception("await_exec(): Not supported on this platform.");
+    #else
+    std::string program, stdin_file_data;
+    std::vector<std::string> arguments;
+    ::duktape::detail::system::exec::process_options popts;
+    ::duktape::detail::system::exec::stdin_source stdin_data;
+    ::duktape::detail::system::exec::fd_guard stdin_file;
+    exec_state x;
+    // <editor-fold desc="arguments" defaultstate="collapsed">
+    {
+      index_t optindex = -1;
+      if(!stack.is<std::string>(0) || stack.get<std::string>(0).empty()) {
+        return stack.throw_exception("await_exec(): First argument must be the program to execute (non-empty string).");
+      }
+      program = stack.get<std::string>(0);
+      if(stack.is_array(1)) {
+        arguments = stack.req<std::vector<std::string>>(1);
+        if(stack.is_object(2)) optindex = 2;
+      } else if(stack.is_object(1) && !stack.is_function(1)) {
+        optindex = 1;
+      } else if((stack.top() > 1) && !stack.is_undefined(1)) {
+        return stack.throw_exception("await_exec(): Program arguments must be passed as array (2nd argument invalid)");
+      }
+      for(auto& e:arguments) {
+        if(e.find('\0') != e.npos) return stack.throw_exception("await_exec(): Argument contains a null character.");
+      }
+      if(optindex >= 0) {
+        std::string err = ::duktape::detail::system::exec::get_process_options(stack, optindex, popts);
+        if(err.empty()) {
+          stack.get_prop_string(optindex, "stdin");
+          err = ::duktape::detail::system::exec::get_stdin_source(stack, -1, stdin_data, stdin_file.fd, stdin_file_data);
+          if(stdin_data.data && stdin_data.size) x.in.assign(stdin_data.data, stdin_data.size);
+          stack.pop();
+        }
+        if(!err.empty()) return stack.throw_exception(std::string("await_exec(): ") + err);
+      }
+    }
+    // </editor-fold>
+    int pi[2] = {-1,-1}, po[2] = {-1,-1}, pe[2] = {-1,-1};
+    const auto close_all = [&]() {
+      for(auto fd:{pi[0],pi[1],po[0],po[1],pe[0],pe[1]}) { if(fd >= 0) ::close(fd); }
+    };
+    if((!x.in.empty() && ::pipe(pi)) || ::pipe(po) || ::pipe(pe)) {
+      const int err = errno;
+      close_all();
+      return stack.throw_exception(std::string("await_exec(): Failed to create pipes: ") + ::strerror(err));
+    }
+    try {
+      x.pid = int(::duktape::detail::system::exec::fork_exec(program, arguments, popts.environment, popts.without_path_search, popts.noenv, (stdin_data.fd >= 0) ? stdin_data.fd : pi[0], po[1], pe[1]));
+    } catch(const std::exception& e) {
+      close_all();
+      return stack.throw_exception(std::string("await_exec(): ") + e.what());
+    }
+    for(auto fd:{pi[0],po[1],pe[1]}) { if(fd >= 0) ::close(fd); }
+    for(auto fd:{pi[1],po[0],pe[0]}) {
+      int o;
+      if((fd >= 0) && ((o=::fcntl(fd, F_GETFL, 0)) >= 0)) ::fcntl(fd, F_SETFL, o|O_NONBLOCK);
+      if(fd >= 0) ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    x.ifd = pi[1];
+    x.ofd = po[0];
+    x.efd = pe[0];
+    const id_type id = sched.current;
+    duktape::engine& js = stack.parent_engine();
+    loop_type* loop = ::duktape::detail::eventloop::get_loop(stack);
+    sched.execs[id] = std::move(x);
+    const exec_state& s = sched.execs[id];
+    const auto on_io = [&js, id](int fd, unsigned events) { exec_io(js, id, fd, events); };
+    if(s.ifd >= 0) { loop->watch(s.ifd, loop_type::writable, on_io); sched.fds.insert(s.ifd); }
+    loop->watch(s.ofd, loop_type::readable, on_io);
+    sched.fds.insert(s.ofd);
+    loop->watch(s.efd, loop_type::readable, on_io);
+    sched.fds.insert(s.efd);
+    sched.waiting = true;
+    return 0;
+    #endif
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="js functions" defaultstate="collapsed">
+  #if(0 && JSDOC)
+  /**
+   * Creates a coroutine, which calls `fn` with the optional arguments in
+   * the event loop. Returns the task object, which is updated when the
+   * coroutine has finished:
+   *
+   *    {
+   *      id      : {number}  Coroutine id.
+   *      done    : {boolean} True when finished.
+   *      failed  : {boolean} True if `fn` has thrown.
+   *      result  : {any}     Return value of `fn`.
+   *      error   : {any}     Exception thrown by `fn`.
+   *    }
+   *
+   * Exceptions of coroutines which are not joined are passed to the
+   * event loop (like exceptions in timer callbacks).
+   *
+   * @throws {Error}
+   * @param {function} fn
+   * @param {...*} [args]
+   * @returns {object}
+   */
+  coroutine.spawn = function(fn, args) {};
+  #endif
+  template <typename=void>
+  int spawn(duktape::api& stack)
+  {
+    scheduler_state* sched = get_scheduler(stack);
+    if(!sched) return stack.throw_exception("coroutine.spawn(): Coroutine module not available.");
+    if(!stack.is_callable(0)) return stack.throw_exception("coroutine.spawn(): First argument must be a function.");
+    const index_t nargs = stack.top();
+    stack.require_stack(8);
+    do { if(++sched->next_id >= std::numeric_limits<id_type>::max()) sched->next_id = 1; } while(!sched->next_id);
+    const id_type id = sched->next_id;
+    // Task object
+    stack.push_object();
+    const index_t task = nargs;
+    stack.push(double(id));
+    stack.put_prop_string(task, "id");
+    stack.push(false);
+    stack.put_prop_string(task, "done");
+    stack.push(false);
+    stack.put_prop_string(task, "failed");
+    // Record [thread, task, [fn, args, task], false, joiners]
+    stack.push_array();
+    const index_t record = nargs+1;
+    const index_t thread = stack.push_thread();
+    push_stash_value(stack, "entry");
+    ::duk_xmove_top(stack.get_context(thread), stack.ctx(), 1);
+    stack.put_prop_index(record, 0);
+    stack.dup(task);
+    stack.put_prop_index(record, 1);
+    stack.push_array();
+    stack.dup(0);
+    stack.put_prop_index(-2, 0);
+    stack.push_array();
+    for(index_t i=1; i<nargs; ++i) {
+      stack.dup(i);
+      stack.put_prop_index(-2, duk_uarridx_t(i-1));
+    }
+    stack.put_prop_index(-2, 1);
+    stack.dup(task);
+    stack.put_prop_index(-2, 2);
+    stack.put_prop_index(record, 2);
+    stack.push(false);
+    stack.put_prop_index(record, 3);
+    stack.push_array();
+    stack.put_prop_index(record, 4);
+    push_stash_value(stack, "records");
+    stack.dup(record);
+    stack.put_prop_index(-2, id);
+    stack.top(task+1);
+    ++sched->count;
+    sched->ready.push_back(id);
+    schedule_run(stack, *sched);
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Returns the task object of the running coroutine, `undefined` if
+   * not called inside a coroutine.
+   *
+   * @returns {object|undefined}
+   */
+  coroutine.current = function() {};
+  #endif
+  template <typename=void>
+  int current(duktape::api& stack)
+  {
+    scheduler_state* sched = get_scheduler(stack);
+    if(!sched || !sched->current) return 0;
+    push_stash_value(stack, "records");
+    stack.get_prop_index(-1, sched->current);
+    stack.get_prop_index(-1, 1);
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Suspends the running coroutine, other ready coroutines and event loop
+   * callbacks run before it continues.
+   *
+   * @throws {Error}
+   */
+  coroutine.yield = function() {};
+
+  /**
+   * Suspends the running coroutine for `ms` milliseconds.
+   *
+   * @throws {Error}
+   * @param {number} ms
+   */
+  coroutine.sleep = function(ms) {};
+
+  /**
+   * Waits until the coroutine of the task object `task` (see `coroutine.spawn()`)
+   * has finished, returns its result or throws its exception.
+   *
+   * @throws {Error}
+   * @param {object} task
+   * @returns {any}
+   */
+  coroutine.join = function(task) {};
+
+  /**
+   * Suspends the running coroutine until data are available from `source`,
+   * returns the data (at most `max_size` bytes, default 64k) as string, or
+   * `undefined` at the end of the stream. The source is a file descriptor
+   * number, an `fs.file` object, or a `sys.spawn()` process object (stdout).
+   *
+   * @throws {Error}
+   * @param {number|fs.file|object} source
+   * @param {number} [max_size]
+   * @returns {string|undefined}
+   */
+  function await_read(source, max_size) {};
+
+  /**
+   * Executes a program like `sys.exec()`, but suspends only the running
+   * coroutine until the program has terminated. Returns an object with the
+   * properties `exitcode`, `stdout` and `stderr`. The options are
+   * `env`, `noenv`, `nopath` and `stdin` (string, buffer, `{file: path}`
+   * or an opened `fs.file`), see `sys.exec()`.
+   *
+   * @throws {Error}
+   * @param {string} program
+   * @param {array} [arguments]
+   * @param {object} [options]
+   * @returns {object}
+   */
+  function await_exec(program, arguments, options) {};
+  #endif
+  // </editor-fold>
+
+  // <editor-fold desc="script parts" defaultstate="collapsed">
+  /**
+   * Duktape allows `Duktape.Thread.resume()` only from ECMAScript functions,
+   * and `Duktape.Thread.yield()` only without native calls in between.
+   * These functions are compiled when the module is defined.
+   */
+  template <typename=void>
+  const char* entry_source() noexcept
+  {
+    return "function(job) {\n"
+           "  var task = job[2];\n"
+           "  try { task.result = job[0].apply(undefined, job[1]); }\n"
+           "  catch(e) { task.error = e; task.failed = true; }\n"
+           "  task.done = true;\n"
+           "}";
+  }
+
+  template <typename=void>
+  const char* resume_source() noexcept
+  { return "function(thread, value, is_error) { return Duktape.Thread.resume(thread, value, is_error); }"; }
+
+  template <typename=void>
+  const char* wrap_source() noexcept
+  {
+    return "function(native_fn) {\n"
+           "  var yield_ = Duktape.Thread.yield;\n"
+           "  return function() { native_fn.apply(undefined, arguments); return yield_(); };\n"
+           "}";
+  }
+  // </editor-fold>
+
+}}}
+
+namespace duktape { namespace mod { namespace coroutine {
+
+  // <editor-fold desc="js decls" defaultstate="collapsed">
+  /**
+   * Export main relay. Adds all module functions to the specified engine
+   * and creates the scheduler. Defines the event loop module if not yet
+   * done.
+   * @param duktape::engine& js
+   */
+  template <typename=void>
+  static void define_in(duktape::engine& js)
+  {
+    using namespace ::duktape::detail::coroutine;
+    duktape::api& stack = js.stack();
+    if(!::duktape::mod::eventloop::loop_of(stack)) ::duktape::mod::eventloop::define_in(js);
+    if(get_scheduler(stack)) return;
+    js.define("coroutine");
+    js.define("coroutine.spawn", spawn<>);
+    js.define("coroutine.current", current<>, 0);
+    {
+      stack_guard sg(stack);
+      stack.require_stack(8);
+      const duktape::api::index_t stash = stack.top();
+      stack.push_heap_stash();
+      stack.push_object();
+      const duktape::api::index_t holder = stash+1;
+      stack.push_pointer(new scheduler_state());
+      stack.put_prop_string(holder, "\xff_scheduler");
+      stack.push_c_function(scheduler_finalizer<>, 1);
+      stack.set_finalizer(holder);
+      stack.push_object();
+      stack.put_prop_string_hidden(holder, "records");
+      stack.compile_string(duktape::api::compile_function, entry_source());
+      stack.put_prop_string_hidden(holder, "entry");
+      stack.compile_string(duktape::api::compile_function, resume_source());
+      stack.put_prop_string_hidden(holder, "resume");
+      stack.dup(holder);
+      stack.put_prop_string_hidden(stash, "coroutine");
+      // Script wrappers of the native await functions.
+      stack.compile_string(duktape::api::compile_function, wrap_source());
+      const duktape::api::index_t wrap = stack.top()-1;
+      stack.get_global_string("coroutine");
+      const struct { const char* name; duk_c_function fn; int nargs; bool global; } awaits[] = {
+        {"yield", native_yield<>, 0, false},
+        {"sleep", native_sleep<>, 1, false},
+        {"join", native_join<>, 1, false},
+        {"await_read", native_read<>, 2, true},
+        {"await_exec", native_exec<>, 3, true}
+      };
+      for(const auto& e: awaits) {
+        stack.dup(wrap);
+        stack.push_c_function(e.fn, e.nargs);
+        stack.call(1);
+        if(e.global) {
+          stack.put_global_string(e.name);
+        } else {
+          stack.put_prop_string(-2, e.name);
+        }
+      }
+    }
+  }
+
+  /**
+   * Returns the number of unfinished coroutines of the engine.
+   * @param duktape::engine& js
+   * @return size_t
+   */
+  template <typename=void>
+  static size_t count(duktape::engine& js)
+  {
+    const auto* sched = ::duktape::detail::coroutine::get_scheduler(js.stack());
+    return sched ? sched->count : 0;
+  }
+  // </editor-fold>
+
+}}}
+
+#endif
@@ -0,0 +1,812 @@
+/**
+ * @file duktape/mod/mod.eventloop.hh
+ * @package de.atwillys.cc.duktape
+ * @license MIT
+ * @authors Stefan Wilhelm (stfwi, <cerbero s@atwillys.de>)
+ * @platform linux, bsd, windows
+ * @standard >= c++11
+ * @requires duk_config.h duktape.h duktape.c >= v2.1
+ * @requires Duktape CFLAGS -DDUK_USE_CPP_EXCEPTIONS
+ * @cxxflags -std=c++11 -W -Wall -Wextra -pedantic -fstrict-aliasing
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Duktape ECMA engine C++ wrapper, event loop module.
+ *
+ * Provides `setTimeout()`, `setInterval()`, `setImmediate()` and the
+ * corresponding clear functions. Pending timers are kept in a hierarchical
+ * timer wheel, the loop driver `duktape::mod::eventloop::run_loop(js)`
+ * sleeps in `epoll_wait()` (Linux) or `poll()` until the next timer is due
+ * or a watched file descriptor is ready. Other modules register their file
+ * descriptors with `duktape::mod::eventloop::loop_of(stack)->watch(...)`.
+ * (Windows: timers only, no file descriptor watching).
+ *
+ * -----------------------------------------------------------------------------
+ * License: http://opensource.org/licenses/MIT
+ * Copyright (c) 2014-2017, the authors (see the @authors tag in this file).
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions: The above copyright notice and
+ * this permission notice shall be included in all copies or substantial portions
+ * of the Software. THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef DUKTAPE_MOD_EVENTLOOP_HH
+#define DUKTAPE_MOD_EVENTLOOP_HH
+
+// <editor-fold desc="preprocessor" defaultstate="collapsed">
+#include "../duktape.hh"
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#if defined(__MINGW32__) || defined(__MINGW64__) || defined(_WIN32)
+  #ifndef WINDOWS
+    #define WINDOWS
+  #endif
+#elif defined(__linux__)
+  #include <sys/epoll.h>
+  #include <unistd.h>
+#else
+  #include <poll.h>
+#endif
+// </editor-fold>
+
+namespace duktape { namespace detail { namespace eventloop {
+
+  // <editor-fold desc="timer wheel" defaultstate="collapsed">
+  /**
+   * Hierarchical timer wheel. Level `l` has 64 slots spanning 64^l ticks
+   * each. Timers are placed in the lowest level covering their remaining
+   * time, and moved ("cascaded") to the lower levels when the current time
+   * reaches their slot. Insertion and removal are O(1), removed timers are
+   * dropped lazily when their slot is processed. Timers beyond the range
+   * of the top level are parked in its last slot and re-placed on cascade.
+   */
+  template <typename=void>
+  class basic_timer_wheel
+  {
+  public:
+
+    using id_type = uint64_t;
+    using tick_type = uint64_t;
+    static constexpr unsigned slot_bits = 6;
+    static constexpr unsigned num_slots = 1u << slot_bits;
+    static constexpr unsigned num_levels = 5;
+
+  private:
+
+    using entry_type = std::pair<id_type, tick_type>;
+    using slot_type = std::vector<entry_type>;
+
+  public:
+
+    explicit basic_timer_wheel() : now_(0), count_(0), active_(), levels_()
+    {}
+
+    /**
+     * Current time of the wheel in ticks.
+     * @return tick_type
+     */
+    tick_type now() const noexcept
+    { return now_; }
+
+    /**
+     * Number of scheduled timers.
+     * @return size_t
+     */
+    size_t size() const noexcept
+    { return active_.size(); }
+
+    /**
+     * True if no timers are scheduled.
+     * @return bool
+     */
+    bool empty() const noexcept
+    { return active_.empty(); }
+
+    /**
+     * True if timer `id` is scheduled.
+     * @return bool
+     */
+    bool contains(id_type id) const
+    { return active_.find(id) != active_.end(); }
+
+    /**
+     * Schedules (or reschedules) timer `id` to expire at the absolute tick
+     * `expires`. Timers already due expire at the next tick.
+     * @param id_type id
+     * @param tick_type expires
+     */
+    void insert(id_type id, tick_type expires)
+    {
+      if(expires <= now_) expires = now_ + 1;
+      active_[id] = expires;
+      place(id, expires);
+    }
+
+    /**
+     * Removes timer `id`, returns false if it was not scheduled.
+     * @param id_type id
+     * @return bool
+     */
+    bool erase(id_type id)
+    { return active_.erase(id) != 0; }
+
+    /**
+     * Returns the next tick at which timers expire or have to be cascaded,
+     * `max()` if the wheel is empty. Advancing the wheel is not needed
+     * before this tick.
+     * @return tick_type
+     */
+    tick_type next_tick() const noexcept
+    {
+      tick_type next = std::numeric_limits<tick_type>::max();
+      if(!count_) return next;
+      for(unsigned l=0; l<num_levels; ++l) {
+        const unsigned shift = l * slot_bits;
+        const tick_type current = now_ >> shift;
+        for(tick_type k=1; k<=num_slots; ++k) {
+          if(!levels_[l][(current+k) & (num_slots-1)].empty()) {
+            next = std::min(next, tick_type((current+k) << shift));
+            break;
+          }
+        }
+      }
+      return next;
+    }
+
+    /**
+     * Advances the wheel time to tick `to` and appends the ids of all timers
+     * expired until then to `expired`, ordered by expiry time and id. The
+     * expired timers are removed from the wheel.
+     * @param tick_type to
+     * @param std::vector<id_type>& expired
+     */
+    void advance(tick_type to, std::vector<id_type>& expired)
+    {
+      std::vector<entry_type> due;
+      while(now_ < to) {
+        const tick_type next = next_tick();
+        if(next > to) { now_ = to; break; }
+        now_ = next;
+        for(unsigned l=1; l<num_levels; ++l) {
+          const unsigned shift = l * slot_bits;
+          if((now_ & ((tick_type(1) << shift)-1)) != 0) break;
+          cascade(l, (now_ >> shift) & (num_slots-1));
+        }
+        slot_type slot;
+        slot.swap(levels_[0][now_ & (num_slots-1)]);
+        count_ -= slot.size();
+        for(const auto& e: slot) {
+          const auto it = active_.find(e.first);
+          if((it == active_.end()) || (it->second != e.second)) continue; // removed or rescheduled
+          if(e.second <= now_) {
+            due.emplace_back(e.second, e.first);
+            active_.erase(it);
+          } else {
+            place(e.first, e.second);
+          }
+        }
+      }
+      std::sort(due.begin(), due.end());
+      for(const auto& e: due) expired.push_back(e.second);
+    }
+
+  private:
+
+    void place(id_type id, tick_type expires)
+    {
+      const tick_type delta = (expires > now_) ? (expires - now_) : 0;
+      for(unsigned l=0; l<num_levels; ++l) {
+        const unsigned shift = l * slot_bits;
+        if(delta < (tick_type(1) << (shift + slot_bits))) {
+          levels_[l][(expires >> shift) & (num_slots-1)].emplace_back(id, expires);
+          ++count_;
+          return;
+        }
+      }
+      // Beyond the wheel range: park in the top level slot cascaded last.
+      const unsigned shift = (num_levels-1) * slot_bits;
+      levels_[num_levels-1][((now_ >> shift) + num_slots - 1) & (num_slots-1)].emplace_back(id, expires);
+      ++count_;
+    }
+
+    void cascade(unsigned level, tick_type index)
+    {
+      slot_type slot;
+      slot.swap(levels_[level][index]);
+      count_ -= slot.size();
+      for(const auto& e: slot) {
+        const auto it = active_.find(e.first);
+        if((it == active_.end()) || (it->second != e.second)) continue;
+        place(e.first, e.second);
+      }
+    }
+
+  private:
+
+    tick_type now_;
+    size_t count_;
+    std::unordered_map<id_type, tick_type> active_;
+    slot_type levels_[num_levels][num_slots];
+  };
+  // </editor-fold>
+
+  // <editor-fold desc="event loop" defaultstate="collapsed">
+  /**
+   * Timers, immediates and file descriptor watches of one engine. The
+   * loop does not know about script callbacks, due timers and immediates
+   * are passed by id to the dispatch function of `run_once()`.
+   */
+  template <typename=void>
+  class basic_eventloop
+  {
+  public:
+
+    using id_type = uint32_t;
+    using clock_type = std::chrono::steady_clock;
+    using wheel_type = basic_timer_wheel<>;
+    using tick_type = typename wheel_type::tick_type;
+    using fd_callback_type = std::function<void(int fd, unsigned events)>;
+    enum : unsigned { readable=1, writable=2, error=4 };
+
+  public:
+
+    explicit basic_eventloop() : epoch_(clock_type::now()), next_id_(0), wheel_(), intervals_(),
+      due_(), immediates_(), immediate_ids_(), watches_()
+    {
+      #if defined(__linux__)
+      epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
+      if(epfd_ < 0) throw engine_error(std::string("eventloop: epoll_create1() failed: ") + ::strerror(errno));
+      #endif
+    }
+
+    ~basic_eventloop() noexcept
+    {
+      #if defined(__linux__)
+      if(epfd_ >= 0) ::close(epfd_);
+      #endif
+    }
+
+    basic_eventloop(const basic_eventloop&) = delete;
+    basic_eventloop& operator=(const basic_eventloop&) = delete;
+
+  public:
+
+    /**
+     * Milliseconds since the loop was created, the time base of the timers.
+     * @return tick_type
+     */
+    tick_type now() const noexcept
+    { return tick_type(std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - epoch_).count()); }
+
+    /**
+     * True if timers, immediates or file descriptor watches are pending.
+     * @return bool
+     */
+    bool alive() const noexcept
+    { return !wheel_.empty() || !due_.empty() || !immediate_ids_.empty() || !watches_.empty(); }
+
+    /**
+     * Number of scheduled timers.
+     * @return size_t
+     */
+    size_t timers() const noexcept
+    { return wheel_.size() + due_.size(); }
+
+    /**
+     * Schedules a timer, returns its id. With `repeat` the timer is
+     * rescheduled after each expiry until it is cleared.
+     * @param tick_type delay_ms
+     * @param bool repeat
+     * @return id_type
+     */
+    id_type set_timer(tick_type delay_ms, bool repeat)
+    {
+      const id_type id = allocate_id();
+      if(repeat) intervals_[id] = std::max(delay_ms, tick_type(1));
+      wheel_.insert(id, now() + delay_ms);
+      return id;
+    }
+
+    /**
+     * Schedules an immediate, which is dispatched in the next loop
+     * iteration before waiting. Returns its id.
+     * @return id_type
+     */
+    id_type set_immediate()
+    {
+      const id_type id = allocate_id();
+      immediates_.push_back(id);
+      immediate_ids_.insert(id);
+      return id;
+    }
+
+    /**
+     * Cancels a timer or immediate, returns false if the id is not pending.
+     * @param id_type id
+     * @return bool
+     */
+    bool clear(id_type id)
+    {
+      bool found = wheel_.erase(id);
+      found = (intervals_.erase(id) != 0) || found;
+      found = (immediate_ids_.erase(id) != 0) || found;
+      const auto it = std::find(due_.begin(), due_.end(), id);
+      if(it != due_.end()) { due_.erase(it); found = true; }
+      return found;
+    }
+
+    /**
+     * Watches file descriptor `fd` for the events `readable` and/or `writable`.
+     * The callback is invoked from the loop with the ready events (which may
+     * include `error`). Watching an already watched descriptor replaces
+     * events and callback.
+     * @param int fd
+     * @param unsigned events
+     * @param fd_callback_type callback
+     */
+    void watch(int fd, unsigned events, fd_callback_type callback)
+    {
+      #if defined(WINDOWS)
+      (void)fd; (void)events; (void)callback;
+      throw engine_error("eventloop: File descriptor watching is not supported on this platform.");
+      #else
+      if(fd < 0) throw engine_error("eventloop: Invalid file descriptor.");
+      #if defined(__linux__)
+      struct ::epoll_event ev;
+      ::memset(&ev, 0, sizeof(ev));
+      ev.events = ((events & readable) ? EPOLLIN : 0u) | ((events & writable) ? EPOLLOUT : 0u);
+      ev.data.fd = fd;
+      const bool exists = watches_.find(fd) != watches_.end();
+      if(::epoll_ctl(epfd_, exists ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev) != 0) {
+        throw engine_error(std::string("eventloop: epoll_ctl() failed: ") + ::strerror(errno));
+      }
+      #endif
+      watches_[fd] = watch_type{events, std::move(callback)};
+      #endif
+    }
+
+    /**
+     * Stops watching `fd`, returns false if it was not watched.
+     * @param int fd
+     * @return bool
+     */
+    bool unwatch(int fd)
+    {
+      const auto it = watches_.find(fd);
+      if(it == watches_.end()) return false;
+      #if defined(__linux__)
+      struct ::epoll_event ev;
+      ::memset(&ev, 0, sizeof(ev));
+      ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, &ev); // ENOENT/EBADF if already closed.
+      #endif
+      watches_.erase(it);
+      return true;
+    }
+
+    /**
+     * Runs one loop iteration: Dispatches the expired timers and the
+     * pending immediates, then waits for ready file descriptors, at most
+     * until the next timer is due (or not at all if `wait` is false or
+     * immediates are pending), and invokes their callbacks.
+     *
+     * `dispatch(id, last)` is invoked for each timer and immediate, `last`
+     * is false for interval timers, which are rescheduled. If `dispatch`
+     * throws, the remaining due timers are kept and dispatched in the next
+     * iteration.
+     *
+     * @param DispatchFn&& dispatch
+     * @param bool wait
+     */
+    template <typename DispatchFn>
+    void run_once(DispatchFn&& dispatch, bool wait=true)
+    {
+      // Timers
+      {
+        std::vector<typename wheel_type::id_type> expired;
+        wheel_.advance(now(), expired);
+        for(const auto id: expired) due_.push_back(id_type(id));
+      }
+      while(!due_.empty()) {
+        const id_type id = due_.front();
+        due_.pop_front();
+        const auto it = intervals_.find(id);
+        if(it != intervals_.end()) wheel_.insert(id, now() + it->second);
+        dispatch(id, it == intervals_.end());
+      }
+      // Immediates scheduled until now, new ones are run in the next iteration.
+      for(size_t n = immediates_.size(); n > 0 && !immediates_.empty(); --n) {
+        const id_type id = immediates_.front();
+        immediates_.pop_front();
+        if(immediate_ids_.erase(id)) dispatch(id, true);
+      }
+      // Wait
+      int timeout_ms = -1;
+      if(!wait || !immediate_ids_.empty()) {
+        timeout_ms = 0;
+      } else if(!wheel_.empty()) {
+        const tick_type next = wheel_.next_tick(), t = now();
+        timeout_ms = (next <= t) ? 0 : int(std::min(next - t, tick_type(std::numeric_limits<int>::max())));
+      } else if(watches_.empty()) {
+        return;
+      }
+      wait_io(timeout_ms);
+    }
+
+  private:
+
+    struct watch_type
+    {
+      unsigned events;
+      fd_callback_type callback;
+    };
+
+    id_type allocate_id()
+    {
+      do {
+        if(++next_id_ >= std::numeric_limits<id_type>::max()) next_id_ = 1;
+      } while(wheel_.contains(next_id_) || immediate_ids_.count(next_id_) || intervals_.count(next_id_));
+      return next_id_;
+    }
+
+    void notify(int fd, unsigned events)
+    {
+      const auto it = watches_.find(fd);
+      if(it == watches_.end()) return;
+      const fd_callback_type callback = it->second.callback; // The callback may unwatch.
+      if(callback) callback(fd, events);
+    }
+
+    void wait_io(int timeout_ms)
+    {
+      #if defined(WINDOWS)
+      if(timeout_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+      #elif defined(__linux__)
+      struct ::epoll_event events[64];
+      const int n = ::epoll_wait(epfd_, events, 64, timeout_ms);
+      if(n < 0) {
+        if(errno == EINTR) return;
+        throw engine_error(std::string("eventloop: epoll_wait() failed: ") + ::strerror(errno));
+      }
+      for(int i=0; i<n; ++i) {
+        const unsigned e = events[i].events;
+        notify(events[i].data.fd, ((e & EPOLLIN) ? unsigned(readable) : 0u)
+          | ((e & EPOLLOUT) ? unsigned(writable) : 0u)
+          | ((e & (EPOLLERR|EPOLLHUP)) ? unsigned(error) : 0u)
+        );
+      }
+      #else
+      std::vector<struct ::pollfd> fds;
+      fds.reserve(watches_.size());
+      for(const auto& w: watches_) {
+        struct ::pollfd p;
+        p.fd = w.first;
+        p.events = ((w.second.events & readable) ? POLLIN : 0) | ((w.second.events & writable) ? POLLOUT : 0);
+        p.revents = 0;
+        fds.push_back(p);
+      }
+      const int n = ::poll(fds.data(), fds.size(), timeout_ms);
+      if(n < 0) {
+        if(errno == EINTR) return;
+        throw engine_error(std::string("eventloop: poll() failed: ") + ::strerror(errno));
+      }
+      for(const auto& p: fds) {
+        if(!p.revents) continue;
+        notify(p.fd, ((p.revents & POLLIN) ? unsigned(readable) : 0u)
+          | ((p.revents & POLLOUT) ? unsigned(writable) : 0u)
+          | ((p.revents & (POLLERR|POLLHUP|POLLNVAL)) ? unsigned(error) : 0u)
+        );
+      }
+      #endif
+    }
+
+  private:
+
+    const typename clock_type::time_point epoch_;
+    id_type next_id_;
+    wheel_type wheel_;
+    std::unordered_map<id_type, tick_type> intervals_;
+    std::deque<id_type> due_;
+    std::deque<id_type> immediates_;
+    std::unordered_set<id_type> immediate_ids_;
+    std::map<int, watch_type> watches_;
+    #if defined(__linux__)
+    int epfd_;
+    #endif
+  };
+
+  using eventloop = basic_eventloop<>;
+  // </editor-fold>
+
+  // <editor-fold desc="engine binding" defaultstate="collapsed">
+  /**
+   * Returns the event loop of the engine of the given stack, nullptr
+   * if the module is not defined in the engine.
+   * @param duktape::api& stack
+   * @return eventloop*
+   */
+  template <typename=void>
+  eventloop* get_loop(duktape::api& stack)
+  {
+    eventloop* loop = nullptr;
+    stack_guard sg(stack);
+    stack.push_heap_stash();
+    if(stack.get_prop_string_hidden(-1, "eventloop") && stack.is_object(-1) && stack.get_prop_string_hidden(-1, "loop")) {
+      loop = reinterpret_cast<eventloop*>(stack.get_pointer(-1));
+    }
+    return loop;
+  }
+
+  template <typename=void>
+  duk_ret_t loop_finalizer(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    if(stack.get_prop_string_hidden(0, "loop")) {
+      eventloop* loop = reinterpret_cast<eventloop*>(stack.get_pointer(-1));
+      stack.pop();
+      stack.push_pointer(nullptr);
+      stack.put_prop_string(0, "\xff_loop");
+      delete loop;
+    }
+    return 0;
+  }
+
+  /**
+   * Pushes the heap stash object holding the callback arrays of the timers
+   * and immediates (indexed by id).
+   */
+  template <typename=void>
+  void push_callbacks(duktape::api& stack)
+  {
+    stack.push_heap_stash();
+    stack.get_prop_string_hidden(-1, "eventloop_callbacks");
+    stack.remove(-2);
+  }
+
+  /**
+   * Invokes the callback with the id `id` via `engine::call_top()`. With
+   * `last` the callback is removed from the callback store before.
+   */
+  template <typename=void>
+  void dispatch(duktape::engine& js, eventloop::id_type id, bool last)
+  {
+    duktape::api& stack = js.stack();
+    stack_guard sg(stack);
+    push_callbacks(stack);
+    stack.get_prop_index(-1, id);
+    if(last) stack.del_prop_index(-2, id);
+    if(!stack.is_array(-1)) return;
+    const int n = int(stack.get_length(-1));
+    if(n < 1) return;
+    stack.require_stack(n + 1);
+    for(int i=0; i<n; ++i) stack.get_prop_index(-1-i, duk_uarridx_t(i));
+    js.call_top(n-1, "eventloop callback");
+  }
+
+  /**
+   * Schedules a timer (`delay < 0`: immediate) for the function at stack
+   * index 0, arguments from index `first_arg` are passed to the callback.
+   * Pushes the id.
+   */
+  template <typename=void>
+  int schedule(duktape::api& stack, const char* fname, double delay, bool repeat, int first_arg)
+  {
+    eventloop* loop = get_loop(stack);
+    if(!loop) return stack.throw_exception(std::string(fname) + "(): Event loop not available.");
+    if(!stack.is_callable(0)) return stack.throw_exception(std::string(fname) + "(): First argument must be a function.");
+    const int nargs = stack.top();
+    push_callbacks(stack);
+    stack.push_array();
+    stack.dup(0);
+    stack.put_prop_index(-2, 0);
+    for(int i=first_arg, k=1; i<nargs; ++i, ++k) {
+      stack.dup(i);
+      stack.put_prop_index(-2, duk_uarridx_t(k));
+    }
+    eventloop::id_type id;
+    if(delay < 0) {
+      id = loop->set_immediate();
+    } else {
+      if(!(delay <= double(std::numeric_limits<int32_t>::max()))) delay = 1; // NaN, too long
+      id = loop->set_timer(eventloop::tick_type(delay), repeat);
+    }
+    stack.put_prop_index(-2, id);
+    stack.push(double(id));
+    return 1;
+  }
+
+  template <typename=void>
+  double get_delay(duktape::api& stack)
+  {
+    if((stack.top() < 2) || (!stack.is_number(1))) return 0;
+    const double delay = stack.get<double>(1);
+    return (delay > 0) ? delay : 0;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="js functions" defaultstate="collapsed">
+  #if(0 && JSDOC)
+  /**
+   * Calls `callback` once after `delay` milliseconds (default 0), passing
+   * the optional additional arguments. Returns the timer id for
+   * `clearTimeout()`. Timers are processed by the event loop, which runs
+   * after the main script has been executed.
+   *
+   * @throws {Error}
+   * @param {function} callback
+   * @param {number} [delay]
+   * @param {...*} [args]
+   * @returns {number}
+   */
+  function setTimeout(callback, delay, args) {};
+  #endif
+  template <typename=void>
+  int set_timeout(duktape::api& stack)
+  { return schedule(stack, "setTimeout", get_delay(stack), false, 2); }
+
+  #if(0 && JSDOC)
+  /**
+   * Calls `callback` every `delay` milliseconds (at least 1ms), passing
+   * the optional additional arguments, until the timer is cleared with
+   * `clearInterval()`. Returns the timer id.
+   *
+   * @throws {Error}
+   * @param {function} callback
+   * @param {number} delay
+   * @param {...*} [args]
+   * @returns {number}
+   */
+  function setInterval(callback, delay, args) {};
+  #endif
+  template <typename=void>
+  int set_interval(duktape::api& stack)
+  { return schedule(stack, "setInterval", get_delay(stack), true, 2); }
+
+  #if(0 && JSDOC)
+  /**
+   * Calls `callback` with the optional additional arguments in the next
+   * event loop iteration, before waiting for timers or I/O. Returns the
+   * id for `clearImmediate()`.
+   *
+   * @throws {Error}
+   * @param {function} callback
+   * @param {...*} [args]
+   * @returns {number}
+   */
+  function setImmediate(callback, args) {};
+  #endif
+  template <typename=void>
+  int set_immediate(duktape::api& stack)
+  { return schedule(stack, "setImmediate", -1, false, 1); }
+
+  #if(0 && JSDOC)
+  /**
+   * Cancels a timer created with `setTimeout()`. Unknown ids are ignored.
+   *
+   * @param {number} id
+   */
+  function clearTimeout(id) {};
+
+  /**
+   * Cancels a timer created with `setInterval()`. Unknown ids are ignored.
+   *
+   * @param {number} id
+   */
+  function clearInterval(id) {};
+
+  /**
+   * Cancels a callback scheduled with `setImmediate()`. Unknown ids are ignored.
+   *
+   * @param {number} id
+   */
+  function clearImmediate(id) {};
+  #endif
+  template <typename=void>
+  int clear_timer(duktape::api& stack)
+  {
+    eventloop* loop = get_loop(stack);
+    if(!loop || (stack.top() < 1) || (!stack.is_number(0))) return 0;
+    const double d = stack.get<double>(0);
+    if(!(d >= 1) || (d > double(std::numeric_limits<eventloop::id_type>::max()))) return 0;
+    const eventloop::id_type id = eventloop::id_type(d);
+    if(loop->clear(id)) {
+      push_callbacks(stack);
+      stack.del_prop_index(-1, id);
+    }
+    return 0;
+  }
+  // </editor-fold>
+
+}}}
+
+namespace duktape { namespace mod { namespace eventloop {
+
+  // <editor-fold desc="js decls" defaultstate="collapsed">
+  /**
+   * Export main relay. Adds all module functions to the specified engine
+   * and creates the event loop of the engine.
+   * @param duktape::engine& js
+   */
+  template <typename=void>
+  static void define_in(duktape::engine& js)
+  {
+    using namespace ::duktape::detail::eventloop;
+    duktape::api& stack = js.stack();
+    if(!get_loop(stack)) {
+      stack_guard sg(stack);
+      const duktape::api::index_t stash = stack.top();
+      stack.push_heap_stash();
+      stack.push_object();
+      stack.put_prop_string_hidden(stash, "eventloop_callbacks");
+      stack.push_object();
+      stack.push_pointer(new ::duktape::detail::eventloop::eventloop());
+      stack.put_prop_string(-2, "\xff_loop");
+      stack.push_c_function(loop_finalizer<>, 1);
+      stack.set_finalizer(-2);
+      stack.put_prop_string_hidden(stash, "eventloop");
+    }
+    js.define("setTimeout", set_timeout<>);
+    js.define("setInterval", set_interval<>);
+    js.define("setImmediate", set_immediate<>);
+    js.define("clearTimeout", clear_timer<>, 1);
+    js.define("clearInterval", clear_timer<>, 1);
+    js.define("clearImmediate", clear_timer<>, 1);
+  }
+
+  /**
+   * Returns the event loop of the engine, e.g. to watch file descriptors.
+   * nullptr if the module is not defined in the engine.
+   * @param duktape::api& stack
+   * @return ::duktape::detail::eventloop::eventloop*
+   */
+  template <typename=void>
+  static ::duktape::detail::eventloop::eventloop* loop_of(duktape::api& stack)
+  { return ::duktape::detail::eventloop::get_loop(stack); }
+
+  /**
+   * Runs the event loop of the engine until no timers, immediates or file
+   * descriptor watches are pending. Exceptions of the callbacks (e.g.
+   * `duktape::script_error`) are passed to the caller, the loop can be
+   * continued by calling `run_loop()` again. Before checking if the loop
+   * is alive and after each iteration the job hook of the engine is
+   * invoked, so that pending jobs (e.g. promise reactions queued from
+   * native code, or left over after an exceeded execution limit) are
+   * processed, and the jobs can keep the loop alive with new timers.
+   * @param duktape::engine& js
+   */
+  template <typename=void>
+  static void run_loop(duktape::engine& js)
+  {
+    using loop_type = ::duktape::detail::eventloop::eventloop;
+    loop_type* loop = ::duktape::detail::eventloop::get_loop(js.stack());
+    if(!loop) return;
+    for(;;) {
+      if(js.job_hook()) js.job_hook()(js);
+      if(!loop->alive()) break;
+      loop->run_once([&js](loop_type::id_type id, bool last) { ::duktape::detail::eventloop::dispatch(js, id, last); });
+    }
+  }
+  // </editor-fold>
+
+}}}
+
+#endif
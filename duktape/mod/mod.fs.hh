@@ -357,26 +357,23 @@ namespace duktape { namespace detail { namespace filesystem { namespace generic
   {
     if(!stack.is<std::string>(0)) { stack.push(false); return 1; }
     std::string path = PathAccessor::to_sys(stack.to<std::string>(0));
-    std::ios::openmode mode = std::ios::out;
+    std::ios::openmode mode = std::ios::out|std::ios::binary;
     if(Append) mode |= std::ios::app;
-    std::string data;
     if(stack.is_undefined(1)) {
       stack.throw_exception("The file write function needs a data argument (2nd argument)");
       return 0;
     } else if(stack.is_function(1)) {
       stack.throw_exception("The file write function cannot use functions as data argument");
       return 0;
-    } else if(stack.is_buffer(1)) {
-      data = stack.get_buffer<std::string>(1);
-      mode |= std::ios::binary;
-    } else {
-      data = stack.to<std::string>(1);
-      mode |= std::ios::binary;
+    } else if(!stack.is_buffer(1) && !stack.is_string(1)) {
+      stack.to_string(1);
     }
+    const void* data; size_t size;
+    stack.get_data_view(1, data, size); // written directly from the engine string/buffer
     try {
       std::ofstream fos(path.c_str(), mode);
       if(!fos.good()) { stack.push(false); return 1; }
-      fos << data;
+      if(size) fos.write((const char*)data, std::streamsize(size));
       stack.push(fos.good());
       return 1;
     } catch(const std::exception& e) {
@@ -0,0 +1,916 @@
+/**
+ * @file duktape/mod/mod.promise.hh
+ * @package de.atwillys.cc.duktape
+ * @license MIT
+ * @authors Stefan Wilhelm (stfwi, <cerbero s@atwillys.de>)
+ * @platform linux, bsd, windows
+ * @standard >= c++11
+ * @requires duk_config.h duktape.h duktape.c >= v2.1
+ * @requires Duktape CFLAGS -DDUK_USE_CPP_EXCEPTIONS
+ * @cxxflags -std=c++11 -W -Wall -Wextra -pedantic -fstrict-aliasing
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Duktape ECMA engine C++ wrapper, native `Promise` module.
+ *
+ * Provides the `Promise` constructor with `then()`, `catch()`, `finally()`
+ * and the static `resolve()`, `reject()`, `all()`, `race()` and
+ * `allSettled()`. Reactions are queued as jobs (microtasks) in the heap
+ * stash, the queue is processed by the engine after each outermost
+ * `eval()`/`call()` (via `engine::job_hook()`), and by the event loop
+ * driver after each iteration. C++ code creates and settles promises with
+ * `duktape::mod::promise::push_promise()`, `resolve()` and `reject()`.
+ *
+ * -----------------------------------------------------------------------------
+ * License: http://opensource.org/licenses/MIT
+ * Copyright (c) 2014-2017, the authors (see the @authors tag in this file).
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions: The above copyright notice and
+ * this permission notice shall be included in all copies or substantial portions
+ * of the Software. THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef DUKTAPE_MOD_PROMISE_HH
+#define DUKTAPE_MOD_PROMISE_HH
+
+// <editor-fold desc="preprocessor" defaultstate="collapsed">
+#include "../duktape.hh"
+#include <string>
+// </editor-fold>
+
+namespace duktape { namespace detail { namespace promise {
+
+  // <editor-fold desc="promise state" defaultstate="collapsed">
+  /**
+   * Promise objects carry their state in hidden (but writable) properties:
+   *
+   *  - "\xff_promise_state"     : pending / fulfilled / rejected
+   *  - "\xff_promise_value"     : fulfillment value or rejection reason
+   *  - "\xff_promise_reactions" : array of reactions while pending
+   *  - "\xff_promise_locked"    : set when resolved (possibly with a thenable)
+   *
+   * A reaction is an array `[on_fulfilled, on_rejected, derived, kind, extra]`,
+   * a job `[job_reaction, reaction, state, value]` or
+   * `[job_thenable, promise, thenable, then]`.
+   */
+  using index_t = ::duktape::api::index_t;
+
+  enum { pending=0, fulfilled=1, rejected=2 };
+  enum { reaction_then=0, reaction_finally, reaction_finally_pass, reaction_all, reaction_all_settled };
+  enum { job_reaction=0, job_thenable };
+
+  template <typename=void>
+  bool is_promise(duktape::api& stack, index_t index)
+  { return stack.is_object(index) && stack.has_prop_string(index, "\xff_promise_state"); }
+
+  template <typename=void>
+  int get_state(duktape::api& stack, index_t index)
+  {
+    stack.get_prop_string(index, "\xff_promise_state");
+    const int state = stack.get<int>(-1);
+    stack.pop();
+    return state;
+  }
+
+  /**
+   * Initialises the object at `index` as pending promise.
+   */
+  template <typename=void>
+  void init_promise(duktape::api& stack, index_t index)
+  {
+    index = stack.normalize_index(index);
+    stack.require_stack(2);
+    stack.push(int(pending));
+    stack.put_prop_string(index, "\xff_promise_state");
+    stack.push_array();
+    stack.put_prop_string(index, "\xff_promise_reactions");
+  }
+
+  /**
+   * Pushes a new pending promise (prototype `Promise.prototype`).
+   */
+  template <typename=void>
+  void push_new_promise(duktape::api& stack)
+  {
+    stack.require_stack(3);
+    stack.push_object();
+    stack.push_heap_stash();
+    stack.get_prop_string_hidden(-1, "promise_prototype");
+    stack.set_prototype(-3);
+    stack.pop();
+    init_promise(stack, -1);
+  }
+
+  /**
+   * Pushes a new `TypeError` object.
+   */
+  template <typename=void>
+  void push_type_error(duktape::api& stack, const char* msg)
+  { ::duk_push_error_object(stack.ctx(), DUK_ERR_TYPE_ERROR, "%s", msg); }
+
+  /**
+   * Appends the job array on the stack top to the job queue, pops it.
+   */
+  template <typename=void>
+  void enqueue_job(duktape::api& stack)
+  {
+    stack.require_stack(3);
+    stack.push_heap_stash();
+    stack.get_prop_string(-1, "\xff_promise_jobs");
+    stack.dup(-3);
+    stack.put_prop_index(-2, duk_uarridx_t(stack.get_length(-2)));
+    stack.pop(3);
+  }
+
+  /**
+   * Pushes a reaction job for the reaction at `reaction`, with the state
+   * and value of the settled promise `promise`.
+   */
+  template <typename=void>
+  void enqueue_reaction(duktape::api& stack, index_t reaction, int state, index_t value)
+  {
+    reaction = stack.normalize_index(reaction);
+    value = stack.normalize_index(value);
+    stack.require_stack(2);
+    stack.push_array();
+    stack.push(int(job_reaction));
+    stack.put_prop_index(-2, 0);
+    stack.dup(reaction);
+    stack.put_prop_index(-2, 1);
+    stack.push(state);
+    stack.put_prop_index(-2, 2);
+    stack.dup(value);
+    stack.put_prop_index(-2, 3);
+    enqueue_job(stack);
+  }
+
+  /**
+   * Fulfills or rejects a pending promise and queues its reactions.
+   */
+  template <typename=void>
+  void settle(duktape::api& stack, index_t promise, index_t value, int state)
+  {
+    promise = stack.normalize_index(promise);
+    value = stack.normalize_index(value);
+    if(get_state(stack, promise) != pending) return;
+    stack.require_stack(3);
+    stack.dup(value);
+    stack.put_prop_string(promise, "\xff_promise_value");
+    stack.push(state);
+    stack.put_prop_string(promise, "\xff_promise_state");
+    stack.get_prop_string(promise, "\xff_promise_reactions");
+    stack.del_prop_string(promise, "\xff_promise_reactions");
+    const index_t reactions = stack.top()-1;
+    const size_t n = stack.is_array(reactions) ? stack.get_length(reactions) : 0;
+    for(size_t i=0; i<n; ++i) {
+      stack.get_prop_index(reactions, duk_uarridx_t(i));
+      enqueue_reaction(stack, -1, state, value);
+      stack.pop();
+    }
+    stack.pop();
+  }
+
+  /**
+   * Adds the reaction on the stack top to the promise at `promise`, or
+   * queues it immediately if the promise is already settled. Pops the
+   * reaction.
+   */
+  template <typename=void>
+  void add_reaction(duktape::api& stack, index_t promise)
+  {
+    promise = stack.normalize_index(promise);
+    const int state = get_state(stack, promise);
+    stack.require_stack(3);
+    if(state == pending) {
+      stack.get_prop_string(promise, "\xff_promise_reactions");
+      stack.dup(-2);
+      stack.put_prop_index(-2, duk_uarridx_t(stack.get_length(-2)));
+      stack.pop();
+    } else {
+      stack.get_prop_string(promise, "\xff_promise_value");
+      enqueue_reaction(stack, -2, state, -1);
+      stack.pop();
+    }
+    stack.pop();
+  }
+
+  /**
+   * Protected `value.then` lookup (the property may be a throwing getter).
+   */
+  template <typename=void>
+  duk_ret_t get_then(duk_context* ctx)
+  {
+    ::duk_get_prop_string(ctx, 0, "then");
+    return 1;
+  }
+
+  /**
+   * Resolves the promise with the value at `value` without checking if
+   * it was already resolved: Thenables are followed (in a job), other
+   * values fulfill the promise. Errors thrown when getting `then` reject
+   * the promise.
+   */
+  template <typename=void>
+  void resolve_unchecked(duktape::api& stack, index_t promise, index_t value)
+  {
+    promise = stack.normalize_index(promise);
+    value = stack.normalize_index(value);
+    stack.require_stack(4);
+    if(stack.is_object(value) && stack.strict_equals(promise, value)) {
+      push_type_error(stack, "Promise resolved with itself");
+      settle(stack, promise, -1, rejected);
+      stack.pop();
+    } else if(stack.is_object(value)) {
+      stack.push_c_function(get_then<>, 1);
+      stack.dup(value);
+      if(!stack.parent_engine().pcall_top(1, false, "Promise job")) {
+        settle(stack, promise, -1, rejected);
+      } else if(stack.is_callable(-1)) {
+        stack.push_array();
+        stack.push(int(job_thenable));
+        stack.put_prop_index(-2, 0);
+        stack.dup(promise);
+        stack.put_prop_index(-2, 1);
+        stack.dup(value);
+        stack.put_prop_index(-2, 2);
+        stack.dup(-2);
+        stack.put_prop_index(-2, 3);
+        enqueue_job(stack);
+      } else {
+        settle(stack, promise, value, fulfilled);
+      }
+      stack.pop();
+    } else {
+      settle(stack, promise, value, fulfilled);
+    }
+  }
+
+  /**
+   * Returns false if the promise was already resolved or rejected, marks
+   * it resolved otherwise.
+   */
+  template <typename=void>
+  bool lock(duktape::api& stack, index_t promise)
+  {
+    promise = stack.normalize_index(promise);
+    stack.require_stack(1);
+    stack.get_prop_string(promise, "\xff_promise_locked");
+    const bool locked = stack.get<bool>(-1);
+    stack.pop();
+    if(locked || (get_state(stack, promise) != pending)) return false;
+    stack.push_true();
+    stack.put_prop_string(promise, "\xff_promise_locked");
+    return true;
+  }
+
+  template <typename=void>
+  void resolve_promise(duktape::api& stack, index_t promise, index_t value)
+  { if(lock(stack, promise)) resolve_unchecked(stack, promise, value); }
+
+  template <typename=void>
+  void reject_promise(duktape::api& stack, index_t promise, index_t reason)
+  { if(lock(stack, promise)) settle(stack, promise, reason, rejected); }
+
+  /**
+   * Pushes the value at `value` if it is a promise, otherwise a new
+   * promise resolved with this value (`Promise.resolve()`).
+   */
+  template <typename=void>
+  void push_resolved(duktape::api& stack, index_t value)
+  {
+    value = stack.normalize_index(value);
+    if(is_promise(stack, value)) {
+      stack.dup(value);
+    } else {
+      push_new_promise(stack);
+      resolve_promise(stack, -1, value);
+    }
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="resolving functions" defaultstate="collapsed">
+  /**
+   * The `resolve`/`reject` functions passed to executors and `then()`
+   * methods of thenables. The pair shares a record object, only the
+   * first call of either function has an effect.
+   */
+  template <bool Reject>
+  duk_ret_t resolving_function(duk_context* ctx)
+  {
+    duktape::api stack(ctx);
+    stack.require_stack(3);
+    stack.push_current_function();
+    stack.get_prop_string(1, "\xff_record");
+    stack.get_prop_string(2, "done");
+    if(stack.get<bool>(-1)) return 0;
+    stack.pop();
+    stack.push_true();
+    stack.put_prop_string(2, "done");
+    stack.get_prop_string(1, "\xff_promise");
+    if(Reject) {
+      settle(stack, 3, 0, rejected);
+    } else {
+      resolve_unchecked(stack, 3, 0);
+    }
+    return 0;
+  }
+
+  /**
+   * Pushes the resolve and reject function for the promise at `promise`.
+   */
+  template <typename=void>
+  void push_resolving_functions(duktape::api& stack, index_t promise)
+  {
+    promise = stack.normalize_index(promise);
+    stack.require_stack(4);
+    stack.push_object();
+    const index_t record = stack.top()-1;
+    stack.push_c_function(resolving_function<false>, 1);
+    stack.push_c_function(resolving_function<true>, 1);
+    for(index_t i=record+1; i<=record+2; ++i) {
+      stack.dup(promise);
+      stack.put_prop_string(i, "\xff_promise");
+      stack.dup(record);
+      stack.put_prop_string(i, "\xff_record");
+    }
+    stack.remove(record);
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="job processing" defaultstate="collapsed">
+  /**
+   * Calls the function below the `nargs` topmost arguments under the engine
+   * execution limits (`engine::pcall_top()`), the result or error is left
+   * on the stack. Errors caused by exceeded execution limits are thrown as
+   * `duktape::timeout_error`, as they must not be turned into rejections.
+   */
+  template <typename=void>
+  bool pcall_job(duktape::engine& js, int nargs, bool method=false)
+  { return js.pcall_top(nargs, method, "Promise job"); }
+
+  template <typename=void>
+  void run_reaction(duktape::engine& js, index_t job)
+  {
+    duktape::api& stack = js.stack();
+    stack.require_stack(8);
+    stack.get_prop_index(job, 1);
+    const index_t reaction = stack.top()-1;
+    stack.get_prop_index(job, 2);
+    const int state = stack.get<int>(-1);
+    stack.pop();
+    stack.get_prop_index(job, 3);
+    const index_t value = stack.top()-1;
+    stack.get_prop_index(reaction, 2);
+    const index_t derived = stack.top()-1;
+    stack.get_prop_index(reaction, 3);
+    const int kind = stack.get<int>(-1);
+    stack.pop();
+    switch(kind) {
+      case reaction_then: {
+        stack.get_prop_index(reaction, (state == fulfilled) ? 0 : 1);
+        if(!stack.is_callable(-1)) {
+          if(state == fulfilled) {
+            resolve_promise(stack, derived, value);
+          } else {
+            reject_promise(stack, derived, value);
+          }
+        } else {
+          stack.dup(value);
+          if(pcall_job(js, 1)) {
+            resolve_promise(stack, derived, -1);
+          } else {
+            reject_promise(stack, derived, -1);
+          }
+        }
+        break;
+      }
+      case reaction_finally: {
+        // Call the handler without arguments, then settle the derived promise
+        // like the original one when the handler's result is fulfilled.
+        stack.get_prop_index(reaction, 0);
+        if(!pcall_job(js, 0)) {
+          reject_promise(stack, derived, -1);
+        } else {
+          push_resolved(stack, -1);
+          stack.push_array();
+          stack.push_undefined();
+          stack.put_prop_index(-2, 0);
+          stack.push_undefined();
+          stack.put_prop_index(-2, 1);
+          stack.dup(derived);
+          stack.put_prop_index(-2, 2);
+          stack.push(int(reaction_finally_pass));
+          stack.put_prop_index(-2, 3);
+          stack.push_array();
+          stack.push(state);
+          stack.put_prop_index(-2, 0);
+          stack.dup(value);
+          stack.put_prop_index(-2, 1);
+          stack.put_prop_index(-2, 4);
+          add_reaction(stack, -2);
+        }
+        break;
+      }
+      case reaction_finally_pass: {
+        if(state == rejected) {
+          reject_promise(stack, derived, value);
+        } else {
+          stack.get_prop_index(reaction, 4);
+          stack.get_prop_index(-1, 0);
+          const int original_state = stack.get<int>(-1);
+          stack.pop();
+          stack.get_prop_index(-1, 1);
+          if(original_state == fulfilled) {
+            resolve_promise(stack, derived, -1);
+          } else {
+            reject_promise(stack, derived, -1);
+          }
+        }
+        break;
+      }
+      case reaction_all:
+      case reaction_all_settled: {
+        if((kind == reaction_all) && (state == rejected)) {
+          reject_promise(stack, derived, value);
+          break;
+        }
+        stack.get_prop_index(reaction, 4);
+        stack.get_prop_index(-1, 0);
+        const index_t record = stack.top()-1;
+        stack.get_prop_index(-2, 1);
+        const duk_uarridx_t index = stack.get<duk_uarridx_t>(-1);
+        stack.pop();
+        stack.get_prop_string(record, "values");
+        if(kind == reaction_all) {
+          stack.dup(value);
+        } else {
+          stack.push_object();
+          stack.push_string((state == fulfilled) ? "fulfilled" : "rejected");
+          stack.put_prop_string(-2, "status");
+          stack.dup(value);
+          stack.put_prop_string(-2, (state == fulfilled) ? "value" : "reason");
+        }
+        stack.put_prop_index(-2, index);
+        stack.get_prop_string(record, "remaining");
+        const double remaining = stack.get<double>(-1) - 1;
+        stack.pop();
+        stack.push(remaining);
+        stack.put_prop_string(record, "remaining");
+        if(remaining <= 0) resolve_promise(stack, derived, -1);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  template <typename=void>
+  void run_thenable(duktape::engine& js, index_t job)
+  {
+    duktape::api& stack = js.stack();
+    stack.require_stack(10);
+    stack.get_prop_index(job, 1);
+    const index_t promise = stack.top()-1;
+    push_resolving_functions(stack, promise);
+    stack.get_prop_index(job, 3);
+    stack.get_prop_index(job, 2);
+    stack.dup(promise+1);
+    stack.dup(promise+2);
+    if(!pcall_job(js, 2, true)) {
+      stack.dup(promise+2);
+      stack.swap(-1, -2);
+      stack.pcall(1);
+    }
+  }
+
+  /**
+   * Processes the job queue until it is empty, including the jobs queued
+   * meanwhile. No-op if the module is not defined in the engine. If a job
+   * throws (exceeded execution limits), the jobs not processed yet are put
+   * back to the front of the queue.
+   */
+  template <typename=void>
+  void run_jobs(duktape::engine& js)
+  {
+    duktape::api& stack = js.stack();
+    stack_guard sg(stack);
+    stack.require_stack(4);
+    stack.push_heap_stash();
+    const index_t stash = stack.top()-1;
+    for(;;) {
+      stack.get_prop_string(stash, "\xff_promise_jobs");
+      if(!stack.is_array(-1)) return;
+      const size_t n = stack.get_length(-1);
+      if(!n) return;
+      stack.push_array();
+      stack.put_prop_string(stash, "\xff_promise_jobs");
+      const index_t jobs = stack.top()-1;
+      size_t i = 0;
+      try {
+        for(; i<n; ++i) {
+          stack.get_prop_index(jobs, duk_uarridx_t(i));
+          const index_t job = stack.top()-1;
+          stack.get_prop_index(job, 0);
+          const int type = stack.get<int>(-1);
+          stack.pop();
+          if(type == job_reaction) {
+            run_reaction(js, job);
+          } else {
+            run_thenable(js, job);
+          }
+          stack.top(job);
+        }
+      } catch(...) {
+        stack.top(jobs+1);
+        stack.get_prop_string(stash, "\xff_promise_jobs");
+        const size_t nqueued = stack.get_length(-1);
+        duk_uarridx_t k = 0;
+        for(size_t j=i+1; j<n; ++j) {
+          stack.get_prop_index(jobs, duk_uarridx_t(j));
+          stack.put_prop_index(jobs, k++);
+        }
+        for(size_t j=0; j<nqueued; ++j) {
+          stack.get_prop_index(-1, duk_uarridx_t(j));
+          stack.put_prop_index(jobs, k++);
+        }
+        stack.set_length(jobs, k);
+        stack.dup(jobs);
+        stack.put_prop_string(stash, "\xff_promise_jobs");
+        throw;
+      }
+      stack.top(jobs);
+    }
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="js functions" defaultstate="collapsed">
+  #if(0 && JSDOC)
+  /**
+   * Creates a new promise. The `executor` is called immediately with the
+   * functions `resolve(value)` and `reject(reason)`. Exceptions thrown
+   * in the executor reject the promise. Reactions (`then()` etc) are
+   * processed when the running script has returned.
+   *
+   * @constructor
+   * @throws {Error}
+   * @param {function} executor
+   */
+  function Promise(executor) {};
+  #endif
+  template <typename=void>
+  duk_ret_t promise_constructor(duk_context* ctx)
+  {
+    duktape::api stack(ctx);
+    if(!stack.is_constructor_call()) return stack.throw_exception("Promise constructor must be called with 'new'.");
+    if(!stack.is_callable(0)) return stack.throw_exception("Promise executor is not a function.");
+    stack.require_stack(6);
+    stack.push_this();
+    init_promise(stack, 1);
+    push_resolving_functions(stack, 1);
+    stack.dup(0);
+    stack.dup(2);
+    stack.dup(3);
+    if(!pcall_job(stack.parent_engine(), 2)) {
+      stack.dup(3);
+      stack.swap(-1, -2);
+      stack.pcall(1);
+    }
+    return 0;
+  }
+
+  /**
+   * Pushes a new promise derived from the promise `this` with a reaction of
+   * the given kind, handlers at stack index 0/1 (if callable).
+   */
+  template <typename=void>
+  duk_ret_t derive(duktape::api& stack, const char* fname, int kind, bool on_fulfilled, bool on_rejected)
+  {
+    stack.require_stack(6);
+    stack.push_this();
+    const index_t self = stack.top()-1;
+    if(!is_promise(stack, self)) return stack.throw_exception(std::string("Promise.prototype.") + fname + "() called on a non-promise.");
+    push_new_promise(stack);
+    stack.push_array();
+    if(on_fulfilled && stack.is_callable(0)) stack.dup(0); else stack.push_undefined();
+    stack.put_prop_index(-2, 0);
+    if(on_rejected && stack.is_callable(1)) stack.dup(1); else stack.push_undefined();
+    stack.put_prop_index(-2, 1);
+    stack.dup(self+1);
+    stack.put_prop_index(-2, 2);
+    stack.push(kind);
+    stack.put_prop_index(-2, 3);
+    add_reaction(stack, self);
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Registers fulfillment and rejection handlers, returns a new promise
+   * resolved with the return value of the called handler (or rejected with
+   * its exception). Missing handlers pass the value or reason through.
+   *
+   * @param {function} [onFulfilled]
+   * @param {function} [onRejected]
+   * @returns {Promise}
+   */
+  Promise.prototype.then = function(onFulfilled, onRejected) {};
+  #endif
+  template <typename=void>
+  duk_ret_t promise_then(duk_context* ctx)
+  { duktape::api stack(ctx); return derive(stack, "then", reaction_then, true, true); }
+
+  #if(0 && JSDOC)
+  /**
+   * Registers a rejection handler, same as `then(undefined, onRejected)`.
+   *
+   * @param {function} onRejected
+   * @returns {Promise}
+   */
+  Promise.prototype.catch = function(onRejected) {};
+  #endif
+  template <typename=void>
+  duk_ret_t promise_catch(duk_context* ctx)
+  {
+    duktape::api stack(ctx);
+    stack.top(1);
+    stack.push_undefined();
+    stack.swap(0, 1);
+    return derive(stack, "catch", reaction_then, false, true);
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Registers a handler called without arguments when the promise is
+   * settled. The returned promise is settled like this promise, unless
+   * the handler throws or returns a rejected promise.
+   *
+   * @param {function} onFinally
+   * @returns {Promise}
+   */
+  Promise.prototype.finally = function(onFinally) {};
+  #endif
+  template <typename=void>
+  duk_ret_t promise_finally(duk_context* ctx)
+  {
+    duktape::api stack(ctx);
+    stack.top(1);
+    stack.dup(0);
+    return derive(stack, "finally", stack.is_callable(0) ? reaction_finally : reaction_then, true, true);
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Returns `value` if it is a promise, otherwise a new promise resolved
+   * with `value` (following thenables).
+   *
+   * @param {any} value
+   * @returns {Promise}
+   */
+  Promise.resolve = function(value) {};
+  #endif
+  template <typename=void>
+  duk_ret_t promise_resolve(duk_context* ctx)
+  { duktape::api stack(ctx); push_resolved(stack, 0); return 1; }
+
+  #if(0 && JSDOC)
+  /**
+   * Returns a new promise rejected with `reason`.
+   *
+   * @param {any} reason
+   * @returns {Promise}
+   */
+  Promise.reject = function(reason) {};
+  #endif
+  template <typename=void>
+  duk_ret_t promise_reject(duk_context* ctx)
+  {
+    duktape::api stack(ctx);
+    push_new_promise(stack);
+    reject_promise(stack, -1, 0);
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Returns a promise fulfilled with the array of the values of all
+   * promises (or values) in `promises`, or rejected with the first
+   * rejection reason.
+   *
+   * @param {Array} promises
+   * @returns {Promise}
+   */
+  Promise.all = function(promises) {};
+
+  /**
+   * Returns a promise settled like the first settled promise in `promises`.
+   *
+   * @param {Array} promises
+   * @returns {Promise}
+   */
+  Promise.race = function(promises) {};
+
+  /**
+   * Returns a promise fulfilled when all promises in `promises` are settled,
+   * with an array of `{status:"fulfilled", value:...}` and
+   * `{status:"rejected", reason:...}` objects.
+   *
+   * @param {Array} promises
+   * @returns {Promise}
+   */
+  Promise.allSettled = function(promises) {};
+  #endif
+  template <int Kind>
+  duk_ret_t promise_combine(duk_context* ctx)
+  {
+    duktape::api stack(ctx);
+    stack.require_stack(10);
+    push_new_promise(stack);
+    if(!stack.is_object(0)) {
+      push_type_error(stack, "Promise combinator argument is not an array.");
+      reject_promise(stack, 1, -1);
+      stack.pop();
+      return 1;
+    }
+    const size_t n = stack.get_length(0);
+    stack.push_object();
+    stack.push_array();
+    stack.put_prop_string(2, "values");
+    stack.push(double(n));
+    stack.put_prop_string(2, "remaining");
+    for(size_t i=0; i<n; ++i) {
+      stack.get_prop_index(0, duk_uarridx_t(i));
+      push_resolved(stack, -1);
+      stack.push_array();
+      stack.push_undefined();
+      stack.put_prop_index(-2, 0);
+      stack.push_undefined();
+      stack.put_prop_index(-2, 1);
+      stack.dup(1);
+      stack.put_prop_index(-2, 2);
+      stack.push(Kind);
+      stack.put_prop_index(-2, 3);
+      if(Kind != reaction_then) {
+        stack.push_array();
+        stack.dup(2);
+        stack.put_prop_index(-2, 0);
+        stack.push(double(i));
+        stack.put_prop_index(-2, 1);
+        stack.put_prop_index(-2, 4);
+      }
+      add_reaction(stack, -2);
+      stack.pop(2);
+    }
+    if((!n) && (Kind != reaction_then)) {
+      stack.get_prop_string(2, "values");
+      resolve_promise(stack, 1, -1);
+    }
+    stack.top(2);
+    return 1;
+  }
+  // </editor-fold>
+
+}}}
+
+namespace duktape { namespace mod { namespace promise {
+
+  // <editor-fold desc="js decls" defaultstate="collapsed">
+  /**
+   * Export main relay. Adds the `Promise` object to the specified engine
+   * and registers the job queue processing in `engine::job_hook()`
+   * (a previously set hook is invoked afterwards).
+   * @param duktape::engine& js
+   */
+  template <typename=void>
+  static void define_in(duktape::engine& js)
+  {
+    using namespace ::duktape::detail::promise;
+    duktape::api& stack = js.stack();
+    {
+      stack_guard sg(stack);
+      stack.push_heap_stash();
+      if(stack.has_prop_string(-1, "\xff_promise_jobs")) return;
+    }
+    js.define("Promise", promise_constructor<>, 1);
+    js.define("Promise.prototype.then", promise_then<>, 2);
+    js.define("Promise.prototype.catch", promise_catch<>, 1);
+    js.define("Promise.prototype.finally", promise_finally<>, 1);
+    js.define("Promise.resolve", promise_resolve<>, 1);
+    js.define("Promise.reject", promise_reject<>, 1);
+    js.define("Promise.all", promise_combine<reaction_all>, 1);
+    js.define("Promise.race", promise_combine<reaction_then>, 1);
+    js.define("Promise.allSettled", promise_combine<reaction_all_settled>, 1);
+    {
+      stack_guard sg(stack);
+      stack.require_stack(5);
+      const duktape::api::index_t stash = stack.top();
+      stack.push_heap_stash();
+      stack.push_array();
+      stack.put_prop_string(stash, "\xff_promise_jobs");
+      stack.get_global_string("Promise");
+      stack.get_prop_string(-1, "prototype");
+      stack.dup(-2);
+      stack.put_prop_string(-2, "constructor");
+      stack.put_prop_string_hidden(stash, "promise_prototype");
+    }
+    auto previous = js.job_hook();
+    js.job_hook([previous](duktape::engine& e) {
+      ::duktape::detail::promise::run_jobs(e);
+      if(previous) previous(e);
+    });
+  }
+
+  /**
+   * Processes the pending Promise jobs (microtasks). Normally invoked
+   * automatically after `eval()`/`call()` and by the event loop.
+   * @param duktape::engine& js
+   */
+  template <typename=void>
+  static void run_jobs(duktape::engine& js)
+  { ::duktape::detail::promise::run_jobs(js); }
+
+  /**
+   * Pushes a new pending promise. To settle it later (e.g. from an I/O
+   * callback), keep a reference reachable for the garbage collector,
+   * e.g. in the heap stash.
+   * @param duktape::api& stack
+   */
+  template <typename=void>
+  static void push_promise(duktape::api& stack)
+  { ::duktape::detail::promise::push_new_promise(stack); }
+
+  /**
+   * Returns true if the value at stack index `index` is a promise.
+   * @param duktape::api& stack
+   * @param duktape::api::index_t index
+   * @return bool
+   */
+  template <typename=void>
+  static bool is_promise(duktape::api& stack, duktape::api::index_t index)
+  { return ::duktape::detail::promise::is_promise(stack, index); }
+
+  /**
+   * Resolves the promise at stack index `promise` with the value at stack
+   * index `value`. Ignored if the promise is already resolved.
+   * @param duktape::api& stack
+   * @param duktape::api::index_t promise
+   * @param duktape::api::index_t value
+   */
+  template <typename=void>
+  static void resolve(duktape::api& stack, duktape::api::index_t promise, duktape::api::index_t value)
+  { ::duktape::detail::promise::resolve_promise(stack, promise, value); }
+
+  /**
+   * Resolves the promise at stack index `promise` with a C++ value.
+   * @param duktape::api& stack
+   * @param duktape::api::index_t promise
+   * @param const T& value
+   */
+  template <typename T>
+  static void resolve_with(duktape::api& stack, duktape::api::index_t promise, const T& value)
+  {
+    promise = stack.normalize_index(promise);
+    stack.push(value);
+    ::duktape::detail::promise::resolve_promise(stack, promise, -1);
+    stack.pop();
+  }
+
+  /**
+   * Rejects the promise at stack index `promise` with the value at stack
+   * index `reason`. Ignored if the promise is already resolved.
+   * @param duktape::api& stack
+   * @param duktape::api::index_t promise
+   * @param duktape::api::index_t reason
+   */
+  template <typename=void>
+  static void reject(duktape::api& stack, duktape::api::index_t promise, duktape::api::index_t reason)
+  { ::duktape::detail::promise::reject_promise(stack, promise, reason); }
+
+  /**
+   * Rejects the promise at stack index `promise` with a new `Error`
+   * object with the given message.
+   * @param duktape::api& stack
+   * @param duktape::api::index_t promise
+   * @param std::string message
+   */
+  template <typename=void>
+  static void reject_with_error(duktape::api& stack, duktape::api::index_t promise, std::string message)
+  {
+    promise = stack.normalize_index(promise);
+    ::duk_push_error_object(stack.ctx(), DUK_ERR_ERROR, "%s", message.c_str());
+    ::duktape::detail::promise::reject_promise(stack, promise, -1);
+    stack.pop();
+  }
+  // </editor-fold>
+
+}}}
+
+#endif
@@ -0,0 +1,424 @@
+/**
+ * @file duktape/mod/mod.sys.encode.hh
+ * @package de.atwillys.cc.duktape
+ * @license MIT
+ * @authors Stefan Wilhelm (stfwi, <cerbero s@atwillys.de>)
+ * @platform linux, bsd, windows
+ * @standard >= c++11
+ * @requires duk_config.h duktape.h duktape.c >= v2.1
+ * @requires Duktape CFLAGS -DDUK_USE_CPP_EXCEPTIONS
+ * @cxxflags -std=c++11 -W -Wall -Wextra -pedantic -fstrict-aliasing
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Duktape ECMA engine C++ wrapper, binary to text encoding functions.
+ *
+ *  - Hex (lower case) encoding/decoding of strings and buffers.
+ *  - Base64 (RFC 4648) encoding/decoding of strings and buffers.
+ *
+ * The table driven encoders are also used by the hash module to format
+ * digests.
+ *
+ * -----------------------------------------------------------------------------
+ * License: http://opensource.org/licenses/MIT
+ * Copyright (c) 2014-2017, the authors (see the @authors tag in this file).
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions: The above copyright notice and
+ * this permission notice shall be included in all copies or substantial portions
+ * of the Software. THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef DUKTAPE_MOD_SYS_ENCODE_HH
+#define DUKTAPE_MOD_SYS_ENCODE_HH
+
+// <editor-fold desc="swlib-cc.encoding" defaultstate="collapsed">
+#ifndef SW_ENCODING_HH
+#define SW_ENCODING_HH
+
+#include <string>
+#include <cstdlib>
+#if defined(OS_WIN) || defined (_WINDOWS_) || defined(_WIN32) || defined(__MSC_VER)
+#include <stdint.h>
+#else
+#include <inttypes.h>
+#endif
+
+namespace sw { namespace detail {
+
+template <typename=void>
+struct encoding_tables
+{
+  static const char hex[513];
+  static const char base64[65];
+  static const int8_t hex_values[256];
+  static const int8_t base64_values[256];
+};
+
+template <typename T>
+const char encoding_tables<T>::hex[513] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+template <typename T>
+const char encoding_tables<T>::base64[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+template <typename T>
+const int8_t encoding_tables<T>::hex_values[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    0,1,2,3,4,5,6,7,8,9,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+};
+
+template <typename T>
+const int8_t encoding_tables<T>::base64_values[256] = { // includes the URL safe '-' and '_'
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,62,-1,63,
+    52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-1,-1,-1,
+    -1,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,
+    15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,63,
+    -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
+    41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+};
+
+/**
+ * @class basic_encoding
+ * @template
+ *
+ * Table driven hex and base64 encoding into preallocated output or strings.
+ */
+template <typename Char_Type=char>
+struct basic_encoding
+{
+  typedef std::basic_string<Char_Type> str_t;
+
+  /**
+   * Number of characters of the hex representation of `size` bytes.
+   */
+  static constexpr size_t hex_size(size_t size) noexcept
+  { return 2 * size; }
+
+  /**
+   * Maximum number of bytes decoded from `length` hex characters.
+   */
+  static constexpr size_t unhex_size(size_t length) noexcept
+  { return length / 2; }
+
+  /**
+   * Number of characters of the (padded) base64 representation of `size` bytes.
+   */
+  static constexpr size_t base64_size(size_t size) noexcept
+  { return ((size + 2) / 3) * 4; }
+
+  /**
+   * Maximum number of bytes decoded from `length` base64 characters.
+   */
+  static constexpr size_t unbase64_size(size_t length) noexcept
+  { return ((length + 3) / 4) * 3; }
+
+  /**
+   * Writes the lower case hex representation of the data to `out`, which
+   * must have space for `hex_size(size)` characters.
+   * @param const void* data
+   * @param size_t size
+   * @param Char_Type* out
+   */
+  static void hex(const void* data, size_t size, Char_Type* out) noexcept
+  {
+    const uint8_t* p = (const uint8_t*) data;
+    const char* tab = encoding_tables<>::hex;
+    for(size_t i = 0; i < size; ++i) {
+      const char* e = &tab[2 * p[i]];
+      *out++ = Char_Type(e[0]);
+      *out++ = Char_Type(e[1]);
+    }
+  }
+
+  /**
+   * Returns the lower case hex representation of the data.
+   * @param const void* data
+   * @param size_t size
+   * @return str_t
+   */
+  static str_t hex(const void* data, size_t size)
+  {
+    str_t s(hex_size(size), Char_Type(0));
+    if(size) hex(data, size, &s[0]);
+    return s;
+  }
+
+  /**
+   * Decodes hex (upper or lower case) to `out`, which must have space for
+   * `unhex_size(length)` bytes. Returns the number of decoded bytes, or
+   * `size_t(-1)` if the input is no valid hex sequence.
+   * @param const Char_Type* s
+   * @param size_t length
+   * @param void* out
+   * @return size_t
+   */
+  static size_t unhex(const Char_Type* s, size_t length, void* out) noexcept
+  {
+    if(length & 1) return size_t(-1);
+    uint8_t* o = (uint8_t*) out;
+    const int8_t* tab = encoding_tables<>::hex_values;
+    for(size_t i = 0; i < length; i += 2) {
+      if((size_t(s[i]) > 0xff) || (size_t(s[i+1]) > 0xff)) return size_t(-1);
+      const int hi = tab[uint8_t(s[i])], lo = tab[uint8_t(s[i+1])];
+      if((hi < 0) || (lo < 0)) return size_t(-1);
+      *o++ = uint8_t((hi << 4) | lo);
+    }
+    return length / 2;
+  }
+
+  /**
+   * Writes the padded base64 representation of the data to `out`, which
+   * must have space for `base64_size(size)` characters.
+   * @param const void* data
+   * @param size_t size
+   * @param Char_Type* out
+   */
+  static void base64(const void* data, size_t size, Char_Type* out) noexcept
+  {
+    const uint8_t* p = (const uint8_t*) data;
+    const char* tab = encoding_tables<>::base64;
+    for(; size >= 3; size -= 3, p += 3) {
+      const uint32_t v = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | uint32_t(p[2]);
+      *out++ = Char_Type(tab[(v >> 18) & 0x3f]);
+      *out++ = Char_Type(tab[(v >> 12) & 0x3f]);
+      *out++ = Char_Type(tab[(v >>  6) & 0x3f]);
+      *out++ = Char_Type(tab[(v >>  0) & 0x3f]);
+    }
+    if(size) {
+      const uint32_t v = (uint32_t(p[0]) << 16) | ((size > 1) ? (uint32_t(p[1]) << 8) : 0u);
+      *out++ = Char_Type(tab[(v >> 18) & 0x3f]);
+      *out++ = Char_Type(tab[(v >> 12) & 0x3f]);
+      *out++ = (size > 1) ? Char_Type(tab[(v >> 6) & 0x3f]) : Char_Type('=');
+      *out++ = Char_Type('=');
+    }
+  }
+
+  /**
+   * Returns the padded base64 representation of the data.
+   * @param const void* data
+   * @param size_t size
+   * @return str_t
+   */
+  static str_t base64(const void* data, size_t size)
+  {
+    str_t s(base64_size(size), Char_Type(0));
+    if(size) base64(data, size, &s[0]);
+    return s;
+  }
+
+  /**
+   * Decodes base64 (standard or URL safe alphabet, padding optional) to
+   * `out`, which must have space for `unbase64_size(length)` bytes. Returns
+   * the number of decoded bytes, or `size_t(-1)` on invalid input.
+   * @param const Char_Type* s
+   * @param size_t length
+   * @param void* out
+   * @return size_t
+   */
+  static size_t unbase64(const Char_Type* s, size_t length, void* out) noexcept
+  {
+    while(length && (s[length-1] == Char_Type('='))) --length;
+    if((length % 4) == 1) return size_t(-1);
+    uint8_t* o = (uint8_t*) out;
+    const int8_t* tab = encoding_tables<>::base64_values;
+    uint32_t v = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < length; ++i) {
+      if(size_t(s[i]) > 0xff) return size_t(-1);
+      const int c = tab[uint8_t(s[i])];
+      if(c < 0) return size_t(-1);
+      v = (v << 6) | uint32_t(c);
+      if((i & 3) == 3) {
+        o[n++] = uint8_t(v >> 16); o[n++] = uint8_t(v >> 8); o[n++] = uint8_t(v);
+        v = 0;
+      }
+    }
+    switch(length & 3) {
+      case 2: o[n++] = uint8_t(v >> 4); break;
+      case 3: o[n++] = uint8_t(v >> 10); o[n++] = uint8_t(v >> 2); break;
+      default: break;
+    }
+    return n;
+  }
+};
+
+}}
+
+namespace sw {
+  typedef detail::basic_encoding<> encoding;
+}
+
+#endif
+// </editor-fold>
+
+// <editor-fold desc="duktape-cc bindings" defaultstate="collapsed">
+#include "../duktape.hh"
+#include <string>
+
+namespace duktape { namespace detail { namespace system { namespace encode {
+
+  #if(0 && JSDOC)
+  /**
+   * Binary to text encoding functions of the system object.
+   * @var {object}
+   */
+  sys.encode = {};
+  #endif
+
+  #if(0 && JSDOC)
+  /**
+   * Binary from text decoding functions of the system object.
+   * @var {object}
+   */
+  sys.decode = {};
+  #endif
+
+  #if(0 && JSDOC)
+  /**
+   * Returns the lower case hex representation of a string or buffer.
+   *
+   * @throws {Error}
+   * @param {string|buffer} data
+   * @returns {string}
+   */
+  sys.encode.hex = function(data) {};
+  #endif
+  template <typename=void>
+  int hex_encode(duktape::api& stack)
+  {
+    const void* data; size_t size;
+    if(!stack.get_data_view(0, data, size)) return stack.throw_exception("sys.encode.hex(): Data have to be a string or buffer.");
+    stack.push(sw::encoding::hex(data, size));
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Returns the base64 representation (with padding) of a string or buffer.
+   *
+   * @throws {Error}
+   * @param {string|buffer} data
+   * @returns {string}
+   */
+  sys.encode.base64 = function(data) {};
+  #endif
+  template <typename=void>
+  int base64_encode(duktape::api& stack)
+  {
+    const void* data; size_t size;
+    if(!stack.get_data_view(0, data, size)) return stack.throw_exception("sys.encode.base64(): Data have to be a string or buffer.");
+    stack.push(sw::encoding::base64(data, size));
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Decodes a hex string (upper or lower case) into a buffer.
+   *
+   * @throws {Error}
+   * @param {string} text
+   * @returns {buffer}
+   */
+  sys.decode.hex = function(text) {};
+  #endif
+  template <typename=void>
+  int hex_decode(duktape::api& stack)
+  {
+    if(!stack.is<std::string>(0)) return stack.throw_exception("sys.decode.hex(): Argument must be a string.");
+    size_t length = 0;
+    const char* s = stack.get_lstring(0, length);
+    const size_t n = sw::encoding::unhex_size(length);
+    void* out = stack.push_fixed_buffer(n);
+    if(sw::encoding::unhex(s, length, out) != n) return stack.throw_exception("sys.decode.hex(): Invalid hex string.");
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Decodes a base64 string (standard or URL safe alphabet, padding optional)
+   * into a buffer.
+   *
+   * @throws {Error}
+   * @param {string} text
+   * @returns {buffer}
+   */
+  sys.decode.base64 = function(text) {};
+  #endif
+  template <typename=void>
+  int base64_decode(duktape::api& stack)
+  {
+    if(!stack.is<std::string>(0)) return stack.throw_exception("sys.decode.base64(): Argument must be a string.");
+    size_t length = 0;
+    const char* s = stack.get_lstring(0, length);
+    void* out = stack.push_buffer(sw::encoding::unbase64_size(length), true);
+    const size_t n = sw::encoding::unbase64(s, length, out);
+    if(n == size_t(-1)) return stack.throw_exception("sys.decode.base64(): Invalid base64 string.");
+    stack.resize_buffer(-1, n);
+    return 1;
+  }
+
+}}}}
+// </editor-fold>
+
+namespace duktape { namespace mod { namespace system { namespace encode {
+
+  // <editor-fold desc="js decls" defaultstate="collapsed">
+  using namespace ::duktape::detail::system::encode;
+
+  /**
+   * Export main relay. Adds all module functions to the specified engine.
+   * @param duktape::engine& js
+   */
+  template <typename=void>
+  static void define_in(duktape::engine& js)
+  {
+    js.define("sys.encode.hex", hex_encode<>, 1);
+    js.define("sys.encode.base64", base64_encode<>, 1);
+    js.define("sys.decode.hex", hex_decode<>, 1);
+    js.define("sys.decode.base64", base64_decode<>, 1);
+  }
+  // </editor-fold>
+
+}}}}
+
+#endif
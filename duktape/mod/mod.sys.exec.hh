@@ -42,6 +42,8 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <fstream>
+#include <iterator>
 
 #if defined(_MSCVER) || defined(__MINGW32__) || defined(__MINGW64__)
   #include <windows.h>
@@ -65,8 +67,16 @@
   #include <sys/stat.h>
   #include <sys/types.h>
   #include <sys/time.h>
+  #include <sys/resource.h>
+  #include <sys/socket.h>
+  #include <sys/uio.h>
+  #include <mutex>
+  #include <cstdint>
+  #include <unordered_map>
   #ifdef __linux__
     #include <wait.h>
+    #include <sys/prctl.h>
+    #include <sys/syscall.h>
   #else
     #include <sys/wait.h>
   #endif
@@ -119,7 +129,722 @@ namespace duktape { namespace detail { namespace system { namespace exec {
   }
   // </editor-fold>
 
+  // <editor-fold desc="process_stats" defaultstate="collapsed">
+  /**
+   * Resource usage of a terminated child process, filled by the execute
+   * backends if a pointer is passed. Times in milliseconds, RSS in bytes.
+   */
+  struct process_stats
+  {
+    bool valid = false;
+    double walltime = 0, utime = 0, stime = 0;
+    double maxrss = 0;
+    double minflt = 0, majflt = 0, nvcsw = 0, nivcsw = 0;
+  };
+  // </editor-fold>
+
+  // <editor-fold desc="stdin_source" defaultstate="collapsed">
+  /**
+   * Closes an owned file descriptor on scope exit.
+   */
+  struct fd_guard
+  {
+    int fd = -1;
+    fd_guard() noexcept = default;
+    fd_guard(const fd_guard&) = delete;
+    fd_guard& operator=(const fd_guard&) = delete;
+    #ifndef WINDOWS
+    ~fd_guard() noexcept { if(fd >= 0) ::close(fd); }
+    #endif
+  };
+
+  /**
+   * Data source for the stdin of a child process. Either a borrowed memory
+   * range, which is written from an offset cursor and not copied (must stay
+   * valid during the execution), or a file descriptor, which is directly
+   * passed to the child as stdin (not closed by the backend).
+   */
+  struct stdin_source
+  {
+    const char* data = nullptr;
+    size_t size = 0;
+    int fd = -1;
+
+    stdin_source() noexcept = default;
+    stdin_source(const std::string& s) noexcept : data(s.data()), size(s.size()), fd(-1) { }
+    stdin_source(const char* d, size_t n) noexcept : data(d), size(n), fd(-1) { }
+    bool empty() const noexcept { return (!size) && (fd < 0); }
+  };
+  // </editor-fold>
+
   #ifndef WINDOWS
+  // <editor-fold desc="write_nosigpipe: linux" defaultstate="collapsed">
+  /**
+   * Pipe write without raising SIGPIPE in this process when the reading
+   * child has already closed its end (returns -1/EPIPE instead).
+   */
+  template <typename=void>
+  ssize_t write_nosigpipe(int fd, const void* data, size_t size) noexcept
+  {
+    ::sigset_t sigpipe_mask, old_mask;
+    sigemptyset(&sigpipe_mask);
+    sigaddset(&sigpipe_mask, SIGPIPE);
+    ::sigset_t pending;
+    sigemptyset(&pending);
+    ::sigpending(&pending);
+    const bool was_pending = sigismember(&pending, SIGPIPE);
+    if(::pthread_sigmask(SIG_BLOCK, &sigpipe_mask, &old_mask)) return ::write(fd, data, size);
+    const ssize_t r = ::write(fd, data, size);
+    const int err = errno;
+    if((r < 0) && (err == EPIPE) && (!was_pending)) {
+      const struct ::timespec ts = {0,0};
+      while((::sigtimedwait(&sigpipe_mask, nullptr, &ts) < 0) && (errno == EINTR));
+    }
+    ::pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    errno = err;
+    return r;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="exec_child: linux" defaultstate="collapsed">
+  /**
+   * Composes the argv/envv pointer arrays for the exec*() calls. The
+   * environment vector contains alternating key/value pairs, which are set
+   * over the inherited environment, or form the complete child environment
+   * if `dont_inherit_environment` is set (then modified to "key=value").
+   */
+  template <typename=void>
+  void compose_exec_args(
+    const std::string& program,
+    const std::vector<std::string>& arguments,
+    std::vector<std::string>& environment,
+    bool dont_inherit_environment,
+    std::vector<const char*>& argv,
+    std::vector<const char*>& envv
+  )
+  {
+    argv.clear();
+    envv.clear();
+    argv.push_back(program.c_str());
+    for(auto& e:arguments) argv.push_back(e.c_str());
+    argv.push_back(nullptr);
+    if(!dont_inherit_environment) {
+      for(auto& e:environment) envv.push_back(e.c_str());
+      envv.push_back(nullptr);
+      envv.push_back(nullptr);
+    } else {
+      if(!environment.empty()) {
+        if(environment.size() & 1) environment.push_back("");
+        std::vector<std::string> tenv;
+        for(size_t i=0; i<environment.size()-1; i+=2) {
+          tenv.emplace_back(environment[i] + "=" + environment[i+1]);
+        }
+        environment.swap(tenv);
+        for(auto& e:environment) envv.push_back(e.c_str());
+      }
+      envv.push_back(nullptr);
+    }
+  }
+
+  /**
+   * Child process part of fork_exec(): Connects the stdio descriptors
+   * (< 0: /dev/null), closes all other descriptors, and executes the
+   * program. Does not return.
+   */
+  template <typename=void>
+  void exec_child(
+    const std::string& program,
+    const std::vector<const char*>& argv,
+    const std::vector<const char*>& envv,
+    bool without_path_search,
+    bool dont_inherit_environment,
+    const int (&fds)[3]
+  ) noexcept
+  {
+    for(int i=0; i<3; ++i) {
+      int fd = (fds[i] >= 0) ? fds[i] : ::open("/dev/null", (i==STDIN_FILENO) ? O_RDONLY : O_WRONLY);
+      if((fd < 0) || (::dup2(fd, i) < 0)) ::_exit(1);
+    }
+    for(int i=3; i<1024; ++i) ::close(i);
+    if(!dont_inherit_environment) {
+      for(size_t i=0; (i < envv.size()-2) && envv[i] && envv[i+1]; i+=2) ::setenv(envv[i], envv[i+1], 1);
+      if(without_path_search) {
+        ::execv(program.c_str(), (char* const*)(&argv[0]));
+      } else {
+        ::execvp(program.c_str(), (char* const*)(&argv[0]));
+      }
+    } else {
+      if(without_path_search) {
+        ::execve(program.c_str(), (char* const*)(&argv[0]), (char* const*)(&envv[0]));
+      } else {
+        ::execvpe(program.c_str(), (char* const*)(&argv[0]), (char* const*)(&envv[0]));
+      }
+    }
+    std::cerr << "Failed to run ''" << program << "': " << ::strerror(errno) << std::endl;
+    ::_exit(1);
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="spawn server: linux" defaultstate="collapsed">
+  /**
+   * State of the optional process wide spawn server ("zygote"). The server
+   * is a small helper process forked early by the host application (see
+   * `duktape::mod::system::exec::start_spawn_server()`). fork_exec()
+   * passes the execution requests over a UNIX socket, the stdio descriptors
+   * are transferred using SCM_RIGHTS. The server forks the children itself,
+   * so the forking process is small and single threaded, independent of the
+   * host size and its threads/locks. As parent, the server reaps its
+   * children and writes their exit status and resource usage to a status
+   * socket per child. The host end of this socket and a pidfd of the child
+   * (if supported by the kernel) are returned with the reply and registered
+   * in `children`, where wait_child() and kill_child() look them up.
+   */
+  struct spawn_server_child
+  {
+    int status_fd = -1;
+    int pid_fd = -1;
+  };
+
+  struct spawn_server_state
+  {
+    int fd = -1;
+    ::pid_t pid = -1;
+    unsigned long long requests = 0;
+    std::vector<const char*> environment;                   // `environ` entries known by the server.
+    std::unordered_map<::pid_t, spawn_server_child> children; // Children not waited for yet.
+    std::mutex mutex;
+  };
+
+  template <typename=void>
+  spawn_server_state& spawn_server() noexcept
+  { static spawn_server_state state; return state; }
+
+  namespace spawn_server_protocol {
+
+    static constexpr uint32_t magic = 0x64756b78u;
+    static constexpr uint32_t flag_nopath = 0x01u;
+    static constexpr uint32_t flag_noenv = 0x02u;
+    static constexpr uint32_t flag_fd0 = 0x10u;     // flag_fd0<<i: stdio fd i is transferred
+    static constexpr uint32_t flag_hostenv = 0x80u; // The host environment has changed and is appended.
+
+    /**
+     * Message written to the status socket when the child has terminated.
+     */
+    struct child_status
+    {
+      int status;
+      struct ::rusage usage;
+    };
+
+    template <typename=void>
+    void put(std::string& msg, uint32_t v)
+    { msg.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+    template <typename=void>
+    void put(std::string& msg, const std::string& s)
+    { put(msg, uint32_t(s.size())); msg.append(s); }
+
+    template <typename=void>
+    void put(std::string& msg, const char* s)
+    { const uint32_t n = uint32_t(std::strlen(s)); put(msg, n); msg.append(s, n); }
+
+    template <typename=void>
+    bool get(const std::string& msg, size_t& pos, uint32_t& v) noexcept
+    {
+      if(pos+sizeof(v) > msg.size()) return false;
+      std::memcpy(&v, msg.data()+pos, sizeof(v));
+      pos += sizeof(v);
+      return true;
+    }
+
+    template <typename=void>
+    bool get(const std::string& msg, size_t& pos, std::string& s)
+    {
+      uint32_t n;
+      if((!get(msg, pos, n)) || (pos+n > msg.size())) return false;
+      s.assign(msg.data()+pos, n);
+      pos += n;
+      return true;
+    }
+
+    template <typename=void>
+    bool get(const std::string& msg, size_t& pos, std::vector<std::string>& v)
+    {
+      uint32_t n;
+      if(!get(msg, pos, n)) return false;
+      v.clear();
+      for(uint32_t i=0; i<n; ++i) {
+        std::string s;
+        if(!get(msg, pos, s)) return false;
+        v.emplace_back(std::move(s));
+      }
+      return true;
+    }
+
+    template <typename=void>
+    bool read_all(int fd, void* data, size_t size) noexcept
+    {
+      char* p = reinterpret_cast<char*>(data);
+      while(size > 0) {
+        const ssize_t r = ::recv(fd, p, size, 0);
+        if(r > 0) { p += r; size -= size_t(r); }
+        else if((r < 0) && (errno == EINTR)) continue;
+        else return false;
+      }
+      return true;
+    }
+
+    template <typename=void>
+    bool write_all(int fd, const void* data, size_t size) noexcept
+    {
+      const char* p = reinterpret_cast<const char*>(data);
+      while(size > 0) {
+        const ssize_t r = ::send(fd, p, size, MSG_NOSIGNAL);
+        if(r > 0) { p += r; size -= size_t(r); }
+        else if((r < 0) && (errno == EINTR)) continue;
+        else return false;
+      }
+      return true;
+    }
+
+    /**
+     * Sends `size` bytes of `data` with the descriptors `fds` attached
+     * (SCM_RIGHTS, at most 3).
+     */
+    template <typename=void>
+    bool send_with_fds(int sock, const void* data, size_t size, const std::vector<int>& fds) noexcept
+    {
+      union { struct ::cmsghdr align; char buf[CMSG_SPACE(sizeof(int)*3)]; } cmsg_buffer;
+      std::memset(cmsg_buffer.buf, 0, sizeof(cmsg_buffer.buf));
+      struct ::iovec iov = { const_cast<void*>(data), size };
+      struct ::msghdr msg = ::msghdr();
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      if((!fds.empty()) && (fds.size() <= 3)) {
+        msg.msg_control = cmsg_buffer.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int)*fds.size());
+        struct ::cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int)*fds.size());
+        std::memcpy(CMSG_DATA(c), fds.data(), sizeof(int)*fds.size());
+      }
+      ssize_t r;
+      while(((r=::sendmsg(sock, &msg, MSG_NOSIGNAL)) < 0) && (errno == EINTR));
+      return (r > 0) && ((size_t(r) >= size) || write_all(sock, reinterpret_cast<const char*>(data)+r, size-size_t(r)));
+    }
+
+    /**
+     * Receives `size` bytes into `data`, descriptors attached to the
+     * message are appended to `fds` (close-on-exec).
+     */
+    template <typename=void>
+    bool recv_with_fds(int sock, void* data, size_t size, std::vector<int>& fds)
+    {
+      union { struct ::cmsghdr align; char buf[CMSG_SPACE(sizeof(int)*3)]; } cmsg_buffer;
+      struct ::iovec iov = { data, size };
+      struct ::msghdr msg = ::msghdr();
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = cmsg_buffer.buf;
+      msg.msg_controllen = sizeof(cmsg_buffer.buf);
+      ssize_t r;
+      while(((r=::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC)) < 0) && (errno == EINTR));
+      if(r <= 0) return false;
+      for(struct ::cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if((c->cmsg_level == SOL_SOCKET) && (c->cmsg_type == SCM_RIGHTS)) {
+          const size_t n = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+          for(size_t i=0; i<n; ++i) { int fd; std::memcpy(&fd, CMSG_DATA(c)+i*sizeof(int), sizeof(int)); fds.push_back(fd); }
+        }
+      }
+      return (size_t(r) >= size) || read_all(sock, reinterpret_cast<char*>(data)+r, size-size_t(r));
+    }
+
+    /**
+     * Returns a new pidfd of the child `pid`, -1 if not supported.
+     */
+    template <typename=void>
+    int open_pidfd(::pid_t pid) noexcept
+    {
+      #if defined(__linux__) && defined(SYS_pidfd_open)
+      return int(::syscall(SYS_pidfd_open, pid, 0));
+      #else
+      (void) pid;
+      return -1;
+      #endif
+    }
+
+    /**
+     * Write end of the server's SIGCHLD self-pipe.
+     */
+    template <typename=void>
+    int& sigchld_pipe() noexcept
+    { static int fd = -1; return fd; }
+
+    template <typename=void>
+    void on_sigchld(int) noexcept
+    {
+      const int err = errno;
+      const char c = 0;
+      if(::write(sigchld_pipe(), &c, 1) < 0) { /* pipe full: wakeup already pending */ }
+      errno = err;
+    }
+
+    /**
+     * Reaps the terminated children of the server (all remaining ones
+     * if `block` is set), and sends their status to the host.
+     */
+    template <typename=void>
+    void reap_children(std::unordered_map<::pid_t, int>& children, bool block) noexcept
+    {
+      while(!children.empty()) {
+        child_status msg = child_status();
+        const ::pid_t pid = ::wait4(-1, &msg.status, block ? 0 : WNOHANG, &msg.usage);
+        if(pid < 0) {
+          if(errno == EINTR) continue;
+          return;
+        } else if(pid == 0) {
+          return;
+        }
+        const auto it = children.find(pid);
+        if(it == children.end()) continue;
+        write_all(it->second, &msg, sizeof(msg));
+        ::close(it->second);
+        children.erase(it);
+      }
+    }
+
+    /**
+     * Server process main loop, exits when the host closes the socket and
+     * all children have terminated.
+     */
+    template <typename=void>
+    void server_main(int sock, ::pid_t host_pid) noexcept
+    {
+      #ifdef __linux__
+      ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+      #endif
+      if(::getppid() != host_pid) ::_exit(0);
+      for(int i=3; i<1024; ++i) { if(i != sock) ::close(i); }
+      std::unordered_map<::pid_t, int> children; // pid -> server end of the status socket
+      std::vector<std::string> host_environment;
+      int sigpipe[2] = {-1,-1};
+      if(::pipe(sigpipe)) ::_exit(1);
+      for(auto fd:sigpipe) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0)|O_NONBLOCK);
+      }
+      sigchld_pipe() = sigpipe[1];
+      {
+        struct ::sigaction sa = {};
+        sa.sa_handler = &on_sigchld<>;
+        sa.sa_flags = SA_RESTART|SA_NOCLDSTOP;
+        ::sigemptyset(&sa.sa_mask);
+        ::sigaction(SIGCHLD, &sa, nullptr);
+        ::sigset_t mask;
+        ::sigemptyset(&mask);
+        ::sigaddset(&mask, SIGCHLD);
+        ::sigprocmask(SIG_UNBLOCK, &mask, nullptr);
+      }
+      const auto shutdown = [&]() {
+        ::close(sock);
+        reap_children(children, true);
+        ::_exit(0);
+      };
+      while(true) {
+        struct ::pollfd pfd[2] = {{sock,POLLIN,0},{sigpipe[0],POLLIN,0}};
+        if(::poll(pfd, 2, -1) < 0) {
+          if(errno == EINTR) continue;
+          shutdown();
+        }
+        if(pfd[1].revents) {
+          char buf[64];
+          while(::read(sigpipe[0], buf, sizeof(buf)) > 0);
+          reap_children(children, false);
+        }
+        if(!pfd[0].revents) continue;
+        uint32_t header[2] = {0,0};
+        std::vector<int> received;
+        if(!recv_with_fds(sock, header, sizeof(header), received)) shutdown();
+        if(header[0] != magic) ::_exit(1);
+        // Payload: flags, cwd, program, args, env[, host env].
+        std::string payload(header[1], '\0');
+        if(!read_all(sock, &payload[0], payload.size())) shutdown();
+        size_t pos = 0;
+        uint32_t flags = 0;
+        std::string cwd, program;
+        std::vector<std::string> arguments, environment;
+        std::vector<int> reply_fds;
+        int32_t reply = -EINVAL;
+        if(get(payload, pos, flags) && get(payload, pos, cwd) && get(payload, pos, program)
+          && get(payload, pos, arguments) && get(payload, pos, environment)
+        ) {
+          if(flags & flag_hostenv) {
+            // The children inherit the host environment from the server.
+            std::vector<std::string> env;
+            if(get(payload, pos, env)) {
+              ::clearenv();
+              host_environment.swap(env);
+              for(auto& e:host_environment) ::putenv(const_cast<char*>(e.c_str()));
+            }
+          }
+          int fds[3] = {-1,-1,-1};
+          size_t k = 0;
+          for(int i=0; i<3; ++i) {
+            if((flags & (flag_fd0<<i)) && (k < received.size())) fds[i] = received[k++];
+          }
+          const bool nopath = (flags & flag_nopath) != 0;
+          const bool noenv = (flags & flag_noenv) != 0;
+          std::vector<const char*> argv, envv;
+          compose_exec_args(program, arguments, environment, noenv, argv, envv);
+          int sv[2] = {-1,-1};
+          if(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) {
+            reply = int32_t(-errno);
+          } else {
+            const ::pid_t pid = ::fork();
+            if(pid == 0) {
+              if((!cwd.empty()) && ::chdir(cwd.c_str())) {
+                std::cerr << "Failed to run ''" << program << "': " << ::strerror(errno) << std::endl;
+                ::_exit(1);
+              }
+              exec_child(program, argv, envv, nopath, noenv, fds);
+            } else if(pid < 0) {
+              reply = int32_t(-errno);
+              ::close(sv[0]);
+              ::close(sv[1]);
+            } else {
+              reply = int32_t(pid);
+              children[pid] = sv[0];
+              reply_fds.push_back(sv[1]);
+              const int pidfd = open_pidfd(pid);
+              if(pidfd >= 0) reply_fds.push_back(pidfd);
+            }
+          }
+        }
+        for(auto fd:received) ::close(fd);
+        const bool sent = send_with_fds(sock, &reply, sizeof(reply), reply_fds);
+        for(auto fd:reply_fds) ::close(fd);
+        if(!sent) shutdown();
+      }
+    }
+
+    /**
+     * Host side request. Returns the child pid, 0 if the server is not
+     * available (execution in the host process), or throws on spawn errors.
+     * The host environment is only transferred when `environ` has changed
+     * since the last request (compared by entry pointers, which change with
+     * setenv()/putenv()).
+     */
+    template <typename=void>
+    ::pid_t request(
+      const std::string& program,
+      const std::vector<std::string>& arguments,
+      const std::vector<std::string>& environment,
+      bool without_path_search,
+      bool dont_inherit_environment,
+      const int (&stdio)[3]
+    )
+    {
+      auto& srv = spawn_server();
+      std::lock_guard<std::mutex> lock(srv.mutex);
+      if(srv.fd < 0) return 0;
+      std::string payload;
+      std::vector<int> fds;
+      uint32_t flags = (without_path_search ? flag_nopath : 0u) | (dont_inherit_environment ? flag_noenv : 0u);
+      for(int i=0; i<3; ++i) {
+        if(stdio[i] >= 0) { flags |= (flag_fd0<<i); fds.push_back(stdio[i]); }
+      }
+      size_t n_environ = 0;
+      for(char** e = environ; e && *e; ++e, ++n_environ) {
+        if((!(flags & flag_hostenv)) && ((n_environ >= srv.environment.size()) || (srv.environment[n_environ] != *e))) flags |= flag_hostenv;
+      }
+      if(n_environ != srv.environment.size()) flags |= flag_hostenv;
+      {
+        std::string cwd(4096, '\0');
+        while((!::getcwd(&cwd[0], cwd.size())) && (errno == ERANGE)) cwd.resize(cwd.size()*2);
+        cwd.resize(std::strlen(cwd.c_str()));
+        put(payload, flags);
+        put(payload, cwd);
+        put(payload, program);
+        put(payload, uint32_t(arguments.size()));
+        for(auto& e:arguments) put(payload, e);
+        put(payload, uint32_t(environment.size()));
+        for(auto& e:environment) put(payload, e);
+        if(flags & flag_hostenv) {
+          srv.environment.assign(environ, environ+n_environ);
+          put(payload, uint32_t(n_environ));
+          for(auto e:srv.environment) put(payload, e);
+        }
+      }
+      int32_t reply = 0;
+      std::vector<int> reply_fds;
+      {
+        const uint32_t header[2] = { magic, uint32_t(payload.size()) };
+        const bool ok = send_with_fds(srv.fd, header, sizeof(header), fds)
+          && write_all(srv.fd, payload.data(), payload.size())
+          && recv_with_fds(srv.fd, &reply, sizeof(reply), reply_fds);
+        if((!ok) || (reply == -EINVAL) || ((reply > 0) && reply_fds.empty())) {
+          // Server not usable (anymore): continue without it.
+          for(auto fd:reply_fds) ::close(fd);
+          if(reply > 0) ::kill(::pid_t(reply), SIGKILL);
+          ::close(srv.fd);
+          srv.fd = -1;
+          if(srv.pid > 0) { ::kill(srv.pid, SIGKILL); ::waitpid(srv.pid, nullptr, 0); }
+          srv.pid = -1;
+          return 0;
+        }
+      }
+      ++srv.requests;
+      if(reply < 0) {
+        for(auto fd:reply_fds) ::close(fd);
+        throw std::runtime_error(std::string("Failed to execute (fork failed): ") + ::strerror(int(-reply)));
+      }
+      spawn_server_child child;
+      child.status_fd = reply_fds[0];
+      child.pid_fd = (reply_fds.size() > 1) ? reply_fds[1] : -1;
+      srv.children[::pid_t(reply)] = child;
+      return ::pid_t(reply);
+    }
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="fork_exec: linux" defaultstate="collapsed">
+  /**
+   * Forks and executes `program` with the given stdio file descriptors.
+   * Descriptors < 0 are connected to /dev/null. All other descriptors
+   * are closed in the child. Returns the child pid, throws on fork errors.
+   * The environment vector contains alternating key/value pairs, which
+   * are set over the inherited environment, or form the complete child
+   * environment if `dont_inherit_environment` is set. If the spawn server
+   * is running, the child is created there, so the child has to be waited
+   * for and signalled with wait_child() and kill_child().
+   */
+  template <typename=void>
+  ::pid_t fork_exec(
+    const std::string& program,
+    const std::vector<std::string>& arguments,
+    std::vector<std::string> environment,
+    bool without_path_search,
+    bool dont_inherit_environment,
+    int stdin_fd, int stdout_fd, int stderr_fd
+  )
+  {
+    const int fds[3] = { stdin_fd, stdout_fd, stderr_fd };
+    {
+      const ::pid_t pid = spawn_server_protocol::request(program, arguments, environment, without_path_search, dont_inherit_environment, fds);
+      if(pid > 0) return pid;
+    }
+    // Composition before forking, no allocations in the child except ::setenv().
+    std::vector<const char*> argv, envv;
+    compose_exec_args(program, arguments, environment, dont_inherit_environment, argv, envv);
+    ::pid_t pid = ::fork();
+    if(pid < 0) {
+      throw std::runtime_error(std::string("Failed to execute (fork failed): ") + ::strerror(errno));
+    } else if(pid == 0) {
+      exec_child(program, argv, envv, without_path_search, dont_inherit_environment, fds);
+    }
+    return pid;
+  }
+
+  /**
+   * waitpid()/wait4() for children created by fork_exec(). Children of the
+   * spawn server are not children of this process: their status is read
+   * from the status socket of the server, `WNOHANG` is the only supported
+   * option. Returns the pid, 0 if not terminated (WNOHANG), or -1 with
+   * errno ECHILD if the status is not available.
+   */
+  template <typename=void>
+  ::pid_t wait_child(::pid_t pid, int* status, int options, struct ::rusage* usage=nullptr) noexcept
+  {
+    auto& srv = spawn_server();
+    spawn_server_child child;
+    {
+      std::lock_guard<std::mutex> lock(srv.mutex);
+      const auto it = srv.children.find(pid);
+      if(it == srv.children.end()) return ::wait4(pid, status, options, usage);
+      child = it->second;
+    }
+    if(options & WNOHANG) {
+      struct ::pollfd pfd = { child.status_fd, POLLIN, 0 };
+      int r;
+      while(((r=::poll(&pfd, 1, 0)) < 0) && (errno == EINTR));
+      if(r == 0) return 0;
+    }
+    spawn_server_protocol::child_status msg = spawn_server_protocol::child_status();
+    const bool ok = spawn_server_protocol::read_all(child.status_fd, &msg, sizeof(msg));
+    {
+      std::lock_guard<std::mutex> lock(srv.mutex);
+      srv.children.erase(pid);
+    }
+    ::close(child.status_fd);
+    if(child.pid_fd >= 0) ::close(child.pid_fd);
+    if(!ok) { errno = ECHILD; return -1; }
+    if(status) *status = msg.status;
+    if(usage) *usage = msg.usage;
+    return pid;
+  }
+
+  /**
+   * kill() for children created by fork_exec(). Children of the spawn
+   * server are signalled via their pidfd where available, so that a
+   * reused pid cannot be hit after the server has reaped the child.
+   */
+  template <typename=void>
+  int kill_child(::pid_t pid, int sig) noexcept
+  {
+    #if defined(__linux__) && defined(SYS_pidfd_send_signal)
+    {
+      auto& srv = spawn_server();
+      std::lock_guard<std::mutex> lock(srv.mutex);
+      const auto it = srv.children.find(pid);
+      if((it != srv.children.end()) && (it->second.pid_fd >= 0)) {
+        return int(::syscall(SYS_pidfd_send_signal, it->second.pid_fd, sig, nullptr, 0));
+      }
+    }
+    #endif
+    return ::kill(pid, sig);
+  }
+
+  /**
+   * Returns a new descriptor of a child created by fork_exec(), which is
+   * readable when the child has terminated (and wait_child() will not
+   * block), or -1 if not supported. Must be closed by the caller.
+   */
+  template <typename=void>
+  int child_exit_fd(::pid_t pid) noexcept
+  {
+    {
+      auto& srv = spawn_server();
+      std::lock_guard<std::mutex> lock(srv.mutex);
+      const auto it = srv.children.find(pid);
+      if(it != srv.children.end()) return ::fcntl(it->second.status_fd, F_DUPFD_CLOEXEC, 0);
+    }
+    return spawn_server_protocol::open_pidfd(pid);
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="process_stats: rusage" defaultstate="collapsed">
+  template <typename=void>
+  void set_process_stats(process_stats* stats, const struct ::rusage& ru, std::chrono::steady_clock::time_point start_time) noexcept
+  {
+    using namespace std::chrono;
+    if(!stats) return;
+    stats->valid = true;
+    stats->walltime = double(duration_cast<microseconds>(steady_clock::now() - start_time).count()) * 1e-3;
+    stats->utime = double(ru.ru_utime.tv_sec) * 1e3 + double(ru.ru_utime.tv_usec) * 1e-3;
+    stats->stime = double(ru.ru_stime.tv_sec) * 1e3 + double(ru.ru_stime.tv_usec) * 1e-3;
+    #if defined(__APPLE__)
+    stats->maxrss = double(ru.ru_maxrss); // bytes on macos
+    #else
+    stats->maxrss = double(ru.ru_maxrss) * 1024.0; // kb on linux/bsd
+    #endif
+    stats->minflt = double(ru.ru_minflt);
+    stats->majflt = double(ru.ru_majflt);
+    stats->nvcsw = double(ru.ru_nvcsw);
+    stats->nivcsw = double(ru.ru_nivcsw);
+  }
+  // </editor-fold>
+
   // <editor-fold desc="execute_backend: linux" defaultstate="collapsed">
   template <typename StdOutCallback, typename StdErrCallback>
   void execute_backend(
@@ -129,7 +854,7 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     int& exit_code,
     StdOutCallback stdout_proc,
     StdErrCallback stderr_proc,
-    std::string stdin_data,
+    stdin_source stdin_data,
     bool ignore_stdout,
     bool ignore_stderr,
     bool redirect_stderr_to_stdout,
@@ -137,7 +862,8 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     bool dont_inherit_environment,
     int timeout_ms,
     bool& was_timeout,
-    bool no_argument_escaping=false
+    bool no_argument_escaping=false,
+    process_stats* stats=nullptr
   )
   {
     (void) no_argument_escaping;
@@ -164,9 +890,11 @@ namespace duktape { namespace detail { namespace system { namespace exec {
       fd_t& ifd;
       fd_t& ofd;
       fd_t& efd;
+      process_stats* stats;
+      std::chrono::steady_clock::time_point start_time;
 
-      explicit proc_guard(::pid_t& pid__, fd_t& ifd__, fd_t& ofd__, fd_t& efd__) noexcept :
-        pid(pid__), ifd(ifd__), ofd(ofd__), efd(efd__)
+      explicit proc_guard(::pid_t& pid__, fd_t& ifd__, fd_t& ofd__, fd_t& efd__, process_stats* stats__, std::chrono::steady_clock::time_point start__) noexcept :
+        pid(pid__), ifd(ifd__), ofd(ofd__), efd(efd__), stats(stats__), start_time(start__)
       { }
 
       ~proc_guard() noexcept
@@ -177,13 +905,15 @@ namespace duktape { namespace detail { namespace system { namespace exec {
         if(efd >= 0) ::close(efd);
         ifd = ofd = efd = -1;
         if(pid > 0) {
-          ::kill(pid, SIGTERM);
+          kill_child(pid, SIGTERM);
           ::sleep(0);
           int status = -1, r;
-          if(((r=::waitpid((const ::pid_t) pid, &status, WNOHANG)) == 0) || (r<0 && (errno == ECHILD))) {
-            ::kill(pid, SIGKILL);
+          struct ::rusage ru = ::rusage();
+          if(((r=wait_child(pid, &status, WNOHANG, &ru)) == 0) || (r<0 && (errno == ECHILD))) {
+            kill_child(pid, SIGKILL);
+            r = wait_child(pid, &status, 0, &ru);
           }
-          r = ::waitpid((const ::pid_t) pid, &status, 0);
+          if(r == pid) set_process_stats(stats, ru, start_time);
         } else {
           pid = -1;
         }
@@ -194,46 +924,30 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     fd_t ifd=-1, ofd=-1, efd=-1;
 
     {
-      std::vector<const char*> argv, envv;
-      argv.push_back(program.c_str());
-      for(auto& e:arguments) argv.push_back(e.c_str());
-      argv.push_back(nullptr);
-
-      // note: we do this composition before forking.
-      if(!dont_inherit_environment) {
-        // for ::setenv()
-        for(auto& e:environment) envv.push_back(e.c_str());
-        envv.push_back(nullptr);
-        envv.push_back(nullptr);
-      } else {
-        // for execve()/execvpe()
-        if(!environment.empty()) {
-          {
-            if(environment.size() & 1) environment.push_back("");
-            std::vector<std::string> tenv;
-            for(size_t i=0; i<environment.size()-1; i+=2) {
-              tenv.emplace_back(environment[i] + "=" + environment[i+1]);
-            }
-            environment.swap(tenv);
-          }
-          for(auto& e:environment) envv.push_back(e.c_str());
-        }
-        envv.push_back(nullptr);
-      }
-
-      // for(auto e:argv) std::cerr << (e ? e : "<nullptr>") << ", "; cerr << std::endl;
-      // for(auto e:envv) std::cerr << (e ? e : "<nullptr>") << ", "; cerr << std::endl;
       int err = 0;
       fd_t pi[2] = {-1,-1}, po[2] = {-1,-1}, pe[2] = {-1,-1};
 
-      if(::pipe(pi)) {
+      if((stdin_data.fd < 0) && ::pipe(pi)) {
         err = errno; pi[0] = pi[1] = -1;
       } else if(::pipe(po)) {
         err = errno; po[0] = po[1] = -1;
       } else if((!redirect_stderr_to_stdout) && ::pipe(pe)) {
         err = errno; pe[0] = pe[1] = -1;
-      } else if(((pid = ::fork()) < 0)) {
-        err = errno; pid = -1;
+      }
+
+      if(!err) {
+        try {
+          pid = fork_exec(program, arguments, environment, without_path_search, dont_inherit_environment,
+            (stdin_data.fd >= 0) ? stdin_data.fd : pi[0],
+            ignore_stdout ? -1 : po[1],
+            ignore_stderr ? -1 : ((pe[1]>=0) ? pe[1] : po[1])
+          );
+        } catch(...) {
+          close_pipe(pi[0]); close_pipe(pi[1]);
+          close_pipe(po[0]); close_pipe(po[1]);
+          close_pipe(pe[0]); close_pipe(pe[1]);
+          throw;
+        }
       }
 
       if(err) {
@@ -243,46 +957,17 @@ namespace duktape { namespace detail { namespace system { namespace exec {
         throw std::runtime_error(std::string("Failed to execute (pipe or fork failed): ") + ::strerror(err));
       }
 
-      if(pid == 0) {
-        // Child
-        if(1
-          && (::dup2(pi[0], STDIN_FILENO) >= 0)
-          && (::dup2(po[1], STDOUT_FILENO) >= 0)
-          && (::dup2((pe[1]>=0)?(pe[1]):(po[1]), STDERR_FILENO) >= 0)
-        ) {
-          for(int i=3; i<1024; ++i) ::close(i); // @sw: check how to safely get the highest fd.
-          if(ignore_stdout) { ::close(STDOUT_FILENO); ::open("/dev/null", O_WRONLY); }
-          if(ignore_stderr) { ::close(STDERR_FILENO); ::open("/dev/null", O_WRONLY); }
-          if(!dont_inherit_environment) {
-            // Set additional environment over the own process env and run
-            for(size_t i=0; (i < envv.size()-2) && envv[i] && envv[i+1]; i+=2) ::setenv(envv[i], envv[i+1], 1);
-            if(without_path_search) {
-              ::execv(program.c_str(), (char* const*)(&argv[0]));
-            } else {
-              ::execvp(program.c_str(), (char* const*)(&argv[0]));
-            }
-          } else {
-            if(without_path_search) {
-              ::execve(program.c_str(), (char* const*)(&argv[0]), (char* const*)(&envv[0]));
-            } else {
-              ::execvpe(program.c_str(), (char* const*)(&argv[0]), (char* const*)(&envv[0]));
-            }
-          }
-          std::cerr << "Failed to run ''" << program << "': " << ::strerror(errno) << std::endl;
-        }
-        _exit(1);
-      } else {
-        // Parent, close unused fds and set variables used further on.
-        ifd = pi[1]; unblock(ifd); close_pipe(pi[0]);
-        ofd = po[0]; unblock(ofd); close_pipe(po[1]);
-        efd = pe[0]; unblock(efd); close_pipe(pe[1]);
-        if(stdin_data.empty()) close_pipe(ifd);
-        if(ignore_stdout) close_pipe(ofd);
-        if(ignore_stderr) close_pipe(efd);
-      }
+      // Parent, close unused fds and set variables used further on.
+      ifd = pi[1]; unblock(ifd); close_pipe(pi[0]);
+      ofd = po[0]; unblock(ofd); close_pipe(po[1]);
+      efd = pe[0]; unblock(efd); close_pipe(pe[1]);
+      if(!stdin_data.size) close_pipe(ifd);
+      if(ignore_stdout) close_pipe(ofd);
+      if(ignore_stderr) close_pipe(efd);
     }
 
-    proc_guard proc(pid, ifd, ofd, efd);
+    proc_guard proc(pid, ifd, ofd, efd, stats, start_time);
+    size_t stdin_offset = 0;
     bool done = false;
     constexpr int force_kill_after_additional_ms = 2500;
     while((pid > 0) || (ofd >= 0) || (efd >= 0)) {
@@ -294,38 +979,37 @@ namespace duktape { namespace detail { namespace system { namespace exec {
           if(!was_timeout) {
             was_timeout = true;
             clog__("timeout: " << dt <<  " --> kill(child pid=" << pid << ", SIGINT)");
-            ::kill(pid, SIGINT);
-            ::kill(pid, SIGQUIT);
+            kill_child(pid, SIGINT);
+            kill_child(pid, SIGQUIT);
           } else if(dt > (timeout_ms + force_kill_after_additional_ms)) {
             clog__("timeout: " << dt <<  " --> kill(child pid=" << pid << ", KILL)");
-            ::kill(pid, SIGKILL);
+            kill_child(pid, SIGKILL);
             break;
           }
         }
       }
 
-      // Write to child stdin if bytes left
+      // Write to child stdin if bytes left (no copying, offset cursor)
       if(ifd >= 0) {
-        size_t size = stdin_data.length();
-        const void* data = stdin_data.data();
-        int r;
+        const size_t size = stdin_data.size - stdin_offset;
+        ssize_t r;
         if(size <= 0) {
           close_pipe(ifd);
-        } else if((r=::write(ifd, data, size)) < 0) {
+        } else if((r=write_nosigpipe(ifd, stdin_data.data + stdin_offset, size)) < 0) {
           switch(errno) {
             case EINTR:
             case EAGAIN:
               break;
             default:
               clog__("Failed to write n=" << std::dec << size << " bytes to child stdin: " << ::strerror(errno));
-              std::string().swap(stdin_data);
+              stdin_offset = stdin_data.size;
           }
-        } else if((!r) || (((size_t)r) == stdin_data.length())) {
-          std::string().swap(stdin_data);
+        } else if(!r) {
+          stdin_offset = stdin_data.size;
         } else {
-          stdin_data = stdin_data.substr(r);
+          stdin_offset += size_t(r);
         }
-        if(stdin_data.empty()) {
+        if(stdin_offset >= stdin_data.size) {
           close_pipe(ifd);
         }
       }
@@ -333,10 +1017,11 @@ namespace duktape { namespace detail { namespace system { namespace exec {
       // Read/check stderr and stdout pipes
       {
         int r = -1;
-        struct ::pollfd pfd[2] = {{0,0,0},{0,0,0}};
+        struct ::pollfd pfd[3] = {{0,0,0},{0,0,0},{0,0,0}};
         if(!done) {
           pfd[0].fd = ofd; pfd[0].events = POLLIN|POLLPRI; pfd[0].revents = 0;
           pfd[1].fd = efd; pfd[1].events = POLLIN|POLLPRI; pfd[1].revents = 0;
+          pfd[2].fd = ifd; pfd[2].events = POLLOUT; pfd[2].revents = 0; // wake up when stdin writable
           r=::poll(pfd, sizeof(pfd)/sizeof(struct ::pollfd), 100);
           if(!r || (r < 0 && (errno == EAGAIN || errno == EINTR))) {
             // continue;
@@ -383,7 +1068,8 @@ namespace duktape { namespace detail { namespace system { namespace exec {
       } else {
         // Check if the child process has terminated
         int r, status = 0;
-        if((r=::waitpid((const ::pid_t)pid, &status, WNOHANG)) < 0) {
+        struct ::rusage ru = ::rusage();
+        if((r=wait_child(pid, &status, WNOHANG, &ru)) < 0) {
           switch(errno) {
             case EAGAIN:
             case EINTR:
@@ -397,6 +1083,7 @@ namespace duktape { namespace detail { namespace system { namespace exec {
         }
         if(r == pid) {
           exit_code = WEXITSTATUS(status);
+          set_process_stats(stats, ru, start_time);
           pid = -1;
         }
       }
@@ -413,7 +1100,7 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     int& exit_code,
     StdOutCallback stdout_proc,
     StdErrCallback stderr_proc,
-    std::string stdin_data,
+    stdin_source stdin_data,
     bool ignore_stdout,
     bool ignore_stderr,
     bool redirect_stderr_to_stdout,
@@ -421,7 +1108,8 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     bool dont_inherit_environment,
     int timeout_ms,
     bool& was_timeout,
-    bool no_argument_escaping=false
+    bool no_argument_escaping=false,
+    process_stats* stats=nullptr
   )
   {
     struct pipe_handles
@@ -555,7 +1243,9 @@ namespace duktape { namespace detail { namespace system { namespace exec {
             throw std::runtime_error(std::string("Running program failed: ") + errstr());
         }
       }
-      if(stdin_data.empty()) {
+      if(stdin_data.fd >= 0) {
+        throw std::runtime_error("Passing files as stdin is not supported on this platform.");
+      } else if(!stdin_data.size) {
         in.close();
       } else {
         ::CloseHandle(in.r);
@@ -625,6 +1315,7 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     };
 
     bool process_terminated = false;
+    size_t stdin_offset = 0;
     int n_loops_left = 2;
     while(--n_loops_left > 0) {
       if(!process_terminated) {
@@ -652,12 +1343,13 @@ namespace duktape { namespace detail { namespace system { namespace exec {
             n_loops_left = 0;
         }
       }
-      if(in.w && !stdin_data.empty()) {
+      if(in.w && (stdin_offset < stdin_data.size)) {
         bool keep_writing = true;
-        while(in.w && !stdin_data.empty() && keep_writing) {
+        while(in.w && (stdin_offset < stdin_data.size) && keep_writing) {
           DWORD n_written = 0;
-          DWORD n_towrite = stdin_data.size() > 4096 ? 4096 : stdin_data.size();
-          if(!::WriteFile(in.w, stdin_data.data(), n_towrite, &n_written, nullptr)) {
+          const size_t n_left = stdin_data.size - stdin_offset;
+          DWORD n_towrite = n_left > 4096 ? 4096 : DWORD(n_left);
+          if(!::WriteFile(in.w, stdin_data.data + stdin_offset, n_towrite, &n_written, nullptr)) {
             switch(::GetLastError()) {
               case ERROR_PIPE_BUSY:
                 keep_writing = false;
@@ -669,18 +1361,16 @@ namespace duktape { namespace detail { namespace system { namespace exec {
                 // break: intentionally no break.
               case ERROR_INVALID_HANDLE:
                 in.w = nullptr;
-                stdin_data.clear();
+                stdin_offset = stdin_data.size;
               default:
                 throw std::runtime_error(std::string("Failed to write to pipe: ") + errstr());
             }
           }
           if(n_written) {
-            if(n_written >= stdin_data.size()) {
-              stdin_data.clear();
+            stdin_offset += n_written;
+            if(stdin_offset >= stdin_data.size) {
               keep_writing = false;
               in.close();
-            } else {
-              stdin_data = stdin_data.substr(n_written);
             }
           }
           if(n_written < n_towrite) {
@@ -701,6 +1391,16 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     }
     if(process_terminated) {
       DWORD ec = 0;
+      if(stats) {
+        using namespace std::chrono;
+        FILETIME tc, te, tk, tu;
+        stats->valid = true;
+        stats->walltime = double(duration_cast<microseconds>(steady_clock::now() - start_time).count()) * 1e-3;
+        if(::GetProcessTimes(proc.pi.hProcess, &tc, &te, &tk, &tu)) {
+          stats->utime = double((((unsigned long long)tu.dwHighDateTime) << 32) | tu.dwLowDateTime) * 1e-4;
+          stats->stime = double((((unsigned long long)tk.dwHighDateTime) << 32) | tk.dwLowDateTime) * 1e-4;
+        }
+      }
       if(::GetExitCodeProcess(proc.pi.hProcess, &ec)) {
         exit_code = int(ec);
       } else {
@@ -713,39 +1413,352 @@ namespace duktape { namespace detail { namespace system { namespace exec {
   // </editor-fold>
   #endif
 
-  // <editor-fold desc="execute" defaultstate="collapsed">
-  #if(0 && JSDOC)
+  #ifndef WINDOWS
+
+  // <editor-fold desc="execute_pipeline_backend: linux" defaultstate="collapsed">
   /**
-   * Execute a process, optionally fetch stdout, stderr or pass stdin data.
-   *
-   * - The `program` is the path to the executable.
-   *
-   * - The `arguments` (if not omitted/undefined) is an array with values, which
-   *   are coercible to strings.
-   *
-   * - The `options` is a plain object with additional flags and options.
-   *   All these options are optional and have sensible default values:
-   *
-   *    {
-   *      // Plain object for environment variables to set.
-   *      env     : {object}={},
-   *
-   *      // Optional text that is passed to the program via stdin piping.
-   *      stdin   : {String}="",
-   *
-   *      // If true the output is an object containing the fetched output in the property `stdout`.
-   *      // The exit code is then stored in the property `exitcode`.
-   *      // If it is a function, see callbacks below.
-   *      stdout  : {boolean|function}=false,
-   *
-   *      // If true the output is an object containing the fetched output in the property `stderr`.
-   *      // The exit code is then stored in the property `exitcode`.
-   *      // If the value is "stdout", then the stderr output is redirected to stdout, and the
-   *      // option `stdout` is implicitly set to `true` if it was `false`.
-   *      // If it is a function, see callbacks below.
-   *      stderr  : {boolean|function|"stdout"}=false,
-   *
-   *      // Normally the user environment is also available for the executed child process. That
+   * Runs a chain of processes, where the stdout of each stage is directly
+   * connected to the stdin of the next stage (the data do not pass this
+   * process). `stages` contains the program at index 0 followed by the
+   * arguments. The stdin data are fed into the first stage, the output of
+   * the last stage is either passed to `stdout_proc` or written into
+   * `output_file`. The stderr of all stages is collected in one pipe.
+   * `exit_codes` contains the exit code of each stage (128+signal if the
+   * stage was terminated by a signal).
+   */
+  template <typename StdOutCallback, typename StdErrCallback>
+  void execute_pipeline_backend(
+    const std::vector<std::vector<std::string>>& stages,
+    const std::vector<std::string>& environment,
+    std::vector<int>& exit_codes,
+    StdOutCallback stdout_proc,
+    StdErrCallback stderr_proc,
+    stdin_source stdin_data,
+    const std::string& output_file,
+    bool append_output_file,
+    bool ignore_stdout,
+    bool ignore_stderr,
+    bool redirect_stderr_to_stdout,
+    bool without_path_search,
+    bool dont_inherit_environment,
+    int timeout_ms,
+    bool& was_timeout
+  )
+  {
+    using fd_t = int;
+    auto start_time = std::chrono::steady_clock::now();
+
+    struct pipeline_guard
+    {
+      std::vector<::pid_t> pids;
+      fd_t ifd, ofd, efd;
+
+      explicit pipeline_guard(size_t n) : pids(n, -1), ifd(-1), ofd(-1), efd(-1)
+      { }
+
+      ~pipeline_guard() noexcept
+      {
+        if(ifd >= 0) ::close(ifd);
+        if(ofd >= 0) ::close(ofd);
+        if(efd >= 0) ::close(efd);
+        for(auto pid:pids) { if(pid > 0) kill_child(pid, SIGTERM); }
+        ::sleep(0);
+        for(auto& pid:pids) {
+          if(pid <= 0) continue;
+          int status = -1, r;
+          if(((r=wait_child(pid, &status, WNOHANG)) == 0) || (r<0 && (errno == ECHILD))) {
+            kill_child(pid, SIGKILL);
+          }
+          r = wait_child(pid, &status, 0);
+          pid = -1;
+        }
+      }
+
+      static void close_fd(fd_t& fd) noexcept
+      { if(fd >= 0) { ::close(fd); fd = -1; } }
+
+      static void unblock(fd_t fd) noexcept
+      { int o; if((fd >=0) && (o=::fcntl(fd, F_GETFL, 0)) >= 0) ::fcntl(fd, F_SETFL, o|O_NONBLOCK); }
+    };
+
+    exit_codes.assign(stages.size(), -1);
+    if(stages.empty()) return;
+    pipeline_guard proc(stages.size());
+
+    // Pipes and process chain
+    {
+      fd_t pi[2] = {-1,-1}, po[2] = {-1,-1}, pe[2] = {-1,-1}, out_fd = -1, err_fd = -1, prev_fd = -1;
+      const auto close_all = [&]() {
+        pipeline_guard::close_fd(pi[0]); pipeline_guard::close_fd(pi[1]);
+        pipeline_guard::close_fd(po[0]); pipeline_guard::close_fd(po[1]);
+        pipeline_guard::close_fd(pe[0]); pipeline_guard::close_fd(pe[1]);
+        pipeline_guard::close_fd(prev_fd);
+        if(!output_file.empty()) pipeline_guard::close_fd(out_fd);
+      };
+      const auto fail = [&](std::string msg) {
+        const int err = errno;
+        close_all();
+        throw std::runtime_error(msg + ::strerror(err));
+      };
+      if(stdin_data.fd >= 0) {
+        if((pi[0] = ::fcntl(stdin_data.fd, F_DUPFD_CLOEXEC, 3)) < 0) fail("Failed to execute (dup failed): ");
+      } else if(stdin_data.size && ::pipe(pi)) {
+        fail("Failed to execute (pipe failed): ");
+      }
+      if(!output_file.empty()) {
+        if((out_fd=::open(output_file.c_str(), O_WRONLY|O_CREAT|O_CLOEXEC|(append_output_file ? O_APPEND : O_TRUNC), 0666)) < 0) {
+          fail(std::string("Failed to open output file '") + output_file + "': ");
+        }
+      } else if(!ignore_stdout) {
+        if(::pipe(po)) fail("Failed to execute (pipe failed): ");
+        out_fd = po[1];
+      }
+      if(redirect_stderr_to_stdout) {
+        err_fd = out_fd;
+      } else if(!ignore_stderr) {
+        if(::pipe(pe)) fail("Failed to execute (pipe failed): ");
+        err_fd = pe[1];
+      }
+      prev_fd = pi[0]; pi[0] = -1;
+      for(size_t i=0; i<stages.size(); ++i) {
+        fd_t next[2] = {-1,-1};
+        const bool last = (i == stages.size()-1);
+        if((!last) && ::pipe(next)) fail("Failed to execute (pipe failed): ");
+        const auto& stage = stages[i];
+        try {
+          proc.pids[i] = fork_exec(
+            stage.front(), std::vector<std::string>(stage.begin()+1, stage.end()),
+            environment, without_path_search, dont_inherit_environment,
+            prev_fd, last ? out_fd : next[1], err_fd
+          );
+        } catch(...) {
+          pipeline_guard::close_fd(next[0]);
+          pipeline_guard::close_fd(next[1]);
+          close_all();
+          throw;
+        }
+        pipeline_guard::close_fd(prev_fd);
+        pipeline_guard::close_fd(next[1]);
+        prev_fd = next[0];
+      }
+      proc.ifd = pi[1]; pi[1] = -1; pipeline_guard::unblock(proc.ifd);
+      proc.ofd = po[0]; po[0] = -1; pipeline_guard::unblock(proc.ofd);
+      proc.efd = pe[0]; pe[0] = -1; pipeline_guard::unblock(proc.efd);
+      close_all();
+    }
+
+    // I/O and wait loop
+    size_t stdin_offset = 0;
+    size_t n_running = stages.size();
+    bool done = false;
+    constexpr int force_kill_after_additional_ms = 2500;
+    while(true) {
+      using namespace std::chrono;
+      if((timeout_ms > 1) && (n_running > 0)) {
+        auto dt = int(duration_cast<milliseconds>(steady_clock::now() - start_time).count());
+        if(dt > timeout_ms) {
+          if(!was_timeout) {
+            was_timeout = true;
+            for(auto pid:proc.pids) { if(pid > 0) { kill_child(pid, SIGINT); kill_child(pid, SIGQUIT); } }
+          } else if(dt > (timeout_ms + force_kill_after_additional_ms)) {
+            for(auto pid:proc.pids) { if(pid > 0) kill_child(pid, SIGKILL); }
+            break;
+          }
+        }
+      }
+
+      // Write stdin to the first stage, read the last stage output and the collected stderr.
+      {
+        struct ::pollfd pfd[3] = {{proc.ifd,POLLOUT,0},{proc.ofd,POLLIN|POLLPRI,0},{proc.efd,POLLIN|POLLPRI,0}};
+        const bool any_fd = (proc.ifd >= 0) || (proc.ofd >= 0) || (proc.efd >= 0);
+        int r = done ? 0 : ::poll(pfd, 3, any_fd ? 100 : 10);
+        if((proc.ifd >= 0) && (pfd[0].revents || r < 0)) {
+          ssize_t n = write_nosigpipe(proc.ifd, stdin_data.data+stdin_offset, stdin_data.size-stdin_offset);
+          if(n > 0) {
+            stdin_offset += size_t(n);
+          } else if((n < 0) && (errno != EAGAIN) && (errno != EINTR)) {
+            stdin_offset = stdin_data.size; // EPIPE: first stage does not read (anymore).
+          }
+          if(stdin_offset >= stdin_data.size) pipeline_guard::close_fd(proc.ifd);
+        }
+        if((proc.ofd >= 0) && (pfd[1].revents || r < 0 || done)) {
+          char data[4096];
+          ssize_t n;
+          while((n = ::read(proc.ofd, data, sizeof(data))) > 0) stdout_proc(std::string(data, data+size_t(n)));
+          if((!n) || ((n<0) && (errno != EAGAIN) && (errno != EINTR))) pipeline_guard::close_fd(proc.ofd);
+        }
+        if((proc.efd >= 0) && (pfd[2].revents || r < 0 || done)) {
+          char data[4096];
+          ssize_t n;
+          while((n = ::read(proc.efd, data, sizeof(data))) > 0) stderr_proc(std::string(data, data+size_t(n)));
+          if((!n) || ((n<0) && (errno != EAGAIN) && (errno != EINTR))) pipeline_guard::close_fd(proc.efd);
+        }
+      }
+
+      if(n_running == 0) {
+        // One more iteration to fetch pending data, see execute_backend().
+        if(done || ((proc.ofd < 0) && (proc.efd < 0))) break;
+        done = true;
+      } else {
+        for(size_t i=0; i<proc.pids.size(); ++i) {
+          if(proc.pids[i] <= 0) continue;
+          int status = 0;
+          const ::pid_t r = wait_child(proc.pids[i], &status, WNOHANG);
+          if(r == proc.pids[i]) {
+            exit_codes[i] = WIFSIGNALED(status) ? (128+WTERMSIG(status)) : WEXITSTATUS(status);
+          } else if(!((r < 0) && (errno == ECHILD))) {
+            continue;
+          }
+          proc.pids[i] = -1;
+          --n_running;
+        }
+      }
+    }
+  }
+  // </editor-fold>
+  #endif
+
+  // <editor-fold desc="get_stdin_source" defaultstate="collapsed">
+  /**
+   * Reads the `stdin` option value at the given stack index into `src`,
+   * without copying string or buffer data. The value must remain on the
+   * stack during the execution. Objects `{file: path}` are opened, the
+   * descriptor is stored in `file_fd` and must be closed by the caller.
+   * Objects with a hidden file descriptor (`fs.file`) are passed on directly.
+   * (Windows: files are read into `file_data`). Returns an error message,
+   * or an empty string on success.
+   */
+  template <typename=void>
+  std::string get_stdin_source(duktape::api& stack, duktape::api::index_t index, stdin_source& src, int& file_fd, std::string& file_data)
+  {
+    src = stdin_source();
+    if(stack.is_string(index)) {
+      src.data = stack.get_lstring(index, src.size);
+    } else if(stack.is_false(index) || stack.is_null(index) || stack.is_undefined(index)) {
+      src.size = 0;
+    } else if(stack.is_buffer(index) || stack.is_buffer_data(index)) {
+      src.data = reinterpret_cast<const char*>(stack.get_buffer_data(index, src.size));
+    } else if(stack.is_object(index) && (!stack.is_function(index)) && (!stack.is_array(index))) {
+      if(stack.get_prop_string(index, "file")) {
+        const std::string path = stack.to<std::string>(-1);
+        stack.pop();
+        #ifndef WINDOWS
+        if((file_fd = ::open(path.c_str(), O_RDONLY|O_CLOEXEC)) < 0) {
+          return std::string("Failed to open stdin file '") + path + "': " + ::strerror(errno);
+        }
+        src.fd = file_fd;
+        #else
+        std::ifstream fis(path, std::ios::in|std::ios::binary);
+        if(!fis.good()) return std::string("Failed to open stdin file '") + path + "'";
+        file_data.assign(std::istreambuf_iterator<char>(fis), std::istreambuf_iterator<char>());
+        src.data = file_data.data();
+        src.size = file_data.size();
+        #endif
+        return std::string();
+      }
+      stack.pop();
+      #ifndef WINDOWS
+      if(stack.get_prop_string_hidden(index, "fd") && stack.is_number(-1)) {
+        src.fd = stack.get<int>(-1);
+        stack.pop();
+        if(src.fd < 0) return "File object passed as stdin is not opened.";
+        return std::string();
+      }
+      stack.pop();
+      #endif
+      return "Invalid value for the 'stdin' exec option.";
+    } else {
+      return "Invalid value for the 'stdin' exec option.";
+    }
+    (void) file_fd;
+    (void) file_data;
+    return std::string();
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="get_process_options" defaultstate="collapsed">
+  /**
+   * Program lookup and environment options shared by exec(), pipeline(),
+   * spawn() and the coroutine await_exec().
+   */
+  struct process_options
+  {
+    bool without_path_search = false;       // `nopath`
+    bool noenv = false;                     // `noenv`, do not inherit the environment.
+    std::vector<std::string> environment;   // `env`, alternating key/value pairs.
+  };
+
+  /**
+   * Reads the `nopath`, `noenv` and `env` options of the option object at
+   * `optindex` into `opts`, the stack is unchanged. Returns an error message
+   * (without function name prefix), or an empty string on success.
+   */
+  template <typename=void>
+  std::string get_process_options(duktape::api& stack, duktape::api::index_t optindex, process_options& opts)
+  {
+    opts.without_path_search = stack.get_prop_string<bool>(optindex, "nopath", false);
+    opts.noenv = stack.get_prop_string<bool>(optindex, "noenv", false);
+    opts.environment.clear();
+    std::string err;
+    if(stack.get_prop_string(optindex, "env")) {
+      if(!stack.is_object(-1) || stack.is_array(-1) || stack.is_function(-1)) {
+        err = "Environment must be passed as plain object.";
+      } else {
+        stack.enumerator(-1, duktape::api::enum_own_properties_only);
+        while(stack.next(-1, true)) {
+          opts.environment.push_back(stack.req<std::string>(-2));
+          opts.environment.push_back(stack.to<std::string>(-1));
+          stack.pop(2);
+        }
+        stack.pop();
+        for(auto& e:opts.environment) {
+          if(e.find_first_of(std::string("=\0", 2)) != e.npos) {
+            err = "Environment contains invalid characters.";
+            break;
+          }
+        }
+      }
+    }
+    stack.pop();
+    return err;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="execute" defaultstate="collapsed">
+  #if(0 && JSDOC)
+  /**
+   * Execute a process, optionally fetch stdout, stderr or pass stdin data.
+   *
+   * - The `program` is the path to the executable.
+   *
+   * - The `arguments` (if not omitted/undefined) is an array with values, which
+   *   are coercible to strings.
+   *
+   * - The `options` is a plain object with additional flags and options.
+   *   All these options are optional and have sensible default values:
+   *
+   *    {
+   *      // Plain object for environment variables to set.
+   *      env     : {object}={},
+   *
+   *      // Optional text or buffer that is passed to the program via stdin piping (not copied).
+   *      // Files can be passed as `{file: path}` or opened `fs.file` object, the child reads
+   *      // directly from the file then.
+   *      stdin   : {String|Buffer|fs.file|object}="",
+   *
+   *      // If true the output is an object containing the fetched output in the property `stdout`.
+   *      // The exit code is then stored in the property `exitcode`.
+   *      // If it is a function, see callbacks below.
+   *      stdout  : {boolean|function}=false,
+   *
+   *      // If true the output is an object containing the fetched output in the property `stderr`.
+   *      // The exit code is then stored in the property `exitcode`.
+   *      // If the value is "stdout", then the stderr output is redirected to stdout, and the
+   *      // option `stdout` is implicitly set to `true` if it was `false`.
+   *      // If it is a function, see callbacks below.
+   *      stderr  : {boolean|function|"stdout"}=false,
+   *
+   *      // Normally the user environment is also available for the executed child process. That
    *      // might cause issues, e.g. with security. To prevent passing through the current environment,
    *      // set this property to `true`.
    *      noenv   : {boolean}=false,
@@ -773,20 +1786,33 @@ namespace duktape { namespace detail { namespace system { namespace exec {
    *
    *      // Process run timeout in ms, the process will be terminated (and SIGKILL killed later if
    *      // not terminating itself) if it runs longer than this timeout.
-   *      timeout : {number}
+   *      timeout : {number},
    *
+   *      // If true, the result is an object containing the resource usage of the
+   *      // child process in the property `stats` (see below).
+   *      stats   : {boolean}=false
    *    }
    *
    * - The return value is:
    *
    *    - the exit code of the process, is no stdout nor stderr fetching is switched on,
    *
-   *    - a plain object if any fetching is enabled:
+   *    - a plain object if any fetching or `stats` is enabled:
    *
    *        {
    *          exitcode: {number},
    *          stdout  : {string},
-   *          stderr  : {string}
+   *          stderr  : {string},
+   *          stats   : {        // Only with option `stats:true`
+   *            walltime: {number}, // Wall clock run time in ms
+   *            utime   : {number}, // User CPU time in ms
+   *            stime   : {number}, // System CPU time in ms
+   *            maxrss  : {number}, // Maximum resident set size in bytes
+   *            minflt  : {number}, // Minor page faults
+   *            majflt  : {number}, // Major page faults
+   *            nvcsw   : {number}, // Voluntary context switches
+   *            nivcsw  : {number}  // Involuntary context switches
+   *          }
    *        }
    *
    *    - `undefined` if exec exceptions are disabled and an error occurs.
@@ -853,14 +1879,17 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     int exit_code = 0;
     int timeout_ms = -1;
     std::string program;
-    std::vector<std::string> arguments, environment;
-    std::string stdin_data, stdout_data, stderr_data;
-    bool without_path_search = false;
-    bool noenv = false;
+    std::vector<std::string> arguments;
+    std::string stdout_data, stderr_data, stdin_file_data;
+    stdin_source stdin_data;
+    fd_guard stdin_file;
+    process_options popts;
     bool ignore_stdout = true;
     bool ignore_stderr = true;
     bool redirect_stderr_to_stdout = false;
     bool no_exception = false;
+    bool with_stats = false;
+    process_stats stats;
     index_t stdout_callback = -1;
     index_t stderr_callback = -1;
     // </editor-fold>
@@ -910,9 +1939,8 @@ namespace duktape { namespace detail { namespace system { namespace exec {
 
       if(optindex >= 0) {
         // flags
-        without_path_search = stack.get_prop_string<bool>(optindex, "nopath", false);
-        noenv = stack.get_prop_string<bool>(optindex, "noenv", false);
         timeout_ms = stack.get_prop_string<int>(optindex, "timeout", -1);
+        with_stats = stack.get_prop_string<bool>(optindex, "stats", false);
 
         // program path/name (in $PATH)
         if(stack.get_prop_string(optindex, "program")) {
@@ -987,48 +2015,25 @@ namespace duktape { namespace detail { namespace system { namespace exec {
         }
         stack.pop();
 
-        // stdin
-        if(stack.get_prop_string(optindex, "stdin")) {
-          if(stack.is_string(-1)) {
-            stdin_data = stack.get<std::string>(-1);
-            clog__("opts.stdin === string(" << stdin_data.length() << ")");
-          } else if(stack.is_false(-1) || stack.is_null(-1) || stack.is_undefined(-1)) {
-            clog__("opts.stdin === false/null/undefined");
-            stdin_data.clear();
-          } else if(stack.is_buffer(-1)) {
-            clog__("opts.stdin === buffer");
-            stdin_data = stack.get_buffer<std::string>(-1);
-          } else {
-            if(!no_exception) stack.throw_exception(std::string("Invalid value for the 'stdin' exec option."));
+        // stdin (string/buffer data are borrowed, not copied: the value stays on the stack)
+        stack.get_prop_string(optindex, "stdin");
+        {
+          const std::string err = get_stdin_source(stack, -1, stdin_data, stdin_file.fd, stdin_file_data);
+          if(!err.empty()) {
+            if(!no_exception) stack.throw_exception(err);
             return 0;
           }
+          clog__("opts.stdin: size=" << stdin_data.size << ", fd=" << stdin_data.fd);
         }
-        stack.pop();
 
-        // env
-        if(stack.get_prop_string(optindex, "env")) {
-          if(!stack.is_object(-1) || stack.is_array(-1) || stack.is_function(-1)) {
-            if(!no_exception) stack.throw_exception(std::string("exec(): Environment must be passed as plain object."));
+        // nopath, noenv, env
+        {
+          const std::string err = get_process_options(stack, optindex, popts);
+          if(!err.empty()) {
+            if(!no_exception) stack.throw_exception(std::string("exec(): ") + err);
             return 0;
-          } else {
-            stack.enumerator(-1, duktape::api::enum_own_properties_only);
-            while(stack.next(-1, true)) {
-              environment.push_back(stack.req<std::string>(-2));
-              environment.push_back(stack.to<std::string>(-1));
-              stack.pop(2);
-            }
-            stack.pop();
-          }
-          for(auto e:environment) {
-            for(auto c:e) {
-              if(c == '\0' || c == '=') {
-                if(!no_exception) stack.throw_exception("Environment contains invalid characters.");
-                return 0;
-              }
-            }
           }
         }
-        stack.pop();
       }
 
       if(program.empty()) {
@@ -1040,16 +2045,16 @@ namespace duktape { namespace detail { namespace system { namespace exec {
       {
         std::stringstream ss_args, ss_env;
         for(auto e:arguments) ss_args << " '" << e << "'";
-        for(auto e:environment) ss_env << " '" << e << "'";
+        for(auto e:popts.environment) ss_env << " '" << e << "'";
         clog__("program = '" << program << "'");
         clog__("arguments =" << ss_args.str());
         clog__("environment =" << ss_env.str());
-        clog__("without_path_search = " << without_path_search);
-        clog__("noenv = " << noenv);
+        clog__("without_path_search = " << popts.without_path_search);
+        clog__("noenv = " << popts.noenv);
         clog__("redirect_stderr_to_stdout = " << redirect_stderr_to_stdout);
         clog__("ignore_stderr = " << ignore_stderr);
         clog__("ignore_stdout = " << ignore_stdout);
-        clog__("stdin_buffer.length() = " << stdin_data.length());
+        clog__("stdin_data.size = " << stdin_data.size);
       }
       #endif
     }
@@ -1059,7 +2064,7 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     try {
       std::string stdout_buffer, stderr_buffer;
       bool was_timeout = false;
-      execute_backend(program, arguments, environment, exit_code,
+      execute_backend(program, arguments, popts.environment, exit_code,
         [&](std::string&& data){
           if(stdout_callback >= 0) {
             read_callback(stdout_callback, stdout_buffer, stdout_data, data.data(), data.size());
@@ -1077,7 +2082,8 @@ namespace duktape { namespace detail { namespace system { namespace exec {
           return true;
         },
         stdin_data,
-        ignore_stdout, ignore_stderr, redirect_stderr_to_stdout, without_path_search, noenv, timeout_ms, was_timeout
+        ignore_stdout, ignore_stderr, redirect_stderr_to_stdout, popts.without_path_search, popts.noenv, timeout_ms, was_timeout,
+        false, with_stats ? (&stats) : nullptr
       );
       // Flush buffers, note: only applies if std***_callback is actually not -1
       if(!stdout_buffer.empty()) read_callback(stdout_callback, stdout_buffer, stdout_data, "", 0);
@@ -1095,13 +2101,26 @@ namespace duktape { namespace detail { namespace system { namespace exec {
     // <editor-fold desc="return value composition" defaultstate="collapsed">
     {
       stack.top(0);
-      if(ignore_stdout && ignore_stderr) {
+      if(ignore_stdout && ignore_stderr && (!with_stats)) {
         stack.push(exit_code);
       } else {
         stack.push_object();
         stack.set("exitcode", exit_code);
         stack.set("stdout", stdout_data);
         stack.set("stderr", stderr_data);
+        if(with_stats && stats.valid) {
+          stack.push("stats");
+          stack.push_object();
+          stack.set("walltime", stats.walltime);
+          stack.set("utime", stats.utime);
+          stack.set("stime", stats.stime);
+          stack.set("maxrss", stats.maxrss);
+          stack.set("minflt", stats.minflt);
+          stack.set("majflt", stats.majflt);
+          stack.set("nvcsw", stats.nvcsw);
+          stack.set("nivcsw", stats.nivcsw);
+          stack.put_prop(-3);
+        }
       }
       return 1;
     }
@@ -1180,10 +2199,771 @@ namespace duktape { namespace detail { namespace system { namespace exec {
   }
   // </editor-fold>
 
+  #ifndef WINDOWS
+  // <editor-fold desc="execute_pipeline" defaultstate="collapsed">
+  #if(0 && JSDOC)
+  /**
+   * Executes a chain of processes, where the output of each stage is
+   * directly piped into the input of the next stage (like `a | b | c` in
+   * a shell, but without shell invocation and argument quoting). The data
+   * passed between the stages do not pass through the engine.
+   *
+   * - `stages` is an array, each stage is either:
+   *
+   *    - a string: The program to run without arguments,
+   *    - an array: `[program, arg1, arg2, ...]`,
+   *    - an object: `{program: {string}, args: {array}}`.
+   *
+   * - The `options` (optional) are similar to `sys.exec()`:
+   *
+   *    {
+   *      env     : {object}={},      // Environment variables to set for all stages.
+   *      stdin   : {string|buffer|fs.file|object}, // Data piped into the first stage, or {file:path}.
+   *      stdout  : {boolean}=false,  // Fetch the output of the last stage.
+   *      stderr  : {boolean|"stdout"}=false, // Fetch the collected stderr of all stages.
+   *      outfile : {string},         // Redirect the output of the last stage into this file.
+   *      append  : {boolean}=false,  // Append to `outfile` instead of truncating it.
+   *      noenv   : {boolean}=false,  // Do not pass on the current environment.
+   *      nopath  : {boolean}=false,  // Do not search programs in $PATH.
+   *      noexcept: {boolean}=false,  // Return `undefined` instead of throwing on errors.
+   *      timeout : {number}          // Terminate all stages after this time in ms.
+   *    }
+   *
+   * - The return value is a plain object:
+   *
+   *    {
+   *      exitcode : {number}, // Exit code of the last stage.
+   *      exitcodes: {array},  // Exit codes of all stages (128+signal number for signal terminated stages).
+   *      stdout   : {string}, // Only if `stdout:true`.
+   *      stderr   : {string}  // Only if `stderr:true`.
+   *    }
+   *
+   * - Exit code convention: Like in a shell (`$?`/`PIPESTATUS`), a stage
+   *   terminated by a signal has the exit code 128+signal number (e.g. 137
+   *   for SIGKILL). This differs from `sys.exec()`, which returns the plain
+   *   exit status (0 for signal terminated processes). Stages that could not
+   *   be executed (program not found etc.) have the exit code 1, as in
+   *   `sys.exec()`. Stages whose status could not be collected have -1.
+   *
+   * @throws {Error}
+   * @param {array} stages
+   * @param {object} [options]
+   * @returns {object}
+   */
+  sys.pipeline = function(stages, options) {};
+  #endif
+  template <typename=void>
+  int execute_pipeline(duktape::api& stack)
+  {
+    using index_t = duktape::api::index_t;
+    std::vector<std::vector<std::string>> stages;
+    std::vector<int> exit_codes;
+    std::string stdout_data, stderr_data, output_file, stdin_file_data;
+    stdin_source stdin_data;
+    fd_guard stdin_file;
+    process_options popts;
+    bool no_exception = false, append_output_file = false;
+    bool ignore_stdout = true, ignore_stderr = true, redirect_stderr_to_stdout = false;
+    int timeout_ms = -1;
+
+    // <editor-fold desc="arguments" defaultstate="collapsed">
+    {
+      const index_t optindex = 1;
+      if(stack.top() > 1) {
+        if(!stack.is_object(optindex) || stack.is_array(optindex) || stack.is_function(optindex)) {
+          return stack.throw_exception("pipeline(): Options must be passed as plain object (2nd argument).");
+        }
+        no_exception = stack.get_prop_string<bool>(optindex, "noexcept", false);
+      }
+      if(stack.top() > 2) {
+        if(!no_exception) stack.throw_exception("pipeline(): After the option object no further arguments can follow.");
+        return 0;
+      }
+      if(!stack.is_array(0)) {
+        if(!no_exception) stack.throw_exception("pipeline(): First argument must be an array of stages to execute.");
+        return 0;
+      }
+      const index_t n = index_t(stack.get_length(0));
+      for(index_t i=0; i<n; ++i) {
+        std::vector<std::string> stage;
+        stack.get_prop_index(0, i);
+        if(stack.is<std::string>(-1)) {
+          stage.push_back(stack.get<std::string>(-1));
+        } else if(stack.is_array(-1)) {
+          stage = stack.req<std::vector<std::string>>(-1);
+        } else if(stack.is_object(-1) && !stack.is_function(-1)) {
+          stage.push_back(stack.get_prop_string<std::string>(-1, "program", ""));
+          if(stack.get_prop_string(-1, "args")) {
+            for(auto& e:stack.req<std::vector<std::string>>(-1)) stage.push_back(e);
+          }
+          stack.pop();
+        }
+        stack.pop();
+        if(stage.empty() || stage.front().empty()) {
+          if(!no_exception) stack.throw_exception(std::string("pipeline(): Stage ") + std::to_string(i) + " has no program to execute.");
+          return 0;
+        }
+        for(auto& e:stage) {
+          if(e.find('\0') != e.npos) {
+            if(!no_exception) stack.throw_exception(std::string("pipeline(): Stage ") + std::to_string(i) + " contains a null character.");
+            return 0;
+          }
+        }
+        stages.emplace_back(std::move(stage));
+      }
+      if(stages.empty()) {
+        if(!no_exception) stack.throw_exception("pipeline(): No stages to execute.");
+        return 0;
+      }
+
+      if(stack.top() > 1) {
+        timeout_ms = stack.get_prop_string<int>(optindex, "timeout", -1);
+        output_file = stack.get_prop_string<std::string>(optindex, "outfile", "");
+        append_output_file = stack.get_prop_string<bool>(optindex, "append", false);
+
+        // stdout
+        if(stack.get_prop_string(optindex, "stdout")) {
+          if(stack.is_boolean(-1) || stack.is_null(-1)) {
+            ignore_stdout = !stack.get<bool>(-1);
+          } else {
+            if(!no_exception) stack.throw_exception("pipeline(): Invalid value for the 'stdout' option.");
+            return 0;
+          }
+        }
+        stack.pop();
+
+        // stderr
+        if(stack.get_prop_string(optindex, "stderr")) {
+          if(stack.is_boolean(-1) || stack.is_null(-1)) {
+            ignore_stderr = !stack.get<bool>(-1);
+          } else if(stack.is_string(-1) && (stack.get<std::string>(-1) == "stdout")) {
+            redirect_stderr_to_stdout = true;
+            ignore_stdout = false;
+            ignore_stderr = false;
+          } else {
+            if(!no_exception) stack.throw_exception("pipeline(): Invalid value for the 'stderr' option.");
+            return 0;
+          }
+        }
+        stack.pop();
+
+        // stdin (borrowed, the value stays on the stack)
+        stack.get_prop_string(optindex, "stdin");
+        {
+          const std::string err = get_stdin_source(stack, -1, stdin_data, stdin_file.fd, stdin_file_data);
+          if(!err.empty()) {
+            if(!no_exception) stack.throw_exception(std::string("pipeline(): ") + err);
+            return 0;
+          }
+        }
+
+        // nopath, noenv, env
+        {
+          const std::string err = get_process_options(stack, optindex, popts);
+          if(!err.empty()) {
+            if(!no_exception) stack.throw_exception(std::string("pipeline(): ") + err);
+            return 0;
+          }
+        }
+      }
+    }
+    // </editor-fold>
+
+    // <editor-fold desc="run" defaultstate="collapsed">
+    try {
+      bool was_timeout = false;
+      execute_pipeline_backend(stages, popts.environment, exit_codes,
+        [&](std::string&& data){ stdout_data.append(data); },
+        [&](std::string&& data){ stderr_data.append(data); },
+        stdin_data, output_file, append_output_file,
+        ignore_stdout, ignore_stderr, redirect_stderr_to_stdout,
+        popts.without_path_search, popts.noenv, timeout_ms, was_timeout
+      );
+      if(was_timeout && (!no_exception)) return stack.throw_exception("timeout");
+    } catch(const std::exception& e) {
+      std::string().swap(stdout_data);
+      std::string().swap(stderr_data);
+      if(!no_exception) return stack.throw_exception(std::string() + e.what());
+      return 0;
+    }
+    // </editor-fold>
+
+    // <editor-fold desc="return value composition" defaultstate="collapsed">
+    stack.top(0);
+    stack.push_object();
+    stack.set("exitcode", exit_codes.back());
+    stack.set("exitcodes", exit_codes);
+    if(!ignore_stdout && output_file.empty()) stack.set("stdout", stdout_data);
+    if(!ignore_stderr && !redirect_stderr_to_stdout) stack.set("stderr", stderr_data);
+    return 1;
+    // </editor-fold>
+  }
+  // </editor-fold>
+  #endif
+
+  #ifndef WINDOWS
+  // <editor-fold desc="spawn: process object" defaultstate="collapsed">
+  /**
+   * Native state of a spawned process, saved in hidden
+   * properties of the JS process object.
+   */
+  struct process_data
+  {
+    ::pid_t pid = -1;
+    int ifd = -1, ofd = -1, efd = -1;
+    int exit_code = -1;
+  };
+
+  /**
+   * Native output buffers of a spawned process, the pointer is saved
+   * in the hidden "output" property and deleted by the finalizer. Data
+   * are appended here and only pushed to the JS stack by `read()`.
+   */
+  struct process_output
+  {
+    std::string out, err;
+  };
+
+  template <typename=void>
+  process_output* get_process_output(duktape::api& stack, duktape::api::index_t index)
+  {
+    process_output* output = nullptr;
+    if(stack.get_prop_string_hidden(index, "output")) output = reinterpret_cast<process_output*>(stack.get_pointer(-1));
+    stack.pop();
+    return output;
+  }
+
+  template <typename=void>
+  bool get_process_data(duktape::api& stack, duktape::api::index_t index, process_data& proc)
+  {
+    const auto top = stack.top();
+    index = stack.absindex(index);
+    if((!stack.is_object(index)) || (!stack.get_prop_string_hidden(index, "pid"))) {
+      stack.top(top);
+      stack.throw_exception("Process methods have to be called on a process object (see sys.spawn()).");
+      return false;
+    }
+    stack.get_prop_string_hidden(index, "ifd");
+    stack.get_prop_string_hidden(index, "ofd");
+    stack.get_prop_string_hidden(index, "efd");
+    stack.get_prop_string_hidden(index, "exitcode");
+    proc.pid = stack.get<int>(-5);
+    proc.ifd = stack.get<int>(-4);
+    proc.ofd = stack.get<int>(-3);
+    proc.efd = stack.get<int>(-2);
+    proc.exit_code = stack.get<int>(-1);
+    stack.top(top);
+    return true;
+  }
+
+  template <typename=void>
+  void set_process_data(duktape::api& stack, duktape::api::index_t index, const process_data& proc)
+  {
+    index = stack.absindex(index);
+    stack.push(int(proc.pid)); stack.put_prop_string_hidden(index, "pid");
+    stack.push(proc.ifd); stack.put_prop_string_hidden(index, "ifd");
+    stack.push(proc.ofd); stack.put_prop_string_hidden(index, "ofd");
+    stack.push(proc.efd); stack.put_prop_string_hidden(index, "efd");
+    stack.push(proc.exit_code); stack.put_prop_string_hidden(index, "exitcode");
+  }
+
+  /**
+   * Non-blocking check if the process has terminated, sets
+   * pid=-1 and the exit code if so. Returns true if terminated.
+   */
+  template <typename=void>
+  bool process_reap(process_data& proc, bool block=false) noexcept
+  {
+    if(proc.pid <= 0) return true;
+    int status = 0;
+    ::pid_t r;
+    while(((r=wait_child(proc.pid, &status, block ? 0 : WNOHANG)) < 0) && (errno == EINTR));
+    if(r == proc.pid) {
+      proc.exit_code = WIFSIGNALED(status) ? (128+WTERMSIG(status)) : WEXITSTATUS(status);
+      proc.pid = -1;
+    } else if(r < 0) {
+      proc.pid = -1; // ECHILD, reaped elsewhere.
+    }
+    return proc.pid <= 0;
+  }
+
+  /**
+   * Reads all currently available data of stdout and stderr into the
+   * native output buffers. Closes the descriptors on EOF. If `timeout_ms`
+   * is not 0, the function polls up to this time for data.
+   */
+  template <typename=void>
+  void process_drain(duktape::api& stack, duktape::api::index_t index, process_data& proc, int timeout_ms=0)
+  {
+    index = stack.absindex(index);
+    struct ::pollfd pfd[2] = {{proc.ofd,POLLIN|POLLPRI,0},{proc.efd,POLLIN|POLLPRI,0}};
+    if((timeout_ms != 0) && ((proc.ofd >= 0) || (proc.efd >= 0))) {
+      while((::poll(pfd, 2, timeout_ms) < 0) && (errno == EINTR));
+    }
+    process_output* output = get_process_output(stack, index);
+    const auto read_fd = [&](int& fd, std::string* data) {
+      if(fd < 0) return;
+      char buf[4096];
+      ssize_t n;
+      while((n=::read(fd, buf, sizeof(buf))) > 0) { if(data) data->append(buf, size_t(n)); }
+      if((!n) || ((n<0) && (errno != EAGAIN) && (errno != EINTR))) { ::close(fd); fd = -1; }
+    };
+    read_fd(proc.ofd, output ? &output->out : nullptr);
+    read_fd(proc.efd, output ? &output->err : nullptr);
+    set_process_data(stack, index, proc);
+  }
+
+  template <typename=void>
+  duk_ret_t process_finalizer(duk_context *ctx)
+  {
+    // See file_finalizer(): only engine errors are passed through.
+    try {
+      duktape::api stack(ctx);
+      const bool is_process = stack.is_object(0) && stack.get_prop_string_hidden(0, "pid");
+      stack.top(1);
+      if(is_process) {
+        process_data proc;
+        if(get_process_data(stack, 0, proc)) {
+          if(proc.ifd >= 0) ::close(proc.ifd);
+          if(proc.ofd >= 0) ::close(proc.ofd);
+          if(proc.efd >= 0) ::close(proc.efd);
+          proc.ifd = proc.ofd = proc.efd = -1;
+          if(proc.pid > 0) {
+            kill_child(proc.pid, SIGTERM);
+            ::sleep(0);
+            if(!process_reap(proc)) kill_child(proc.pid, SIGKILL);
+            process_reap(proc, true);
+          }
+          set_process_data(stack, 0, proc);
+        }
+        delete get_process_output(stack, 0);
+        stack.push_pointer(nullptr);
+        stack.put_prop_string_hidden(0, "output");
+      }
+    } catch(const duktape::engine_error&) {
+      throw;
+    } catch(const duktape::exit_exception&) {
+      // ignore
+    } catch(const std::exception&) {
+      // ignore
+    }
+    return 0;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="spawn" defaultstate="collapsed">
+  #if(0 && JSDOC)
+  /**
+   * Starts a process without waiting for it to terminate, and returns a
+   * process object to interact with the running child. The child is
+   * terminated when the process object is garbage collected.
+   *
+   * - `program` and `arguments` are the same as for `sys.exec()`.
+   *
+   * - The `options` (optional):
+   *
+   *    {
+   *      env     : {object}={},    // Environment variables to set.
+   *      noenv   : {boolean}=false,// Do not pass on the current environment.
+   *      nopath  : {boolean}=false,// Do not search the program in $PATH.
+   *      stdin   : {boolean}=true, // false: stdin is /dev/null.
+   *      stdout  : {boolean}=true, // false: stdout is /dev/null.
+   *      stderr  : {boolean|"stdout"}=true // false: /dev/null, "stdout": redirected to stdout.
+   *    }
+   *
+   * - Process object methods/properties:
+   *
+   *    proc.pid          : {number} Process ID of the child.
+   *    proc.read([stream="stdout"|"stderr"], [timeout_ms=0])
+   *                      : Returns the available output data, or `undefined` at EOF.
+   *                        Does not block unless a timeout is given.
+   *    proc.write(data)  : Writes as much of the string/buffer as possible without
+   *                        blocking, returns the number of bytes written.
+   *    proc.closeStdin() : Closes the stdin pipe of the child (EOF for the child).
+   *    proc.wait([timeout_ms]) : Waits for termination and returns the exit code, or
+   *                        `undefined` if the child is still running after the timeout.
+   *                        Output is buffered for read() during waiting.
+   *    proc.kill([signal=15]): Sends a signal (number or name like "SIGKILL") to the child.
+   *
+   * @throws {Error}
+   * @param {string} program
+   * @param {array} [arguments]
+   * @param {object} [options]
+   * @returns {object}
+   */
+  sys.spawn = function(program, arguments, options) {};
+  #endif
+  template <typename=void>
+  int process_spawn(duktape::api& stack)
+  {
+    using index_t = duktape::api::index_t;
+    std::string program;
+    std::vector<std::string> arguments;
+    process_options popts;
+    bool with_stdin = true, with_stdout = true, with_stderr = true, redirect_stderr_to_stdout = false;
+
+    // <editor-fold desc="arguments" defaultstate="collapsed">
+    {
+      index_t optindex = -1;
+      if(!stack.is<std::string>(0) || stack.get<std::string>(0).empty()) {
+        return stack.throw_exception("spawn(): First argument must be the program to execute (non-empty string).");
+      }
+      program = stack.get<std::string>(0);
+      if(stack.is_array(1)) {
+        arguments = stack.req<std::vector<std::string>>(1);
+        if(stack.is_object(2)) optindex = 2;
+      } else if(stack.is_object(1) && !stack.is_function(1)) {
+        optindex = 1;
+      } else if((stack.top() > 1) && !stack.is_undefined(1)) {
+        return stack.throw_exception("spawn(): Program arguments must be passed as array (2nd argument invalid)");
+      }
+      for(auto& e:arguments) {
+        if(e.find('\0') != e.npos) return stack.throw_exception("spawn(): Argument contains a null character.");
+      }
+      if(optindex >= 0) {
+        const std::string err = get_process_options(stack, optindex, popts);
+        if(!err.empty()) return stack.throw_exception(std::string("spawn(): ") + err);
+        with_stdin = stack.get_prop_string<bool>(optindex, "stdin", true);
+        with_stdout = stack.get_prop_string<bool>(optindex, "stdout", true);
+        if(stack.get_prop_string(optindex, "stderr")) {
+          if(stack.is_string(-1) && (stack.get<std::string>(-1) == "stdout")) {
+            redirect_stderr_to_stdout = true;
+            with_stdout = true;
+          } else {
+            with_stderr = stack.to<bool>(-1);
+          }
+        }
+        stack.pop();
+      }
+    }
+    // </editor-fold>
+
+    // <editor-fold desc="start" defaultstate="collapsed">
+    process_data proc;
+    {
+      int pi[2] = {-1,-1}, po[2] = {-1,-1}, pe[2] = {-1,-1};
+      const auto close_all = [&]() {
+        for(auto fd:{pi[0],pi[1],po[0],po[1],pe[0],pe[1]}) { if(fd >= 0) ::close(fd); }
+      };
+      if((with_stdin && ::pipe(pi)) || (with_stdout && ::pipe(po)) || (with_stderr && (!redirect_stderr_to_stdout) && ::pipe(pe))) {
+        const int err = errno;
+        close_all();
+        return stack.throw_exception(std::string("spawn(): Failed to create pipes: ") + ::strerror(err));
+      }
+      try {
+        proc.pid = fork_exec(program, arguments, popts.environment, popts.without_path_search, popts.noenv,
+          pi[0], po[1], redirect_stderr_to_stdout ? po[1] : pe[1]);
+      } catch(const std::exception& e) {
+        close_all();
+        return stack.throw_exception(std::string("spawn(): ") + e.what());
+      }
+      for(auto fd:{pi[0],po[1],pe[1]}) { if(fd >= 0) ::close(fd); }
+      for(auto fd:{pi[1],po[0],pe[0]}) {
+        int o;
+        if((fd >= 0) && ((o=::fcntl(fd, F_GETFL, 0)) >= 0)) ::fcntl(fd, F_SETFL, o|O_NONBLOCK);
+        if(fd >= 0) ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+      }
+      proc.ifd = pi[1];
+      proc.ofd = po[0];
+      proc.efd = pe[0];
+    }
+    // </editor-fold>
+
+    // <editor-fold desc="process object" defaultstate="collapsed">
+    stack.top(0);
+    stack.push_object();
+    stack.get_global_string("sys");
+    stack.get_prop_string(-1, "spawn");
+    stack.get_prop_string(-1, "prototype");
+    stack.set_prototype(0);
+    stack.top(1);
+    set_process_data(stack, 0, proc);
+    stack.push_pointer(new process_output());
+    stack.put_prop_string_hidden(0, "output");
+    stack.push_c_function(process_finalizer<>, 1);
+    stack.set_finalizer(0);
+    stack.push(int(proc.pid));
+    stack.put_prop_string(0, "pid");
+    return 1;
+    // </editor-fold>
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Returns the available output of the child process (stdout or stderr),
+   * an empty string if no data are available (yet), or `undefined` if the
+   * stream is closed and all data were read. Optionally waits up to
+   * `timeout` milliseconds for data (negative: infinite).
+   *
+   * @param {string} [stream="stdout"]
+   * @param {number} [timeout=0]
+   * @returns {string|undefined}
+   */
+  sys.spawn.prototype.read = function(stream, timeout) {};
+  #endif
+  template <typename=void>
+  int process_read(duktape::api& stack)
+  {
+    const std::string stream = stack.is_undefined(0) ? std::string("stdout") : stack.to<std::string>(0);
+    const int timeout_ms = stack.is_undefined(1) ? 0 : stack.to<int>(1);
+    if((stream != "stdout") && (stream != "stderr")) return stack.throw_exception("read(): Stream must be 'stdout' or 'stderr'.");
+    stack.top(0);
+    stack.push_this();
+    process_data proc;
+    if(!get_process_data(stack, 0, proc)) return 0;
+    process_output* output = get_process_output(stack, 0);
+    if(!output) return stack.throw_exception("read(): Process object has no output buffers.");
+    std::string& buffer = (stream == "stdout") ? output->out : output->err;
+    process_drain(stack, 0, proc, buffer.empty() ? timeout_ms : 0);
+    if(buffer.empty() && (((stream == "stdout") ? proc.ofd : proc.efd) < 0)) return 0;
+    stack.push(buffer);
+    buffer.clear();
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Writes data to the stdin of the child without blocking. Returns the
+   * number of bytes written, which may be less than the data size (or 0)
+   * if the pipe is full.
+   *
+   * @throws {Error}
+   * @param {string|buffer} data
+   * @returns {number}
+   */
+  sys.spawn.prototype.write = function(data) {};
+  #endif
+  template <typename=void>
+  int process_write(duktape::api& stack)
+  {
+    stack.top(1);
+    if(!stack.is_buffer_data(0) && !stack.is_string(0)) stack.to_string(0);
+    const void* data; size_t size;
+    stack.get_data_view(0, data, size); // borrowed, argument stays on the stack.
+    stack.push_this();
+    process_data proc;
+    if(!get_process_data(stack, 1, proc)) return 0;
+    if(proc.ifd < 0) return stack.throw_exception("write(): Process stdin is closed.");
+    ssize_t n = 0;
+    while(((n=write_nosigpipe(proc.ifd, data, size)) < 0) && (errno == EINTR));
+    if(n < 0) {
+      if(errno == EAGAIN) {
+        n = 0;
+      } else {
+        const int err = errno;
+        ::close(proc.ifd);
+        proc.ifd = -1;
+        set_process_data(stack, 1, proc);
+        return stack.throw_exception(std::string("write(): Failed to write to process stdin: ") + ::strerror(err));
+      }
+    }
+    stack.push(double(n));
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Closes the stdin pipe of the child process. Returns `this`.
+   *
+   * @returns {object}
+   */
+  sys.spawn.prototype.closeStdin = function() {};
+  #endif
+  template <typename=void>
+  int process_close_stdin(duktape::api& stack)
+  {
+    stack.top(0);
+    stack.push_this();
+    process_data proc;
+    if(!get_process_data(stack, 0, proc)) return 0;
+    if(proc.ifd >= 0) ::close(proc.ifd);
+    proc.ifd = -1;
+    set_process_data(stack, 0, proc);
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Waits for the child process to terminate and returns its exit code
+   * (128+signal number if terminated by a signal). Without timeout the
+   * function waits until the process has terminated, with timeout it
+   * returns `undefined` if the process is still running. Output of the
+   * child is read and buffered during waiting, so that a child cannot
+   * block on a full pipe.
+   *
+   * @param {number} [timeout]
+   * @returns {number|undefined}
+   */
+  sys.spawn.prototype.wait = function(timeout) {};
+  #endif
+  template <typename=void>
+  int process_wait(duktape::api& stack)
+  {
+    using namespace std::chrono;
+    const int timeout_ms = stack.is_undefined(0) ? -1 : stack.to<int>(0);
+    stack.top(0);
+    stack.push_this();
+    process_data proc;
+    if(!get_process_data(stack, 0, proc)) return 0;
+    const auto start_time = steady_clock::now();
+    while(!process_reap(proc)) {
+      int poll_ms = 50;
+      if(timeout_ms >= 0) {
+        const int left = timeout_ms - int(duration_cast<milliseconds>(steady_clock::now() - start_time).count());
+        if(left <= 0) break;
+        if(left < poll_ms) poll_ms = left;
+      }
+      if((proc.ofd < 0) && (proc.efd < 0)) {
+        ::usleep(useconds_t(poll_ms < 5 ? poll_ms : 5) * 1000);
+      } else {
+        process_drain(stack, 0, proc, poll_ms);
+      }
+    }
+    if(proc.pid > 0) {
+      set_process_data(stack, 0, proc);
+      return 0;
+    }
+    process_drain(stack, 0, proc);
+    stack.push(proc.exit_code);
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Sends a signal to the child process (default SIGTERM). The signal can
+   * be specified as number or name (e.g. "SIGKILL", "KILL"). Returns true
+   * if the signal was sent, false if the process has already terminated.
+   *
+   * @throws {Error}
+   * @param {number|string} [signal]
+   * @returns {boolean}
+   */
+  sys.spawn.prototype.kill = function(signal) {};
+  #endif
+  template <typename=void>
+  int process_kill(duktape::api& stack)
+  {
+    int sig = SIGTERM;
+    if(stack.is_number(0)) {
+      sig = stack.get<int>(0);
+    } else if(stack.is_string(0)) {
+      std::string name = stack.get<std::string>(0);
+      if(name.find("SIG") == 0) name = name.substr(3);
+      const struct { const char* name; int sig; } signals[] = {
+        {"HUP",SIGHUP}, {"INT",SIGINT}, {"QUIT",SIGQUIT}, {"KILL",SIGKILL}, {"TERM",SIGTERM},
+        {"USR1",SIGUSR1}, {"USR2",SIGUSR2}, {"STOP",SIGSTOP}, {"CONT",SIGCONT}, {"ALRM",SIGALRM}
+      };
+      sig = -1;
+      for(const auto& e:signals) { if(name == e.name) sig = e.sig; }
+      if(sig < 0) return stack.throw_exception(std::string("kill(): Unknown signal name '") + stack.get<std::string>(0) + "'.");
+    } else if(!stack.is_undefined(0)) {
+      return stack.throw_exception("kill(): Signal must be a number or signal name.");
+    }
+    stack.top(0);
+    stack.push_this();
+    process_data proc;
+    if(!get_process_data(stack, 0, proc)) return 0;
+    if(process_reap(proc)) {
+      set_process_data(stack, 0, proc);
+      stack.push(false);
+    } else if(kill_child(proc.pid, sig) < 0) {
+      return stack.throw_exception(std::string("kill(): ") + ::strerror(errno));
+    } else {
+      stack.push(true);
+    }
+    return 1;
+  }
+  // </editor-fold>
+  #endif
+
 }}}}
 
 namespace duktape { namespace mod { namespace system { namespace exec {
 
+  #ifndef WINDOWS
+  // <editor-fold desc="spawn server" defaultstate="collapsed">
+  /**
+   * Starts the process wide spawn server ("zygote"), which creates all child
+   * processes of sys.exec(), sys.shell(), sys.pipeline() and sys.spawn().
+   * Should be called early by the host application, before threads are
+   * started and the heap grows. The server must be started from a long-lived
+   * thread (normally the main thread): it is killed with PR_SET_PDEATHSIG
+   * when the thread that forked it exits, not only when the process exits.
+   * The server is the parent of the children (their `$PPID`), exit status
+   * and resource usage are passed back to the host. The children inherit
+   * the umask of the host at the time the server was started, and the
+   * current host environment and working directory. The JS API does not
+   * change. Returns true if the server is running (Linux only, false on
+   * other platforms or errors, where the children are forked from the host
+   * process as usual).
+   * @return bool
+   */
+  template <typename=void>
+  static bool start_spawn_server()
+  {
+    #ifdef __linux__
+    auto& srv = ::duktape::detail::system::exec::spawn_server();
+    std::lock_guard<std::mutex> lock(srv.mutex);
+    if(srv.fd >= 0) return true;
+    int sv[2] = {-1,-1};
+    if(::socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, sv)) return false;
+    const ::pid_t host_pid = ::getpid();
+    const ::pid_t pid = ::fork();
+    if(pid < 0) {
+      ::close(sv[0]);
+      ::close(sv[1]);
+      return false;
+    } else if(pid == 0) {
+      ::close(sv[0]);
+      ::duktape::detail::system::exec::spawn_server_protocol::server_main(sv[1], host_pid);
+      ::_exit(0);
+    }
+    ::close(sv[1]);
+    srv.fd = sv[0];
+    srv.pid = pid;
+    srv.requests = 0;
+    srv.environment.clear();
+    for(char** e = environ; e && *e; ++e) srv.environment.push_back(*e);
+    return true;
+    #else
+    return false;
+    #endif
+  }
+
+  /**
+   * Stops the spawn server, children are forked from the host process again.
+   * The server exits when all children it has created have terminated, this
+   * function blocks until then.
+   */
+  template <typename=void>
+  static void stop_spawn_server()
+  {
+    auto& srv = ::duktape::detail::system::exec::spawn_server();
+    int fd = -1;
+    ::pid_t pid = -1;
+    {
+      std::lock_guard<std::mutex> lock(srv.mutex);
+      std::swap(fd, srv.fd);
+      std::swap(pid, srv.pid);
+    }
+    if(fd >= 0) ::close(fd);
+    if(pid > 0) while((::waitpid(pid, nullptr, 0) < 0) && (errno == EINTR));
+  }
+
+  /**
+   * Returns true if the spawn server is running.
+   * @return bool
+   */
+  template <typename=void>
+  static bool spawn_server_running()
+  {
+    auto& srv = ::duktape::detail::system::exec::spawn_server();
+    std::lock_guard<std::mutex> lock(srv.mutex);
+    return srv.fd >= 0;
+  }
+  // </editor-fold>
+  #endif
+
   // <editor-fold desc="js decls" defaultstate="collapsed">
   /**
    * Export main relay. Adds all module functions to the specified engine.
@@ -1196,6 +2976,20 @@ namespace duktape { namespace mod { namespace system { namespace exec {
     js.define("sys.exec", execute<>, -1);
     js.define("sys.shell", execute_shell<>, -1);
     js.define("sys.escapeshellarg", escape_shell_arg<void>);
+    #ifndef WINDOWS
+    js.define("sys.pipeline", execute_pipeline<>, -1);
+    js.define("sys.spawn", process_spawn<>, -1);
+    {
+      auto flags = js.define_flags();
+      js.define_flags(duktape::engine::defflags::restricted);
+      js.define("sys.spawn.prototype.read", process_read<>, 2);
+      js.define("sys.spawn.prototype.write", process_write<>, 1);
+      js.define("sys.spawn.prototype.closeStdin", process_close_stdin<>, 0);
+      js.define("sys.spawn.prototype.wait", process_wait<>, 1);
+      js.define("sys.spawn.prototype.kill", process_kill<>, 1);
+      js.define_flags(flags);
+    }
+    #endif
   }
   // </editor-fold>
 
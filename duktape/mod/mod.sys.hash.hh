@@ -19,9 +19,20 @@
  *  - CRC8  (PEC polynomial, init value and final XOR) for string and buffer.
  *  - CRC16 (USB polynomial, init value and final XOR) for string and buffer.
  *  - CRC32 (CITT polynomial, init value and final XOR) for string and buffer.
+ *  - CRC32C (Castagnoli polynomial) for string and buffer.
  *  - MD5 for string, buffer and file
  *  - SHA1 for string, buffer and file
+ *  - SHA256 for string, buffer and file
  *  - SHA512 for string, buffer and file
+ *  - XXH3 64/128 bit (non-cryptographic) for string, buffer and file
+ *  - BLAKE3 for string, buffer and file (SIMD and multi-threaded)
+ *
+ * Files are read sequentially in large page aligned blocks (with read-ahead
+ * advice where available), and the hash classes process all complete blocks
+ * of a span in one `update()` pass. SHA1 and SHA256 use the x86 SHA
+ * extensions if the CPU has them, BLAKE3 hashes long inputs with several
+ * threads. `sys.hash.files()` hashes lists of files in a worker pool
+ * (requires thread support, `-pthread` on older systems).
  *
  * Note: The CRC algorithms are already quite old (not in contemporary
  *       c++ style), but they are approved to work. Versions tracking
@@ -49,6 +60,8 @@
 #ifndef DUKTAPE_MOD_HASHES_EXT_HH
 #define DUKTAPE_MOD_HASHES_EXT_HH
 
+#include "mod.sys.encode.hh" /* hex/base64 digest formatting */
+
 // <editor-fold desc="swlib-cc.crc" defaultstate="collapsed">
 // @version: #f84cdfe 2009-11-01T20:38:02+01:00
 /**
@@ -68,6 +81,8 @@
  *
  *  uint32_t checksum = sw::crc32::calculate(pointer_to_data, size_of_data);
  *
+ *  uint32_t checksum = sw::crc32c::calculate(pointer_to_data, size_of_data);
+ *
  * -------------------------------------------------------------------------------------
  * +++ MIT license +++
  * Copyright (c) 2008-2017, Stefan Wilhelm <cerbero s@atwilly s.de>
@@ -96,6 +111,10 @@
 #else
 #include <inttypes.h>
 #endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define SW_CRC_HAVE_X86_KERNELS
+  #include <immintrin.h>
+#endif
 
 namespace sw { namespace detail {
 
@@ -171,10 +190,282 @@ const uint32_t crc_lookups<uint32_t>::tab[256] = {
   0xb3667a2e,0xc4614ab8,0x5d681b02,0x2a6f2b94,0xb40bbe37,0xc30c8ea1,0x5a05df1b,0x2d02ef8d
 };
 
+/**
+ * Slicing-by-8 tables for reflected CRCs up to 64 bit. `t[0]` is the
+ * bytewise lookup table, `t[k][b]` is the CRC contribution of byte `b`
+ * followed by `k` zero bytes, so that eight input bytes are processed
+ * with eight independent lookups.
+ */
+template <typename AccType>
+struct crc_slicing_table
+{
+  AccType t[8][256];
+
+  /**
+   * Construct from an existing bytewise lookup table.
+   * @param const AccType* tab
+   */
+  explicit crc_slicing_table(const AccType* tab)
+  {
+    for(unsigned i = 0; i < 256; ++i) t[0][i] = tab[i];
+    derive();
+  }
+
+  /**
+   * Construct from the reflected polynomial.
+   * @param AccType reflected_polynomial
+   * @param bool
+   */
+  crc_slicing_table(AccType reflected_polynomial, bool)
+  {
+    for(unsigned i = 0; i < 256; ++i) {
+      AccType c = AccType(i);
+      for(unsigned k = 0; k < 8; ++k) c = (c & 1) ? AccType((c >> 1) ^ reflected_polynomial) : AccType(c >> 1);
+      t[0][i] = c;
+    }
+    derive();
+  }
+
+  /**
+   * Bytewise update of the CRC register `crc`.
+   */
+  inline AccType update_bytewise(AccType crc, const uint8_t* p, size_t size) const
+  {
+    while(size--) crc = AccType(t[0][(crc ^ (*p++)) & 0xff] ^ (crc >> 8));
+    return crc;
+  }
+
+  /**
+   * Slicing-by-8 update of the CRC register `crc`.
+   */
+  AccType update(AccType crc, const uint8_t* p, size_t size) const
+  {
+    for(; size >= 8; size -= 8, p += 8) {
+      const uint64_t x = uint64_t(crc) ^ (
+        (uint64_t(p[0])    ) | (uint64_t(p[1])<< 8) | (uint64_t(p[2])<<16) | (uint64_t(p[3])<<24) |
+        (uint64_t(p[4])<<32) | (uint64_t(p[5])<<40) | (uint64_t(p[6])<<48) | (uint64_t(p[7])<<56)
+      );
+      crc = AccType(
+        t[7][(x    ) & 0xff] ^ t[6][(x>> 8) & 0xff] ^ t[5][(x>>16) & 0xff] ^ t[4][(x>>24) & 0xff] ^
+        t[3][(x>>32) & 0xff] ^ t[2][(x>>40) & 0xff] ^ t[1][(x>>48) & 0xff] ^ t[0][(x>>56)       ]
+      );
+    }
+    return update_bytewise(crc, p, size);
+  }
+
+private:
+
+  void derive()
+  {
+    for(unsigned k = 1; k < 8; ++k) {
+      for(unsigned i = 0; i < 256; ++i) {
+        t[k][i] = AccType((t[k-1][i] >> 8) ^ t[0][t[k-1][i] & 0xff]);
+      }
+    }
+  }
+};
+
+/**
+ * CRC register update kernels. The generic version uses slicing-by-8
+ * tables derived from `crc_lookups<AccType>::tab`.
+ */
+template <typename AccType>
+struct crc_kernels
+{
+  static const crc_slicing_table<AccType>& table()
+  { static const crc_slicing_table<AccType> tables(crc_lookups<AccType>::tab); return tables; }
+
+  static AccType bytewise(AccType crc, const void* data, size_t size)
+  { return table().update_bytewise(crc, (const uint8_t*)data, size); }
+
+  static AccType slicing8(AccType crc, const void* data, size_t size)
+  { return table().update(crc, (const uint8_t*)data, size); }
+
+  static AccType update(AccType crc, const void* data, size_t size)
+  { return table().update(crc, (const uint8_t*)data, size); }
+};
+
+#ifdef SW_CRC_HAVE_X86_KERNELS
+
+/**
+ * CRC32 (0xEDB88320) folding with carry-less multiplication, as described in
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+ * (Intel, 2009). Processes `size` bytes (`size >= 64`, multiple of 16) and
+ * returns the updated CRC register.
+ */
+template <typename=void>
+__attribute__((target("pclmul,sse4.1")))
+uint32_t crc32_pclmul_fold(uint32_t crc, const uint8_t* p, size_t size)
+{
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596ll, 0x0154442bd4ll);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009ell, 0x01751997d0ll);
+  const __m128i k5k0 = _mm_set_epi64x(0x0000000000ll, 0x0163cd6124ll);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641ll, 0x01db710641ll);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+  x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+  x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+  x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+  x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(int(crc)));
+  p += 64; size -= 64;
+  // Four parallel folds of 64 byte blocks.
+  for(; size >= 64; size -= 64, p += 64) {
+    x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+  }
+  // Fold the four lanes into one 128 bit value.
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+  // Remaining 16 byte blocks.
+  for(; size >= 16; size -= 16, p += 16) {
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)p)), x5);
+  }
+  // 128 -> 64 bit.
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  // Barrett reduction to 32 bit.
+  x0 = _mm_and_si128(x1, mask32);
+  x0 = _mm_clmulepi64_si128(x0, poly, 0x10);
+  x0 = _mm_and_si128(x0, mask32);
+  x0 = _mm_clmulepi64_si128(x0, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x0);
+  return uint32_t(_mm_extract_epi32(x1, 1));
+}
+
+/**
+ * CRC32C (Castagnoli) with the SSE4.2 `crc32` instruction.
+ */
+template <typename=void>
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t size)
+{
+  #if defined(__x86_64__)
+  uint64_t c = crc;
+  for(; size >= 8; size -= 8, p += 8) { uint64_t v; memcpy(&v, p, 8); c = _mm_crc32_u64(c, v); }
+  crc = uint32_t(c);
+  #endif
+  for(; size >= 4; size -= 4, p += 4) { uint32_t v; memcpy(&v, p, 4); crc = _mm_crc32_u32(crc, v); }
+  while(size--) crc = _mm_crc32_u8(crc, *p++);
+  return crc;
+}
+#endif
+
+/**
+ * CRC32 kernels: slicing-by-8 baseline and (x86) PCLMULQDQ folding,
+ * selected once at runtime depending on the CPU features.
+ */
+template <>
+struct crc_kernels<uint32_t>
+{
+  typedef uint32_t (*kernel_type)(uint32_t, const void*, size_t);
+
+  static const crc_slicing_table<uint32_t>& table()
+  { static const crc_slicing_table<uint32_t> tables(crc_lookups<uint32_t>::tab); return tables; }
+
+  static uint32_t bytewise(uint32_t crc, const void* data, size_t size)
+  { return table().update_bytewise(crc, (const uint8_t*)data, size); }
+
+  static uint32_t slicing8(uint32_t crc, const void* data, size_t size)
+  { return table().update(crc, (const uint8_t*)data, size); }
+
+  #ifdef SW_CRC_HAVE_X86_KERNELS
+  static bool have_pclmul()
+  {
+    static const bool have = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    return have;
+  }
+
+  static uint32_t pclmul(uint32_t crc, const void* data, size_t size)
+  {
+    const uint8_t* p = (const uint8_t*)data;
+    if(size >= 64) {
+      const size_t n = size & ~size_t(15);
+      crc = crc32_pclmul_fold(crc, p, n);
+      p += n; size -= n;
+    }
+    return table().update(crc, p, size);
+  }
+  #else
+  static bool have_pclmul()
+  { return false; }
+
+  static uint32_t pclmul(uint32_t crc, const void* data, size_t size)
+  { return slicing8(crc, data, size); }
+  #endif
+
+  static kernel_type kernel()
+  { static const kernel_type k = have_pclmul() ? &pclmul : &slicing8; return k; }
+
+  static uint32_t update(uint32_t crc, const void* data, size_t size)
+  { return (size < 64) ? slicing8(crc, data, size) : kernel()(crc, data, size); }
+};
+
+/**
+ * CRC32C (Castagnoli, reflected polynomial 0x82F63B78) kernels: slicing-by-8
+ * baseline and (x86) SSE4.2 `crc32` instruction.
+ */
+struct crc32c_kernels
+{
+  typedef uint32_t (*kernel_type)(uint32_t, const void*, size_t);
+
+  static const crc_slicing_table<uint32_t>& table()
+  { static const crc_slicing_table<uint32_t> tables(0x82f63b78u, true); return tables; }
+
+  static uint32_t bytewise(uint32_t crc, const void* data, size_t size)
+  { return table().update_bytewise(crc, (const uint8_t*)data, size); }
+
+  static uint32_t slicing8(uint32_t crc, const void* data, size_t size)
+  { return table().update(crc, (const uint8_t*)data, size); }
+
+  #ifdef SW_CRC_HAVE_X86_KERNELS
+  static bool have_sse42()
+  { static const bool have = __builtin_cpu_supports("sse4.2"); return have; }
+
+  static uint32_t sse42(uint32_t crc, const void* data, size_t size)
+  { return crc32c_sse42(crc, (const uint8_t*)data, size); }
+  #else
+  static bool have_sse42()
+  { return false; }
+
+  static uint32_t sse42(uint32_t crc, const void* data, size_t size)
+  { return slicing8(crc, data, size); }
+  #endif
+
+  static kernel_type kernel()
+  { static const kernel_type k = have_sse42() ? &sse42 : &slicing8; return k; }
+
+  static uint32_t update(uint32_t crc, const void* data, size_t size)
+  { return kernel()(crc, data, size); }
+};
+
 /**
  * Template class basic_crc
  */
-template <typename acc_type, typename size_type, acc_type initial_crc_value, acc_type final_xor_value>
+template <typename acc_type, typename size_type, acc_type initial_crc_value, acc_type final_xor_value, typename kernels=crc_kernels<acc_type>>
 class basic_crc
 {
 public:
@@ -201,23 +492,32 @@ public:
    * @param size_type size
    * @return acc_type
    */
-  static acc_type calculate(const void *data, register size_type size)
-  {
-    // Compiler is gently asked to as much as possible in registers, but depending
-    // on the processor it will not to that.
-    acc_type crc = initial_crc_value;
-    const unsigned char *p = (const unsigned char*) data;
-    if(data) {
-      while(size--) crc = (crc_lookups<acc_type>::tab[((crc) ^ (*p++)) & 0xff] ^ ((crc) >> 8));
-    }
-    return crc ^ final_xor_value;
-  }
+  static acc_type calculate(const void *data, size_type size)
+  { return acc_type((data ? update(initial_crc_value, data, size) : initial_crc_value) ^ final_xor_value); }
+
+  /**
+   * Update a CRC register (without final XOR) with more data. Start value
+   * is `initial_value()`, the checksum is `update(...) ^ final_xor()`.
+   * @param acc_type crc
+   * @param const void *data
+   * @param size_type size
+   * @return acc_type
+   */
+  static acc_type update(acc_type crc, const void *data, size_type size)
+  { return kernels::update(crc, data, size_t(size)); }
+
+  static constexpr acc_type initial_value()
+  { return initial_crc_value; }
+
+  static constexpr acc_type final_xor()
+  { return final_xor_value; }
 };
 }}
 
 namespace sw {
   typedef detail::basic_crc<uint16_t, size_t, 0xffff     , 0xffff> crc16;
   typedef detail::basic_crc<uint32_t, size_t, 0xffffffff , 0xffffffff> crc32;
+  typedef detail::basic_crc<uint32_t, size_t, 0xffffffff , 0xffffffff, detail::crc32c_kernels> crc32c;
 }
 
 /**
@@ -232,28 +532,144 @@ namespace sw {
  *
  * CRC8 (PEC)
  * @param const void *data
- * @param uint8_t size
+ * @param size_t size
  * @return typename T
  */
 namespace sw {
   template <typename=void>
-  uint8_t crc8(const void *data, uint8_t size)
+  uint16_t crc8_update(uint16_t crc, const void *data, size_t size)
   {
     const uint8_t *p = (const uint8_t*)data;
-    uint16_t crc = 0;
-    for (uint8_t j = size; j; --j, ++p) {
+    for (size_t j = size; j; --j, ++p) {
       crc ^= ((*p) << 8);
       for(uint8_t i = 8; i > 0; --i) {
         crc = ((crc & 0x8000u) ? (crc ^ (0x1070u << 3)) : (crc)) << 1;
       }
     }
-    return (uint8_t)(crc >> 8);
+    return crc;
   }
+
+  template <typename=void>
+  uint8_t crc8(const void *data, size_t size)
+  { return (uint8_t)(crc8_update(0, data, size) >> 8); }
 }
 
 #endif
 // </editor-fold>
 
+// <editor-fold desc="block file reader" defaultstate="collapsed">
+#ifndef SW_BLOCK_FILE_READER_HH
+#define SW_BLOCK_FILE_READER_HH
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdlib>
+#if defined(OS_WIN) || defined (_WINDOWS_) || defined(_WIN32) || defined(__MSC_VER)
+  #define SW_BLOCK_FILE_READER_ISTREAM
+#else
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <cerrno>
+#endif
+
+namespace sw { namespace detail {
+
+  /**
+   * Size of the blocks passed from the file readers to the hash `update()`
+   * functions. Multiple of the page size and of all hash block sizes.
+   */
+  static constexpr size_t file_read_block_size = size_t(1) << 20;
+
+  /**
+   * Reads a file sequentially and passes the data in large blocks to
+   * `update(const void* data, size_t size)`. On POSIX systems the file
+   * is read with plain `read()` calls into a page aligned buffer after
+   * advising the kernel of the sequential access pattern. The `binary`
+   * flag is only relevant for the std::ifstream fallback. Returns false
+   * if the file could not be opened or read completely (POSIX: `errno`
+   * set accordingly). `block_size` is the maximum size of the spans
+   * passed to `update()`.
+   *
+   * @param const char* path
+   * @param bool binary
+   * @param Fn&& update
+   * @param size_t block_size
+   * @return bool
+   */
+  template <typename Fn>
+  bool read_file_blocks(const char* path, bool binary, Fn&& update, size_t block_size=file_read_block_size)
+  {
+    #ifdef SW_BLOCK_FILE_READER_ISTREAM
+    std::ifstream fs(path, binary ? (std::ios::in|std::ios::binary) : (std::ios::in));
+    if(!fs.good()) return false;
+    std::vector<char> buffer(block_size);
+    while(fs.read(&buffer[0], buffer.size()), fs.gcount() > 0) {
+      update(&buffer[0], size_t(fs.gcount()));
+    }
+    return fs.eof() && !fs.bad();
+    #else
+    (void)binary;
+    int fd;
+    do { fd = ::open(path, O_RDONLY|O_CLOEXEC); } while((fd < 0) && (errno == EINTR));
+    if(fd < 0) return false;
+    #ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    #endif
+    // Small files (the common case when hashing many files) get a buffer
+    // of their size (plus a page to see EOF in one read) instead of a block.
+    struct ::stat st;
+    if((::fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size >= 0) && (size_t(st.st_size) < block_size)) {
+      block_size = (size_t(st.st_size) + 4096) & ~size_t(4095);
+    }
+    void* buffer = nullptr;
+    if(::posix_memalign(&buffer, 4096, block_size) != 0) { ::close(fd); errno = ENOMEM; return false; }
+    bool ok = true;
+    for(;;) {
+      const ssize_t n = ::read(fd, buffer, block_size);
+      if(n > 0) {
+        update(buffer, size_t(n));
+      } else if(n == 0) {
+        break;
+      } else if(errno != EINTR) {
+        ok = false;
+        break;
+      }
+    }
+    const int read_errno = errno;
+    ::free(buffer);
+    ::close(fd);
+    if(!ok) errno = read_errno;
+    return ok;
+    #endif
+  }
+
+  /**
+   * Reads a stream in large chunks and passes them to `update(const void*, size_t)`.
+   * Returns false if the stream could not be read until EOF.
+   *
+   * @param std::istream& is
+   * @param Fn&& update
+   * @return bool
+   */
+  template <typename Fn>
+  bool read_stream_blocks(std::istream& is, Fn&& update)
+  {
+    std::vector<char> buffer(size_t(1) << 16);
+    while(is.good() && is.read(&buffer[0], buffer.size()).good()) {
+      update(&buffer[0], buffer.size());
+    }
+    if(!is.eof()) return false;
+    if(is.gcount() > 0) update(&buffer[0], size_t(is.gcount()));
+    return true;
+  }
+
+}}
+
+#endif
+// </editor-fold>
+
 // <editor-fold desc="swlib-cc.md5" defaultstate="collapsed">
 // @version: #f84cdfe 2009-11-01T20:38:02+01:00
 /**
@@ -301,6 +717,11 @@ public:
    */
   typedef std::basic_string<Char_Type> str_t;
 
+  /**
+   * Number of bytes of the binary digest.
+   */
+  static constexpr size_t digest_size = 16;
+
 public:
 
   /**
@@ -332,7 +753,20 @@ public:
    * @param const void* data
    * @param size_t size
    */
-  void update(const void *data, uint32_t size)
+  void update(const void *data, size_t size)
+  {
+    const uint8_t* p = (const uint8_t*) data;
+    while(size > 0x10000000u) { // Keep the bit count arithmetic below in 32 bit.
+      update_span(p, 0x10000000u);
+      p += 0x10000000u;
+      size -= 0x10000000u;
+    }
+    update_span(p, uint32_t(size));
+  }
+
+private:
+
+  void update_span(const void *data, uint32_t size)
   {
     uint32_t index = cnt_[0] / 8 % 64;
     if((cnt_[0] += (size << 3)) < (size << 3)) cnt_[1]++; // Update number of bits
@@ -347,11 +781,13 @@ public:
     memcpy(&buf_[index], ((const uint8_t*)data)+i, size-i); // remainder
   }
 
+public:
+
   /**
-   * Finanlise checksum, return hex string.
-   * @return str_t
+   * Finanlise checksum, write the `digest_size` digest bytes to `out`.
+   * @param uint8_t* out
    */
-  std::string final_result()
+  void final_digest(uint8_t* out)
   {
     #define U32_B(O_, I_, len) { \
       for (uint32_t i = 0, j = 0; j < len; i++, j += 4) { \
@@ -371,17 +807,18 @@ public:
     uint32_t padLen = (index < 56) ? (56 - index) : (120 - index);
     update(padding, padLen);
     update(bits, 8); // Append length (before padding)
-    uint8_t res[16];
-    U32_B(res, sum_, 16); // Store state in digest
-    std::basic_stringstream<Char_Type> ss; // hex string
-    for (unsigned i = 0; i < 16; ++i) { // stream hex includes endian conversion
-      ss << std::hex << std::setfill('0') << std::setw(2) << (res[i] & 0xff);
-    }
+    U32_B(out, sum_, 16); // Store state in digest
     clear();
-    return ss.str();
     #undef U32_B
   }
 
+  /**
+   * Finanlise checksum, return hex string.
+   * @return str_t
+   */
+  std::string final_result()
+  { uint8_t d[digest_size]; final_digest(d); return basic_encoding<char>::hex(d, digest_size); }
+
 public:
 
   /**
@@ -408,12 +845,7 @@ public:
   static str_t calculate(std::istream & is)
   {
     basic_md5 r;
-    char data[64];
-    while(is.good() && is.read(data, sizeof(data)).good()) {
-      r.update(data, sizeof(data));
-    }
-    if(!is.eof()) return str_t();
-    if(is.gcount()) r.update(data, is.gcount());
+    if(!read_stream_blocks(is, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
     return r.final_result();
   }
 
@@ -425,11 +857,9 @@ public:
    */
   static str_t file(const str_t & path, bool binary=true)
   {
-    std::ifstream fs;
-    fs.open(path.c_str(), binary ? (std::ios::in|std::ios::binary) : (std::ios::in));
-    str_t s = calculate(fs);
-    fs.close();
-    return s;
+    basic_md5 r;
+    if(!read_file_blocks(path.c_str(), binary, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final_result();
   }
 
 private:
@@ -518,6 +948,180 @@ namespace sw {
 #endif
 // </editor-fold>
 
+// <editor-fold desc="sha-ni kernels" defaultstate="collapsed">
+/**
+ * x86 SHA extensions (SHA-NI) block functions for SHA1 and SHA256, used by
+ * the hash classes below for all complete 64 byte blocks if the CPU supports
+ * them (detected once at runtime via CPUID). The scalar transforms are the
+ * reference and fallback.
+ */
+#ifndef SW_SHA_NI_HH
+#define SW_SHA_NI_HH
+
+#include <cstdlib>
+#if defined(OS_WIN) || defined (_WINDOWS_) || defined(_WIN32) || defined(__MSC_VER)
+#include <stdint.h>
+#else
+#include <inttypes.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define SW_SHA_HAVE_X86_KERNELS
+  #include <immintrin.h>
+  #include <cpuid.h>
+#endif
+
+namespace sw { namespace detail {
+
+template <typename=void>
+struct sha_ni
+{
+  /**
+   * Returns true if the SHA extensions (and the SSSE3/SSE4.1 instructions
+   * used around them) are available.
+   * @return bool
+   */
+  static bool available()
+  {
+    #ifdef SW_SHA_HAVE_X86_KERNELS
+    static const bool have = []() {
+      unsigned a=0, b=0, c=0, d=0;
+      if(!__get_cpuid(1, &a, &b, &c, &d) || !(c & (1u<<9)) || !(c & (1u<<19))) return false; // SSSE3, SSE4.1
+      if(!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+      return (b & (1u<<29)) != 0; // SHA
+    }();
+    return have;
+    #else
+    return false;
+    #endif
+  }
+
+  #ifdef SW_SHA_HAVE_X86_KERNELS
+  /**
+   * SHA1 compression of `nblocks` 64 byte blocks.
+   * @param uint32_t* state (5 words)
+   * @param const uint8_t* data
+   * @param size_t nblocks
+   */
+  __attribute__((target("sha,sse4.1,ssse3")))
+  static void sha1_blocks(uint32_t* state, const uint8_t* data, size_t nblocks)
+  {
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ll, 0x08090a0b0c0d0e0fll);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+    __m128i e0 = _mm_set_epi32(int(state[4]), 0, 0, 0), e1;
+    __m128i m0, m1, m2, m3;
+    // Four rounds with message schedule, each step of the schedule only
+    // touches words that are not needed anymore after the last rounds.
+    #define sha1_rounds4(ea, eb, f, mc, md, mn, mp) \
+      ea = _mm_sha1nexte_epu32(ea, mc); eb = abcd; md = _mm_sha1msg2_epu32(md, mc); \
+      abcd = _mm_sha1rnds4_epu32(abcd, ea, f); mp = _mm_sha1msg1_epu32(mp, mc); mn = _mm_xor_si128(mn, mc);
+    for(; nblocks; --nblocks, data += 64) {
+      const __m128i abcd_save = abcd, e0_save = e0;
+      m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+ 0)), mask);
+      m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+16)), mask);
+      m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+32)), mask);
+      m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+48)), mask);
+      e0 = _mm_add_epi32(e0, m0); e1 = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      e1 = _mm_sha1nexte_epu32(e1, m1); e0 = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e1, 0); m0 = _mm_sha1msg1_epu32(m0, m1);
+      e0 = _mm_sha1nexte_epu32(e0, m2); e1 = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e0, 0); m1 = _mm_sha1msg1_epu32(m1, m2); m0 = _mm_xor_si128(m0, m2);
+      sha1_rounds4(e1, e0, 0, m3, m0, m1, m2);
+      sha1_rounds4(e0, e1, 0, m0, m1, m2, m3);
+      sha1_rounds4(e1, e0, 1, m1, m2, m3, m0);
+      sha1_rounds4(e0, e1, 1, m2, m3, m0, m1);
+      sha1_rounds4(e1, e0, 1, m3, m0, m1, m2);
+      sha1_rounds4(e0, e1, 1, m0, m1, m2, m3);
+      sha1_rounds4(e1, e0, 1, m1, m2, m3, m0);
+      sha1_rounds4(e0, e1, 2, m2, m3, m0, m1);
+      sha1_rounds4(e1, e0, 2, m3, m0, m1, m2);
+      sha1_rounds4(e0, e1, 2, m0, m1, m2, m3);
+      sha1_rounds4(e1, e0, 2, m1, m2, m3, m0);
+      sha1_rounds4(e0, e1, 2, m2, m3, m0, m1);
+      sha1_rounds4(e1, e0, 3, m3, m0, m1, m2);
+      sha1_rounds4(e0, e1, 3, m0, m1, m2, m3);
+      sha1_rounds4(e1, e0, 3, m1, m2, m3, m0);
+      sha1_rounds4(e0, e1, 3, m2, m3, m0, m1);
+      e1 = _mm_sha1nexte_epu32(e1, m3); e0 = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+      e0 = _mm_sha1nexte_epu32(e0, e0_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+    #undef sha1_rounds4
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = uint32_t(_mm_extract_epi32(e0, 3));
+  }
+
+  /**
+   * SHA256 compression of `nblocks` 64 byte blocks.
+   * @param uint32_t* state (8 words)
+   * @param const uint8_t* data
+   * @param size_t nblocks
+   * @param const uint32_t* k (64 round constants)
+   */
+  __attribute__((target("sha,sse4.1,ssse3")))
+  static void sha256_blocks(uint32_t* state, const uint8_t* data, size_t nblocks, const uint32_t* k)
+  {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state+0)), 0xb1); // CDAB
+    __m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state+4)), 0x1b); // EFGH
+    __m128i s0 = _mm_alignr_epi8(tmp, s1, 8); // ABEF
+    s1 = _mm_blend_epi16(s1, tmp, 0xf0); // CDGH
+    __m128i msg, m0, m1, m2, m3;
+    #define sha256_rounds4(i, mc) \
+      msg = _mm_add_epi32(mc, _mm_loadu_si128((const __m128i*)(k+4*(i)))); \
+      s1 = _mm_sha256rnds2_epu32(s1, s0, msg); \
+      s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0e));
+    // Four rounds with message schedule, as for SHA1 the last steps of the
+    // schedule only compute words that are not used anymore.
+    #define sha256_rounds4s(i, mc, mn, mp) \
+      msg = _mm_add_epi32(mc, _mm_loadu_si128((const __m128i*)(k+4*(i)))); \
+      s1 = _mm_sha256rnds2_epu32(s1, s0, msg); \
+      mn = _mm_sha256msg2_epu32(_mm_add_epi32(mn, _mm_alignr_epi8(mc, mp, 4)), mc); \
+      s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0e)); \
+      mp = _mm_sha256msg1_epu32(mp, mc);
+    for(; nblocks; --nblocks, data += 64) {
+      const __m128i s0_save = s0, s1_save = s1;
+      m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+ 0)), mask);
+      m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+16)), mask);
+      m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+32)), mask);
+      m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+48)), mask);
+      sha256_rounds4(0, m0);
+      sha256_rounds4(1, m1); m0 = _mm_sha256msg1_epu32(m0, m1);
+      sha256_rounds4(2, m2); m1 = _mm_sha256msg1_epu32(m1, m2);
+      sha256_rounds4s( 3, m3, m0, m2);
+      sha256_rounds4s( 4, m0, m1, m3);
+      sha256_rounds4s( 5, m1, m2, m0);
+      sha256_rounds4s( 6, m2, m3, m1);
+      sha256_rounds4s( 7, m3, m0, m2);
+      sha256_rounds4s( 8, m0, m1, m3);
+      sha256_rounds4s( 9, m1, m2, m0);
+      sha256_rounds4s(10, m2, m3, m1);
+      sha256_rounds4s(11, m3, m0, m2);
+      sha256_rounds4s(12, m0, m1, m3);
+      sha256_rounds4s(13, m1, m2, m0);
+      sha256_rounds4s(14, m2, m3, m1);
+      sha256_rounds4(15, m3);
+      s0 = _mm_add_epi32(s0, s0_save);
+      s1 = _mm_add_epi32(s1, s1_save);
+    }
+    #undef sha256_rounds4
+    #undef sha256_rounds4s
+    tmp = _mm_shuffle_epi32(s0, 0x1b); // FEBA
+    s1 = _mm_shuffle_epi32(s1, 0xb1); // DCHG
+    _mm_storeu_si128((__m128i*)(state+0), _mm_blend_epi16(tmp, s1, 0xf0)); // DCBA
+    _mm_storeu_si128((__m128i*)(state+4), _mm_alignr_epi8(s1, tmp, 8)); // HGFE
+  }
+  #else
+  static void sha1_blocks(uint32_t*, const uint8_t*, size_t)
+  {}
+
+  static void sha256_blocks(uint32_t*, const uint8_t*, size_t, const uint32_t*)
+  {}
+  #endif
+};
+
+}}
+
+#endif
+// </editor-fold>
+
 // <editor-fold desc="swlib-cc.sha1" defaultstate="collapsed">
 // @version: #f84cdfe 2009-11-01T20:38:02+01:00
 /**
@@ -549,6 +1153,7 @@ namespace sw {
 #include <iostream>
 #include <string>
 #include <cstdlib>
+#include <cstring>
 
 namespace sw { namespace detail {
 
@@ -566,13 +1171,18 @@ public:
    */
   typedef std::basic_string<Char_Type> str_t;
 
+  /**
+   * Number of bytes of the binary digest.
+   */
+  static constexpr size_t digest_size = 20;
+
 public:
 
   /**
    * Constructor
    */
   inline basic_sha1()
-  { buf_.reserve(64); clear(); }
+  { clear(); }
 
   /**
    * Destructor
@@ -588,7 +1198,7 @@ public:
   void clear()
   {
     sum_[0] = 0x67452301; sum_[1] = 0xefcdab89; sum_[2] = 0x98badcfe; sum_[3] = 0x10325476;
-    sum_[4] = 0xc3d2e1f0; iterations_ = 0; buf_.clear();
+    sum_[4] = 0xc3d2e1f0; iterations_ = 0; sz_ = 0;
   }
 
   /**
@@ -599,75 +1209,46 @@ public:
   void update(const void* data, size_t size)
   {
     if(!data || !size) return;
-    const char* p = (const char*) data;
-    uint32_t block[16];
-    if(!buf_.empty()) { // Deal with the remaining buf_ data
-      while(size && buf_.length() < 64) { buf_ += *p++; --size; } // Copy bytes
-      if(buf_.length() < 64) return; // Not enough data
-      const char* pp = (const char*) buf_.data();
-      for(unsigned i = 0; i < 16; ++i) {
-        #if (defined (BYTE_ORDER)) && (defined (BIG_ENDIAN)) && ((BYTE_ORDER == BIG_ENDIAN))
-        block[i] = (pp[0] << 0) | (pp[1] << 8) | (pp[2] << 16) | (pp[3] << 24);
-        #else
-        block[i] = (pp[3] << 0) | (pp[2] << 8) | (pp[1] << 16) | (pp[0] << 24);
-        #endif
-        pp += 4;
-      }
-      buf_.clear();
-      transform(block);
-    }
-    while(size >= 64) { // Transform full blocks
-      for(unsigned i = 0; i < 16; ++i) {
-        #if (defined (BYTE_ORDER)) && (defined (BIG_ENDIAN)) && ((BYTE_ORDER == BIG_ENDIAN))
-        block[i] = (p[0] << 0) | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
-        #else
-        block[i] = (p[3] << 0) | (p[2] << 8) | (p[1] << 16) | (p[0] << 24);
-        #endif
-        p += 4;
-      }
-      transform(block);
-      size -= 64;
-    }
-    while(size--) {
-      buf_ += *p++; // Transfer remaining bytes into the buf_
+    const uint8_t* p = (const uint8_t*) data;
+    if(sz_) { // Complete the remaining buf_ data first
+      size_t n = 64 - sz_;
+      if(n > size) n = size;
+      memcpy(&buf_[sz_], p, n);
+      sz_ += unsigned(n); p += n; size -= n;
+      if(sz_ < 64) return; // Not enough data
+      transform_blocks(buf_, 1);
+      sz_ = 0;
     }
+    if(size >= 64) { transform_blocks(p, size/64); p += size & ~size_t(63); size &= 63; } // Full blocks in place
+    if(size) { memcpy(buf_, p, size); sz_ = unsigned(size); } // Remaining bytes
   }
 
   /**
-   * Finanlise checksum, return hex string.
-   * @return str_t
+   * Finanlise checksum, write the `digest_size` digest bytes to `out`.
+   * @param uint8_t* out
    */
-  str_t final()
+  void final_digest(uint8_t* out)
   {
-    uint64_t total_bits = (iterations_ * 64 + buf_.size()) * 8;
-    buf_ += (char) 0x80;
-    typename std::string::size_type sz = buf_.size();
-    while (buf_.size() < 64) buf_ += (char) 0;
-    uint32_t block[16];
-    for(unsigned i = 0; i < 16; i++) {
-      #if (defined (BYTE_ORDER)) && (defined (BIG_ENDIAN)) && ((BYTE_ORDER == BIG_ENDIAN))
-      block[i] = ((buf_[4*i+0] & 0xff) << 0) | ((buf_[4*i+1] & 0xff) << 8) |
-         ((buf_[4*i+2] & 0xff) << 16) | ((buf_[4*i+3] & 0xff) << 24);
-      #else
-      block[i] = ((buf_[4*i+3] & 0xff) << 0) | ((buf_[4*i+2] & 0xff) << 8) |
-         ((buf_[4*i+1] & 0xff) << 16) | ((buf_[4*i+0] & 0xff) << 24);
-      #endif
-    }
-    if(sz > 56) {
-      transform(block);
-      for(unsigned i=0; i<14; ++i) block[i] = 0;
-    }
-    block[15] = (total_bits >>  0);
-    block[14] = (total_bits >> 32);
-    transform(block);
-    std::basic_stringstream<Char_Type> ss; // hex string
-    for (unsigned i = 0; i < 5; ++i) { // stream hex includes endian conversion
-      ss << std::hex << std::setfill('0') << std::setw(8) << (sum_[i] & 0xffffffff);
+    uint64_t total_bits = (iterations_ * 64 + sz_) * 8;
+    buf_[sz_++] = 0x80;
+    memset(&buf_[sz_], 0, 64-sz_);
+    if(sz_ > 56) {
+      transform_blocks(buf_, 1);
+      memset(buf_, 0, 56);
     }
+    for(unsigned i = 0; i < 8; ++i) buf_[63-i] = (uint8_t)(total_bits >> (8*i));
+    transform_blocks(buf_, 1);
+    for(unsigned i = 0; i < 20; ++i) out[i] = uint8_t(sum_[i/4] >> (24-8*(i%4)));
     clear();
-    return ss.str();
   }
 
+  /**
+   * Finanlise checksum, return hex string.
+   * @return str_t
+   */
+  str_t final()
+  { uint8_t d[digest_size]; final_digest(d); return basic_encoding<Char_Type>::hex(d, digest_size); }
+
 public:
 
   /**
@@ -694,12 +1275,7 @@ public:
   static str_t calculate(std::istream & is)
   {
     basic_sha1 r;
-    char data[64];
-    while(is.good() && is.read(data, sizeof(data)).good()) {
-      r.update(data, sizeof(data));
-    }
-    if(!is.eof()) return str_t();
-    if(is.gcount()) r.update(data, is.gcount());
+    if(!read_stream_blocks(is, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
     return r.final();
   }
 
@@ -711,21 +1287,23 @@ public:
    */
   static str_t file(const str_t & path, bool binary=true)
   {
-    std::ifstream fs;
-    fs.open(path.c_str(), binary ? (std::ios::in|std::ios::binary) : (std::ios::in));
-    str_t s = calculate(fs);
-    fs.close();
-    return s;
+    basic_sha1 r;
+    if(!read_file_blocks(path.c_str(), binary, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final();
   }
 
-private:
-
   /**
-   * Performs the SHA1 transformation on a given block
-   * @param uint32_t *block
+   * Scalar SHA1 transformation of a given 64 byte block (reference for the
+   * accelerated kernels).
+   * @param uint32_t* state
+   * @param const uint8_t* data
    */
-  void transform(uint32_t *block)
+  static void transform_scalar(uint32_t* state, const uint8_t* data)
   {
+    uint32_t block[16];
+    for(unsigned i = 0; i < 16; ++i, data += 4) {
+      block[i] = (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+    }
     #define rol(value, bits) (((value) << (bits)) | (((value) & 0xffffffff) >> (32-(bits))))
     #define blk(i) (block[i&15]=rol(block[(i+13)&15]^block[(i+8)&15]^block[(i+2)&15]^block[i&15],1))
     #define R0(v,w,x,y,z,i) z += ((w&(x^y))^y) + block[i] + 0x5a827999 + rol(v,5); w=rol(w,30);
@@ -733,7 +1311,7 @@ private:
     #define R2(v,w,x,y,z,i) z += (w^x^y) + blk(i) + 0x6ed9eba1 + rol(v,5); w=rol(w,30);
     #define R3(v,w,x,y,z,i) z += (((w|x)&y)|(w&x)) + blk(i) + 0x8f1bbcdc + rol(v,5); w=rol(w,30);
     #define R4(v,w,x,y,z,i) z += (w^x^y) + blk(i) + 0xca62c1d6 + rol(v,5); w=rol(w,30);
-    uint32_t a = sum_[0], b = sum_[1], c = sum_[2], d = sum_[3], e = sum_[4];
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
     R0(a,b,c,d,e, 0); R0(e,a,b,c,d, 1); R0(d,e,a,b,c, 2); R0(c,d,e,a,b, 3); R0(b,c,d,e,a, 4);
     R0(a,b,c,d,e, 5); R0(e,a,b,c,d, 6); R0(d,e,a,b,c, 7); R0(c,d,e,a,b, 8); R0(b,c,d,e,a, 9);
     R0(a,b,c,d,e,10); R0(e,a,b,c,d,11); R0(d,e,a,b,c,12); R0(c,d,e,a,b,13); R0(b,c,d,e,a,14);
@@ -750,7 +1328,7 @@ private:
     R4(a,b,c,d,e,65); R4(e,a,b,c,d,66); R4(d,e,a,b,c,67); R4(c,d,e,a,b,68); R4(b,c,d,e,a,69);
     R4(a,b,c,d,e,70); R4(e,a,b,c,d,71); R4(d,e,a,b,c,72); R4(c,d,e,a,b,73); R4(b,c,d,e,a,74);
     R4(a,b,c,d,e,75); R4(e,a,b,c,d,76); R4(d,e,a,b,c,77); R4(c,d,e,a,b,78); R4(b,c,d,e,a,79);
-    sum_[0] += a; sum_[1] += b; sum_[2] += c; sum_[3] += d; sum_[4] += e; iterations_++;
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
     #undef rol
     #undef blk
     #undef R0
@@ -760,11 +1338,30 @@ private:
     #undef R4
   }
 
+private:
+
+  /**
+   * Transforms `nblocks` 64 byte blocks, SHA-NI if available.
+   * @param const uint8_t* data
+   * @param size_t nblocks
+   */
+  void transform_blocks(const uint8_t* data, size_t nblocks)
+  {
+    if(sha_ni<>::available()) {
+      sha_ni<>::sha1_blocks(sum_, data, nblocks);
+    } else {
+      for(size_t i = 0; i < nblocks; ++i) transform_scalar(sum_, data + 64*i);
+    }
+    iterations_ += nblocks;
+  }
+
+
 private:
 
   uint64_t iterations_; // Number of iterations
   uint32_t sum_[5];     // Intermediate checksum digest buffer
-  std::string buf_;     // Intermediate buffer for remaining pushed data
+  unsigned sz_;         // Number of bytes in buf_
+  uint8_t  buf_[64];    // Intermediate buffer for remaining pushed data
 };
 }}
 
@@ -775,6 +1372,260 @@ namespace sw {
 #endif
 // </editor-fold>
 
+// <editor-fold desc="swlib-cc.sha256" defaultstate="collapsed">
+/**
+ * @package de.atwillys.cc.swl
+ * @license %, public domain
+ * @file sha256.hh
+ * @ccflags
+ * @ldflags
+ * @platform linux, bsd, windows
+ * @standard >= c++11
+ *
+ * SHA256 (FIPS 180-4) calculation class template, same interface as
+ * basic_sha1. Complete blocks are processed with the SHA-NI kernel where
+ * available.
+ */
+#ifndef SHA256_HH
+#define	SHA256_HH
+
+#if defined(OS_WIN) || defined (_WINDOWS_) || defined(_WIN32) || defined(__MSC_VER)
+#include <stdint.h>
+#else
+#include <inttypes.h>
+#endif
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+namespace sw { namespace detail {
+
+/**
+ * @class basic_sha256
+ * @template
+ */
+template <typename Char_Type=char>
+class basic_sha256
+{
+public:
+
+  /**
+   * Types
+   */
+  typedef std::basic_string<Char_Type> str_t;
+
+  /**
+   * Number of bytes of the binary digest.
+   */
+  static constexpr size_t digest_size = 32;
+
+public:
+
+  /**
+   * Constructor
+   */
+  inline basic_sha256()
+  { clear(); }
+
+  /**
+   * Destructor
+   */
+  virtual ~basic_sha256()
+  { ; }
+
+public:
+
+  /**
+   * Clear/reset all internal buffers and states.
+   */
+  void clear()
+  {
+    sum_[0] = 0x6a09e667; sum_[1] = 0xbb67ae85; sum_[2] = 0x3c6ef372; sum_[3] = 0xa54ff53a;
+    sum_[4] = 0x510e527f; sum_[5] = 0x9b05688c; sum_[6] = 0x1f83d9ab; sum_[7] = 0x5be0cd19;
+    iterations_ = 0; sz_ = 0;
+  }
+
+  /**
+   * Push new binary data into the internal buf_ and recalculate the checksum.
+   * @param const void* data
+   * @param size_t size
+   */
+  void update(const void* data, size_t size)
+  {
+    if(!data || !size) return;
+    const uint8_t* p = (const uint8_t*) data;
+    if(sz_) { // Complete the remaining buf_ data first
+      size_t n = 64 - sz_;
+      if(n > size) n = size;
+      memcpy(&buf_[sz_], p, n);
+      sz_ += unsigned(n); p += n; size -= n;
+      if(sz_ < 64) return; // Not enough data
+      transform_blocks(buf_, 1);
+      sz_ = 0;
+    }
+    if(size >= 64) { transform_blocks(p, size/64); p += size & ~size_t(63); size &= 63; } // Full blocks in place
+    if(size) { memcpy(buf_, p, size); sz_ = unsigned(size); } // Remaining bytes
+  }
+
+  /**
+   * Finanlise checksum, write the `digest_size` digest bytes to `out`.
+   * @param uint8_t* out
+   */
+  void final_digest(uint8_t* out)
+  {
+    uint64_t total_bits = (iterations_ * 64 + sz_) * 8;
+    buf_[sz_++] = 0x80;
+    memset(&buf_[sz_], 0, 64-sz_);
+    if(sz_ > 56) {
+      transform_blocks(buf_, 1);
+      memset(buf_, 0, 56);
+    }
+    for(unsigned i = 0; i < 8; ++i) buf_[63-i] = (uint8_t)(total_bits >> (8*i));
+    transform_blocks(buf_, 1);
+    for(unsigned i = 0; i < 32; ++i) out[i] = uint8_t(sum_[i/4] >> (24-8*(i%4)));
+    clear();
+  }
+
+  /**
+   * Finanlise checksum, return hex string.
+   * @return str_t
+   */
+  str_t final()
+  { uint8_t d[digest_size]; final_digest(d); return basic_encoding<Char_Type>::hex(d, digest_size); }
+
+public:
+
+  /**
+   * Calculates the SHA256 for a given string.
+   * @param const str_t & s
+   * @return str_t
+   */
+  static str_t calculate(const str_t & s)
+  { basic_sha256 r; r.update(s.data(), s.length() * sizeof(Char_Type)); return r.final(); }
+
+  /**
+   * Calculates the SHA256 for given binary data.
+   * @param const void* data
+   * @param size_t size
+   * @return str_t
+   */
+  static str_t calculate(const void* data, size_t size)
+  { basic_sha256 r; r.update(data, size); return r.final(); }
+
+  /**
+   * Calculates the SHA256 for a stream. Returns an empty string on error.
+   * @param std::istream & is
+   * @return str_t
+   */
+  static str_t calculate(std::istream & is)
+  {
+    basic_sha256 r;
+    if(!read_stream_blocks(is, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final();
+  }
+
+  /**
+   * Calculates the SHA256 checksum for a given file, either read binary or as text.
+   * @param const str_t & path
+   * @param bool binary = true
+   * @return str_t
+   */
+  static str_t file(const str_t & path, bool binary=true)
+  {
+    basic_sha256 r;
+    if(!read_file_blocks(path.c_str(), binary, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final();
+  }
+
+  /**
+   * Scalar compression function of `nblocks` 64 byte blocks (reference
+   * for the accelerated kernels).
+   * @param uint32_t* state
+   * @param const uint8_t* data
+   * @param size_t nblocks
+   */
+  static void transform_scalar(uint32_t* state, const uint8_t* data, size_t nblocks)
+  {
+    #define ror(x, n) (((x) >> (n)) | ((x) << (32-(n))))
+    for(; nblocks; --nblocks, data += 64) {
+      uint32_t w[64];
+      for(unsigned i = 0; i < 16; ++i) {
+        w[i] = (uint32_t(data[4*i]) << 24) | (uint32_t(data[4*i+1]) << 16) | (uint32_t(data[4*i+2]) << 8) | uint32_t(data[4*i+3]);
+      }
+      for(unsigned i = 16; i < 64; ++i) {
+        const uint32_t s0 = ror(w[i-15], 7) ^ ror(w[i-15], 18) ^ (w[i-15] >> 3);
+        const uint32_t s1 = ror(w[i-2], 17) ^ ror(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+      }
+      uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+      uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+      for(unsigned i = 0; i < 64; ++i) {
+        const uint32_t t1 = h + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25)) + ((e & f) ^ (~e & g)) + k_[i] + w[i];
+        const uint32_t t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+      }
+      state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+      state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+    #undef ror
+  }
+
+  /**
+   * Returns the 64 SHA256 round constants.
+   * @return const uint32_t*
+   */
+  static const uint32_t* round_constants()
+  { return k_; }
+
+private:
+
+  /**
+   * Transforms `nblocks` 64 byte blocks, SHA-NI if available.
+   * @param const uint8_t* data
+   * @param size_t nblocks
+   */
+  void transform_blocks(const uint8_t* data, size_t nblocks)
+  {
+    if(sha_ni<>::available()) {
+      sha_ni<>::sha256_blocks(sum_, data, nblocks, round_constants());
+    } else {
+      transform_scalar(sum_, data, nblocks);
+    }
+    iterations_ += nblocks;
+  }
+
+private:
+
+  static const uint32_t k_[64]; // Round constants
+  uint64_t iterations_;         // Number of iterations
+  uint32_t sum_[8];             // Intermediate checksum digest buffer
+  unsigned sz_;                 // Number of bytes in buf_
+  uint8_t  buf_[64];            // Intermediate buffer for remaining pushed data
+};
+
+template <typename C>
+const uint32_t basic_sha256<C>::k_[64] = {
+  0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+  0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+  0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+  0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+  0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+  0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+  0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+  0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+};
+
+}}
+
+namespace sw {
+  typedef detail::basic_sha256<> sha256;
+}
+
+#endif
+// </editor-fold>
+
 // <editor-fold desc="swlib-cc.sha512" defaultstate="collapsed">
 // @version: #fd54d17 2015-08-18T21:44:36+02:00
 /**
@@ -838,6 +1689,11 @@ public:
    */
   typedef std::basic_string<Char_Type> str_t;
 
+  /**
+   * Number of bytes of the binary digest.
+   */
+  static constexpr size_t digest_size = 64;
+
 public:
 
   /**
@@ -873,7 +1729,7 @@ public:
    */
   void update(const void* data, size_t size)
   {
-    unsigned nb, n, n_tail;
+    size_t nb, n, n_tail;
     const uint8_t *p;
     n = 128 - sz_;
     n_tail = size < n ? size : n;
@@ -891,18 +1747,11 @@ public:
   }
 
   /**
-   * Finanlise checksum, return hex string.
-   * @return str_t
+   * Finanlise checksum, write the `digest_size` digest bytes to `out`.
+   * @param uint8_t* out
    */
-  str_t final_data()
+  void final_digest(uint8_t* out)
   {
-    #if (defined (BYTE_ORDER)) && (defined (BIG_ENDIAN)) && ((BYTE_ORDER == BIG_ENDIAN))
-    #define U32_B(x,b) *((b)+0)=(uint8_t)((x)); *((b)+1)=(uint8_t)((x)>>8); \
-            *((b)+2)=(uint8_t)((x)>>16); *((b)+3)=(uint8_t)((x)>>24);
-    #else
-    #define U32_B(x,b) *((b)+3)=(uint8_t)((x)); *((b)+2)=(uint8_t)((x)>>8); \
-            *((b)+1)=(uint8_t)((x)>>16); *((b)+0)=(uint8_t)((x)>>24);
-    #endif
     unsigned nb, n;
     uint64_t n_total;
     nb = 1 + ((0x80-17) < (sz_ & 0x7f));
@@ -910,17 +1759,19 @@ public:
     n = nb << 7;
     memset(block_ + sz_, 0, n - sz_);
     block_[sz_] = 0x80;
-    U32_B(n_total, block_ + n-4);
+    for(unsigned i = 0; i < 8; ++i) block_[n-1-i] = (uint8_t)(n_total >> (8*i)); // 128 bit big endian length
     transform(block_, nb);
-    std::basic_stringstream<Char_Type> ss; // hex string
-    for (unsigned i = 0; i < 8; ++i) {
-      ss << std::hex << std::setfill('0') << std::setw(16) << (sum_[i]);
-    }
+    for(unsigned i = 0; i < 64; ++i) out[i] = uint8_t(sum_[i/8] >> (56-8*(i%8)));
     clear();
-    return ss.str();
-    #undef U32_B
   }
 
+  /**
+   * Finanlise checksum, return hex string.
+   * @return str_t
+   */
+  str_t final_data()
+  { uint8_t d[digest_size]; final_digest(d); return basic_encoding<Char_Type>::hex(d, digest_size); }
+
 public:
 
   /**
@@ -951,12 +1802,7 @@ public:
   static str_t calculate(std::istream & is)
   {
     basic_sha512 r;
-    char data[64];
-    while(is.good() && is.read(data, sizeof(data)).good()) {
-      r.update(data, sizeof(data));
-    }
-    if(!is.eof()) return str_t();
-    if(is.gcount()) r.update(data, is.gcount());
+    if(!read_stream_blocks(is, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
     return r.final_data();
   }
 
@@ -968,11 +1814,9 @@ public:
    */
   static str_t file(const str_t & path, bool binary=true)
   {
-    std::ifstream fs;
-    fs.open(path.c_str(), binary ? (std::ios::in|std::ios::binary) : (std::ios::in));
-    str_t s = calculate(fs);
-    fs.close();
-    return s;
+    basic_sha512 r;
+    if(!read_file_blocks(path.c_str(), binary, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final_data();
   }
 
 private:
@@ -1004,7 +1848,7 @@ private:
     uint64_t t, u, v[8], w[80];
     const uint8_t *tblock;
     unsigned j;
-    for(unsigned i = 0; i < size; ++i) {
+    for(size_t i = 0; i < size; ++i) {
       tblock = data + (i << 7);
       for(j = 0; j < 16; ++j) B_U64(&tblock[j<<3], &w[j]);
       for(j = 16; j < 80; ++j) w[j] = F4(w[j-2]) + w[j-7] + F3(w[j-15]) + w[j-16];
@@ -1070,205 +1914,2040 @@ namespace sw {
 #endif
 // </editor-fold>
 
-// <editor-fold desc="duktape-cc bindings" defaultstate="collapsed">
-#include "../duktape.hh"
+// <editor-fold desc="xxh3" defaultstate="collapsed">
+/**
+ * XXH3 (64 and 128 bit) non-cryptographic hash, compatible with xxHash
+ * >= v0.8 (https://github.com/Cyan4973/xxHash, BSD 2-clause, Yann Collet).
+ * Default secret with optional 64 bit seed. The long input stripe
+ * accumulation has scalar, SSE2 and AVX2 variants. AVX2 is selected at
+ * runtime if the CPU has it, otherwise the scalar kernels (the SSE2 ones
+ * are not reliably faster than the compiler's scalar code).
+ *
+ *  uint64_t h = sw::xxh3::hash64(pointer_to_data, size_of_data);
+ *
+ *  sw::xxh3 hasher; hasher.update(data, size); ...; std::string hex = hasher.final_result();
+ */
+#ifndef SW_XXH3_HH
+#define SW_XXH3_HH
+
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#if defined(OS_WIN) || defined (_WINDOWS_) || defined(_WIN32) || defined(__MSC_VER)
+#include <stdint.h>
+#else
+#include <inttypes.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define SW_XXH3_HAVE_X86_KERNELS
+  #include <immintrin.h>
+#endif
 
-namespace duktape { namespace detail { namespace system { namespace hash {
+namespace sw { namespace detail {
 
-  #if(0 && JSDOC)
-  /**
-   * Hashing functionality of the system object.
-   * @var {object}
-   */
-  sys.hash = {};
-  #endif
+template <typename=void>
+struct xxh3_constants
+{
+  static constexpr uint32_t prime32_1 = 0x9e3779b1u;
+  static constexpr uint32_t prime32_2 = 0x85ebca77u;
+  static constexpr uint32_t prime32_3 = 0xc2b2ae3du;
+  static constexpr uint64_t prime64_1 = 0x9e3779b185ebca87ull;
+  static constexpr uint64_t prime64_2 = 0xc2b2ae3d27d4eb4full;
+  static constexpr uint64_t prime64_3 = 0x165667b19e3779f9ull;
+  static constexpr uint64_t prime64_4 = 0x85ebca77c2b2ae63ull;
+  static constexpr uint64_t prime64_5 = 0x27d4eb2f165667c5ull;
+  static constexpr size_t stripe_size = 64;
+  static constexpr size_t secret_size = 192;
+  static constexpr size_t secret_size_min = 136;
+  static constexpr size_t stripes_per_block = (secret_size - stripe_size) / 8;
+  static constexpr size_t mid_size_max = 240;
+  static const uint8_t secret[secret_size];
+};
 
-  #if(0 && JSDOC)
-  /**
-   * CRC8 (PEC) of a string or buffer.
-   * (PEC CRC is: polynomial: 0x07, initial value: 0x00, final XOR: 0x00)
-   *
-   * @param {string|buffer} data
-   * @returns {number}
-   */
-  sys.hash.crc8 = function(data) {};
+template <typename T>
+const uint8_t xxh3_constants<T>::secret[xxh3_constants<T>::secret_size] = {
+  0xb8,0xfe,0x6c,0x39,0x23,0xa4,0x4b,0xbe,0x7c,0x01,0x81,0x2c,0xf7,0x21,0xad,0x1c,
+  0xde,0xd4,0x6d,0xe9,0x83,0x90,0x97,0xdb,0x72,0x40,0xa4,0xa4,0xb7,0xb3,0x67,0x1f,
+  0xcb,0x79,0xe6,0x4e,0xcc,0xc0,0xe5,0x78,0x82,0x5a,0xd0,0x7d,0xcc,0xff,0x72,0x21,
+  0xb8,0x08,0x46,0x74,0xf7,0x43,0x24,0x8e,0xe0,0x35,0x90,0xe6,0x81,0x3a,0x26,0x4c,
+  0x3c,0x28,0x52,0xbb,0x91,0xc3,0x00,0xcb,0x88,0xd0,0x65,0x8b,0x1b,0x53,0x2e,0xa3,
+  0x71,0x64,0x48,0x97,0xa2,0x0d,0xf9,0x4e,0x38,0x19,0xef,0x46,0xa9,0xde,0xac,0xd8,
+  0xa8,0xfa,0x76,0x3f,0xe3,0x9c,0x34,0x3f,0xf9,0xdc,0xbb,0xc7,0xc7,0x0b,0x4f,0x1d,
+  0x8a,0x51,0xe0,0x4b,0xcd,0xb4,0x59,0x31,0xc8,0x9f,0x7e,0xc9,0xd9,0x78,0x73,0x64,
+  0xea,0xc5,0xac,0x83,0x34,0xd3,0xeb,0xc3,0xc5,0x81,0xa0,0xff,0xfa,0x13,0x63,0xeb,
+  0x17,0x0d,0xdd,0x51,0xb7,0xf0,0xda,0x49,0xd3,0x16,0x55,0x26,0x29,0xd4,0x68,0x9e,
+  0x2b,0x16,0xbe,0x58,0x7d,0x47,0xa1,0xfc,0x8f,0xf8,0xb8,0xd1,0x7a,0xd0,0x31,0xce,
+  0x45,0xcb,0x3a,0x8f,0x95,0x16,0x04,0x28,0xaf,0xd7,0xfb,0xca,0xbb,0x4b,0x40,0x7e
+};
+
+/**
+ * Basic XXH3 arithmetic.
+ */
+struct xxh3_math : public xxh3_constants<>
+{
+  #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  static inline uint32_t read32(const uint8_t* p)
+  { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+  static inline uint64_t read64(const uint8_t* p)
+  { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+  #else
+  static inline uint32_t read32(const uint8_t* p)
+  { return uint32_t(p[0]) | (uint32_t(p[1])<<8) | (uint32_t(p[2])<<16) | (uint32_t(p[3])<<24); }
+
+  static inline uint64_t read64(const uint8_t* p)
+  { return uint64_t(read32(p)) | (uint64_t(read32(p+4)) << 32); }
   #endif
-  template <typename=void>
-  int crc8_wrapper(duktape::api& stack)
+
+  static inline void write64(uint8_t* p, uint64_t v)
+  { for(unsigned i=0; i<8; ++i) p[i] = uint8_t(v >> (8*i)); }
+
+  static inline uint32_t swap32(uint32_t x)
+  { return ((x << 24) & 0xff000000u) | ((x << 8) & 0x00ff0000u) | ((x >> 8) & 0x0000ff00u) | ((x >> 24) & 0x000000ffu); }
+
+  static inline uint64_t swap64(uint64_t x)
+  { return (uint64_t(swap32(uint32_t(x))) << 32) | uint64_t(swap32(uint32_t(x >> 32))); }
+
+  static inline uint64_t rotl64(uint64_t x, unsigned r)
+  { return (x << r) | (x >> (64-r)); }
+
+  static inline uint32_t rotl32(uint32_t x, unsigned r)
+  { return (x << r) | (x >> (32-r)); }
+
+  static inline uint64_t mul32to64(uint64_t a, uint64_t b)
+  { return uint64_t(uint32_t(a)) * uint64_t(uint32_t(b)); }
+
+  static inline void mul64to128(uint64_t a, uint64_t b, uint64_t& lo, uint64_t& hi)
   {
-    if(stack.is<std::string>(0)) {
-      auto data = stack.get<std::string>(0);
-      stack.push(sw::crc8(data.c_str(), data.size()));
-      return 1;
-    } else if(stack.is_buffer(0) || stack.is_buffer_data(0)) {
-      auto buffer = stack.buffer<std::vector<char>>(0);
-      stack.push(sw::crc8(buffer.data(), buffer.size()));
-      return 1;
-    } else {
-      return stack.throw_exception("crc8 input data have to be a string of buffer");
-    }
+    #if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 u128_t;
+    const u128_t r = u128_t(a) * u128_t(b);
+    lo = uint64_t(r);
+    hi = uint64_t(r >> 64);
+    #else
+    const uint64_t lo_lo = mul32to64(a, b), hi_lo = mul32to64(a >> 32, b);
+    const uint64_t lo_hi = mul32to64(a, b >> 32), hi_hi = mul32to64(a >> 32, b >> 32);
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffffu) + lo_hi;
+    hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    lo = (cross << 32) | (lo_lo & 0xffffffffu);
+    #endif
   }
 
-  #if(0 && JSDOC)
-  /**
-   * CRC16 (USB) of a string or buffer.
-   * (USB CRC is: polynomial: 0x8005, initial value: 0xffff, final XOR: 0xffff)
-   *
-   * @param {string|buffer} data
-   * @returns {number}
-   */
-  sys.hash.crc16 = function(data) {};
-  #endif
-  template <typename=void>
-  int crc16_wrapper(duktape::api& stack)
+  static inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+  { uint64_t lo, hi; mul64to128(a, b, lo, hi); return lo ^ hi; }
+
+  static inline uint64_t xxh64_avalanche(uint64_t h)
+  { h ^= h >> 33; h *= prime64_2; h ^= h >> 29; h *= prime64_3; return h ^ (h >> 32); }
+
+  static inline uint64_t avalanche(uint64_t h)
+  { h ^= h >> 37; h *= 0x165667919e3779f9ull; return h ^ (h >> 32); }
+
+  static inline uint64_t rrmxmx(uint64_t h, uint64_t len)
   {
-    if(stack.is<std::string>(0)) {
-      stack.push(sw::crc16::calculate(stack.to<std::string>(0)));
-      return 1;
-    } else if(stack.is_buffer(0) || stack.is_buffer_data(0)) {
-      auto buffer = stack.buffer<std::vector<char>>(0);
-      stack.push(sw::crc16::calculate(buffer.data(), buffer.size()));
-      return 1;
-    } else {
-      return stack.throw_exception("crc16 input data have to be a string of buffer");
-    }
+    h ^= rotl64(h, 49) ^ rotl64(h, 24);
+    h *= 0x9fb21c651e98df25ull;
+    h ^= (h >> 35) + len;
+    h *= 0x9fb21c651e98df25ull;
+    return h ^ (h >> 28);
   }
 
-  #if(0 && JSDOC)
-  /**
-   * CRC32 (CITT) of a string or buffer.
-   *
-   * @param {string|buffer} data
-   * @returns {number}
-   */
-  sys.hash.crc32 = function(data) {};
-  #endif
-  template <typename=void>
-  int crc32_wrapper(duktape::api& stack)
+  static inline uint64_t mix16(const uint8_t* in, const uint8_t* secret, uint64_t seed)
+  { return mul128_fold64(read64(in) ^ (read64(secret) + seed), read64(in+8) ^ (read64(secret+8) - seed)); }
+
+  static inline void mix32(uint64_t& lo, uint64_t& hi, const uint8_t* in1, const uint8_t* in2, const uint8_t* secret, uint64_t seed)
   {
-    if(stack.is<std::string>(0)) {
-      stack.push(sw::crc32::calculate(stack.to<std::string>(0)));
-      return 1;
-    } else if(stack.is_buffer(0) || stack.is_buffer_data(0)) {
-      auto buffer = stack.buffer<std::vector<char>>(0);
-      stack.push(sw::crc32::calculate(buffer.data(), buffer.size()));
-      return 1;
-    } else {
-      return stack.throw_exception("crc32 input data have to be a string of buffer");
+    lo += mix16(in1, secret, seed);
+    lo ^= read64(in2) + read64(in2+8);
+    hi += mix16(in2, secret+16, seed);
+    hi ^= read64(in1) + read64(in1+8);
+  }
+
+  static inline uint64_t merge_accs(const uint64_t* acc, const uint8_t* secret, uint64_t start)
+  {
+    uint64_t r = start;
+    for(unsigned i=0; i<4; ++i) r += mul128_fold64(acc[2*i] ^ read64(secret+16*i), acc[2*i+1] ^ read64(secret+16*i+8));
+    return avalanche(r);
+  }
+
+  static void init_acc(uint64_t* acc)
+  {
+    acc[0] = prime32_3; acc[1] = prime64_1; acc[2] = prime64_2; acc[3] = prime64_3;
+    acc[4] = prime64_4; acc[5] = prime32_2; acc[6] = prime64_5; acc[7] = prime32_1;
+  }
+
+  static void init_secret(uint8_t* out, uint64_t seed)
+  {
+    for(size_t i=0; i < secret_size; i += 16) {
+      write64(out+i, read64(secret+i) + seed);
+      write64(out+i+8, read64(secret+i+8) - seed);
+    }
+  }
+};
+
+/**
+ * Stripe accumulation and scrambling kernels for long inputs.
+ */
+struct xxh3_kernels : public xxh3_math
+{
+  typedef void (*accumulate_type)(uint64_t* acc, const uint8_t* in, const uint8_t* secret, size_t nb_stripes);
+  typedef void (*scramble_type)(uint64_t* acc, const uint8_t* secret);
+
+  accumulate_type accumulate;
+  scramble_type scramble;
+  const char* name;
+
+  xxh3_kernels(accumulate_type acc, scramble_type scr, const char* nm) : accumulate(acc), scramble(scr), name(nm)
+  {}
+
+  static void accumulate_scalar(uint64_t* acc, const uint8_t* in, const uint8_t* secret, size_t nb_stripes)
+  {
+    for(; nb_stripes; --nb_stripes, in += stripe_size, secret += 8) {
+      for(unsigned i=0; i<8; ++i) {
+        const uint64_t data_val = read64(in+8*i);
+        const uint64_t data_key = data_val ^ read64(secret+8*i);
+        acc[i^1] += data_val;
+        acc[i] += mul32to64(data_key, data_key >> 32);
+      }
+    }
+  }
+
+  static void scramble_scalar(uint64_t* acc, const uint8_t* secret)
+  {
+    for(unsigned i=0; i<8; ++i) {
+      acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ read64(secret+8*i)) * prime32_1;
+    }
+  }
+
+  #ifdef SW_XXH3_HAVE_X86_KERNELS
+  __attribute__((target("sse2")))
+  static void accumulate_sse2(uint64_t* acc, const uint8_t* in, const uint8_t* secret, size_t nb_stripes)
+  {
+    __m128i a[4];
+    for(unsigned i=0; i<4; ++i) a[i] = _mm_loadu_si128((const __m128i*)(acc+2*i));
+    for(; nb_stripes; --nb_stripes, in += stripe_size, secret += 8) {
+      for(unsigned i=0; i<4; ++i) {
+        const __m128i data_vec = _mm_loadu_si128((const __m128i*)(in+16*i));
+        const __m128i data_key = _mm_xor_si128(data_vec, _mm_loadu_si128((const __m128i*)(secret+16*i)));
+        const __m128i product = _mm_mul_epu32(data_key, _mm_srli_epi64(data_key, 32));
+        a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, _mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1,0,3,2))));
+      }
+    }
+    for(unsigned i=0; i<4; ++i) _mm_storeu_si128((__m128i*)(acc+2*i), a[i]);
+  }
+
+  __attribute__((target("sse2")))
+  static void scramble_sse2(uint64_t* acc, const uint8_t* secret)
+  {
+    const __m128i prime = _mm_set1_epi32(int(prime32_1));
+    for(unsigned i=0; i<4; ++i) {
+      __m128i a = _mm_loadu_si128((const __m128i*)(acc+2*i));
+      a = _mm_xor_si128(_mm_xor_si128(a, _mm_srli_epi64(a, 47)), _mm_loadu_si128((const __m128i*)(secret+16*i)));
+      const __m128i lo = _mm_mul_epu32(a, prime);
+      const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+      _mm_storeu_si128((__m128i*)(acc+2*i), _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+  }
+
+  __attribute__((target("avx2")))
+  static void accumulate_avx2(uint64_t* acc, const uint8_t* in, const uint8_t* secret, size_t nb_stripes)
+  {
+    __m256i a0 = _mm256_loadu_si256((const __m256i*)(acc+0));
+    __m256i a1 = _mm256_loadu_si256((const __m256i*)(acc+4));
+    for(; nb_stripes; --nb_stripes, in += stripe_size, secret += 8) {
+      const __m256i d0 = _mm256_loadu_si256((const __m256i*)(in+0));
+      const __m256i d1 = _mm256_loadu_si256((const __m256i*)(in+32));
+      const __m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i*)(secret+0)));
+      const __m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i*)(secret+32)));
+      a0 = _mm256_add_epi64(a0, _mm256_add_epi64(_mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32)), _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1,0,3,2))));
+      a1 = _mm256_add_epi64(a1, _mm256_add_epi64(_mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32)), _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1,0,3,2))));
+    }
+    _mm256_storeu_si256((__m256i*)(acc+0), a0);
+    _mm256_storeu_si256((__m256i*)(acc+4), a1);
+  }
+
+  __attribute__((target("avx2")))
+  static void scramble_avx2(uint64_t* acc, const uint8_t* secret)
+  {
+    const __m256i prime = _mm256_set1_epi32(int(prime32_1));
+    for(unsigned i=0; i<2; ++i) {
+      __m256i a = _mm256_loadu_si256((const __m256i*)(acc+4*i));
+      a = _mm256_xor_si256(_mm256_xor_si256(a, _mm256_srli_epi64(a, 47)), _mm256_loadu_si256((const __m256i*)(secret+32*i)));
+      const __m256i lo = _mm256_mul_epu32(a, prime);
+      const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+      _mm256_storeu_si256((__m256i*)(acc+4*i), _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+    }
+  }
+  #endif
+
+  static bool have_avx2()
+  {
+    #ifdef SW_XXH3_HAVE_X86_KERNELS
+    static const bool have = __builtin_cpu_supports("avx2");
+    return have;
+    #else
+    return false;
+    #endif
+  }
+
+  static const xxh3_kernels& scalar()
+  { static const xxh3_kernels k(&accumulate_scalar, &scramble_scalar, "scalar"); return k; }
+
+  /**
+   * SSE2 kernels, scalar if not compiled in.
+   */
+  static const xxh3_kernels& sse2()
+  {
+    #ifdef SW_XXH3_HAVE_X86_KERNELS
+    static const xxh3_kernels k(&accumulate_sse2, &scramble_sse2, "sse2");
+    return k;
+    #else
+    return scalar();
+    #endif
+  }
+
+  /**
+   * AVX2 kernels, scalar if not available on this CPU.
+   */
+  static const xxh3_kernels& avx2()
+  {
+    #ifdef SW_XXH3_HAVE_X86_KERNELS
+    static const xxh3_kernels k(&accumulate_avx2, &scramble_avx2, "avx2");
+    if(have_avx2()) return k;
+    #endif
+    return scalar();
+  }
+
+  /**
+   * Returns the fastest kernels available on this CPU.
+   */
+  static const xxh3_kernels& best()
+  { return avx2(); }
+
+  /**
+   * Hashes all stripes of a long input (> 240 bytes) into `acc`.
+   */
+  void hash_long(uint64_t* acc, const uint8_t* in, size_t size, const uint8_t* secret) const
+  {
+    const size_t block_size = stripe_size * stripes_per_block;
+    const size_t nb_blocks = (size - 1) / block_size;
+    for(size_t n=0; n < nb_blocks; ++n) {
+      accumulate(acc, in + n*block_size, secret, stripes_per_block);
+      scramble(acc, secret + secret_size - stripe_size);
+    }
+    const size_t nb_stripes = ((size - 1) - (block_size * nb_blocks)) / stripe_size;
+    accumulate(acc, in + nb_blocks*block_size, secret, nb_stripes);
+    accumulate(acc, in + size - stripe_size, secret + secret_size - stripe_size - 7, 1);
+  }
+};
+
+/**
+ * @class basic_xxh3
+ * @template
+ */
+template <typename Char_Type=char>
+class basic_xxh3 : public xxh3_math
+{
+public:
+
+  typedef std::basic_string<Char_Type> str_t;
+
+  /**
+   * Number of bytes of the (64 bit) binary digest.
+   */
+  static constexpr size_t digest_size = 8;
+
+public:
+
+  explicit basic_xxh3(uint64_t seed=0, const xxh3_kernels& kernels=xxh3_kernels::best()) : kernels_(kernels)
+  { reset(seed); }
+
+  /**
+   * Clear/reset all internal buffers and states, keeps the seed.
+   */
+  void clear()
+  { reset(seed_); }
+
+  /**
+   * Reset with a new seed.
+   * @param uint64_t seed
+   */
+  void reset(uint64_t seed)
+  {
+    seed_ = seed;
+    if(seed) init_secret(secret_, seed); else memcpy(secret_, xxh3_constants<>::secret, secret_size);
+    init_acc(acc_);
+    total_ = 0; buffered_ = 0; nb_stripes_acc_ = 0;
+  }
+
+  /**
+   * Push new binary data.
+   * @param const void* data
+   * @param size_t size
+   */
+  void update(const void* data, size_t size)
+  {
+    if(!data || !size) return;
+    const uint8_t* p = (const uint8_t*) data;
+    total_ += size;
+    if(buffered_ + size <= buffer_size) {
+      memcpy(buffer_ + buffered_, p, size);
+      buffered_ += size;
+      return;
+    }
+    if(buffered_) {
+      const size_t n = buffer_size - buffered_;
+      memcpy(buffer_ + buffered_, p, n);
+      p += n; size -= n;
+      consume_stripes(buffer_, buffer_size / stripe_size);
+      buffered_ = 0;
+    }
+    if(size > buffer_size) {
+      // Whole multi-stripe spans directly from the input, at least one byte
+      // is kept for the buffer, plus the last consumed stripe for digest().
+      const size_t n = ((size - 1) / buffer_size) * buffer_size;
+      consume_stripes(p, n / stripe_size);
+      p += n; size -= n;
+      memcpy(buffer_ + buffer_size - stripe_size, p - stripe_size, stripe_size);
+    }
+    memcpy(buffer_, p, size);
+    buffered_ = size;
+  }
+
+  /**
+   * Returns the 64 bit hash of all data pushed so far (state unchanged).
+   * @return uint64_t
+   */
+  uint64_t digest64() const
+  {
+    if(total_ <= mid_size_max) return hash64(buffer_, size_t(total_), seed_, kernels_);
+    uint64_t acc[8];
+    digest_long(acc);
+    return merge_accs(acc, secret_ + 11, total_ * prime64_1);
+  }
+
+  /**
+   * Returns the 128 bit hash of all data pushed so far (state unchanged).
+   * @param uint64_t& low
+   * @param uint64_t& high
+   */
+  void digest128(uint64_t& low, uint64_t& high) const
+  {
+    if(total_ <= mid_size_max) { hash128(buffer_, size_t(total_), low, high, seed_, kernels_); return; }
+    uint64_t acc[8];
+    digest_long(acc);
+    low = merge_accs(acc, secret_ + 11, total_ * prime64_1);
+    high = merge_accs(acc, secret_ + secret_size - 64 - 11, ~(total_ * prime64_2));
+  }
+
+  /**
+   * Finalise the 64 bit hash, write the canonical `digest_size` bytes to `out`, resets.
+   * @param uint8_t* out
+   */
+  void final_digest(uint8_t* out)
+  { canonical(digest64(), out); clear(); }
+
+  /**
+   * Finalise the 128 bit hash, write the canonical 16 bytes (high, low) to `out`, resets.
+   * @param uint8_t* out
+   */
+  void final_digest128(uint8_t* out)
+  { uint64_t lo, hi; digest128(lo, hi); canonical(hi, out); canonical(lo, out+8); clear(); }
+
+  /**
+   * Finalise the 64 bit hash, return (big endian, xxhsum compatible) hex string, resets.
+   * @return str_t
+   */
+  str_t final_result()
+  { const str_t s = hex(digest64()); clear(); return s; }
+
+  /**
+   * Finalise the 128 bit hash, return hex string (high, low), resets.
+   * @return str_t
+   */
+  str_t final_result128()
+  { uint64_t lo, hi; digest128(lo, hi); clear(); return hex(hi) + hex(lo); }
+
+public:
+
+  /**
+   * One-shot 64 bit hash.
+   */
+  static uint64_t hash64(const void* data, size_t size, uint64_t seed=0, const xxh3_kernels& k=xxh3_kernels::best())
+  {
+    const uint8_t* in = (const uint8_t*) data;
+    const uint8_t* s = xxh3_constants<>::secret;
+    if(size <= 16) {
+      if(size > 8) {
+        const uint64_t lo = read64(in) ^ ((read64(s+24) ^ read64(s+32)) + seed);
+        const uint64_t hi = read64(in+size-8) ^ ((read64(s+40) ^ read64(s+48)) - seed);
+        return avalanche(uint64_t(size) + swap64(lo) + hi + mul128_fold64(lo, hi));
+      } else if(size >= 4) {
+        seed ^= uint64_t(swap32(uint32_t(seed))) << 32;
+        const uint64_t in64 = uint64_t(read32(in+size-4)) + (uint64_t(read32(in)) << 32);
+        return rrmxmx(in64 ^ ((read64(s+8) ^ read64(s+16)) - seed), size);
+      } else if(size > 0) {
+        const uint32_t combined = (uint32_t(in[0]) << 16) | (uint32_t(in[size>>1]) << 24) | uint32_t(in[size-1]) | (uint32_t(size) << 8);
+        return xxh64_avalanche(uint64_t(combined) ^ (uint64_t(read32(s) ^ read32(s+4)) + seed));
+      } else {
+        return xxh64_avalanche(seed ^ (read64(s+56) ^ read64(s+64)));
+      }
+    } else if(size <= 128) {
+      uint64_t acc = uint64_t(size) * prime64_1;
+      if(size > 32) {
+        if(size > 64) {
+          if(size > 96) { acc += mix16(in+48, s+96, seed); acc += mix16(in+size-64, s+112, seed); }
+          acc += mix16(in+32, s+64, seed); acc += mix16(in+size-48, s+80, seed);
+        }
+        acc += mix16(in+16, s+32, seed); acc += mix16(in+size-32, s+48, seed);
+      }
+      acc += mix16(in, s, seed); acc += mix16(in+size-16, s+16, seed);
+      return avalanche(acc);
+    } else if(size <= mid_size_max) {
+      uint64_t acc = uint64_t(size) * prime64_1;
+      const size_t nb_rounds = size / 16;
+      for(size_t i=0; i<8; ++i) acc += mix16(in+16*i, s+16*i, seed);
+      acc = avalanche(acc);
+      for(size_t i=8; i<nb_rounds; ++i) acc += mix16(in+16*i, s+16*(i-8)+3, seed);
+      acc += mix16(in+size-16, s+secret_size_min-17, seed);
+      return avalanche(acc);
+    } else {
+      uint8_t custom[secret_size];
+      if(seed) { init_secret(custom, seed); s = custom; }
+      uint64_t acc[8];
+      init_acc(acc);
+      k.hash_long(acc, in, size, s);
+      return merge_accs(acc, s + 11, uint64_t(size) * prime64_1);
+    }
+  }
+
+  /**
+   * One-shot 128 bit hash.
+   */
+  static void hash128(const void* data, size_t size, uint64_t& low, uint64_t& high, uint64_t seed=0, const xxh3_kernels& k=xxh3_kernels::best())
+  {
+    const uint8_t* in = (const uint8_t*) data;
+    const uint8_t* s = xxh3_constants<>::secret;
+    if(size <= 16) {
+      if(size > 8) {
+        const uint64_t flip_lo = (read64(s+32) ^ read64(s+40)) - seed;
+        const uint64_t flip_hi = (read64(s+48) ^ read64(s+56)) + seed;
+        const uint64_t in_lo = read64(in);
+        uint64_t in_hi = read64(in+size-8);
+        uint64_t m_lo, m_hi;
+        mul64to128(in_lo ^ in_hi ^ flip_lo, prime64_1, m_lo, m_hi);
+        m_lo += uint64_t(size - 1) << 54;
+        in_hi ^= flip_hi;
+        m_hi += in_hi + mul32to64(uint32_t(in_hi), prime32_2 - 1);
+        m_lo ^= swap64(m_hi);
+        uint64_t r_lo, r_hi;
+        mul64to128(m_lo, prime64_2, r_lo, r_hi);
+        r_hi += m_hi * prime64_2;
+        low = avalanche(r_lo);
+        high = avalanche(r_hi);
+      } else if(size >= 4) {
+        seed ^= uint64_t(swap32(uint32_t(seed))) << 32;
+        const uint64_t in64 = uint64_t(read32(in)) + (uint64_t(read32(in+size-4)) << 32);
+        const uint64_t keyed = in64 ^ ((read64(s+16) ^ read64(s+24)) + seed);
+        uint64_t lo, hi;
+        mul64to128(keyed, prime64_1 + (uint64_t(size) << 2), lo, hi);
+        hi += (lo << 1);
+        lo ^= (hi >> 3);
+        lo ^= lo >> 35;
+        lo *= 0x9fb21c651e98df25ull;
+        lo ^= lo >> 28;
+        low = lo;
+        high = avalanche(hi);
+      } else if(size > 0) {
+        const uint32_t in_lo = (uint32_t(in[0]) << 16) | (uint32_t(in[size>>1]) << 24) | uint32_t(in[size-1]) | (uint32_t(size) << 8);
+        const uint32_t in_hi = rotl32(swap32(in_lo), 13);
+        low = xxh64_avalanche(uint64_t(in_lo) ^ (uint64_t(read32(s) ^ read32(s+4)) + seed));
+        high = xxh64_avalanche(uint64_t(in_hi) ^ (uint64_t(read32(s+8) ^ read32(s+12)) - seed));
+      } else {
+        low = xxh64_avalanche(seed ^ read64(s+64) ^ read64(s+72));
+        high = xxh64_avalanche(seed ^ read64(s+80) ^ read64(s+88));
+      }
+    } else if(size <= mid_size_max) {
+      uint64_t lo = uint64_t(size) * prime64_1, hi = 0;
+      if(size <= 128) {
+        if(size > 32) {
+          if(size > 64) {
+            if(size > 96) mix32(lo, hi, in+48, in+size-64, s+96, seed);
+            mix32(lo, hi, in+32, in+size-48, s+64, seed);
+          }
+          mix32(lo, hi, in+16, in+size-32, s+32, seed);
+        }
+        mix32(lo, hi, in, in+size-16, s, seed);
+      } else {
+        const size_t nb_rounds = size / 32;
+        for(size_t i=0; i<4; ++i) mix32(lo, hi, in+32*i, in+32*i+16, s+32*i, seed);
+        lo = avalanche(lo);
+        hi = avalanche(hi);
+        for(size_t i=4; i<nb_rounds; ++i) mix32(lo, hi, in+32*i, in+32*i+16, s+3+32*(i-4), seed);
+        mix32(lo, hi, in+size-16, in+size-32, s+secret_size_min-17-16, 0-seed);
+      }
+      low = avalanche(lo + hi);
+      high = 0 - avalanche(lo * prime64_1 + hi * prime64_4 + (uint64_t(size) - seed) * prime64_2);
+    } else {
+      uint8_t custom[secret_size];
+      if(seed) { init_secret(custom, seed); s = custom; }
+      uint64_t acc[8];
+      init_acc(acc);
+      k.hash_long(acc, in, size, s);
+      low = merge_accs(acc, s + 11, uint64_t(size) * prime64_1);
+      high = merge_accs(acc, s + secret_size - 64 - 11, ~(uint64_t(size) * prime64_2));
+    }
+  }
+
+  /**
+   * Canonical (big endian, xxhsum) byte representation of a 64 bit hash.
+   * @param uint64_t h
+   * @param uint8_t* out
+   */
+  static void canonical(uint64_t h, uint8_t* out) noexcept
+  { for(unsigned i=0; i<8; ++i) out[i] = uint8_t(h >> (56-8*i)); }
+
+  /**
+   * Big endian hex representation of a 64 bit hash.
+   * @param uint64_t h
+   * @return str_t
+   */
+  static str_t hex(uint64_t h)
+  { uint8_t b[8]; canonical(h, b); return basic_encoding<Char_Type>::hex(b, 8); }
+
+  static str_t calculate(const void* data, size_t size)
+  { return hex(hash64(data, size)); }
+
+  static str_t calculate(const str_t& s)
+  { return calculate(s.data(), s.size() * sizeof(Char_Type)); }
+
+  static str_t calculate128(const void* data, size_t size)
+  { uint64_t lo, hi; hash128(data, size, lo, hi); return hex(hi) + hex(lo); }
+
+  /**
+   * XXH3-64 checksum of a file, empty string on error.
+   * @param const str_t & path
+   * @param bool binary = true
+   * @return str_t
+   */
+  static str_t file(const str_t & path, bool binary=true)
+  {
+    basic_xxh3 r;
+    if(!read_file_blocks(path.c_str(), binary, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final_result();
+  }
+
+  /**
+   * XXH3-128 checksum of a file, empty string on error.
+   * @param const str_t & path
+   * @param bool binary = true
+   * @return str_t
+   */
+  static str_t file128(const str_t & path, bool binary=true)
+  {
+    basic_xxh3 r;
+    if(!read_file_blocks(path.c_str(), binary, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final_result128();
+  }
+
+private:
+
+  void consume_stripes(const uint8_t* p, size_t nb_stripes)
+  {
+    while(nb_stripes) {
+      size_t n = stripes_per_block - nb_stripes_acc_;
+      if(n > nb_stripes) n = nb_stripes;
+      kernels_.accumulate(acc_, p, secret_ + nb_stripes_acc_ * 8, n);
+      p += n * stripe_size;
+      nb_stripes -= n;
+      nb_stripes_acc_ += n;
+      if(nb_stripes_acc_ == stripes_per_block) {
+        kernels_.scramble(acc_, secret_ + secret_size - stripe_size);
+        nb_stripes_acc_ = 0;
+      }
+    }
+  }
+
+  void digest_long(uint64_t* acc) const
+  {
+    basic_xxh3 s(*this);
+    if(s.buffered_ >= stripe_size) {
+      s.consume_stripes(s.buffer_, (s.buffered_ - 1) / stripe_size);
+      s.kernels_.accumulate(s.acc_, s.buffer_ + s.buffered_ - stripe_size, s.secret_ + secret_size - stripe_size - 7, 1);
+    } else {
+      uint8_t last[stripe_size];
+      const size_t catchup = stripe_size - s.buffered_;
+      memcpy(last, s.buffer_ + buffer_size - catchup, catchup);
+      memcpy(last + catchup, s.buffer_, s.buffered_);
+      s.kernels_.accumulate(s.acc_, last, s.secret_ + secret_size - stripe_size - 7, 1);
+    }
+    memcpy(acc, s.acc_, sizeof(s.acc_));
+  }
+
+private:
+
+  static constexpr size_t buffer_size = 256;
+  const xxh3_kernels& kernels_;
+  uint64_t acc_[8];
+  uint64_t seed_;
+  uint64_t total_;
+  size_t buffered_;
+  size_t nb_stripes_acc_;
+  uint8_t secret_[secret_size];
+  uint8_t buffer_[buffer_size];
+};
+
+}}
+
+namespace sw {
+  typedef detail::basic_xxh3<> xxh3;
+}
+
+#endif
+// </editor-fold>
+
+// <editor-fold desc="blake3" defaultstate="collapsed">
+/**
+ * BLAKE3 (https://github.com/BLAKE3-team/BLAKE3, CC0/Apache-2.0, Jack
+ * O'Connor, Jean-Philippe Aumasson, Samuel Neves, Zooko Wilcox-O'Hearn),
+ * hash mode with the default 256 bit output. The input is split into 1KiB
+ * chunks, which are compressed independently and merged as binary tree.
+ * Complete chunks are compressed 4 (SSE4.1) or 8 (AVX2) at a time, the
+ * kernels are selected at runtime depending on the CPU features. Long
+ * `update()` spans are split over up to `max_threads` threads.
+ *
+ *  sw::blake3 hasher(4); hasher.update(data, size); ...; std::string hex = hasher.final();
+ */
+#ifndef SW_BLAKE3_HH
+#define SW_BLAKE3_HH
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <system_error>
+#include <cstring>
+#include <cstdlib>
+#if defined(OS_WIN) || defined (_WINDOWS_) || defined(_WIN32) || defined(__MSC_VER)
+#include <stdint.h>
+#else
+#include <inttypes.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define SW_BLAKE3_HAVE_X86_KERNELS
+  #include <immintrin.h>
+#endif
+
+// Quarter round and round on 32 bit words or vectors, depends on the
+// SW_BLAKE3_ADD/XOR/ROTx operations defined in the kernels.
+#define SW_BLAKE3_G(v, a, b, c, d, x, y) \
+  v[a] = SW_BLAKE3_ADD(SW_BLAKE3_ADD(v[a], v[b]), x); v[d] = SW_BLAKE3_ROT16(SW_BLAKE3_XOR(v[d], v[a])); \
+  v[c] = SW_BLAKE3_ADD(v[c], v[d]); v[b] = SW_BLAKE3_ROT12(SW_BLAKE3_XOR(v[b], v[c])); \
+  v[a] = SW_BLAKE3_ADD(SW_BLAKE3_ADD(v[a], v[b]), y); v[d] = SW_BLAKE3_ROT8(SW_BLAKE3_XOR(v[d], v[a])); \
+  v[c] = SW_BLAKE3_ADD(v[c], v[d]); v[b] = SW_BLAKE3_ROT7(SW_BLAKE3_XOR(v[b], v[c]));
+
+#define SW_BLAKE3_ROUND(v, m, s0,s1,s2,s3,s4,s5,s6,s7,s8,s9,s10,s11,s12,s13,s14,s15) \
+  SW_BLAKE3_G(v, 0, 4,  8, 12, m[s0], m[s1]) SW_BLAKE3_G(v, 1, 5,  9, 13, m[s2], m[s3]) \
+  SW_BLAKE3_G(v, 2, 6, 10, 14, m[s4], m[s5]) SW_BLAKE3_G(v, 3, 7, 11, 15, m[s6], m[s7]) \
+  SW_BLAKE3_G(v, 0, 5, 10, 15, m[s8], m[s9]) SW_BLAKE3_G(v, 1, 6, 11, 12, m[s10], m[s11]) \
+  SW_BLAKE3_G(v, 2, 7,  8, 13, m[s12], m[s13]) SW_BLAKE3_G(v, 3, 4,  9, 14, m[s14], m[s15])
+
+// The 7 rounds, unrolled with the message word permutation of each round.
+#define SW_BLAKE3_ROUNDS(v, m) \
+  SW_BLAKE3_ROUND(v, m, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15) \
+  SW_BLAKE3_ROUND(v, m, 2,6,3,10,7,0,4,13,1,11,12,5,9,14,15,8) \
+  SW_BLAKE3_ROUND(v, m, 3,4,10,12,13,2,7,14,6,5,9,0,11,15,8,1) \
+  SW_BLAKE3_ROUND(v, m, 10,7,12,9,14,3,13,15,4,0,11,2,5,8,1,6) \
+  SW_BLAKE3_ROUND(v, m, 12,13,9,11,15,10,14,8,7,2,5,3,0,1,6,4) \
+  SW_BLAKE3_ROUND(v, m, 9,14,11,5,8,12,15,1,13,3,0,10,2,6,4,7) \
+  SW_BLAKE3_ROUND(v, m, 11,15,5,0,1,9,8,6,14,10,2,12,3,4,7,13)
+
+namespace sw { namespace detail {
+
+template <typename=void>
+struct blake3_constants
+{
+  static constexpr size_t block_size = 64;
+  static constexpr size_t chunk_size = 1024;
+  static constexpr uint32_t chunk_start = 1;
+  static constexpr uint32_t chunk_end = 2;
+  static constexpr uint32_t parent = 4;
+  static constexpr uint32_t root = 8;
+  static const uint32_t iv[8];
+};
+
+template <typename T> constexpr size_t blake3_constants<T>::block_size;
+template <typename T> constexpr size_t blake3_constants<T>::chunk_size;
+
+template <typename T>
+const uint32_t blake3_constants<T>::iv[8] = {
+  0x6a09e667u, 0xbb67ae85u, 0x3c6ef372u, 0xa54ff53au, 0x510e527fu, 0x9b05688cu, 0x1f83d9abu, 0x5be0cd19u
+};
+
+struct blake3_kernels : public blake3_constants<>
+{
+  /**
+   * Compresses `nchunks` complete consecutive chunks (chunk counters
+   * `counter`, `counter+1`, ...) and stores their 8 word chaining values
+   * consecutively in `cvs`.
+   */
+  typedef void (*chunks_type)(const uint8_t* data, size_t nchunks, const uint32_t* key, uint64_t counter, uint32_t* cvs);
+
+  chunks_type chunks;
+  const char* name;
+
+  blake3_kernels(chunks_type chk, const char* nm) : chunks(chk), name(nm)
+  {}
+
+  static inline uint32_t read32(const uint8_t* p)
+  {
+    #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    uint32_t v; memcpy(&v, p, sizeof(v)); return v;
+    #else
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    #endif
+  }
+
+  static void load_block(uint32_t* m, const uint8_t* p)
+  { for(unsigned i=0; i<16; ++i) m[i] = read32(p+4*i); }
+
+  /**
+   * Compression function, `cv` is replaced with the (first 8 words of the)
+   * output.
+   * @param uint32_t* cv
+   * @param const uint32_t* m
+   * @param uint32_t block_len
+   * @param uint64_t counter
+   * @param uint32_t flags
+   */
+  static void compress(uint32_t* cv, const uint32_t* m, uint32_t block_len, uint64_t counter, uint32_t flags)
+  {
+    #define SW_BLAKE3_ADD(a,b) ((a)+(b))
+    #define SW_BLAKE3_XOR(a,b) ((a)^(b))
+    #define SW_BLAKE3_ROT16(x) (((x)>>16)|((x)<<16))
+    #define SW_BLAKE3_ROT12(x) (((x)>>12)|((x)<<20))
+    #define SW_BLAKE3_ROT8(x) (((x)>>8)|((x)<<24))
+    #define SW_BLAKE3_ROT7(x) (((x)>>7)|((x)<<25))
+    uint32_t v[16] = {
+      cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+      iv[0], iv[1], iv[2], iv[3], uint32_t(counter), uint32_t(counter >> 32), block_len, flags
+    };
+    SW_BLAKE3_ROUNDS(v, m)
+    for(unsigned i=0; i<8; ++i) cv[i] = v[i] ^ v[i+8];
+    #undef SW_BLAKE3_ADD
+    #undef SW_BLAKE3_XOR
+    #undef SW_BLAKE3_ROT16
+    #undef SW_BLAKE3_ROT12
+    #undef SW_BLAKE3_ROT8
+    #undef SW_BLAKE3_ROT7
+  }
+
+  static void chunks_portable(const uint8_t* data, size_t nchunks, const uint32_t* key, uint64_t counter, uint32_t* cvs)
+  {
+    for(; nchunks; --nchunks, ++counter, cvs += 8) {
+      memcpy(cvs, key, 8*sizeof(uint32_t));
+      for(unsigned b=0; b<16; ++b, data += block_size) {
+        uint32_t m[16];
+        load_block(m, data);
+        compress(cvs, m, block_size, counter, ((b==0) ? chunk_start : 0) | ((b==15) ? chunk_end : 0));
+      }
+    }
+  }
+
+  #ifdef SW_BLAKE3_HAVE_X86_KERNELS
+  /**
+   * 4 chunks in parallel, one chunk per 32 bit vector lane.
+   */
+  __attribute__((target("sse4.1")))
+  static void chunks_sse41(const uint8_t* data, size_t nchunks, const uint32_t* key, uint64_t counter, uint32_t* cvs)
+  {
+    #define SW_BLAKE3_ADD(a,b) _mm_add_epi32(a, b)
+    #define SW_BLAKE3_XOR(a,b) _mm_xor_si128(a, b)
+    #define SW_BLAKE3_ROT16(x) _mm_shuffle_epi8(x, rot16)
+    #define SW_BLAKE3_ROT12(x) _mm_or_si128(_mm_srli_epi32(x, 12), _mm_slli_epi32(x, 20))
+    #define SW_BLAKE3_ROT8(x) _mm_shuffle_epi8(x, rot8)
+    #define SW_BLAKE3_ROT7(x) _mm_or_si128(_mm_srli_epi32(x, 7), _mm_slli_epi32(x, 25))
+    #define SW_BLAKE3_TRANSPOSE4(r0, r1, r2, r3) { \
+      const __m128i t0 = _mm_unpacklo_epi32(r0, r1), t1 = _mm_unpackhi_epi32(r0, r1); \
+      const __m128i t2 = _mm_unpacklo_epi32(r2, r3), t3 = _mm_unpackhi_epi32(r2, r3); \
+      r0 = _mm_unpacklo_epi64(t0, t2); r1 = _mm_unpackhi_epi64(t0, t2); \
+      r2 = _mm_unpacklo_epi64(t1, t3); r3 = _mm_unpackhi_epi64(t1, t3); }
+    const __m128i rot16 = _mm_set_epi8(13,12,15,14, 9,8,11,10, 5,4,7,6, 1,0,3,2);
+    const __m128i rot8 = _mm_set_epi8(12,15,14,13, 8,11,10,9, 4,7,6,5, 0,3,2,1);
+    for(; nchunks >= 4; nchunks -= 4, data += 4*chunk_size, counter += 4, cvs += 4*8) {
+      __m128i h[8], m[16], v[16];
+      for(unsigned i=0; i<8; ++i) h[i] = _mm_set1_epi32(int(key[i]));
+      const __m128i counter_lo = _mm_set_epi32(int(uint32_t(counter+3)), int(uint32_t(counter+2)), int(uint32_t(counter+1)), int(uint32_t(counter)));
+      const __m128i counter_hi = _mm_set_epi32(int(uint32_t((counter+3)>>32)), int(uint32_t((counter+2)>>32)), int(uint32_t((counter+1)>>32)), int(uint32_t(counter>>32)));
+      for(unsigned b=0; b<16; ++b) {
+        const uint8_t* p = data + b*block_size;
+        for(unsigned w=0; w<4; ++w) {
+          m[4*w+0] = _mm_loadu_si128((const __m128i*)(p + 0*chunk_size + 16*w));
+          m[4*w+1] = _mm_loadu_si128((const __m128i*)(p + 1*chunk_size + 16*w));
+          m[4*w+2] = _mm_loadu_si128((const __m128i*)(p + 2*chunk_size + 16*w));
+          m[4*w+3] = _mm_loadu_si128((const __m128i*)(p + 3*chunk_size + 16*w));
+          SW_BLAKE3_TRANSPOSE4(m[4*w+0], m[4*w+1], m[4*w+2], m[4*w+3])
+        }
+        for(unsigned i=0; i<8; ++i) v[i] = h[i];
+        for(unsigned i=0; i<4; ++i) v[8+i] = _mm_set1_epi32(int(iv[i]));
+        v[12] = counter_lo;
+        v[13] = counter_hi;
+        v[14] = _mm_set1_epi32(int(block_size));
+        v[15] = _mm_set1_epi32(int(((b==0) ? chunk_start : 0) | ((b==15) ? chunk_end : 0)));
+        SW_BLAKE3_ROUNDS(v, m)
+        for(unsigned i=0; i<8; ++i) h[i] = _mm_xor_si128(v[i], v[i+8]);
+      }
+      SW_BLAKE3_TRANSPOSE4(h[0], h[1], h[2], h[3])
+      SW_BLAKE3_TRANSPOSE4(h[4], h[5], h[6], h[7])
+      for(unsigned i=0; i<4; ++i) {
+        _mm_storeu_si128((__m128i*)(cvs + 8*i), h[i]);
+        _mm_storeu_si128((__m128i*)(cvs + 8*i + 4), h[4+i]);
+      }
+    }
+    if(nchunks) chunks_portable(data, nchunks, key, counter, cvs);
+    #undef SW_BLAKE3_ADD
+    #undef SW_BLAKE3_XOR
+    #undef SW_BLAKE3_ROT16
+    #undef SW_BLAKE3_ROT12
+    #undef SW_BLAKE3_ROT8
+    #undef SW_BLAKE3_ROT7
+    #undef SW_BLAKE3_TRANSPOSE4
+  }
+
+  /**
+   * 8 chunks in parallel, remaining chunks with SSE4.1.
+   */
+  __attribute__((target("avx2")))
+  static void chunks_avx2(const uint8_t* data, size_t nchunks, const uint32_t* key, uint64_t counter, uint32_t* cvs)
+  {
+    #define SW_BLAKE3_ADD(a,b) _mm256_add_epi32(a, b)
+    #define SW_BLAKE3_XOR(a,b) _mm256_xor_si256(a, b)
+    #define SW_BLAKE3_ROT16(x) _mm256_shuffle_epi8(x, rot16)
+    #define SW_BLAKE3_ROT12(x) _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 20))
+    #define SW_BLAKE3_ROT8(x) _mm256_shuffle_epi8(x, rot8)
+    #define SW_BLAKE3_ROT7(x) _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 25))
+    #define SW_BLAKE3_TRANSPOSE8(r) { \
+      const __m256i ab_0145 = _mm256_unpacklo_epi32(r[0], r[1]), ab_2367 = _mm256_unpackhi_epi32(r[0], r[1]); \
+      const __m256i cd_0145 = _mm256_unpacklo_epi32(r[2], r[3]), cd_2367 = _mm256_unpackhi_epi32(r[2], r[3]); \
+      const __m256i ef_0145 = _mm256_unpacklo_epi32(r[4], r[5]), ef_2367 = _mm256_unpackhi_epi32(r[4], r[5]); \
+      const __m256i gh_0145 = _mm256_unpacklo_epi32(r[6], r[7]), gh_2367 = _mm256_unpackhi_epi32(r[6], r[7]); \
+      const __m256i abcd_04 = _mm256_unpacklo_epi64(ab_0145, cd_0145), abcd_15 = _mm256_unpackhi_epi64(ab_0145, cd_0145); \
+      const __m256i abcd_26 = _mm256_unpacklo_epi64(ab_2367, cd_2367), abcd_37 = _mm256_unpackhi_epi64(ab_2367, cd_2367); \
+      const __m256i efgh_04 = _mm256_unpacklo_epi64(ef_0145, gh_0145), efgh_15 = _mm256_unpackhi_epi64(ef_0145, gh_0145); \
+      const __m256i efgh_26 = _mm256_unpacklo_epi64(ef_2367, gh_2367), efgh_37 = _mm256_unpackhi_epi64(ef_2367, gh_2367); \
+      r[0] = _mm256_permute2x128_si256(abcd_04, efgh_04, 0x20); r[4] = _mm256_permute2x128_si256(abcd_04, efgh_04, 0x31); \
+      r[1] = _mm256_permute2x128_si256(abcd_15, efgh_15, 0x20); r[5] = _mm256_permute2x128_si256(abcd_15, efgh_15, 0x31); \
+      r[2] = _mm256_permute2x128_si256(abcd_26, efgh_26, 0x20); r[6] = _mm256_permute2x128_si256(abcd_26, efgh_26, 0x31); \
+      r[3] = _mm256_permute2x128_si256(abcd_37, efgh_37, 0x20); r[7] = _mm256_permute2x128_si256(abcd_37, efgh_37, 0x31); }
+    const __m256i rot16 = _mm256_set_epi8(13,12,15,14, 9,8,11,10, 5,4,7,6, 1,0,3,2, 13,12,15,14, 9,8,11,10, 5,4,7,6, 1,0,3,2);
+    const __m256i rot8 = _mm256_set_epi8(12,15,14,13, 8,11,10,9, 4,7,6,5, 0,3,2,1, 12,15,14,13, 8,11,10,9, 4,7,6,5, 0,3,2,1);
+    for(; nchunks >= 8; nchunks -= 8, data += 8*chunk_size, counter += 8, cvs += 8*8) {
+      __m256i h[8], m[16], v[16];
+      uint32_t ctr_lo[8], ctr_hi[8];
+      for(unsigned i=0; i<8; ++i) {
+        h[i] = _mm256_set1_epi32(int(key[i]));
+        ctr_lo[i] = uint32_t(counter+i);
+        ctr_hi[i] = uint32_t((counter+i) >> 32);
+      }
+      const __m256i counter_lo = _mm256_loadu_si256((const __m256i*)ctr_lo);
+      const __m256i counter_hi = _mm256_loadu_si256((const __m256i*)ctr_hi);
+      for(unsigned b=0; b<16; ++b) {
+        const uint8_t* p = data + b*block_size;
+        for(unsigned w=0; w<2; ++w) {
+          for(unsigned i=0; i<8; ++i) m[8*w+i] = _mm256_loadu_si256((const __m256i*)(p + i*chunk_size + 32*w));
+          SW_BLAKE3_TRANSPOSE8((m+8*w))
+        }
+        for(unsigned i=0; i<8; ++i) v[i] = h[i];
+        for(unsigned i=0; i<4; ++i) v[8+i] = _mm256_set1_epi32(int(iv[i]));
+        v[12] = counter_lo;
+        v[13] = counter_hi;
+        v[14] = _mm256_set1_epi32(int(block_size));
+        v[15] = _mm256_set1_epi32(int(((b==0) ? chunk_start : 0) | ((b==15) ? chunk_end : 0)));
+        SW_BLAKE3_ROUNDS(v, m)
+        for(unsigned i=0; i<8; ++i) h[i] = _mm256_xor_si256(v[i], v[i+8]);
+      }
+      SW_BLAKE3_TRANSPOSE8(h)
+      for(unsigned i=0; i<8; ++i) _mm256_storeu_si256((__m256i*)(cvs + 8*i), h[i]);
+    }
+    if(nchunks) chunks_sse41(data, nchunks, key, counter, cvs);
+    #undef SW_BLAKE3_ADD
+    #undef SW_BLAKE3_XOR
+    #undef SW_BLAKE3_ROT16
+    #undef SW_BLAKE3_ROT12
+    #undef SW_BLAKE3_ROT8
+    #undef SW_BLAKE3_ROT7
+    #undef SW_BLAKE3_TRANSPOSE8
+  }
+  #endif
+
+  static bool have_sse41()
+  {
+    #ifdef SW_BLAKE3_HAVE_X86_KERNELS
+    static const bool have = __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3");
+    return have;
+    #else
+    return false;
+    #endif
+  }
+
+  static bool have_avx2()
+  {
+    #ifdef SW_BLAKE3_HAVE_X86_KERNELS
+    static const bool have = have_sse41() && __builtin_cpu_supports("avx2");
+    return have;
+    #else
+    return false;
+    #endif
+  }
+
+  static const blake3_kernels& portable()
+  { static const blake3_kernels k(&chunks_portable, "portable"); return k; }
+
+  /**
+   * SSE4.1 kernels, portable if not available on this CPU.
+   */
+  static const blake3_kernels& sse41()
+  {
+    #ifdef SW_BLAKE3_HAVE_X86_KERNELS
+    static const blake3_kernels k(&chunks_sse41, "sse4.1");
+    if(have_sse41()) return k;
+    #endif
+    return portable();
+  }
+
+  /**
+   * AVX2 kernels, SSE4.1 (or portable) if not available on this CPU.
+   */
+  static const blake3_kernels& avx2()
+  {
+    #ifdef SW_BLAKE3_HAVE_X86_KERNELS
+    static const blake3_kernels k(&chunks_avx2, "avx2");
+    if(have_avx2()) return k;
+    #endif
+    return sse41();
+  }
+
+  /**
+   * Returns the fastest kernels available on this CPU.
+   */
+  static const blake3_kernels& best()
+  { return avx2(); }
+};
+
+/**
+ * @class basic_blake3
+ * @template
+ */
+template <typename Char_Type=char>
+class basic_blake3 : public blake3_constants<>
+{
+public:
+
+  typedef std::basic_string<Char_Type> str_t;
+
+  /**
+   * Number of bytes of the (default length) binary digest.
+   */
+  static constexpr size_t digest_size = 32;
+
+  /**
+   * Minimum number of chunks compressed per thread, below that the
+   * thread start costs more than it saves.
+   */
+  static constexpr size_t thread_min_chunks = 1024;
+
+public:
+
+  explicit basic_blake3(unsigned max_threads=1, const blake3_kernels& kernels=blake3_kernels::best())
+    : kernels_(kernels), max_threads_(max_threads ? max_threads : 1)
+  { clear(); }
+
+  /**
+   * Clear/reset all internal buffers and states.
+   */
+  void clear()
+  {
+    memcpy(chunk_cv_, iv, sizeof(chunk_cv_));
+    chunk_counter_ = 0; blocks_ = 0; buffered_ = 0; stack_size_ = 0;
+  }
+
+  /**
+   * Maximum number of threads used for long inputs.
+   * @return unsigned
+   */
+  unsigned max_threads() const noexcept
+  { return max_threads_; }
+
+  /**
+   * Size of the spans passed from file readers to `update()`, large
+   * enough to keep all threads busy.
+   * @return size_t
+   */
+  size_t read_block_size() const noexcept
+  { return (max_threads_ > 1) ? ((max_threads_ < 16 ? max_threads_ : 16) * thread_min_chunks * chunk_size * 4) : file_read_block_size; }
+
+  /**
+   * Push new binary data.
+   * @param const void* data
+   * @param size_t size
+   */
+  void update(const void* data, size_t size)
+  {
+    if(!data || !size) return;
+    const uint8_t* p = (const uint8_t*) data;
+    while(size) {
+      if(chunk_length() == chunk_size) {
+        // The current chunk is complete and not the last one.
+        uint32_t m[16];
+        load_block(m, buffer_, buffered_);
+        compress(chunk_cv_, m, block_size, chunk_counter_, chunk_flags() | chunk_end);
+        push_chunk_cv(chunk_cv_);
+      }
+      if((chunk_length() == 0) && (size > chunk_size)) {
+        // Whole chunks directly from the input, at least one byte is kept
+        // for the last chunk.
+        const size_t n = (size - 1) / chunk_size;
+        compress_chunks(p, n);
+        p += n * chunk_size; size -= n * chunk_size;
+        continue;
+      }
+      if(buffered_ == block_size) {
+        uint32_t m[16];
+        load_block(m, buffer_, buffered_);
+        compress(chunk_cv_, m, block_size, chunk_counter_, chunk_flags());
+        ++blocks_; buffered_ = 0;
+      }
+      size_t n = block_size - buffered_;
+      if(n > size) n = size;
+      memcpy(buffer_ + buffered_, p, n);
+      buffered_ += n; p += n; size -= n;
+    }
+  }
+
+  /**
+   * Finalise the hash, write the `digest_size` digest bytes to `out`.
+   * @param uint8_t* out
+   */
+  void final_digest(uint8_t* out)
+  {
+    uint32_t cv[8], m[16];
+    memcpy(cv, chunk_cv_, sizeof(cv));
+    load_block(m, buffer_, buffered_);
+    uint32_t block_len = uint32_t(buffered_);
+    uint64_t counter = chunk_counter_;
+    uint32_t flags = chunk_flags() | chunk_end;
+    for(size_t i = stack_size_; i > 0; --i) {
+      compress(cv, m, block_len, counter, flags);
+      memcpy(m, stack_[i-1], 8*sizeof(uint32_t));
+      memcpy(m+8, cv, 8*sizeof(uint32_t));
+      memcpy(cv, iv, sizeof(cv));
+      block_len = block_size; counter = 0; flags = parent;
+    }
+    compress(cv, m, block_len, counter, flags | root);
+    for(unsigned i = 0; i < 32; ++i) out[i] = uint8_t(cv[i/4] >> (8*(i%4)));
+    clear();
+  }
+
+  /**
+   * Finalise the hash, return hex string.
+   * @return str_t
+   */
+  str_t final()
+  { uint8_t d[digest_size]; final_digest(d); return basic_encoding<Char_Type>::hex(d, digest_size); }
+
+public:
+
+  /**
+   * Calculates the BLAKE3 for a given string.
+   * @param const str_t & s
+   * @return str_t
+   */
+  static str_t calculate(const str_t & s)
+  { basic_blake3 r; r.update(s.data(), s.length() * sizeof(Char_Type)); return r.final(); }
+
+  /**
+   * Calculates the BLAKE3 for given binary data, using up to `max_threads`
+   * threads.
+   * @param const void* data
+   * @param size_t size
+   * @param unsigned max_threads
+   * @return str_t
+   */
+  static str_t calculate(const void* data, size_t size, unsigned max_threads=1)
+  { basic_blake3 r(max_threads); r.update(data, size); return r.final(); }
+
+  /**
+   * Calculates the BLAKE3 for a stream. Returns an empty string on error.
+   * @param std::istream & is
+   * @return str_t
+   */
+  static str_t calculate(std::istream & is)
+  {
+    basic_blake3 r;
+    if(!read_stream_blocks(is, [&r](const void* data, size_t size){ r.update(data, size); })) return str_t();
+    return r.final();
+  }
+
+  /**
+   * Calculates the BLAKE3 checksum for a given file, using up to
+   * `max_threads` threads. Returns an empty string on error.
+   * @param const str_t & path
+   * @param bool binary = true
+   * @param unsigned max_threads
+   * @return str_t
+   */
+  static str_t file(const str_t & path, bool binary=true, unsigned max_threads=1)
+  {
+    basic_blake3 r(max_threads);
+    if(!read_file_blocks(path.c_str(), binary, [&r](const void* data, size_t size){ r.update(data, size); }, r.read_block_size())) return str_t();
+    return r.final();
+  }
+
+private:
+
+  static void compress(uint32_t* cv, const uint32_t* m, size_t block_len, uint64_t counter, uint32_t flags)
+  { blake3_kernels::compress(cv, m, uint32_t(block_len), counter, flags); }
+
+  static void load_block(uint32_t* m, const uint8_t* p, size_t size)
+  {
+    uint8_t block[block_size];
+    memcpy(block, p, size);
+    memset(block + size, 0, block_size - size);
+    blake3_kernels::load_block(m, block);
+  }
+
+  size_t chunk_length() const noexcept
+  { return blocks_ * block_size + buffered_; }
+
+  uint32_t chunk_flags() const noexcept
+  { return blocks_ ? 0 : chunk_start; }
+
+  /**
+   * Adds the chaining value of the completed chunk to the tree, merges
+   * all complete subtrees (number of trailing zero bits of the chunk
+   * count), and starts the next chunk.
+   */
+  void push_chunk_cv(const uint32_t* chunk_cv)
+  {
+    uint32_t cv[8];
+    memcpy(cv, chunk_cv, sizeof(cv));
+    for(uint64_t total = ++chunk_counter_; !(total & 1); total >>= 1) {
+      uint32_t m[16];
+      memcpy(m, stack_[--stack_size_], 8*sizeof(uint32_t));
+      memcpy(m+8, cv, 8*sizeof(uint32_t));
+      memcpy(cv, iv, sizeof(cv));
+      compress(cv, m, block_size, 0, parent);
+    }
+    memcpy(stack_[stack_size_++], cv, sizeof(cv));
+    memcpy(chunk_cv_, iv, sizeof(chunk_cv_));
+    blocks_ = 0; buffered_ = 0;
+  }
+
+  /**
+   * Compresses `n` whole chunks, split over the threads if large enough,
+   * the chaining values are merged in order afterwards.
+   */
+  void compress_chunks(const uint8_t* p, size_t n)
+  {
+    const size_t slice_chunks = size_t(1) << 16; // chaining values of 64MiB input per round.
+    uint32_t local[8*64];
+    std::vector<uint32_t> cvs;
+    while(n) {
+      size_t k;
+      if((max_threads_ > 1) && (n >= 2*thread_min_chunks)) {
+        k = (n < slice_chunks) ? n : slice_chunks;
+        cvs.resize(8*k);
+        compress_chunks_parallel(p, k, &cvs[0]);
+        for(size_t i = 0; i < k; ++i) push_chunk_cv(&cvs[8*i]);
+      } else {
+        k = (n < 64) ? n : 64;
+        kernels_.chunks(p, k, iv, chunk_counter_, local);
+        for(size_t i = 0; i < k; ++i) push_chunk_cv(local + 8*i);
+      }
+      p += k * chunk_size; n -= k;
+    }
+  }
+
+  void compress_chunks_parallel(const uint8_t* p, size_t n, uint32_t* cvs)
+  {
+    size_t nthreads = n / thread_min_chunks;
+    if(nthreads > max_threads_) nthreads = max_threads_;
+    const size_t part = (((n + nthreads - 1) / nthreads) + 7) & ~size_t(7); // whole SIMD groups
+    const blake3_kernels& kernels = kernels_;
+    const uint64_t counter = chunk_counter_;
+    auto work = [&kernels, p, n, part, counter, cvs](size_t t) {
+      const size_t begin = t * part;
+      if(begin >= n) return;
+      const size_t end = (begin + part < n) ? (begin + part) : n;
+      kernels.chunks(p + begin*chunk_size, end-begin, iv, counter+begin, cvs + 8*begin);
+    };
+    std::vector<std::thread> threads;
+    size_t t = 1;
+    try {
+      for(; t < nthreads; ++t) threads.emplace_back(work, t);
+    } catch(const std::system_error&) {
+      // Compress the remaining parts in this thread.
+    }
+    work(0);
+    for(size_t i = t; i < nthreads; ++i) work(i);
+    for(auto& th: threads) th.join();
+  }
+
+private:
+
+  const blake3_kernels& kernels_;
+  unsigned max_threads_;
+  uint32_t chunk_cv_[8];
+  uint64_t chunk_counter_;
+  size_t blocks_;
+  size_t buffered_;
+  size_t stack_size_;
+  uint32_t stack_[54][8]; // max tree depth: 2^64 bytes / 1KiB chunks.
+  uint8_t buffer_[block_size];
+};
+
+}}
+
+namespace sw {
+  typedef detail::basic_blake3<> blake3;
+}
+
+#undef SW_BLAKE3_G
+#undef SW_BLAKE3_ROUND
+#undef SW_BLAKE3_ROUNDS
+#endif
+// </editor-fold>
+
+// <editor-fold desc="duktape-cc bindings" defaultstate="collapsed">
+#include "../duktape.hh"
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <system_error>
+#include <cerrno>
+#include <cstring>
+
+namespace duktape { namespace detail { namespace system { namespace hash {
+
+  #if(0 && JSDOC)
+  /**
+   * Hashing functionality of the system object.
+   * @var {object}
+   */
+  sys.hash = {};
+  #endif
+
+  // <editor-fold desc="digest output" defaultstate="collapsed">
+  /**
+   * Result formats of the hash functions, `standard` is lower case hex for
+   * digests and a number for CRCs.
+   */
+  enum class digest_output { standard, hex, buffer, base64 };
+
+  /**
+   * Returns true if the value at `index` is a plain options object (not an
+   * array, buffer or function, e.g. the extra arguments of `Array.map()`).
+   */
+  template <typename=void>
+  bool is_options_object(duktape::api& stack, duktape::api::index_t index)
+  { return stack.is_object(index) && !stack.is_array(index) && !stack.is_buffer_data(index) && !stack.is_function(index); }
+
+  /**
+   * Reads the output format from a string ("hex", "buffer", "base64"), or
+   * the `output` property of an object at the given index. Undefined or
+   * null means `standard`. Returns false if the format is invalid.
+   */
+  template <typename=void>
+  bool get_digest_output(duktape::api& stack, duktape::api::index_t index, digest_output& output)
+  {
+    output = digest_output::standard;
+    std::string fmt;
+    if(stack.is_undefined(index) || stack.is_null(index)) {
+      return true;
+    } else if(stack.is<std::string>(index)) {
+      fmt = stack.get<std::string>(index);
+    } else if(is_options_object(stack, index)) {
+      stack.get_prop_string(index, "output");
+      const bool is_unset = stack.is_undefined(-1);
+      const bool is_string = stack.is<std::string>(-1);
+      if(is_string) fmt = stack.get<std::string>(-1);
+      stack.pop();
+      if(is_unset) return true;
+      if(!is_string) return false;
+    } else {
+      return false;
+    }
+    if(fmt == "hex") { output = digest_output::hex; return true; }
+    if(fmt == "buffer") { output = digest_output::buffer; return true; }
+    if(fmt == "base64") { output = digest_output::base64; return true; }
+    return false;
+  }
+
+  /**
+   * Reads the second argument of the hash functions, which is either the
+   * boolean `isfile`, or an object `{file:, output:}`. Other values (e.g.
+   * the index passed by `Array.map()`) mean no options. Returns false if
+   * the options object is invalid.
+   */
+  template <typename=void>
+  bool get_digest_options(duktape::api& stack, duktape::api::index_t index, bool& isfile, digest_output& output)
+  {
+    isfile = false;
+    output = digest_output::standard;
+    if(stack.is<bool>(index)) { isfile = stack.get<bool>(index); return true; }
+    if(!is_options_object(stack, index)) return true;
+    isfile = stack.get_prop_string<bool>(index, "file", false);
+    return get_digest_output(stack, index, output);
+  }
+
+  /**
+   * Pushes the binary digest in the requested format.
+   */
+  template <typename=void>
+  void push_digest(duktape::api& stack, const uint8_t* digest, size_t size, digest_output output)
+  {
+    switch(output) {
+      case digest_output::buffer: {
+        void* buffer = stack.push_fixed_buffer(size);
+        if(buffer && size) ::memcpy(buffer, digest, size);
+        break;
+      }
+      case digest_output::base64:
+        stack.push(sw::encoding::base64(digest, size));
+        break;
+      default:
+        stack.push(sw::encoding::hex(digest, size));
     }
   }
 
+  /**
+   * Pushes a CRC as number (standard) or in its big endian byte representation.
+   */
+  template <typename Acc>
+  void push_crc(duktape::api& stack, Acc crc, digest_output output)
+  {
+    if(output == digest_output::standard) {
+      stack.push(crc);
+    } else {
+      uint8_t digest[sizeof(Acc)];
+      for(size_t i = 0; i < sizeof(Acc); ++i) digest[i] = uint8_t(uint64_t(crc) >> (8*(sizeof(Acc)-1-i)));
+      push_digest(stack, digest, sizeof(Acc), output);
+    }
+  }
+
+  /**
+   * Common implementation of the digest functions `sys.hash.<algorithm>(data, isfile|options)`.
+   * `Digest` provides `update()`, `final_digest()` and `digest_size`, files are
+   * passed to `hash` in spans of up to `read_block_size` bytes.
+   */
+  template <typename Digest>
+  int digest_function(duktape::api& stack, const char* name, Digest hash=Digest(), size_t read_block_size=sw::detail::file_read_block_size)
+  {
+    bool isfile;
+    digest_output output;
+    if(!get_digest_options(stack, 1, isfile, output)) {
+      return stack.throw_exception(std::string(name) + ": Invalid options, output must be \"hex\", \"buffer\" or \"base64\".");
+    }
+    if(isfile) {
+      if(!stack.is<std::string>(0)) {
+        return stack.throw_exception(std::string(name) + ": First argument must be a string for file checksum calculation.");
+      }
+      const std::string path = stack.get<std::string>(0);
+      if(!sw::detail::read_file_blocks(path.c_str(), true, [&hash](const void* data, size_t size){ hash.update(data, size); }, read_block_size)) {
+        return stack.throw_exception(std::string("Failed to read file for ") + name + " checksum calculation.");
+      }
+    } else {
+      const void* data; size_t size;
+      if(!stack.get_data_view(0, data, size)) {
+        return stack.throw_exception(std::string(name) + " input data have to be a string of buffer");
+      }
+      hash.update(data, size);
+    }
+    uint8_t digest[Digest::digest_size];
+    hash.final_digest(digest);
+    push_digest(stack, digest, Digest::digest_size, output);
+    return 1;
+  }
+
+  /**
+   * Common implementation of the CRC functions `sys.hash.<crc>(data, options)`.
+   */
+  template <typename Acc, typename Fn>
+  int crc_function(duktape::api& stack, const char* name, Fn&& calculate)
+  {
+    digest_output output = digest_output::standard;
+    if(is_options_object(stack, 1) && !get_digest_output(stack, 1, output)) {
+      return stack.throw_exception(std::string(name) + ": Invalid output format (\"hex\", \"buffer\" or \"base64\").");
+    }
+    const void* data; size_t size;
+    if(!stack.get_data_view(0, data, size)) {
+      return stack.throw_exception(std::string(name) + " input data have to be a string of buffer");
+    }
+    push_crc(stack, Acc(calculate(data, size)), output);
+    return 1;
+  }
+
+  /**
+   * XXH3 128 bit adapter with the digest interface.
+   */
+  template <typename=void>
+  struct xxh128_digest : public sw::xxh3
+  {
+    static constexpr size_t digest_size = 16;
+    void final_digest(uint8_t* out) { final_digest128(out); }
+  };
+
+  /**
+   * BLAKE3 using all CPU threads for long inputs.
+   */
+  template <typename=void>
+  struct blake3_digest : public sw::blake3
+  {
+    explicit blake3_digest(unsigned max_threads=std::thread::hardware_concurrency()) : sw::blake3(max_threads)
+    {}
+  };
+  // </editor-fold>
+
+  #if(0 && JSDOC)
+  /**
+   * CRC8 (PEC) of a string or buffer.
+   * (PEC CRC is: polynomial: 0x07, initial value: 0x00, final XOR: 0x00)
+   * Returns a number, or with `options.output` ("hex", "buffer", "base64")
+   * the big endian bytes in that format.
+   *
+   * @param {string|buffer} data
+   * @param {object} [options]
+   * @returns {number|string|buffer}
+   */
+  sys.hash.crc8 = function(data, options) {};
+  #endif
+  template <typename=void>
+  int crc8_wrapper(duktape::api& stack)
+  { return crc_function<uint8_t>(stack, "crc8", [](const void* data, size_t size){ return sw::crc8(data, size); }); }
+
+  #if(0 && JSDOC)
+  /**
+   * CRC16 (USB) of a string or buffer.
+   * (USB CRC is: polynomial: 0x8005, initial value: 0xffff, final XOR: 0xffff)
+   * Returns a number, or with `options.output` ("hex", "buffer", "base64")
+   * the big endian bytes in that format.
+   *
+   * @param {string|buffer} data
+   * @param {object} [options]
+   * @returns {number|string|buffer}
+   */
+  sys.hash.crc16 = function(data, options) {};
+  #endif
+  template <typename=void>
+  int crc16_wrapper(duktape::api& stack)
+  { return crc_function<uint16_t>(stack, "crc16", [](const void* data, size_t size){ return sw::crc16::calculate(data, size); }); }
+
+  #if(0 && JSDOC)
+  /**
+   * CRC32 (CITT) of a string or buffer.
+   * Returns a number, or with `options.output` ("hex", "buffer", "base64")
+   * the big endian bytes in that format.
+   *
+   * @param {string|buffer} data
+   * @param {object} [options]
+   * @returns {number|string|buffer}
+   */
+  sys.hash.crc32 = function(data, options) {};
+  #endif
+  template <typename=void>
+  int crc32_wrapper(duktape::api& stack)
+  { return crc_function<uint32_t>(stack, "crc32", [](const void* data, size_t size){ return sw::crc32::calculate(data, size); }); }
+
+  #if(0 && JSDOC)
+  /**
+   * CRC32C (Castagnoli) of a string or buffer.
+   * (polynomial: 0x1EDC6F41 (reflected 0x82F63B78), initial value: 0xffffffff, final XOR: 0xffffffff)
+   * Returns a number, or with `options.output` ("hex", "buffer", "base64")
+   * the big endian bytes in that format.
+   *
+   * @param {string|buffer} data
+   * @param {object} [options]
+   * @returns {number|string|buffer}
+   */
+  sys.hash.crc32c = function(data, options) {};
+  #endif
+  template <typename=void>
+  int crc32c_wrapper(duktape::api& stack)
+  { return crc_function<uint32_t>(stack, "crc32c", [](const void* data, size_t size){ return sw::crc32c::calculate(data, size); }); }
+
   #if(0 && JSDOC)
   /**
    * MD5 of a string, buffer or file (if `isfile==true`).
+   * Instead of `isfile`, an options object `{file:boolean, output:string}`
+   * can be passed, where `output` is "hex" (default), "buffer" (the raw
+   * digest bytes as fixed size buffer) or "base64".
    *
    * @param {string|buffer} data
-   * @param {boolean} [isfile=false]
-   * @returns {string}
+   * @param {boolean|object} [isfile=false]
+   * @returns {string|buffer}
    */
   sys.hash.md5 = function(data, isfile) {};
   #endif
   template <typename=void>
   int md5_wrapper(duktape::api& stack)
-  {
-    if(stack.is<bool>(1) && stack.get<bool>(1)) {
-      if(!stack.is<std::string>(0)) {
-        return stack.throw_exception("md5: First argument must be a string for file checksum calculation.");
-      } else {
-        std::string cksum = sw::md5::file(stack.get<std::string>(0));
-        if(cksum.empty()) {
-          return stack.throw_exception("Failed to read file for MD5 checksum calculation.");
-        } else {
-          stack.push(cksum);
-          return 1;
-        }
-      }
-    } else if(stack.is<std::string>(0)) {
-      stack.push(sw::md5::calculate(stack.to<std::string>(0)));
-      return 1;
-    } else if(stack.is_buffer(0) || stack.is_buffer_data(0)) {
-      auto buffer = stack.buffer<std::vector<char>>(0);
-      stack.push(sw::md5::calculate(buffer.data(), buffer.size()));
-      return 1;
-    } else {
-      return stack.throw_exception("md5 input data have to be a string of buffer");
-    }
-  }
+  { return digest_function<sw::md5>(stack, "MD5"); }
 
   #if(0 && JSDOC)
   /**
    * SHA1 of a string, buffer or file (if `isfile==true`).
+   * Instead of `isfile`, an options object `{file:boolean, output:string}`
+   * can be passed, where `output` is "hex" (default), "buffer" (the raw
+   * digest bytes as fixed size buffer) or "base64".
    *
    * @param {string|buffer} data
-   * @param {boolean} [isfile=false]
-   * @returns {string}
+   * @param {boolean|object} [isfile=false]
+   * @returns {string|buffer}
    */
   sys.hash.sha1 = function(data, isfile) {};
   #endif
   template <typename=void>
   int sha1_wrapper(duktape::api& stack)
+  { return digest_function<sw::sha1>(stack, "SHA1"); }
+
+  #if(0 && JSDOC)
+  /**
+   * SHA256 of a string, buffer or file (if `isfile==true`).
+   * Instead of `isfile`, an options object `{file:boolean, output:string}`
+   * can be passed, where `output` is "hex" (default), "buffer" (the raw
+   * digest bytes as fixed size buffer) or "base64".
+   *
+   * @param {string|buffer} data
+   * @param {boolean|object} [isfile=false]
+   * @returns {string|buffer}
+   */
+  sys.hash.sha256 = function(data, isfile) {};
+  #endif
+  template <typename=void>
+  int sha256_wrapper(duktape::api& stack)
+  { return digest_function<sw::sha256>(stack, "SHA256"); }
+
+  #if(0 && JSDOC)
+  /**
+   * SHA512 of a string, buffer or file (if `isfile==true`).
+   * Instead of `isfile`, an options object `{file:boolean, output:string}`
+   * can be passed, where `output` is "hex" (default), "buffer" (the raw
+   * digest bytes as fixed size buffer) or "base64".
+   *
+   * @param {string|buffer} data
+   * @param {boolean|object} [isfile=false]
+   * @returns {string|buffer}
+   */
+  sys.hash.sha512 = function(data, isfile) {};
+  #endif
+  template <typename=void>
+  int sha512_wrapper(duktape::api& stack)
+  { return digest_function<sw::sha512>(stack, "SHA512"); }
+
+  #if(0 && JSDOC)
+  /**
+   * XXH3 of a string, buffer or file (if `isfile==true`).
+   * XXH3 is a 64 bit non-cryptographic hash for deduplication, sharding or
+   * change detection, not suitable for security purposes. The hex result
+   * (16 digits, big endian as printed by `xxhsum -H3`) does not lose
+   * precision like a number would. Use e.g. `parseInt(h.substr(0,8), 16)`
+   * for a 32 bit shard key.
+   * Instead of `isfile`, an options object `{file:boolean, output:string}`
+   * can be passed, where `output` is "hex" (default), "buffer" (the raw
+   * digest bytes as fixed size buffer) or "base64".
+   *
+   * @param {string|buffer} data
+   * @param {boolean|object} [isfile=false]
+   * @returns {string|buffer}
+   */
+  sys.hash.xxh3 = function(data, isfile) {};
+  #endif
+  template <typename=void>
+  int xxh3_wrapper(duktape::api& stack)
+  { return digest_function<sw::xxh3>(stack, "XXH3"); }
+
+  #if(0 && JSDOC)
+  /**
+   * XXH128 of a string, buffer or file (if `isfile==true`).
+   * 128 bit variant of XXH3, hex result with the high 64 bits first.
+   * Instead of `isfile`, an options object `{file:boolean, output:string}`
+   * can be passed, where `output` is "hex" (default), "buffer" (the raw
+   * digest bytes as fixed size buffer) or "base64".
+   *
+   * @param {string|buffer} data
+   * @param {boolean|object} [isfile=false]
+   * @returns {string|buffer}
+   */
+  sys.hash.xxh128 = function(data, isfile) {};
+  #endif
+  template <typename=void>
+  int xxh128_wrapper(duktape::api& stack)
+  { return digest_function<xxh128_digest<>>(stack, "XXH128"); }
+
+  #if(0 && JSDOC)
+  /**
+   * BLAKE3 (256 bit) of a string, buffer or file (if `isfile==true`).
+   * Cryptographic hash, faster than SHA256 and SHA512 on one core, and
+   * inputs from about 2MB are hashed with several threads (tree mode).
+   * Instead of `isfile`, an options object can be passed:
+   *
+   *  - file:    {boolean} The data argument is a file path.
+   *  - output:  {string} "hex" (default), "buffer" (the raw digest bytes as
+   *             fixed size buffer) or "base64".
+   *  - threads: {number} Maximum number of threads, default: number of CPU
+   *             threads.
+   *
+   * @param {string|buffer} data
+   * @param {boolean|object} [isfile=false]
+   * @returns {string|buffer}
+   */
+  sys.hash.blake3 = function(data, isfile) {};
+  #endif
+  template <typename=void>
+  int blake3_wrapper(duktape::api& stack)
   {
-    if(stack.is<bool>(1) && stack.get<bool>(1)) {
-      if(!stack.is<std::string>(0)) {
-        return stack.throw_exception("SHA1: First argument must be a string for file checksum calculation.");
-      } else {
-        std::string cksum = sw::sha1::file(stack.get<std::string>(0));
-        if(cksum.empty()) {
-          return stack.throw_exception("Failed to read file for SHA1 checksum calculation.");
-        } else {
-          stack.push(cksum);
-          return 1;
+    int threads = int(std::thread::hardware_concurrency());
+    if(stack.is_object(1)) threads = stack.get_prop_string<int>(1, "threads", threads);
+    if(threads < 1) threads = 1;
+    if(threads > 64) threads = 64;
+    const unsigned max_threads = unsigned(threads);
+    const blake3_digest<> hash(max_threads);
+    return digest_function(stack, "BLAKE3", hash, hash.read_block_size());
+  }
+
+  // <editor-fold desc="hash objects" defaultstate="collapsed">
+  /**
+   * Native state of incremental hash objects (`sys.hash.create()`).
+   */
+  struct hasher
+  {
+    virtual ~hasher() {}
+    virtual void update(const void* data, size_t size) = 0;
+    virtual void digest(duktape::api& stack, digest_output output) = 0; // pushes the result, resets the state.
+    virtual size_t digest_bytes(uint8_t* out) = 0; // writes the binary digest (max. 64 bytes), returns its size, resets the state.
+  };
+
+  template <typename Crc, typename Acc>
+  struct crc_hasher : public hasher
+  {
+    Acc crc = Crc::initial_value();
+    void update(const void* data, size_t size) override { crc = Crc::update(crc, data, size); }
+    void digest(duktape::api& stack, digest_output output) override { push_crc(stack, Acc(crc ^ Crc::final_xor()), output); crc = Crc::initial_value(); }
+    size_t digest_bytes(uint8_t* out) override
+    {
+      const Acc r = Acc(crc ^ Crc::final_xor());
+      for(size_t i = 0; i < sizeof(Acc); ++i) out[i] = uint8_t(uint64_t(r) >> (8*(sizeof(Acc)-1-i)));
+      crc = Crc::initial_value();
+      return sizeof(Acc);
+    }
+  };
+
+  template <typename=void>
+  struct crc8_hasher : public hasher
+  {
+    uint16_t crc = 0;
+    void update(const void* data, size_t size) override { crc = sw::crc8_update(crc, data, size); }
+    void digest(duktape::api& stack, digest_output output) override { push_crc(stack, uint8_t(crc >> 8), output); crc = 0; }
+    size_t digest_bytes(uint8_t* out) override { out[0] = uint8_t(crc >> 8); crc = 0; return 1; }
+  };
+
+  template <typename Digest>
+  struct digest_hasher : public hasher
+  {
+    Digest hash;
+    void update(const void* data, size_t size) override { hash.update(data, size); }
+    void digest(duktape::api& stack, digest_output output) override
+    { uint8_t d[Digest::digest_size]; push_digest(stack, d, digest_bytes(d), output); }
+    size_t digest_bytes(uint8_t* out) override
+    { hash.final_digest(out); return Digest::digest_size; }
+  };
+
+  /**
+   * Returns a new hasher for the given algorithm name, nullptr if the
+   * algorithm is not known.
+   * @param const std::string& algorithm
+   * @return hasher*
+   */
+  template <typename=void>
+  hasher* create_hasher(const std::string& algorithm)
+  {
+    if(algorithm == "md5") return new digest_hasher<sw::md5>();
+    if(algorithm == "sha1") return new digest_hasher<sw::sha1>();
+    if(algorithm == "sha256") return new digest_hasher<sw::sha256>();
+    if(algorithm == "sha512") return new digest_hasher<sw::sha512>();
+    if(algorithm == "crc32") return new crc_hasher<sw::crc32, uint32_t>();
+    if(algorithm == "crc32c") return new crc_hasher<sw::crc32c, uint32_t>();
+    if(algorithm == "crc16") return new crc_hasher<sw::crc16, uint16_t>();
+    if(algorithm == "crc8") return new crc8_hasher<>();
+    if(algorithm == "xxh3") return new digest_hasher<sw::xxh3>();
+    if(algorithm == "xxh128") return new digest_hasher<xxh128_digest<>>();
+    if(algorithm == "blake3") return new digest_hasher<blake3_digest<>>();
+    return nullptr;
+  }
+
+  /**
+   * Returns the native hasher of the object at the given index, nullptr if
+   * the object is not a hash object (or already finalized).
+   */
+  template <typename=void>
+  hasher* get_hasher(duktape::api& stack, duktape::api::index_t index)
+  {
+    hasher* h = nullptr;
+    if(stack.is_object(index) && stack.get_prop_string_hidden(index, "hasher")) {
+      h = reinterpret_cast<hasher*>(stack.get_pointer(-1));
+    }
+    stack.pop();
+    return h;
+  }
+
+  template <typename=void>
+  duk_ret_t hasher_finalizer(duk_context *ctx)
+  {
+    duktape::api stack(ctx);
+    hasher* h = get_hasher(stack, 0);
+    if(h) {
+      stack.push_pointer(nullptr);
+      stack.put_prop_string_hidden(0, "hasher");
+      delete h;
+    }
+    return 0;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Creates an incremental hash object for the given algorithm
+   * ("md5", "sha1", "sha256", "sha512", "crc32", "crc32c", "crc16", "crc8", "xxh3", "xxh128", "blake3").
+   * Data are added with `update()`, the result is returned by `digest()`,
+   * so that streamed data do not need to be concatenated in memory:
+   *
+   *  var h = sys.hash.create("sha1");
+   *  var f = new fs.file(path, "rb");
+   *  var chunk;
+   *  while((chunk = f.read(65536)) !== undefined) h.update(chunk);
+   *  f.close();
+   *  var digest = h.digest();
+   *
+   * @throws {Error}
+   * @param {string} algorithm
+   * @returns {sys.hash.create}
+   */
+  sys.hash.create = function(algorithm) {};
+  #endif
+  template <typename=void>
+  int hasher_create(duktape::api& stack)
+  {
+    const std::string algorithm = stack.is<std::string>(0) ? stack.get<std::string>(0) : std::string();
+    if(algorithm.empty()) return stack.throw_exception("sys.hash.create(): Need a hash algorithm name (e.g. \"sha1\").");
+    hasher* h = create_hasher(algorithm);
+    if(!h) return stack.throw_exception(std::string("sys.hash.create(): Unknown hash algorithm '") + algorithm + "'");
+    stack.top(0);
+    stack.push_object();
+    stack.push_pointer(h);
+    stack.put_prop_string_hidden(0, "hasher");
+    stack.push_c_function(hasher_finalizer<>, 1);
+    stack.set_finalizer(0);
+    stack.get_global_string("sys");
+    stack.get_prop_string(-1, "hash");
+    stack.get_prop_string(-1, "create");
+    stack.get_prop_string(-1, "prototype");
+    stack.set_prototype(0);
+    stack.top(1);
+    stack.push(algorithm);
+    stack.put_prop_string(0, "algorithm");
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Adds data (string or buffer) to the hash. Returns `this`.
+   *
+   * @throws {Error}
+   * @param {string|buffer} data
+   * @returns {sys.hash.create}
+   */
+  sys.hash.create.prototype.update = function(data) {};
+  #endif
+  template <typename=void>
+  int hasher_update(duktape::api& stack)
+  {
+    stack.top(1);
+    stack.push_this();
+    hasher* h = get_hasher(stack, 1);
+    if(!h) return stack.throw_exception("update(): Not a hash object (use sys.hash.create()).");
+    const void* data; size_t size;
+    if(!stack.get_data_view(0, data, size)) return stack.throw_exception("update(): Data have to be a string or buffer.");
+    h->update(data, size);
+    return 1;
+  }
+
+  #if(0 && JSDOC)
+  /**
+   * Returns the hash of all data added so far (hex string for MD5/SHA/XXH3/BLAKE3,
+   * number for CRCs), and resets the object for reuse. The optional `output`
+   * ("hex", "buffer", "base64", or `{output:...}`) selects the format, as
+   * for `sys.hash.sha1()`.
+   *
+   * @throws {Error}
+   * @param {string|object} [output]
+   * @returns {string|number|buffer}
+   */
+  sys.hash.create.prototype.digest = function(output) {};
+  #endif
+  template <typename=void>
+  int hasher_digest(duktape::api& stack)
+  {
+    stack.top(1);
+    digest_output output;
+    if(!get_digest_output(stack, 0, output)) return stack.throw_exception("digest(): Invalid output format (\"hex\", \"buffer\" or \"base64\").");
+    stack.push_this();
+    hasher* h = get_hasher(stack, 1);
+    if(!h) return stack.throw_exception("digest(): Not a hash object (use sys.hash.create()).");
+    h->digest(stack, output);
+    return 1;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="batch file hashing" defaultstate="collapsed">
+  /**
+   * Hashes the given files with `num_threads` workers (the calling thread
+   * included). Each worker owns its file buffer, the number of threads
+   * bounds the number of concurrently open/read files. The hashers are
+   * created beforehand and only updated by the workers, digests are
+   * taken afterwards (need the JS stack). Per file errors are recorded
+   * as `errno` (or -1) in `errors`.
+   */
+  template <typename=void>
+  void hash_files(const std::vector<std::string>& paths, std::vector<std::unique_ptr<hasher>>& hashers, std::vector<int>& errors, unsigned num_threads)
+  {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+      for(size_t i = next++; i < paths.size(); i = next++) {
+        hasher* h = hashers[i].get();
+        errno = 0;
+        if(!sw::detail::read_file_blocks(paths[i].c_str(), true, [h](const void* data, size_t size){ h->update(data, size); })) {
+          errors[i] = errno ? errno : -1;
         }
       }
-    } else if(stack.is<std::string>(0)) {
-      stack.push(sw::sha1::calculate(stack.to<std::string>(0)));
-      return 1;
-    } else if(stack.is_buffer(0) || stack.is_buffer_data(0)) {
-      auto buffer = stack.buffer<std::vector<char>>(0);
-      stack.push(sw::sha1::calculate(buffer.data(), buffer.size()));
-      return 1;
-    } else {
-      return stack.throw_exception("SHA1 input data have to be a string of buffer");
+    };
+    std::vector<std::thread> threads;
+    try {
+      for(unsigned i = 1; i < num_threads; ++i) threads.emplace_back(worker);
+    } catch(const std::system_error&) {
+      // Continue with the threads we got.
     }
+    worker();
+    for(auto& t: threads) t.join();
   }
 
   #if(0 && JSDOC)
   /**
-   * SHA512 of a string, buffer or file (if `isfile==true`).
+   * Hashes many files in parallel with the given algorithm (see
+   * `sys.hash.create()`, default "sha1"). `paths` is either an array
+   * of file paths, or a directory path, which is scanned using
+   * `fs.find(path, options.find)` (default: all regular files).
    *
-   * @param {string|buffer} data
-   * @param {boolean} [isfile=false]
-   * @returns {string}
+   * Options:
+   *
+   *  - threads: {number} Number of files hashed (read) concurrently,
+   *             default: number of CPU threads.
+   *
+   *  - array:   {boolean} Return an array of `{path:, digest:}` objects
+   *             in the order of the input paths, instead of an object
+   *             with the paths as keys and the digests as values.
+   *
+   *  - find:    {string|object} `fs.find()` options when scanning a directory.
+   *
+   *  - output:  {string} Digest format "hex", "buffer" or "base64" (see `sys.hash.sha1()`).
+   *
+   * Files that cannot be read do not abort the batch, their result is
+   * `{error: message}` (respectively `{path:, error:}` in array mode).
+   *
+   *  var sums = sys.hash.files("/data/artifacts", "sha256");
+   *  var list = sys.hash.files(manifest_paths, "md5", {threads:4, array:true});
+   *
+   * @throws {Error}
+   * @param {array|string} paths
+   * @param {string} [algorithm="sha1"]
+   * @param {object} [options]
+   * @returns {object|array}
    */
-  sys.hash.sha1 = function(data, isfile) {};
+  sys.hash.files = function(paths, algorithm, options) {};
   #endif
   template <typename=void>
-  int sha512_wrapper(duktape::api& stack)
+  int hash_files_wrapper(duktape::api& stack)
   {
-    if(stack.is<bool>(1) && stack.get<bool>(1)) {
-      if(!stack.is<std::string>(0)) {
-        return stack.throw_exception("SHA512: First argument must be a string for file checksum calculation.");
+    stack.top(3);
+    const std::string algorithm = stack.is_undefined(1) ? std::string("sha1") : stack.to<std::string>(1);
+    unsigned num_threads = std::thread::hardware_concurrency();
+    bool as_array = false;
+    digest_output output = digest_output::standard;
+    if(stack.is_object(2)) {
+      const int n = stack.get_prop_string<int>(2, "threads", int(num_threads));
+      num_threads = (n > 0) ? unsigned(n) : 1u;
+      as_array = stack.get_prop_string<bool>(2, "array", as_array);
+      if(!get_digest_output(stack, 2, output)) return stack.throw_exception("sys.hash.files(): Invalid output format (\"hex\", \"buffer\" or \"base64\").");
+    } else if(!stack.is_undefined(2) && !stack.is_null(2)) {
+      return stack.throw_exception("sys.hash.files(): Options must be an object.");
+    }
+    std::vector<std::string> paths;
+    if(stack.is<std::string>(0)) {
+      if(!stack.get_global_string("fs") || !stack.get_prop_string(-1, "find") || !stack.is_function(-1)) {
+        return stack.throw_exception("sys.hash.files(): Directory scanning needs fs.find(), pass a list of files instead.");
+      }
+      stack.dup(0);
+      if(stack.is_object(2) && stack.has_prop_string(2, "find")) {
+        stack.get_prop_string(2, "find");
       } else {
-        std::string cksum = sw::sha512::file(stack.get<std::string>(0));
-        if(cksum.empty()) {
-          return stack.throw_exception("Failed to read file for SHA512 checksum calculation.");
-        } else {
-          stack.push(cksum);
-          return 1;
-        }
+        stack.push_object();
+        stack.push("f");
+        stack.put_prop_string(-2, "type");
+      }
+      stack.call(2);
+      if(!stack.is_array(-1)) return stack.throw_exception("sys.hash.files(): Failed to scan the directory.");
+      paths = stack.get<std::vector<std::string>>(-1);
+      stack.top(3);
+    } else if(stack.is_array(0)) {
+      paths = stack.get<std::vector<std::string>>(0);
+      if(paths.size() != size_t(stack.get_length(0))) {
+        return stack.throw_exception("sys.hash.files(): All paths must be strings.");
       }
-    } else if(stack.is<std::string>(0)) {
-      stack.push(sw::sha512::calculate(stack.to<std::string>(0)));
-      return 1;
-    } else if(stack.is_buffer(0) || stack.is_buffer_data(0)) {
-      auto buffer = stack.buffer<std::vector<char>>(0);
-      stack.push(sw::sha512::calculate(buffer.data(), buffer.size()));
-      return 1;
     } else {
-      return stack.throw_exception("SHA512 input data have to be a string of buffer");
+      return stack.throw_exception("sys.hash.files(): First argument must be an array of paths or a directory.");
+    }
+    std::vector<std::unique_ptr<hasher>> hashers(paths.size());
+    for(auto& h: hashers) {
+      h.reset(create_hasher(algorithm));
+      if(!h) return stack.throw_exception(std::string("sys.hash.files(): Unknown hash algorithm '") + algorithm + "'");
+    }
+    std::vector<int> errors(paths.size(), 0);
+    if(num_threads < 1) num_threads = 1;
+    if(num_threads > 64) num_threads = 64;
+    if(num_threads > paths.size()) num_threads = unsigned(paths.size());
+    hash_files(paths, hashers, errors, num_threads);
+    const auto result = as_array ? stack.push_array() : stack.push_object();
+    for(size_t i = 0; i < paths.size(); ++i) {
+      if(as_array) {
+        stack.push_object();
+        stack.push(paths[i]);
+        stack.put_prop_string(-2, "path");
+      }
+      if(!errors[i]) {
+        hashers[i]->digest(stack, output);
+        if(as_array) stack.put_prop_string(-2, "digest");
+      } else {
+        if(!as_array) stack.push_object();
+        stack.push(std::string("Failed to read file") + ((errors[i] > 0) ? (std::string(": ") + ::strerror(errors[i])) : std::string()));
+        stack.put_prop_string(-2, "error");
+      }
+      if(as_array) {
+        stack.put_prop_index(result, duktape::api::array_index_t(i));
+      } else {
+        stack.put_prop_string(result, paths[i]);
+      }
     }
+    return 1;
   }
+  // </editor-fold>
+
 
 }}}}
 
@@ -1286,12 +3965,26 @@ namespace duktape { namespace mod { namespace system { namespace hash {
   template <typename=void>
   static void define_in(duktape::engine& js)
   {
-    js.define("sys.hash.crc8", crc8_wrapper, 1);
-    js.define("sys.hash.crc16", crc16_wrapper, 1);
-    js.define("sys.hash.crc32", crc32_wrapper, 1);
+    js.define("sys.hash.crc8", crc8_wrapper, 2);
+    js.define("sys.hash.crc16", crc16_wrapper, 2);
+    js.define("sys.hash.crc32", crc32_wrapper, 2);
+    js.define("sys.hash.crc32c", crc32c_wrapper, 2);
     js.define("sys.hash.md5", md5_wrapper, 2);
     js.define("sys.hash.sha1", sha1_wrapper, 2);
+    js.define("sys.hash.sha256", sha256_wrapper, 2);
     js.define("sys.hash.sha512", sha512_wrapper, 2);
+    js.define("sys.hash.xxh3", xxh3_wrapper, 2);
+    js.define("sys.hash.xxh128", xxh128_wrapper, 2);
+    js.define("sys.hash.blake3", blake3_wrapper<>, 2);
+    js.define("sys.hash.create", hasher_create<>, 1);
+    js.define("sys.hash.files", hash_files_wrapper<>, 3);
+    {
+      auto flags = js.define_flags();
+      js.define_flags(duktape::engine::defflags::restricted);
+      js.define("sys.hash.create.prototype.update", hasher_update<>, 1);
+      js.define("sys.hash.create.prototype.digest", hasher_digest<>, 1);
+      js.define_flags(flags);
+    }
   }
   // </editor-fold>
 
@@ -0,0 +1,504 @@
+/**
+ * @file duktape/mod/mod.sys.hash.tree.hh
+ * @package de.atwillys.cc.duktape
+ * @license MIT
+ * @authors Stefan Wilhelm (stfwi, <cerbero s@atwillys.de>)
+ * @platform linux, bsd, windows
+ * @standard >= c++11
+ * @requires duk_config.h duktape.h duktape.c >= v2.1
+ * @requires Duktape CFLAGS -DDUK_USE_CPP_EXCEPTIONS
+ * @cxxflags -std=c++11 -W -Wall -Wextra -pedantic -fstrict-aliasing
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Duktape ECMA engine C++ wrapper, directory tree digest `sys.hash.tree()`.
+ *
+ * Combines the hash functions (mod.sys.hash.hh) with the directory recursion
+ * of the extended file system module (mod.fs.ext.hh), therefore a separate
+ * module. Unchanged files can be looked up in an on-disk cache instead of
+ * being read again.
+ *
+ * -----------------------------------------------------------------------------
+ * License: http://opensource.org/licenses/MIT
+ * Copyright (c) 2014-2017, the authors (see the @authors tag in this file).
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions: The above copyright notice and
+ * this permission notice shall be included in all copies or substantial portions
+ * of the Software. THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef DUKTAPE_MOD_SYS_HASH_TREE_HH
+#define DUKTAPE_MOD_SYS_HASH_TREE_HH
+
+#include "mod.sys.hash.hh"
+#include "mod.fs.ext.hh"
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <ctime>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+
+namespace duktape { namespace detail { namespace system { namespace hash { namespace tree {
+
+  // <editor-fold desc="tree scan" defaultstate="collapsed">
+  /**
+   * Entry of a scanned tree. `rel` is the path relative to the root with
+   * "/" separators, `type` is 'f' (regular file), 'd' (directory) or 'l'
+   * (symbolic link), `digest` the binary digest.
+   */
+  struct tree_entry
+  {
+    std::string rel;
+    char type;
+    uint64_t dev, ino, size;
+    int64_t mtime_ns;
+    std::string digest;
+  };
+
+  /**
+   * Shell wildcard match (`*`, `?`) of a whole string.
+   * @param const char* pattern
+   * @param const char* s
+   * @return bool
+   */
+  template <typename=void>
+  bool wildcard_match(const char* pattern, const char* s)
+  {
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while(*s) {
+      if(*pattern == '*') {
+        star = pattern++;
+        resume = s;
+      } else if((*pattern == '?') || (*pattern == *s)) {
+        ++pattern; ++s;
+      } else if(star) {
+        pattern = star + 1;
+        s = ++resume;
+      } else {
+        return false;
+      }
+    }
+    while(*pattern == '*') ++pattern;
+    return !*pattern;
+  }
+
+  /**
+   * True if one of the patterns matches the relative path or the file name.
+   */
+  template <typename=void>
+  bool is_excluded(const std::vector<std::string>& patterns, const std::string& rel)
+  {
+    const auto p = rel.rfind('/');
+    const char* name = rel.c_str() + ((p == rel.npos) ? 0 : (p+1));
+    for(const auto& pattern: patterns) {
+      if(wildcard_match(pattern.c_str(), rel.c_str()) || wildcard_match(pattern.c_str(), name)) return true;
+    }
+    return false;
+  }
+
+  /**
+   * Collects all regular files, directories and symbolic links below `root`
+   * (not following links), in the order of `recurse_directory()`. Excluded
+   * directories are skipped with all their contents. Returns false with
+   * `error` set if the directory could not be read.
+   *
+   * @param const std::string& root
+   * @param const std::vector<std::string>& excludes
+   * @param std::vector<tree_entry>& entries
+   * @param std::string& error
+   * @return bool
+   */
+  template <typename=void>
+  bool scan_tree(const std::string& root, const std::vector<std::string>& excludes, std::vector<tree_entry>& entries, std::string& error)
+  {
+    const size_t prefix_length = (root.size() > 1 && root.back() != '/') ? (root.size()+1) : root.size();
+    std::vector<std::string> excluded_dirs;
+    return ::duktape::detail::filesystem::extended::recurse_directory(
+      root, std::string(), std::string(), std::numeric_limits<int>::max(), true, true, false,
+      [&](std::string&& path) -> bool {
+        if(path.size() <= prefix_length) return true;
+        const int errno_before = errno; // recurse_directory() reports errno
+        tree_entry e;
+        e.rel = path.substr(prefix_length);
+        #ifdef WINDOWS
+        std::replace(e.rel.begin(), e.rel.end(), '\\', '/');
+        #endif
+        for(const auto& dir: excluded_dirs) {
+          if(e.rel.compare(0, dir.size(), dir) == 0) return true;
+        }
+        struct ::stat st;
+        #ifndef WINDOWS
+        const bool stat_ok = (::lstat(path.c_str(), &st) == 0);
+        #else
+        const bool stat_ok = (::stat(path.c_str(), &st) == 0);
+        #endif
+        errno = errno_before;
+        if(!stat_ok) return true;
+        if(S_ISDIR(st.st_mode)) {
+          e.type = 'd';
+        } else if(S_ISLNK(st.st_mode)) {
+          e.type = 'l';
+        } else if(S_ISREG(st.st_mode)) {
+          e.type = 'f';
+        } else {
+          return true;
+        }
+        if(is_excluded(excludes, e.rel)) {
+          if(e.type == 'd') excluded_dirs.push_back(e.rel + "/");
+          return true;
+        }
+        e.dev = uint64_t(st.st_dev);
+        e.ino = uint64_t(st.st_ino);
+        e.size = uint64_t(st.st_size);
+        #ifdef MACINTOSH
+        e.mtime_ns = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + int64_t(st.st_mtimespec.tv_nsec);
+        #elif defined(WINDOWS)
+        e.mtime_ns = int64_t(st.st_mtime) * 1000000000;
+        #else
+        e.mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + int64_t(st.st_mtim.tv_nsec);
+        #endif
+        entries.push_back(std::move(e));
+        return true;
+      },
+      [&](const std::string& message) { error = message; }
+    );
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="re-hash cache" defaultstate="collapsed">
+  /**
+   * Cache of file digests keyed by (device, inode, size, mtime in ns).
+   * The cache file is a text file with a header line naming the algorithm,
+   * followed by one line "<dev> <ino> <size> <mtime_ns> <hex digest>" per
+   * file. Only the files of the last run are stored.
+   */
+  typedef std::tuple<uint64_t, uint64_t, uint64_t, int64_t> cache_key;
+  typedef std::map<cache_key, std::string> cache_map;
+
+  template <typename=void>
+  std::string cache_header(const std::string& algorithm)
+  { return std::string("#duktape-cc sys.hash.tree v1 ") + algorithm; }
+
+  /**
+   * Loads the cache, a missing or unmatching cache file results in an
+   * empty cache.
+   */
+  template <typename=void>
+  void read_cache(const std::string& path, const std::string& algorithm, cache_map& cache)
+  {
+    std::ifstream is(path.c_str());
+    std::string line;
+    if(!std::getline(is, line) || (line != cache_header(algorithm))) return;
+    while(std::getline(is, line)) {
+      std::istringstream ss(line);
+      uint64_t dev, ino, size;
+      int64_t mtime_ns;
+      std::string hex;
+      if(!(ss >> dev >> ino >> size >> mtime_ns >> hex) || hex.empty()) continue;
+      std::string digest(sw::encoding::unhex_size(hex.size()), '\0');
+      const size_t n = sw::encoding::unhex(hex.data(), hex.size(), &digest[0]);
+      if(n == size_t(-1) || n == 0) continue;
+      digest.resize(n);
+      cache[cache_key(dev, ino, size, mtime_ns)] = digest;
+    }
+  }
+
+  /**
+   * Writes the file digests to a temporary file and renames it to the cache
+   * path. Files modified less than two seconds before `scan_time` are not
+   * stored, as they may still change within the timestamp granularity
+   * without changing their mtime.
+   */
+  template <typename=void>
+  bool write_cache(const std::string& path, const std::string& algorithm, const std::vector<tree_entry>& entries, std::time_t scan_time)
+  {
+    const std::string tmp = path + ".tmp";
+    const int64_t racy_ns = (int64_t(scan_time) - 2) * 1000000000;
+    {
+      std::ofstream os(tmp.c_str(), std::ios::out|std::ios::trunc);
+      if(!os.good()) return false;
+      os << cache_header(algorithm) << "\n";
+      for(const auto& e: entries) {
+        if((e.type != 'f') || (e.mtime_ns >= racy_ns)) continue;
+        os << e.dev << ' ' << e.ino << ' ' << e.size << ' ' << e.mtime_ns << ' '
+           << sw::encoding::hex(e.digest.data(), e.digest.size()) << "\n";
+      }
+      os.flush();
+      if(!os.good()) { os.close(); ::remove(tmp.c_str()); return false; }
+    }
+    #ifdef WINDOWS
+    ::remove(path.c_str());
+    #endif
+    if(::rename(tmp.c_str(), path.c_str()) != 0) { ::remove(tmp.c_str()); return false; }
+    return true;
+  }
+  // </editor-fold>
+
+  // <editor-fold desc="merkle digest" defaultstate="collapsed">
+  /**
+   * Returns the base name of a relative path.
+   */
+  template <typename=void>
+  std::string entry_name(const std::string& rel)
+  { const auto p = rel.rfind('/'); return (p == rel.npos) ? rel : rel.substr(p+1); }
+
+  /**
+   * Returns the parent of a relative path ("" for the root).
+   */
+  template <typename=void>
+  std::string entry_parent(const std::string& rel)
+  { const auto p = rel.rfind('/'); return (p == rel.npos) ? std::string() : rel.substr(0, p); }
+
+  /**
+   * Directory digest: hash over all children sorted by name, each child
+   * contributing `<type><name>\0<digest>`. Directories are processed deepest
+   * first, so that the digests of subdirectories are known. Returns the
+   * root digest.
+   */
+  template <typename=void>
+  std::string merkle_digest(std::vector<tree_entry>& entries, const std::string& algorithm)
+  {
+    std::map<std::string, std::vector<size_t>> children;
+    std::map<std::string, size_t> dirs;
+    for(size_t i = 0; i < entries.size(); ++i) {
+      children[entry_parent(entries[i].rel)].push_back(i);
+      if(entries[i].type == 'd') dirs[entries[i].rel] = i;
+    }
+    std::vector<std::string> order;
+    for(const auto& d: dirs) order.push_back(d.first);
+    std::stable_sort(order.begin(), order.end(), [](const std::string& a, const std::string& b) {
+      return std::count(a.begin(), a.end(), '/') > std::count(b.begin(), b.end(), '/');
+    });
+    order.push_back(std::string()); // root
+    std::unique_ptr<hasher> h(create_hasher(algorithm));
+    uint8_t digest[64];
+    std::string root_digest;
+    for(const auto& dir: order) {
+      std::vector<size_t>& list = children[dir];
+      std::sort(list.begin(), list.end(), [&entries](size_t a, size_t b) {
+        return entry_name(entries[a].rel) < entry_name(entries[b].rel);
+      });
+      for(auto i: list) {
+        const tree_entry& e = entries[i];
+        const std::string name = entry_name(e.rel);
+        h->update(&e.type, 1);
+        h->update(name.c_str(), name.size()+1);
+        h->update(e.digest.data(), e.digest.size());
+      }
+      const size_t n = h->digest_bytes(digest);
+      if(dir.empty()) {
+        root_digest.assign((const char*)digest, n);
+      } else {
+        entries[dirs[dir]].digest.assign((const char*)digest, n);
+      }
+    }
+    return root_digest;
+  }
+  // </editor-fold>
+
+  #if(0 && JSDOC)
+  /**
+   * Calculates a Merkle digest of a directory tree: Regular files are hashed
+   * by content, symbolic links by their target path (not followed), and each
+   * directory by the names, types and digests of its entries. The root digest
+   * changes if any file content, name or the structure changes, but not if
+   * only timestamps or permissions change.
+   *
+   * Options:
+   *
+   *  - algo:    {string} Hash algorithm (see `sys.hash.create()`), default "sha1".
+   *
+   *  - exclude: {string|array} Wildcard pattern(s) (`*`, `?`) matched against
+   *             the path relative to the root and the file name. Excluded
+   *             directories are skipped with their contents.
+   *
+   *  - cache:   {string} Path of a cache file. File digests are stored keyed
+   *             by (device, inode, size, mtime), so that unchanged files are
+   *             not read again in the next run.
+   *
+   *  - files:   {boolean} Also return the digests of all files.
+   *
+   *  - threads: {number} Number of files hashed concurrently, default: number
+   *             of CPU threads.
+   *
+   *  - output:  {string} Digest format "hex" (default), "buffer" or "base64".
+   *
+   * Returns an object `{digest:, hashed:, cached:}`, where `hashed` and
+   * `cached` are the numbers of files read respectively taken from the cache,
+   * and with `options.files` the file digests as `files: {relative_path: digest}`.
+   *
+   *  var before = sys.hash.tree("/srv/app", {algo:"sha256", exclude:["*.log", ".git"], cache:"/var/cache/app.tree"});
+   *  ... deployment ...
+   *  var after = sys.hash.tree("/srv/app", {algo:"sha256", exclude:["*.log", ".git"], cache:"/var/cache/app.tree"});
+   *  if(before.digest !== after.digest) print("changed");
+   *
+   * @throws {Error}
+   * @param {string} root
+   * @param {object} [options]
+   * @returns {object}
+   */
+  sys.hash.tree = function(root, options) {};
+  #endif
+  template <typename=void>
+  int tree_wrapper(duktape::api& stack)
+  {
+    stack.top(2);
+    if(!stack.is<std::string>(0)) return stack.throw_exception("sys.hash.tree(): First argument must be a directory path.");
+    std::string root = stack.get<std::string>(0);
+    std::string algorithm("sha1");
+    std::string cache_path;
+    std::vector<std::string> excludes;
+    bool with_files = false;
+    unsigned num_threads = std::thread::hardware_concurrency();
+    digest_output output = digest_output::standard;
+    if(stack.is_object(1)) {
+      algorithm = stack.get_prop_string<std::string>(1, "algo", algorithm);
+      cache_path = stack.get_prop_string<std::string>(1, "cache", cache_path);
+      with_files = stack.get_prop_string<bool>(1, "files", with_files);
+      const int n = stack.get_prop_string<int>(1, "threads", int(num_threads));
+      num_threads = (n > 0) ? unsigned(n) : 1u;
+      if(!get_digest_output(stack, 1, output)) return stack.throw_exception("sys.hash.tree(): Invalid output format (\"hex\", \"buffer\" or \"base64\").");
+      stack.get_prop_string(1, "exclude");
+      if(stack.is<std::string>(-1)) {
+        excludes.push_back(stack.get<std::string>(-1));
+      } else if(stack.is_array(-1)) {
+        excludes = stack.get<std::vector<std::string>>(-1);
+        if(excludes.size() != size_t(stack.get_length(-1))) return stack.throw_exception("sys.hash.tree(): Exclude patterns must be strings.");
+      } else if(!stack.is_undefined(-1)) {
+        return stack.throw_exception("sys.hash.tree(): Exclude must be a pattern or an array of patterns.");
+      }
+      stack.top(2);
+    } else if(!stack.is_undefined(1)) {
+      return stack.throw_exception("sys.hash.tree(): Options must be an object.");
+    }
+    {
+      std::unique_ptr<hasher> h(create_hasher(algorithm));
+      if(!h) return stack.throw_exception(std::string("sys.hash.tree(): Unknown hash algorithm '") + algorithm + "'");
+    }
+    while((root.size() > 1) && (root.back() == '/')) root.pop_back();
+    struct ::stat st;
+    if((::stat(root.c_str(), &st) != 0) || !S_ISDIR(st.st_mode)) {
+      return stack.throw_exception(std::string("sys.hash.tree(): Not a directory: '") + root + "'");
+    }
+
+    // Scan, and take unchanged files from the cache.
+    const std::time_t scan_time = std::time(nullptr);
+    std::vector<tree_entry> entries;
+    std::string error;
+    errno = 0;
+    if(!scan_tree(root, excludes, entries, error)) {
+      if(error.empty() && errno) error = ::strerror(errno);
+      return stack.throw_exception(std::string("sys.hash.tree(): Failed to scan '") + root + "'" + (error.empty() ? std::string() : (": " + error)));
+    }
+    cache_map cache;
+    if(!cache_path.empty()) read_cache(cache_path, algorithm, cache);
+    std::vector<size_t> to_hash;
+    size_t num_cached = 0;
+    for(size_t i = 0; i < entries.size(); ++i) {
+      tree_entry& e = entries[i];
+      if(e.type == 'f') {
+        const auto it = cache.find(cache_key(e.dev, e.ino, e.size, e.mtime_ns));
+        if(it != cache.end()) {
+          e.digest = it->second;
+          ++num_cached;
+        } else {
+          to_hash.push_back(i);
+        }
+      } else if(e.type == 'l') {
+        #ifndef WINDOWS
+        const std::string path = root + "/" + e.rel;
+        char target[PATH_MAX];
+        const ssize_t n = ::readlink(path.c_str(), target, sizeof(target));
+        if(n < 0) return stack.throw_exception(std::string("sys.hash.tree(): Failed to read link '") + path + "': " + ::strerror(errno));
+        std::unique_ptr<hasher> h(create_hasher(algorithm));
+        uint8_t digest[64];
+        h->update(target, size_t(n));
+        e.digest.assign((const char*)digest, h->digest_bytes(digest));
+        #endif
+      }
+    }
+
+    // Hash the new/changed files.
+    {
+      std::vector<std::string> paths;
+      std::vector<std::unique_ptr<hasher>> hashers(to_hash.size());
+      for(size_t k = 0; k < to_hash.size(); ++k) {
+        paths.push_back(root + DIRECTORY_SEPARATOR + entries[to_hash[k]].rel);
+        hashers[k].reset(create_hasher(algorithm));
+      }
+      std::vector<int> errors(paths.size(), 0);
+      if(num_threads > 64) num_threads = 64;
+      if(num_threads > paths.size()) num_threads = unsigned(paths.size());
+      if(!paths.empty()) hash_files(paths, hashers, errors, num_threads);
+      for(size_t k = 0; k < to_hash.size(); ++k) {
+        if(errors[k]) {
+          return stack.throw_exception(std::string("sys.hash.tree(): Failed to read file '") + paths[k] + "'" + ((errors[k] > 0) ? (std::string(": ") + ::strerror(errors[k])) : std::string()));
+        }
+        uint8_t digest[64];
+        entries[to_hash[k]].digest.assign((const char*)digest, hashers[k]->digest_bytes(digest));
+      }
+    }
+
+    const std::string root_digest = merkle_digest(entries, algorithm);
+    if(!cache_path.empty() && !write_cache(cache_path, algorithm, entries, scan_time)) {
+      return stack.throw_exception(std::string("sys.hash.tree(): Failed to write cache file '") + cache_path + "'");
+    }
+
+    const auto result = stack.push_object();
+    push_digest(stack, (const uint8_t*)root_digest.data(), root_digest.size(), output);
+    stack.put_prop_string(result, "digest");
+    stack.push(to_hash.size());
+    stack.put_prop_string(result, "hashed");
+    stack.push(num_cached);
+    stack.put_prop_string(result, "cached");
+    if(with_files) {
+      const auto files = stack.push_object();
+      for(const auto& e: entries) {
+        if(e.type != 'f') continue;
+        push_digest(stack, (const uint8_t*)e.digest.data(), e.digest.size(), output);
+        stack.put_prop_string(files, e.rel);
+      }
+      stack.put_prop_string(result, "files");
+    }
+    return 1;
+  }
+
+}}}}}
+
+namespace duktape { namespace mod { namespace system { namespace hash { namespace tree {
+
+  // <editor-fold desc="js decls" defaultstate="collapsed">
+  using namespace ::duktape::detail::system::hash::tree;
+
+  /**
+   * Export main relay. Adds all module functions to the specified engine.
+   * @param duktape::engine& js
+   */
+  template <typename=void>
+  static void define_in(duktape::engine& js)
+  {
+    js.define("sys.hash.tree", tree_wrapper<>, 2);
+  }
+  // </editor-fold>
+
+}}}}}
+
+#endif
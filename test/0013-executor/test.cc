@@ -0,0 +1,103 @@
+/**
+ * Executor: worker pool with one engine per thread.
+ */
+#include "../testenv.hh"
+#include <duktape.executor.hh>
+#include <future>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+void test(duktape::engine& js)
+{
+  (void) js;
+  duktape::executor executor(3, [](duktape::engine& e) {
+    e.eval("function square(x) { return x*x; }");
+    e.eval("function fail(msg) { throw new Error(msg); }");
+  });
+  test_expect(executor.size() == 3);
+
+  // Function calls, converted results.
+  {
+    vector<future<int>> results;
+    for(int i=0; i<100; ++i) results.push_back(executor.submit<int>("square", i));
+    bool ok = true;
+    for(int i=0; i<100; ++i) ok = ok && (results[size_t(i)].get() == i*i);
+    test_expect(ok);
+  }
+
+  // Evaluation and native jobs.
+  test_expect(executor.eval<string>("'a' + 'b'").get() == "ab");
+  test_expect(executor.post([](duktape::engine& e) { return e.call<int>("square", 7) + 1; }).get() == 50);
+
+  // Script errors are rethrown by future::get().
+  {
+    auto f = executor.submit<int>("fail", "expected error");
+    try {
+      f.get();
+      test_fail("Expected duktape::script_error was not thrown.");
+    } catch(const duktape::script_error& e) {
+      test_expect(string(e.what()).find("expected error") != string::npos);
+    } catch(...) {
+      test_fail("Expected duktape::script_error, but another exception was thrown.");
+    }
+  }
+
+  // Statistics
+  {
+    uint64_t jobs = 0;
+    for(const auto& s: executor.stats()) {
+      jobs += s.jobs;
+      test_expect(s.utilisation >= 0 && s.utilisation <= 1);
+    }
+    test_expect(jobs == 103);
+    test_expect(executor.queue_depth() == 0);
+  }
+
+  // Deadline expires while the only worker is busy.
+  {
+    duktape::executor single(1);
+    promise<void> started, gate;
+    shared_future<void> open = gate.get_future().share();
+    auto blocker = single.post([&started, open](duktape::engine&) { started.set_value(); open.wait(); });
+    started.get_future().wait();
+    auto late = single.eval<int>("1", "(eval)", chrono::milliseconds(1));
+    auto in_time = single.eval<int>("2");
+    test_expect(single.queue_depth() == 2);
+    this_thread::sleep_for(chrono::milliseconds(20));
+    gate.set_value();
+    blocker.get();
+    try {
+      late.get();
+      test_fail("Expected duktape::timeout_error was not thrown.");
+    } catch(const duktape::timeout_error&) {
+      test_pass("Expected duktape::timeout_error was thrown.");
+    }
+    test_expect(in_time.get() == 2);
+    test_expect(single.stats()[0].timeouts == 1);
+  }
+
+  // The job deadline applies to all calls of the job together: several
+  // calls, each shorter than the timeout, exceed it in sum.
+  {
+    duktape::executor single(1, [](duktape::engine& e) {
+      e.eval("function busy(ms) { var t=Date.now()+ms; while(Date.now() < t); return ms; }");
+    });
+    auto overrun = single.post([](duktape::engine& e) {
+      int n = 0;
+      for(int i=0; i<10; ++i) n += e.call<int>("busy", 50);
+      return n;
+    }, chrono::milliseconds(200));
+    const auto t0 = chrono::steady_clock::now();
+    try {
+      overrun.get();
+      test_fail("Expected duktape::timeout_error was not thrown.");
+    } catch(const duktape::timeout_error&) {
+      test_pass("Expected duktape::timeout_error was thrown.");
+    }
+    test_expect(chrono::steady_clock::now() - t0 < chrono::milliseconds(400));
+    // The engine deadline is reset after the job.
+    test_expect(single.post([](duktape::engine& e) { return e.call<int>("busy", 250); }).get() == 250);
+  }
+}
@@ -0,0 +1,66 @@
+/**
+ * Execution timeout and instruction budget of eval() and call().
+ */
+#include "../testenv.hh"
+#include <duktape.executor.hh>
+#include <chrono>
+
+using namespace std;
+
+using ms = chrono::milliseconds;
+
+template <typename Fn>
+void expect_timeout(Fn fn, string what)
+{
+  const auto t0 = chrono::steady_clock::now();
+  try {
+    fn();
+    test_fail(what + ": expected duktape::timeout_error was not thrown.");
+  } catch(const duktape::timeout_error& e) {
+    const auto elapsed = chrono::duration_cast<ms>(chrono::steady_clock::now() - t0).count();
+    test_pass(what + ": " + e.what() + " after " + to_string(elapsed) + "ms");
+    test_expect(elapsed < 5000);
+  } catch(const std::exception& e) {
+    test_fail(what + ": expected duktape::timeout_error, but got: " + e.what());
+  }
+}
+
+int native_eval(duktape::api& stack)
+{
+  stack.parent_engine().eval("while(true) {}");
+  return 0;
+}
+
+void test(duktape::engine& js)
+{
+  js.eval("function spin() { while(true) {} }");
+  js.eval("function catching() { for(;;) { try { while(true) {} } catch(e) {} } }");
+  js.define("native_eval", native_eval, 0);
+
+  // Per call limits
+  expect_timeout([&]{ js.eval("while(true) {}", "(eval)", false, ms(50)); }, "eval timeout");
+  test_expect(js.eval<int>("1+1") == 2);
+  expect_timeout([&]{ js.call_for(ms(50), "spin"); }, "call timeout");
+  expect_timeout([&]{ js.call_for(ms(50), "catching"); }, "timeout not catchable in script");
+  expect_timeout([&]{ js.eval("while(true) {}", "(eval)", false, ms(0), 1000000); }, "eval instruction budget");
+  expect_timeout([&]{ js.call_for(ms(0), 1000000, "spin"); }, "call instruction budget");
+  test_expect(js.eval<int>("var n=0; for(var i=0; i<1000; ++i) n+=i; n", "(eval)", false, ms(1000), 1000000) == 499500);
+
+  // Nested evaluation without own limits is bound by the enclosing deadline.
+  expect_timeout([&]{ js.eval("native_eval()", "(eval)", false, ms(50)); }, "nested eval");
+
+  // Engine defaults
+  js.timeout(ms(50));
+  test_expect(js.timeout() == ms(50));
+  expect_timeout([&]{ js.call("spin"); }, "engine default timeout");
+  js.timeout(ms(0));
+  js.instruction_budget(1000000);
+  expect_timeout([&]{ js.eval("while(true) {}"); }, "engine default instruction budget");
+  js.instruction_budget(0);
+  test_expect(js.eval<int>("2+2") == 4);
+
+  // Executor jobs are interrupted at their deadline.
+  duktape::executor executor(1, [](duktape::engine& e) { e.eval("function spin() { while(true) {} }"); });
+  expect_timeout([&]{ executor.submit_for(ms(50), "spin").get(); }, "executor job timeout");
+  test_expect(executor.eval<int>("3+3").get() == 6);
+}
@@ -0,0 +1,109 @@
+/**
+ * Event loop: timer wheel, timers and file descriptor watches.
+ */
+#include "../testenv.hh"
+#include <mod/mod.eventloop.hh>
+#include <map>
+#include <random>
+#include <unistd.h>
+
+using namespace std;
+
+void test_timer_wheel()
+{
+  using wheel_type = duktape::detail::eventloop::basic_timer_wheel<>;
+  wheel_type wheel;
+  std::mt19937_64 rnd(1234);
+  map<uint64_t, uint64_t> expected; // id -> expiry
+  uint64_t next_id = 1;
+  bool ok = true;
+  size_t fired = 0;
+  for(int round=0; round<2000; ++round) {
+    // Insert timers with short to very long delays, remove some.
+    for(int i=0; i<5; ++i) {
+      const uint64_t delay = (rnd() % 4) == 0 ? (rnd() % (1ull<<32)) : (rnd() % 5000);
+      expected[next_id] = std::max(wheel.now() + delay, wheel.now() + 1);
+      wheel.insert(next_id, wheel.now() + delay);
+      ++next_id;
+    }
+    if(!expected.empty() && (rnd() % 3) == 0) {
+      auto it = expected.begin();
+      std::advance(it, rnd() % expected.size());
+      ok = ok && wheel.erase(it->first);
+      expected.erase(it);
+    }
+    // Advance in random steps, sometimes far.
+    const uint64_t to = wheel.now() + (((rnd() % 50) == 0) ? (rnd() % (1ull<<31)) : (rnd() % 200));
+    vector<uint64_t> expired;
+    wheel.advance(to, expired);
+    uint64_t last = 0;
+    for(auto id: expired) {
+      auto it = expected.find(id);
+      if(it == expected.end() || it->second > to || it->second < last) { ok = false; break; }
+      last = it->second;
+      expected.erase(it);
+      ++fired;
+    }
+    for(const auto& e: expected) {
+      if(e.second <= to) { ok = false; break; }
+    }
+    ok = ok && (wheel.size() == expected.size()) && (wheel.next_tick() > wheel.now());
+  }
+  test_note("timer wheel: " << fired << " timers fired, " << expected.size() << " pending");
+  test_expect(ok);
+  test_expect(fired > 1000);
+}
+
+void test_fd_watch(duktape::engine& js)
+{
+  int fds[2];
+  if(::pipe(fds) != 0) { test_fail("pipe() failed"); return; }
+  auto* loop = duktape::mod::eventloop::loop_of(js.stack());
+  test_expect(loop != nullptr);
+  if(!loop) return;
+  string received;
+  loop->watch(fds[0], loop->readable, [&](int fd, unsigned events) {
+    char buf[64];
+    if(events & loop->readable) {
+      const ssize_t n = ::read(fd, buf, sizeof(buf));
+      if(n > 0) received.append(buf, size_t(n));
+    }
+    if(received == "ping") loop->unwatch(fd);
+  });
+  js.define("write_pipe", [](duktape::api& stack) -> int {
+    const string s = stack.get<string>(0);
+    return (::write(int(stack.get<int>(1)), s.data(), s.size()) == ssize_t(s.size())) ? 0 : stack.throw_exception("write failed");
+  });
+  js.eval(string("setTimeout(function(){ write_pipe('pi', ") + to_string(fds[1]) + "); }, 20);" +
+          "setTimeout(function(){ write_pipe('ng', " + to_string(fds[1]) + "); }, 40);");
+  duktape::mod::eventloop::run_loop(js);
+  test_expect(received == "ping");
+  test_expect(!loop->alive());
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+void test(duktape::engine& js)
+{
+  test_timer_wheel();
+  duktape::mod::eventloop::define_in(js);
+  test_fd_watch(js);
+
+  // Script errors in callbacks are passed to the caller of run_loop().
+  js.eval("var after_error = false; setTimeout(function(){ throw new Error('expected'); }, 1); setTimeout(function(){ after_error = true; }, 2);");
+  try {
+    duktape::mod::eventloop::run_loop(js);
+    test_fail("Expected duktape::script_error was not thrown.");
+  } catch(const duktape::script_error& e) {
+    test_pass(string("Expected duktape::script_error: ") + e.what());
+  }
+  duktape::mod::eventloop::run_loop(js);
+  test_expect(js.eval<bool>("after_error"));
+
+  // Many pending timers
+  const auto t0 = chrono::steady_clock::now();
+  js.eval("var count = 0; for(var i=0; i<10000; ++i) setTimeout(function(){ ++count; }, i % 97);");
+  duktape::mod::eventloop::run_loop(js);
+  test_expect(js.eval<int>("count") == 10000);
+  test_note("10000 timers: " << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count() << "ms");
+}
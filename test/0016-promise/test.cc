@@ -0,0 +1,118 @@
+/**
+ * Promise module: job queue processing and C++ api helpers.
+ */
+#include "../testenv.hh"
+#include <mod/mod.promise.hh>
+#include <mod/mod.eventloop.hh>
+#include <chrono>
+
+using namespace std;
+
+int nested_eval(duktape::api& stack)
+{
+  // Nested evaluation must not process the job queue of the outer script.
+  stack.parent_engine().eval("Promise.resolve().then(function(){ order.push('nested job'); }); order.push('nested eval');");
+  return 0;
+}
+
+void test(duktape::engine& js)
+{
+  duktape::mod::promise::define_in(js);
+  duktape::mod::eventloop::define_in(js);
+  duktape::mod::promise::define_in(js); // no-op
+  test_expect(bool(js.job_hook()));
+  js.define("nested_eval", nested_eval, 0);
+
+  // Jobs are processed after the outermost eval() and call().
+  js.eval("var order = []; Promise.resolve().then(function(){ order.push('job'); }); nested_eval(); order.push('end');");
+  test_expect(js.eval<string>("order.join(',')") == "nested eval,end,job,nested job");
+  js.eval("function later(v) { return Promise.resolve(v).then(function(x){ result = x * 2; }); }; var result = 0;");
+  js.call("later", 21);
+  test_expect(js.eval<int>("result") == 42);
+
+  // Promises created and settled from C++.
+  {
+    duktape::api& stack = js.stack();
+    duktape::stack_guard sg(stack);
+    js.eval("var resolved = undefined, rejected = undefined;");
+    duktape::mod::promise::push_promise(stack);
+    duktape::mod::promise::push_promise(stack);
+    test_expect(duktape::mod::promise::is_promise(stack, -1));
+    test_expect(!duktape::mod::promise::is_promise(stack, (stack.push_object(), -1)));
+    stack.pop();
+    stack.get_global_string("Promise");
+    stack.get_prop_string(-1, "prototype");
+    stack.get_prop_string(-1, "then");
+    stack.dup(-5);
+    stack.push_c_function([](duk_context* ctx) -> duk_ret_t {
+      duktape::api s(ctx); s.dup(0); s.put_global_string("resolved"); return 0;
+    }, 1);
+    stack.call_method(1);
+    stack.pop(3);
+    stack.get_prop_string(-1, "catch");
+    stack.dup(-2);
+    stack.push_c_function([](duk_context* ctx) -> duk_ret_t {
+      duktape::api s(ctx); s.get_prop_string(0, "message"); s.put_global_string("rejected"); return 0;
+    }, 1);
+    stack.call_method(1);
+    stack.pop();
+    duktape::mod::promise::resolve_with(stack, -2, string("from c++"));
+    duktape::mod::promise::reject_with_error(stack, -1, "failed in c++");
+    duktape::mod::promise::resolve_with(stack, -1, 1); // ignored, already rejected
+    test_expect(js.eval<string>("'' + resolved") == "undefined");
+    duktape::mod::promise::run_jobs(js);
+    test_expect(js.eval<string>("resolved") == "from c++");
+    test_expect(js.eval<string>("rejected") == "failed in c++");
+  }
+
+  // Exceeded execution limits in jobs are not converted into rejections.
+  js.eval("function spin_job() { Promise.resolve().then(function(){ while(true) {} }).catch(function(){ caught = true; }); }; var caught = false;");
+  try {
+    js.call_for(chrono::milliseconds(50), "spin_job");
+    test_fail("Expected duktape::timeout_error was not thrown.");
+  } catch(const duktape::timeout_error& e) {
+    test_pass(string("Expected duktape::timeout_error: ") + e.what());
+  }
+  test_expect(!js.eval<bool>("caught"));
+
+  // Jobs not processed when the limit was exceeded stay queued.
+  js.eval("function spin_first() { Promise.resolve().then(function(){ while(true) {} }); Promise.resolve().then(function(){ after_spin = true; }); }; var after_spin = false;");
+  test_expect_except(js.call_for(chrono::milliseconds(50), "spin_first"));
+  test_expect(!js.eval<bool>("after_spin"));
+  duktape::mod::eventloop::run_loop(js); // pending jobs are processed although no timers are pending.
+  test_expect(js.eval<bool>("after_spin"));
+
+  // Runaway jobs processed by the event loop are aborted by the engine limits.
+  js.eval("function spin_twice() { for(var i=0; i<2; ++i) Promise.resolve().then(function(){ while(true) {} }); }");
+  test_expect_except(js.call_for(chrono::milliseconds(50), "spin_twice"));
+  js.timeout(chrono::milliseconds(50));
+  try {
+    duktape::mod::eventloop::run_loop(js);
+    test_fail("Expected duktape::timeout_error was not thrown.");
+  } catch(const duktape::timeout_error& e) {
+    test_pass(string("Expected duktape::timeout_error: ") + e.what());
+  }
+  js.timeout(chrono::milliseconds(0));
+  test_expect_except(js.call_for(chrono::milliseconds(50), "spin_twice"));
+  js.instruction_budget(1000000);
+  test_expect_except(duktape::mod::eventloop::run_loop(js));
+  js.instruction_budget(0);
+  test_expect_noexcept(duktape::mod::eventloop::run_loop(js));
+
+  // Errors thrown by a `then` getter reject the promise.
+  js.eval("var getter_errors = [], thenable = {}; Object.defineProperty(thenable, 'then', { get: function(){ throw new Error('then getter'); } });"
+          "Promise.resolve(1).then(function(){ return thenable; }).catch(function(e){ getter_errors.push(e.message); });"
+          "new Promise(function(res){ res(thenable); }).catch(function(e){ getter_errors.push(e.message); });");
+  test_expect(js.eval<string>("getter_errors.join()") == "then getter,then getter");
+
+  // Many chained reactions.
+  const auto t0 = chrono::steady_clock::now();
+  js.eval("var count = 0, p = Promise.resolve(); for(var i=0; i<10000; ++i) p = p.then(function(){ ++count; });");
+  test_expect(js.eval<int>("count") == 10000);
+  test_note("10000 chained reactions: " << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count() << "ms");
+
+  // Promises settled by timers are processed by the event loop.
+  js.eval("var timed = ''; new Promise(function(res){ setTimeout(res, 5, 'timer'); }).then(function(v){ timed = v; });");
+  duktape::mod::eventloop::run_loop(js);
+  test_expect(js.eval<string>("timed") == "timer");
+}
@@ -0,0 +1,108 @@
+/**
+ * Coroutine scheduler: suspension on I/O, concurrency, errors.
+ */
+#include "../testenv.hh"
+#include <mod/mod.coroutine.hh>
+#include <chrono>
+#include <unistd.h>
+
+using namespace std;
+
+void test(duktape::engine& js)
+{
+  duktape::mod::coroutine::define_in(js);
+
+  // Await functions are only allowed inside coroutines.
+  test_expect_except(js.eval("await_read(0)"));
+  test_expect_except(js.eval("coroutine.sleep(1)"));
+  test_expect_except(js.eval("coroutine.spawn(1)"));
+  test_expect(js.eval<bool>("coroutine.current() === undefined"));
+
+  // Reading from a pipe suspends only the reading coroutine.
+  {
+    int fds[2];
+    if(::pipe(fds) != 0) { test_fail("pipe() failed"); return; }
+    js.define("write_pipe", [](duktape::api& stack) -> int {
+      const string s = stack.get<string>(0);
+      return (::write(int(stack.get<int>(1)), s.data(), s.size()) == ssize_t(s.size())) ? 0 : stack.throw_exception("write failed");
+    });
+    js.define("close_fd", [](duktape::api& stack) -> int { ::close(stack.get<int>(0)); return 0; });
+    js.eval(string("var rfd = ") + to_string(fds[0]) + ", wfd = " + to_string(fds[1]) + ", events = [];" +
+      "var reader = coroutine.spawn(function() {"
+      "  var data = '', chunk;"
+      "  events.push('reader waits');"
+      "  while((chunk = await_read(rfd)) !== undefined) { events.push('read ' + chunk); data += chunk; }"
+      "  return data;"
+      "});"
+      "var writer = coroutine.spawn(function() {"
+      "  events.push('writer runs');"
+      "  coroutine.sleep(10); write_pipe('ab', wfd);"
+      "  coroutine.sleep(10); write_pipe('cd', wfd);"
+      "  coroutine.sleep(10); close_fd(wfd);"
+      "  return coroutine.join(reader);"
+      "});"
+    );
+    test_expect(duktape::mod::coroutine::count(js) == 2);
+    duktape::mod::eventloop::run_loop(js);
+    test_note("events: " << js.eval<string>("events.join(',')"));
+    test_expect(js.eval<string>("events.join(',')") == "reader waits,writer runs,read ab,read cd");
+    test_expect(js.eval<string>("writer.result") == "abcd");
+    test_expect(duktape::mod::coroutine::count(js) == 0);
+    ::close(fds[0]);
+  }
+
+  // Concurrent processes.
+  {
+    const auto t0 = chrono::steady_clock::now();
+    js.eval("var tasks = []; for(var i=0; i<20; ++i) tasks.push(coroutine.spawn(function(n) {"
+            "  return await_exec('sh', ['-c', 'sleep 0.2; echo $0', String(n)]).stdout;"
+            "}, i));");
+    duktape::mod::eventloop::run_loop(js);
+    const auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count();
+    test_note("20 concurrent await_exec('sleep 0.2'): " << ms << "ms");
+    test_expect(js.eval<bool>("tasks.every(function(t, i){ return t.done && t.result === i + '\\n'; })"));
+    test_expect(ms < 4000);
+  }
+
+  // Errors are thrown in the joining coroutine, or passed to the event loop.
+  js.eval("var failing = coroutine.spawn(function(){ coroutine.yield(); throw new Error('expected'); });"
+          "var joiner = coroutine.spawn(function(){ try { coroutine.join(failing); } catch(e) { return e.message; } });");
+  duktape::mod::eventloop::run_loop(js);
+  test_expect(js.eval<string>("joiner.result") == "expected");
+  test_expect(js.eval<bool>("failing.failed"));
+  js.eval("coroutine.spawn(function(){ throw new Error('unhandled'); }); var after = coroutine.spawn(function(){ return 1; });");
+  try {
+    duktape::mod::eventloop::run_loop(js);
+    test_fail("Expected duktape::script_error was not thrown.");
+  } catch(const duktape::script_error& e) {
+    test_pass(string("Expected duktape::script_error: ") + e.what());
+  }
+  duktape::mod::eventloop::run_loop(js);
+  test_expect(js.eval<int>("after.result") == 1);
+
+  // Suspending across native calls is rejected by Duktape.
+  js.eval("var native_between = coroutine.spawn(function(){ [1].forEach(function(){ coroutine.yield(); }); });");
+  test_expect_except(duktape::mod::eventloop::run_loop(js));
+  test_expect(js.eval<bool>("native_between.failed"));
+
+  // Coroutines aborted by the engine timeout are finished as failed.
+  {
+    js.timeout(chrono::milliseconds(50));
+    js.eval("var endless = coroutine.spawn(function(){ while(true){} }); var joins_endless = coroutine.spawn(function(){"
+            "  try { coroutine.join(endless); } catch(e) { return 'joined'; } });");
+    test_expect_except(duktape::mod::eventloop::run_loop(js));
+    js.timeout(chrono::milliseconds(0));
+    duktape::mod::eventloop::run_loop(js);
+    test_expect(duktape::mod::coroutine::count(js) == 0);
+    test_expect(js.eval<bool>("endless.done && endless.failed"));
+    test_expect(js.eval<string>("joins_endless.result") == "joined");
+    js.eval("var after_timeout = coroutine.spawn(function(){ coroutine.yield(); return 2; });");
+    duktape::mod::eventloop::run_loop(js);
+    test_expect(js.eval<int>("after_timeout.result") == 2);
+  }
+
+  // Many coroutines
+  js.eval("var sum = 0; for(var i=0; i<2000; ++i) coroutine.spawn(function(n){ coroutine.yield(); sum += n; }, i);");
+  duktape::mod::eventloop::run_loop(js);
+  test_expect(js.eval<int>("sum") == 1999000);
+}
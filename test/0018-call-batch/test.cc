@@ -0,0 +1,84 @@
+/**
+ * Batch calls: one function, many argument sets.
+ */
+#include "../testenv.hh"
+#include <chrono>
+#include <tuple>
+#include <list>
+
+using namespace std;
+
+void test(duktape::engine& js)
+{
+  using batch_error = duktape::engine::batch_error;
+  js.eval("function add(a, b) { if(b < 0) throw new Error('negative: ' + b); return a + b; }");
+  js.eval("function map(rec) { return rec.toUpperCase(); }");
+  js.eval("function maybe_string(x) { return (x % 2) ? String(x) : x; }");
+
+  // Tuples as argument sets, errors are collected per element.
+  {
+    vector<tuple<int, int>> args;
+    for(int i=0; i<100; ++i) args.emplace_back(i, (i % 10 == 9) ? -1 : i);
+    vector<batch_error> errors;
+    const vector<int> results = js.call_batch<int>("add", args, errors);
+    test_expect(results.size() == 100);
+    test_expect(errors.size() == 10);
+    bool ok = true;
+    for(int i=0; i<100; ++i) ok = ok && (results[size_t(i)] == ((i % 10 == 9) ? 0 : 2*i));
+    test_expect(ok);
+    test_expect(!errors.empty() && errors[0].index == 9);
+    test_expect(!errors.empty() && errors[0].message.find("negative: -1") != string::npos);
+    test_expect(!errors.empty() && !errors[0].callstack.empty());
+  }
+
+  // Single values, iterator version.
+  {
+    const list<string> records = {"a", "bc", "def"};
+    vector<string> out;
+    vector<batch_error> errors;
+    js.call_batch<string>("map", records.begin(), records.end(), back_inserter(out), errors);
+    test_expect((out == vector<string>{"A", "BC", "DEF"}));
+    test_expect(errors.empty());
+  }
+
+  // Strict return type checks, unknown functions.
+  {
+    vector<batch_error> errors;
+    const vector<int> results = js.call_batch<int, true>("maybe_string", vector<int>{1,2,3,4}, errors);
+    test_expect(errors.size() == 2);
+    test_expect((results == vector<int>{0,2,0,4}));
+    test_expect_except(js.call_batch<int>("not_defined", vector<int>{1}, errors));
+  }
+
+  // Execution limits apply to each call.
+  {
+    js.eval("function spin(x) { if(x) while(true) {} return x; }");
+    js.timeout(chrono::milliseconds(50));
+    vector<batch_error> errors;
+    try {
+      js.call_batch<int>("spin", vector<int>{0, 1}, errors);
+      test_fail("Expected duktape::timeout_error was not thrown.");
+    } catch(const duktape::timeout_error& e) {
+      test_pass(string("Expected duktape::timeout_error: ") + e.what());
+    }
+    js.timeout(chrono::milliseconds(0));
+  }
+
+  // Comparison with single calls.
+  {
+    vector<tuple<int, int>> args;
+    for(int i=0; i<100000; ++i) args.emplace_back(i, 1);
+    auto t0 = chrono::steady_clock::now();
+    int64_t sum_single = 0;
+    for(const auto& a: args) sum_single += js.call<int>("add", get<0>(a), get<1>(a));
+    const auto single_ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count();
+    t0 = chrono::steady_clock::now();
+    vector<batch_error> errors;
+    int64_t sum_batch = 0;
+    for(auto r: js.call_batch<int>("add", args, errors)) sum_batch += r;
+    const auto batch_ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count();
+    test_note("100000 calls: call() " << single_ms << "ms, call_batch() " << batch_ms << "ms");
+    test_expect(sum_single == sum_batch);
+    test_expect(errors.empty());
+  }
+}
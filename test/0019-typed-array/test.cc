@@ -0,0 +1,93 @@
+/**
+ * Bulk conversions between std::vector<numeric> and TypedArrays.
+ */
+#include "../testenv.hh"
+#include <chrono>
+#include <numeric>
+
+using namespace std;
+
+double sum(duktape::typed_view<double> v)
+{ return std::accumulate(v.begin(), v.end(), 0.0); }
+
+void scale(duktape::typed_view<float> v, double f)
+{ for(auto& e: v) e = float(e * f); }
+
+void test(duktape::engine& js)
+{
+  duktape::api stack(js);
+
+  // TypedArray --> vector (block copy).
+  {
+    const vector<double> d = js.eval<vector<double>>("new Float64Array([1.5, 2.5, -3])");
+    test_expect((d == vector<double>{1.5, 2.5, -3}));
+    const vector<int> i = js.eval<vector<int>>("new Int32Array([1, -2, 3])");
+    test_expect((i == vector<int>{1, -2, 3}));
+    const vector<unsigned char> u = js.eval<vector<unsigned char>>("new Uint8Array([0, 128, 255]).subarray(1)");
+    test_expect((u == vector<unsigned char>{128, 255}));
+    test_expect(js.eval<vector<double>>("new Float64Array(0)").empty());
+    test_expect((js.eval<vector<int>>("[4,5,6]") == vector<int>{4,5,6}));
+    test_expect_except((js.eval<vector<int>, true>("new Float64Array([1])")));
+  }
+
+  // typed_array --> TypedArray, plain vectors stay Arrays.
+  {
+    js.define("f64", duktape::typed_array<double>{1, 2, 3});
+    js.define("u16", duktape::typed_array<unsigned short>{1, 65535});
+    js.define("plain", vector<double>{1, 2, 3});
+    test_expect(js.eval<bool>("f64 instanceof Float64Array && f64.length === 3 && f64[2] === 3"));
+    test_expect(js.eval<bool>("u16 instanceof Uint16Array && u16[1] === 65535"));
+    test_expect(js.eval<bool>("Array.isArray(plain)"));
+    const duktape::typed_array<double> rb = js.eval<duktape::typed_array<double>>("f64");
+    test_expect((rb == vector<double>{1, 2, 3}));
+  }
+
+  // typed_view native function arguments (no copy, writable).
+  {
+    js.define("sum", sum);
+    js.define("scale", scale);
+    test_expect(js.eval<double>("sum(new Float64Array([1, 2, 3.5]))") == 6.5);
+    test_expect(js.eval<bool>("var f32 = new Float32Array([1, 2]); scale(f32, 2); f32[0] === 2 && f32[1] === 4"));
+    test_expect_except(js.eval("sum([1,2,3])"));
+    test_expect_except(js.eval("sum(new Float32Array(1))"));
+  }
+
+  // Element types are the internal classes, not spoofable by scripts.
+  {
+    test_expect_except(js.eval("var i8 = new Int8Array(8); Object.setPrototypeOf(i8, Float64Array.prototype); sum(i8)"));
+    test_expect_except(js.eval("var saved_f64 = Float64Array; Float64Array = Int8Array; try { sum(new Int8Array(8)); } finally { Float64Array = saved_f64; }"));
+    test_expect(js.eval<double>("var saved_f64 = Float64Array; Float64Array = Array; var r = sum(new saved_f64([1, 2])); Float64Array = saved_f64; r") == 3);
+    test_expect(js.eval<int>("(new Uint8Array([1,2,3])).length") == 3);
+  }
+
+  // Zero-copy external array.
+  {
+    duktape::stack_guard sg(stack);
+    vector<int> data{1, 2, 3};
+    stack.push_global_object();
+    stack.push_external_typed_array(data.data(), data.size());
+    stack.put_prop_string(-2, "ext");
+    js.eval("ext[0] = 10; ext[2] += 1;");
+    test_expect((data == vector<int>{10, 2, 4}));
+    js.eval("ext = undefined");
+  }
+
+  // Bulk performance compared to plain Arrays.
+  {
+    const size_t n = 1000000;
+    vector<double> v(n);
+    std::iota(v.begin(), v.end(), 0.0);
+    auto t0 = chrono::steady_clock::now();
+    js.define("big_plain", v);
+    const vector<double> rb_plain = js.eval<vector<double>>("big_plain");
+    auto t1 = chrono::steady_clock::now();
+    js.define("big_typed", duktape::typed_array<double>(v));
+    const vector<double> rb_typed = js.eval<vector<double>>("big_typed");
+    auto t2 = chrono::steady_clock::now();
+    test_expect(rb_plain == v);
+    test_expect(rb_typed == v);
+    test_note("1M doubles round trip: Array " << chrono::duration_cast<chrono::milliseconds>(t1-t0).count()
+      << "ms, Float64Array " << chrono::duration_cast<chrono::milliseconds>(t2-t1).count() << "ms");
+    js.eval("big_plain = big_typed = undefined");
+  }
+}
@@ -0,0 +1,99 @@
+/**
+ * Borrowed string/buffer views as native function arguments.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+  #pragma GCC diagnostic ignored "-Wmismatched-new-delete" // allocation counting operator new/delete below
+#endif
+#include "../testenv.hh"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace { std::atomic<size_t> num_allocations(0); }
+
+void* operator new(std::size_t size)
+{
+  ++num_allocations;
+  void* p = std::malloc(size ? size : 1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{ std::free(p); }
+
+int count_char_view(duktape::string_view s, duktape::string_view c)
+{
+  int n = 0;
+  for(auto ch: s) { if((!c.empty()) && (ch == c[0])) ++n; }
+  return n;
+}
+
+int count_char_string(std::string s, std::string c)
+{
+  int n = 0;
+  for(auto ch: s) { if((!c.empty()) && (ch == c[0])) ++n; }
+  return n;
+}
+
+duktape::string_view first_word(duktape::string_view s)
+{ return s.substr(0, s.find(' ')); }
+
+unsigned checksum(duktape::buffer_view b)
+{
+  unsigned sum = 0;
+  for(auto c: b) sum += c;
+  return sum;
+}
+
+duktape::buffer_view head(duktape::buffer_view b)
+{ return duktape::buffer_view(b.data(), std::min(b.size(), size_t(2))); }
+
+void test(duktape::engine& js)
+{
+  js.define("count_char_view", count_char_view);
+  js.define("count_char_string", count_char_string);
+  js.define("first_word", first_word);
+  js.define("checksum", checksum);
+  js.define("head", head);
+
+  // Conversions
+  test_expect(js.eval<int>("count_char_view('banana', 'a')") == 3);
+  test_expect(js.eval<int>("count_char_view(101, 1)") == 2); // coerced in place
+  test_expect(js.eval<int>("count_char_view('', 'a')") == 0);
+  test_expect(js.eval<string>("first_word('hello world')") == "hello");
+  test_expect(js.eval<string>("first_word('single')") == "single");
+  test_expect(js.eval<unsigned>("checksum(new Uint8Array([1,2,3]))") == 6);
+  test_expect(js.eval<unsigned>("checksum(new Uint8Array([1,2,3,4]).subarray(2))") == 7);
+  test_expect(js.eval<unsigned>("checksum('AB')") == 131);
+  test_expect_except(js.eval("checksum({})"));
+  test_expect(js.eval<bool>("var h = head(new Uint8Array([5,6,7])); h.length === 2 && h[0] === 5 && h[1] === 6"));
+
+  // string_view auxiliaries
+  {
+    const duktape::string_view v("abc def");
+    test_expect(v.size() == 7);
+    test_expect(v.substr(4) == "def");
+    test_expect(v.substr(4, 1).str() == "d");
+    test_expect(v.substr(10).empty());
+    test_expect(v.find('x') == duktape::string_view::npos);
+    test_expect(duktape::string_view("abc") < duktape::string_view("abd"));
+    test_expect(duktape::string_view("ab") < duktape::string_view("abc"));
+  }
+
+  // No per-call allocations for views, at least one per argument for std::string.
+  {
+    js.eval("var text = new Array(200).join('xa');");
+    size_t n0 = num_allocations;
+    test_expect(js.eval<int>("var n=0; for(var i=0; i<10000; ++i) n += count_char_view(text, 'a'); n") == 1990000);
+    const size_t n_view = num_allocations - n0;
+    n0 = num_allocations;
+    test_expect(js.eval<int>("var n=0; for(var i=0; i<10000; ++i) n += count_char_string(text, 'a'); n") == 1990000);
+    const size_t n_string = num_allocations - n0;
+    test_note("allocations for 10000 calls: string_view " << n_view << ", std::string " << n_string);
+    test_expect(n_view < 100);
+    test_expect(n_string >= 10000);
+  }
+}
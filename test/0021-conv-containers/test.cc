@@ -0,0 +1,75 @@
+/**
+ * Conversions of std::map, std::unordered_map, std::pair, std::tuple,
+ * std::array (and nested combinations).
+ */
+#include "../testenv.hh"
+#include <chrono>
+#include <sstream>
+
+using namespace std;
+
+void test(duktape::engine& js)
+{
+  // Maps <--> objects
+  {
+    js.define("m", map<string, int>{{"a", 1}, {"b", 2}});
+    test_expect(js.eval<bool>("m.a === 1 && m.b === 2 && Object.keys(m).length === 2"));
+    const auto rb = js.eval<unordered_map<string, double>>("({x: 1.5, y: -2})");
+    test_expect(rb.size() == 2 && rb.at("x") == 1.5 && rb.at("y") == -2);
+    const auto num_keys = js.eval<map<int, string>>("({1: 'one', 10: 'ten'})");
+    test_expect((num_keys == map<int, string>{{1, "one"}, {10, "ten"}}));
+    js.define("num_keys", num_keys);
+    test_expect(js.eval<string>("num_keys[10]") == "ten");
+    test_expect(js.eval<map<string, int>>("({})").empty());
+    test_expect((js.eval<map<string, int>, true>("({a: 'no number'})").empty())); // strict: mismatch --> empty, like vector.
+  }
+
+  // Pairs, tuples and fixed size arrays <--> arrays
+  {
+    js.define("p", make_pair(string("key"), 42));
+    test_expect(js.eval<bool>("p.length === 2 && p[0] === 'key' && p[1] === 42"));
+    test_expect((js.eval<pair<string, int>>("['a', 1]") == make_pair(string("a"), 1)));
+    js.define("t", make_tuple(1, string("two"), 3.5, true));
+    test_expect(js.eval<string>("JSON.stringify(t)") == "[1,\"two\",3.5,true]");
+    test_expect((js.eval<tuple<int, string, bool>>("[1, 'x', false]") == make_tuple(1, string("x"), false)));
+    js.define("a3", array<int, 3>{{1, 2, 3}});
+    test_expect(js.eval<string>("JSON.stringify(a3)") == "[1,2,3]");
+    test_expect((js.eval<array<double, 2>>("[0.5, 1.5]") == array<double, 2>{{0.5, 1.5}}));
+    test_expect_except((js.eval<array<int, 3>, true>("[1, 2]")));
+    test_expect_except((js.eval<tuple<int, int>, true>("[1, 2, 3]")));
+  }
+
+  // Nested
+  {
+    using nested_type = map<string, vector<pair<string, array<int, 2>>>>;
+    const nested_type n{{"a", {{"x", {{1, 2}}}, {"y", {{3, 4}}}}}, {"b", {}}};
+    js.define("nested", n);
+    test_expect(js.eval<string>("JSON.stringify(nested)") == "{\"a\":[[\"x\",[1,2]],[\"y\",[3,4]]],\"b\":[]}");
+    test_expect(js.eval<nested_type>("nested") == n);
+  }
+
+  // Comparison with a JSON string round trip.
+  {
+    map<string, double> big;
+    for(int i = 0; i < 100000; ++i) big["key" + to_string(i)] = i * 0.5;
+    auto t0 = chrono::steady_clock::now();
+    js.define("big_native", big);
+    const auto rb_native = js.eval<map<string, double>>("big_native");
+    auto t1 = chrono::steady_clock::now();
+    {
+      ostringstream ss;
+      ss << "{";
+      for(const auto& e: big) ss << (e.first == big.begin()->first ? "" : ",") << "\"" << e.first << "\":" << e.second;
+      ss << "}";
+      js.define("big_json_text", ss.str());
+      js.eval("var big_json = JSON.parse(big_json_text);");
+    }
+    const string json_back = js.eval<string>("JSON.stringify(big_json)");
+    auto t2 = chrono::steady_clock::now();
+    test_expect(rb_native == big);
+    test_expect(json_back.size() > 100000);
+    test_note("100000 entry map round trip: native " << chrono::duration_cast<chrono::milliseconds>(t1-t0).count()
+      << "ms, JSON (without c++ parsing) " << chrono::duration_cast<chrono::milliseconds>(t2-t1).count() << "ms");
+    js.eval("big_native = big_json = big_json_text = undefined");
+  }
+}
@@ -0,0 +1,134 @@
+/**
+ * Structured clone of values between engines (value_blob).
+ */
+#include "../testenv.hh"
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+void test_round_trip(duktape::engine& js)
+{
+  js.eval(
+    "var src = { s: 'text \\u00e4\\u20ac', i: 42, neg0: -0, d: 1.5, big: Math.pow(2, 40), nan: NaN,"
+    "  t: true, f: false, n: null, u: undefined, date: new Date(1500000000123),"
+    "  arr: [1, 'two', [3, [4]], {five: 5}], u8: new Uint8Array([1, 2, 255]),"
+    "  f64: new Float64Array([0.5, -1]), ab: new Uint8Array([7, 8]).buffer,"
+    "  large: new Uint8Array(200000) };"
+    "src.large[0] = 1; src.large[199999] = 2;"
+    "src.shared = src.arr[3]; src.self = src;"
+  );
+  const duktape::value_blob blob = js.eval<duktape::value_blob>("src");
+  test_expect(!blob.empty());
+  test_note("blob size: " << blob.size() << " bytes");
+
+  duktape::engine js2;
+  js2.define("dst", blob);
+  test_expect(js2.eval<string>("dst.s") == js.eval<string>("src.s"));
+  test_expect(js2.eval<bool>("dst.i === 42 && dst.d === 1.5 && dst.big === Math.pow(2, 40) && isNaN(dst.nan)"));
+  test_expect(js2.eval<bool>("(1/dst.neg0) === -Infinity"));
+  test_expect(js2.eval<bool>("dst.t === true && dst.f === false && dst.n === null && ('u' in dst) && dst.u === undefined"));
+  test_expect(js2.eval<bool>("(dst.date instanceof Date) && dst.date.getTime() === 1500000000123"));
+  test_expect(js2.eval<string>("JSON.stringify(dst.arr)") == "[1,\"two\",[3,[4]],{\"five\":5}]");
+  test_expect(js2.eval<bool>("(dst.u8 instanceof Uint8Array) && dst.u8.length === 3 && dst.u8[2] === 255"));
+  test_expect(js2.eval<bool>("(dst.f64 instanceof Float64Array) && dst.f64[0] === 0.5 && dst.f64[1] === -1"));
+  test_expect(js2.eval<bool>("(dst.ab instanceof ArrayBuffer) && dst.ab.byteLength === 2"));
+  test_expect(js2.eval<bool>("dst.large.length === 200000 && dst.large[0] === 1 && dst.large[199999] === 2"));
+  test_expect(js2.eval<bool>("dst.shared === dst.arr[3] && dst.self === dst"));
+
+  // Blob copies share large buffers, the materialised values are independent.
+  duktape::value_blob copy = blob;
+  duktape::engine js3;
+  js3.define("dst", copy);
+  js3.eval("dst.large[0] = 99;");
+  test_expect(js2.eval<int>("dst.large[0]") == 1);
+
+  // Non-integer and out of int32 range numbers
+  js2.define("numbers", js.eval<duktape::value_blob>("[NaN, Infinity, -Infinity, 1e20, -1e20, 2147483647, -2147483648, 2147483648, -2147483649, 0.5]"));
+  test_expect(js2.eval<string>("numbers.map(String).join()") == "NaN,Infinity,-Infinity,100000000000000000000,-100000000000000000000,2147483647,-2147483648,2147483648,-2147483649,0.5");
+
+  // Unsupported values
+  test_expect_except(js.eval<duktape::value_blob>("({ f: function(){} })"));
+  test_expect(js.eval<duktape::value_blob>("undefined").size() == 1);
+  test_expect(duktape::value_blob().empty());
+}
+
+void test_internal_types(duktape::engine& js)
+{
+  // Types and Date time values are taken from the internal classes,
+  // overridden valueOf() or replaced constructors do not matter.
+  js.eval(
+    "var spoof = { date: new Date(1000), fake_date: Object.create(Date.prototype), nb: new Buffer('abc') };"
+    "spoof.date.valueOf = function() { return 5; };"
+    "var saved_f64 = Float64Array; Float64Array = Uint8Array; var saved_ab = ArrayBuffer; ArrayBuffer = Array;"
+    "spoof.f64 = new saved_f64([0.5]); spoof.ab = new saved_ab(3);"
+  );
+  const duktape::value_blob blob = js.eval<duktape::value_blob>("spoof");
+  js.eval("Float64Array = saved_f64; ArrayBuffer = saved_ab;");
+  duktape::engine js2;
+  js2.define("dst", blob);
+  test_expect(js2.eval<bool>("(dst.date instanceof Date) && dst.date.getTime() === 1000"));
+  test_expect(js2.eval<bool>("!(dst.fake_date instanceof Date)"));
+  test_expect(js2.eval<bool>("(dst.f64 instanceof Float64Array) && dst.f64[0] === 0.5"));
+  test_expect(js2.eval<bool>("(dst.ab instanceof ArrayBuffer) && dst.ab.byteLength === 3"));
+  test_expect(js2.eval<bool>("Buffer.isBuffer(dst.nb) && String(dst.nb) === 'abc'"));
+
+  // Decoding Dates requires the built-in Date constructor.
+  duktape::engine js3;
+  js3.eval("Date = function() { return {}; };");
+  test_expect_except(js3.define("dst", js.eval<duktape::value_blob>("new Date(1)")));
+
+  // Documented limitation: views sharing one ArrayBuffer are decoded as separate buffers.
+  js2.define("views", js.eval<duktape::value_blob>("(function(){ var ab = new ArrayBuffer(8); var a = new Uint8Array(ab, 0, 4); a[0] = 1; return [a, new Uint8Array(ab, 4, 4)]; })()"));
+  test_expect(js2.eval<bool>("views[0].length === 4 && views[1].length === 4 && views[0][0] === 1 && views[0].buffer !== views[1].buffer"));
+}
+
+void test_fan_out_fan_in()
+{
+  // Fan out one input blob to worker engines in threads, fan in the results.
+  duktape::engine js;
+  js.eval("var input = []; for(var i=0; i<1000; ++i) input.push({ id: i, values: [i, i*2, i*3] });");
+  const duktape::value_blob input = js.eval<duktape::value_blob>("input");
+  const int num_workers = 4;
+  vector<duktape::value_blob> results(num_workers);
+  vector<thread> workers;
+  for(int w = 0; w < num_workers; ++w) {
+    workers.emplace_back([w, &input, &results]() {
+      duktape::engine worker;
+      worker.define("input", input);
+      worker.define("worker_id", w);
+      results[size_t(w)] = worker.eval<duktape::value_blob>(
+        "(function(){ var sum = 0; input.forEach(function(e){ if(e.id % 4 === worker_id) sum += e.values[2]; });"
+        "  return { worker: worker_id, sum: sum }; })()"
+      );
+    });
+  }
+  for(auto& t: workers) t.join();
+  js.eval("var results = []; function add_result(r) { results.push(r); }");
+  for(const auto& r: results) js.call<void>("add_result", r);
+  test_expect(js.eval<int>("results.length") == num_workers);
+  test_expect(js.eval<int>("results.reduce(function(a, r){ return a + r.sum; }, 0)") == 3 * (999 * 1000 / 2));
+}
+
+void test_performance(duktape::engine& js)
+{
+  js.eval("var rows = []; for(var i=0; i<50000; ++i) rows.push({ id: i, name: 'row' + i, value: i * 0.25, tags: ['a', 'b'] });");
+  duktape::engine js2;
+  auto t0 = chrono::steady_clock::now();
+  js2.define("rows", js.eval<duktape::value_blob>("rows"));
+  auto t1 = chrono::steady_clock::now();
+  js2.define("json_text", js.eval<string>("JSON.stringify(rows)"));
+  js2.eval("var rows_json = JSON.parse(json_text);");
+  auto t2 = chrono::steady_clock::now();
+  test_expect(js2.eval<string>("JSON.stringify(rows)") == js2.eval<string>("JSON.stringify(rows_json)"));
+  test_note("50000 rows between engines: value_blob " << chrono::duration_cast<chrono::milliseconds>(t1-t0).count()
+    << "ms, JSON " << chrono::duration_cast<chrono::milliseconds>(t2-t1).count() << "ms");
+}
+
+void test(duktape::engine& js)
+{
+  test_round_trip(js);
+  test_internal_types(js);
+  test_fan_out_fan_in();
+  test_performance(js);
+}
@@ -1,7 +1,14 @@
 #include "../testenv.hh"
 #include <mod/mod.stdio.hh>
 #include <mod/mod.fs.hh>
+#include <mod/mod.fs.file.hh>
 #include <mod/mod.sys.exec.hh>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#ifndef WINDOWS
+  #include <dirent.h>
+#endif
 
 using namespace std;
 
@@ -150,9 +157,286 @@ void test_shell(duktape::engine& js)
   #endif
 }
 
+void test_pipeline(duktape::engine& js)
+{
+  #ifndef WINDOWS
+  // Parameter validity checks
+  test_expect_except( js.eval<int>("sys.pipeline()") );
+  test_expect_except( js.eval<int>("sys.pipeline([])") );
+  test_expect_except( js.eval<int>("sys.pipeline([''])") );
+  test_expect_except( js.eval<int>("sys.pipeline(['cat'], [])") );
+  test_expect_except( js.eval<int>("sys.pipeline(['cat'], {stdout:'x'})") );
+  test_expect_noexcept( js.eval<int>("sys.pipeline([''], {noexcept:true})") );
+
+  // Exit codes
+  test_expect( js.eval<int>("sys.pipeline(['/bin/true']).exitcode") == 0 );
+  test_expect( js.eval<int>("sys.pipeline(['/bin/false']).exitcode") == 1 );
+  test_expect( js.eval<string>("JSON.stringify(sys.pipeline(['/bin/false', 'cat', ['sh','-c','exit 3']]).exitcodes)") == "[1,0,3]" );
+  test_expect( js.eval<string>("JSON.stringify(sys.pipeline(['/bin/true', '###notthere']).exitcodes)") == "[0,1]" );
+  test_expect( js.eval<string>("JSON.stringify(sys.pipeline([['sh','-c','kill -9 $$'], 'cat']).exitcodes)") == "[137,0]" );
+
+  // Stage formats, stdin/stdout chaining
+  test_expect( js.eval<string>("sys.pipeline([['echo','-n','a b c']], {stdout:true}).stdout") == "a b c" );
+  test_expect( js.eval<string>("sys.pipeline([{program:'echo', args:['-n','a']}], {stdout:true}).stdout") == "a" );
+  test_expect( js.eval<string>("sys.pipeline(['cat', ['tr','a-z','A-Z'], 'cat'], {stdin:'test', stdout:true}).stdout") == "TEST" );
+  test_expect( js.eval<string>("sys.pipeline([['sort'], ['uniq','-c'], ['wc','-l']], {stdin:'b\\na\\nb\\nc\\n', stdout:true}).stdout") == "3\n" );
+  test_expect( js.eval<int>("sys.pipeline(['cat','cat'], {stdin:new Array(100001).join('0123456789'), stdout:true}).stdout.length") == 1000000 );
+
+  // Early closing stage (SIGPIPE in the writing stage, not in this process)
+  test_expect( js.eval<string>("sys.pipeline([['yes'], ['head','-n','2']], {stdout:true}).stdout") == "y\ny\n" );
+  test_expect( js.eval<string>("sys.pipeline([['head','-c','1']], {stdin:new Array(100001).join('0123456789'), stdout:true}).stdout") == "0" );
+
+  // stderr
+  test_expect( js.eval<string>("sys.pipeline([['sh','-c','echo -n e1 >&2'], ['sh','-c','cat; echo -n e2 >&2']], {stderr:true}).stderr").length() == 4 );
+  test_expect( js.eval<string>("sys.pipeline([['sh','-c','echo -n e >&2']], {stderr:'stdout'}).stdout") == "e" );
+  test_expect( js.eval<bool>("sys.pipeline(['true']).stdout === undefined") );
+
+  // File redirect
+  test_expect( js.eval<int>("sys.pipeline([['echo','-n','abc'], ['tr','a-z','A-Z']], {outfile:'pipeline.txt'}).exitcode") == 0 );
+  test_expect( js.eval<string>("fs.readfile('pipeline.txt')") == "ABC" );
+  test_expect( js.eval<int>("sys.pipeline([['echo','-n','def']], {outfile:'pipeline.txt', append:true}).exitcode") == 0 );
+  test_expect( js.eval<string>("fs.readfile('pipeline.txt')") == "ABCdef" );
+  test_expect( js.eval<bool>("fs.unlink('pipeline.txt')") );
+
+  // env, noenv, nopath, timeout
+  test_expect( js.eval<string>("sys.pipeline(['env', ['grep','TEST_ENVVAR']], {stdout:true, env:{TEST_ENVVAR:123456}}).stdout") == "TEST_ENVVAR=123456\n" );
+  test_expect( js.eval<string>("sys.pipeline(['/usr/bin/env', 'cat'], {stdout:true, noenv:true}).stdout") == "" );
+  test_expect( js.eval<int>("sys.pipeline(['echo'], {nopath:true}).exitcode") == 1 );
+  test_expect_except( js.eval<int>("sys.pipeline([['sleep','10'], 'cat'], {timeout:100}).exitcode") );
+  #else
+  test_expect_except( js.eval<int>("sys.pipeline(['cmd.exe'])") );
+  #endif
+}
+
+void test_spawn(duktape::engine& js)
+{
+  #ifndef WINDOWS
+  test_expect_except( js.eval<int>("sys.spawn()") );
+  test_expect_except( js.eval<int>("sys.spawn('')") );
+  test_expect_except( js.eval<int>("sys.spawn('cat', 1)") );
+  test_expect_except( js.eval<int>("sys.spawn.prototype.wait.call({})") );
+
+  // Interactive stdin/stdout
+  test_expect( js.eval<bool>("var p = sys.spawn('cat'); p.pid > 0") );
+  test_expect( js.eval<int>("p.write('line1\\n')") == 6 );
+  test_expect( js.eval<string>("p.read('stdout', 2000)") == "line1\n" );
+  test_expect( js.eval<string>("p.read()") == "" );
+  test_expect( js.eval<bool>("p.wait(10) === undefined") );
+  test_expect( js.eval<int>("p.write(Duktape.dec('hex', '41420a'))") == 3 );
+  test_expect( js.eval<bool>("p.closeStdin() === p") );
+  test_expect_except( js.eval<int>("p.write('x')") );
+  test_expect( js.eval<int>("p.wait()") == 0 );
+  test_expect( js.eval<string>("p.read()") == "AB\n" );
+  test_expect( js.eval<bool>("p.read() === undefined") );
+  test_expect( js.eval<bool>("p.kill() === false") );
+
+  // Exit codes, stderr, kill
+  test_expect( js.eval<int>("sys.spawn('sh', ['-c','exit 7']).wait()") == 7 );
+  test_expect( js.eval<string>("var p = sys.spawn('sh', ['-c','echo -n e >&2; echo -n o']); p.wait(); p.read('stderr') + p.read('stdout')") == "eo" );
+  test_expect( js.eval<string>("var p = sys.spawn('sh', ['-c','echo -n e >&2'], {stderr:'stdout'}); p.wait(); p.read()") == "e" );
+  test_expect( js.eval<bool>("var p = sys.spawn('sleep', ['10']); p.kill('SIGKILL')") );
+  test_expect( js.eval<int>("p.wait(5000)") == 128+9 );
+  test_expect_except( js.eval<bool>("sys.spawn('true').kill('SIGNOTHERE')") );
+  test_expect( js.eval<int>("sys.spawn('###notthere').wait()") == 1 );
+
+  // Output larger than the pipe capacity does not block wait().
+  test_expect( js.eval<int>("var p = sys.spawn('head', ['-c','1000000','/dev/zero']); p.wait()") == 0 );
+  test_expect( js.eval<int>("p.read().length") == 1000000 );
+
+  // env, disabled streams
+  test_expect( js.eval<string>("var p = sys.spawn('sh', ['-c','echo -n $TEST_ENVVAR'], {env:{TEST_ENVVAR:123}}); p.wait(); p.read()") == "123" );
+  test_expect( js.eval<bool>("var p = sys.spawn('echo', {stdout:false}); p.wait(); p.read() === undefined") );
+
+  // Finalizer terminates the child.
+  test_expect( js.eval<int>("var pid = sys.spawn('sleep', ['10']).pid; Duktape.gc(); Duktape.gc(); sys.exec('kill', ['-0', ''+pid], {stderr:true}).exitcode") != 0 );
+  #endif
+}
+
+void test_exec_stats(duktape::engine& js)
+{
+  #ifndef WINDOWS
+  test_expect( js.eval<bool>("sys.exec('true', {stats:false}) === 0") );
+  test_expect( js.eval<bool>("sys.exec('true', {stats:true}).stats !== undefined") );
+  test_expect( js.eval<bool>("sys.exec('true', {stdout:true}).stats === undefined") );
+  test_note( "sys.exec('sh', ['-c','i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done'], {stats:true}) = "
+    << js.eval<string>("JSON.stringify(sys.exec('sh', ['-c','i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done'], {stats:true}))")
+  );
+  test_expect( js.eval<bool>("var r = sys.exec('sh', ['-c','i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done'], {stats:true}); r.exitcode === 0") );
+  test_expect( js.eval<bool>("r.stats.utime + r.stats.stime > 0") );
+  test_expect( js.eval<bool>("r.stats.walltime >= r.stats.utime / 2") );
+  test_expect( js.eval<bool>("r.stats.maxrss > 0") );
+  test_expect( js.eval<bool>("r.stats.minflt > 0") );
+  test_expect( js.eval<bool>("typeof(r.stats.majflt) === 'number' && typeof(r.stats.nvcsw) === 'number' && typeof(r.stats.nivcsw) === 'number'") );
+  test_expect( js.eval<bool>("sys.exec('sleep', ['0.2'], {stats:true}).stats.walltime >= 190") );
+  test_expect( js.eval<bool>("sys.exec('cat', {stats:true, stdin:'abc', stdout:true}).stdout === 'abc'") );
+  #endif
+}
+
+void test_exec_stdin_sources(duktape::engine& js)
+{
+  #ifndef WINDOWS
+  // Large buffer, borrowed from the engine.
+  test_expect( js.eval<bool>("var buf = new Uint8Array(64*1024*1024); for(var i=0; i<buf.length; i+=4096) buf[i]=1; true") );
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    test_expect( js.eval<string>("sys.exec('wc', ['-c'], {stdin:buf, stdout:true}).stdout.replace(/\\s/g,'')") == "67108864" );
+    const auto dt = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-t0).count();
+    test_note( "sys.exec('wc', {stdin:<64MB buffer>}): " << dt << "ms" );
+  }
+  test_expect( js.eval<string>("sys.exec('md5sum', {stdin:buf.subarray(0, 4096), stdout:true}).stdout.substr(0,32)") == js.eval<string>("sys.shell('printf \"\\\\001\" | cat - /dev/zero | head -c 4096 | md5sum').substr(0,32)") );
+  test_expect( js.eval<bool>("buf = undefined; true") );
+
+  // Strings with binary data, buffers, invalid values
+  test_expect( js.eval<string>("sys.exec('od', ['-An','-tx1'], {stdin:'a\\u0000b', stdout:true}).stdout.replace(/\\s/g,'')") == "610062" );
+  test_expect( js.eval<string>("sys.exec('cat', {stdin:Duktape.dec('hex','414243'), stdout:true}).stdout") == "ABC" );
+  test_expect_except( js.eval<int>("sys.exec('cat', {stdin:123})") );
+  test_expect_except( js.eval<int>("sys.exec('cat', {stdin:{}})") );
+
+  // File sources: path object and fs.file (the child reads directly from the file).
+  test_expect( js.eval<bool>("fs.writefile('stdin-test.txt', 'line1\\nline2\\n')") );
+  test_expect( js.eval<string>("sys.exec('cat', {stdin:{file:'stdin-test.txt'}, stdout:true}).stdout") == "line1\nline2\n" );
+  test_expect( js.eval<string>("sys.pipeline(['cat', ['wc','-l']], {stdin:{file:'stdin-test.txt'}, stdout:true}).stdout") == "2\n" );
+  test_expect_except( js.eval<int>("sys.exec('cat', {stdin:{file:'stdin-not-existing.txt'}})") );
+  test_expect( js.eval<string>("var f = new fs.file('stdin-test.txt', 'r'); f.readln(); sys.exec('cat', {stdin:f, stdout:true}).stdout") == "line2\n" );
+  test_expect( js.eval<bool>("f.close(); true") );
+  test_expect_except( js.eval<int>("sys.exec('cat', {stdin:f})") );
+  test_expect( js.eval<bool>("fs.unlink('stdin-test.txt')") );
+  #endif
+}
+
+#ifndef WINDOWS
+/**
+ * Returns the number of zombie processes whose parent is `ppid`.
+ */
+int count_zombies(::pid_t ppid)
+{
+  int n = 0;
+  DIR* dir = ::opendir("/proc");
+  if(!dir) return -1;
+  struct ::dirent* e;
+  while((e = ::readdir(dir)) != nullptr) {
+    if((e->d_name[0] < '1') || (e->d_name[0] > '9')) continue;
+    std::ifstream fis(string("/proc/") + e->d_name + "/stat");
+    string stat;
+    if(!std::getline(fis, stat)) continue;
+    const auto p = stat.rfind(')'); // "pid (comm) state ppid ..."
+    if((p == stat.npos) || (p+4 >= stat.size())) continue;
+    if((stat[p+2] == 'Z') && (std::atol(stat.c_str()+p+4) == long(ppid))) ++n;
+  }
+  ::closedir(dir);
+  return n;
+}
+#endif
+
+/**
+ * Concurrent requests from several threads and engines, all exit codes
+ * are passed back correctly and no zombies are left.
+ */
+void test_spawn_server_threads()
+{
+  #ifndef WINDOWS
+  const auto& srv = duktape::detail::system::exec::spawn_server();
+  const auto n_requests = srv.requests;
+  constexpr int num_threads = 4, num_loops = 20;
+  std::atomic<int> errors(0);
+  std::vector<std::thread> threads;
+  for(int t=0; t<num_threads; ++t) {
+    threads.emplace_back([t, &errors]() {
+      duktape::engine js;
+      duktape::mod::system::exec::define_in<>(js);
+      const string code = std::to_string(t+1);
+      for(int i=0; i<num_loops; ++i) {
+        try {
+          if(js.eval<int>("sys.exec('sh', ['-c', 'exit " + code + "'])") != t+1) ++errors;
+          if(js.eval<int>("sys.spawn('sh', ['-c', 'exit " + code + "']).wait()") != t+1) ++errors;
+          if(js.eval<int>("sys.pipeline([['true'], ['sh', '-c', 'cat; exit " + code + "']]).exitcode") != t+1) ++errors;
+          js.eval("sys.spawn('sleep', ['10']).kill('KILL')"); // Not waited for, reaped by the server.
+        } catch(const std::exception&) {
+          ++errors;
+        }
+      }
+    });
+  }
+  for(auto& th:threads) th.join();
+  test_expect( errors == 0 );
+  test_expect( srv.requests == n_requests + 5*num_threads*num_loops );
+  ::usleep(100000);
+  test_expect( count_zombies(::getpid()) == 0 );
+  test_expect( count_zombies(srv.pid) == 0 );
+  #endif
+}
+
+void test_spawn_server(duktape::engine& js)
+{
+  #ifndef WINDOWS
+  using namespace duktape::mod::system::exec;
+  test_expect( !spawn_server_running() );
+  test_expect( start_spawn_server() );
+  test_expect( spawn_server_running() );
+  test_expect( start_spawn_server() );
+  const auto& srv = duktape::detail::system::exec::spawn_server();
+  const auto n_requests = srv.requests;
+  test_expect( js.eval<int>("sys.exec('/bin/true')") == 0 );
+  test_expect( js.eval<int>("sys.exec('/bin/false')") == 1 );
+  test_expect( js.eval<int>("sys.exec('###notthere')") == 1 );
+  test_expect( srv.requests == n_requests + 3 );
+
+  // Children are children of the server, environment and cwd are the current ones of the host.
+  test_expect( js.eval<string>("sys.exec('sh', ['-c','echo -n $PPID'], {stdout:true}).stdout") == std::to_string(srv.pid) );
+  ::setenv("TEST_SPAWN_SERVER_ENV", "late", 1);
+  test_expect( js.eval<string>("sys.exec('sh', ['-c','echo -n $TEST_SPAWN_SERVER_ENV'], {stdout:true}).stdout") == "late" );
+  test_expect( js.eval<string>("sys.exec('sh', ['-c','echo -n $TEST_SPAWN_SERVER_ENV'], {stdout:true, noenv:true}).stdout") == "" );
+  ::unsetenv("TEST_SPAWN_SERVER_ENV");
+  {
+    char cwd[4096];
+    test_expect( ::getcwd(cwd, sizeof(cwd)) != nullptr );
+    test_expect( ::chdir("/tmp") == 0 );
+    test_expect( js.eval<string>("sys.exec('pwd', {stdout:true}).stdout") == "/tmp\n" );
+    test_expect( ::chdir(cwd) == 0 );
+  }
+  {
+    const auto mask = ::umask(022);
+    ::umask(mask);
+    char expected[16];
+    std::snprintf(expected, sizeof(expected), "%04o\n", unsigned(mask));
+    test_expect( js.eval<string>("sys.shell('umask')") == expected );
+  }
+
+  // All exec variants via the server.
+  test_shell(js);
+  test_pipeline(js);
+  test_spawn(js);
+  test_exec_stats(js);
+  test_exec_stdin_sources(js);
+  test_note( "Spawn server requests: " << (srv.requests - n_requests) );
+  test_expect( srv.requests > n_requests + 50 );
+  test_spawn_server_threads();
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    for(int i=0; i<100; ++i) js.eval<int>("sys.spawn('/bin/true').wait()");
+    const auto t1 = std::chrono::steady_clock::now();
+    stop_spawn_server();
+    for(int i=0; i<100; ++i) js.eval<int>("sys.spawn('/bin/true').wait()");
+    const auto t2 = std::chrono::steady_clock::now();
+    test_note( "100x spawn+wait: via server " << std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count()
+      << "ms, forked from host " << std::chrono::duration_cast<std::chrono::milliseconds>(t2-t1).count() << "ms" );
+  }
+  test_expect( !spawn_server_running() );
+  test_expect( js.eval<int>("sys.exec('/bin/false')") == 1 );
+  #endif
+}
+
 void test(duktape::engine& js)
 {
   duktape::mod::system::exec::define_in<>(js);
+  duktape::mod::filesystem::generic::define_in<>(js);
+  duktape::mod::filesystem::basic::define_in<>(js);
+  duktape::mod::filesystem::fileobject::define_in<>(js);
   //test_exec(js);
   test_shell(js);
+  test_pipeline(js);
+  test_spawn(js);
+  test_exec_stats(js);
+  test_exec_stdin_sources(js);
+  test_spawn_server(js);
 }
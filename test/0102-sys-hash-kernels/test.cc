@@ -0,0 +1,238 @@
+#include "../testenv.hh"
+#include <mod/mod.sys.hash.hh>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+  std::vector<uint8_t> test_data(size_t size)
+  {
+    std::mt19937 rng(0x64756b);
+    std::vector<uint8_t> data(size);
+    for(auto& e:data) e = uint8_t(rng());
+    return data;
+  }
+
+  template <typename Fn>
+  double benchmark(const char* name, const std::vector<uint8_t>& data, Fn&& fn)
+  {
+    const unsigned rounds = 8;
+    volatile uint64_t sink = 0; // keeps the results in use
+    const auto t0 = std::chrono::steady_clock::now();
+    for(unsigned i=0; i<rounds; ++i) sink = sink + uint64_t(fn(data.data(), data.size()));
+    const auto t1 = std::chrono::steady_clock::now();
+    const double s = std::chrono::duration<double>(t1-t0).count();
+    const double mbps = double(rounds*data.size()) / (s > 0 ? s : 1e-9) / 1e6;
+    test_note( name << ": " << long(mbps) << "MB/s" );
+    return mbps;
+  }
+
+}
+
+void test_crc_kernels(duktape::engine& js)
+{
+  using crc16k = sw::detail::crc_kernels<uint16_t>;
+  using crc32k = sw::detail::crc_kernels<uint32_t>;
+  using crc32ck = sw::detail::crc32c_kernels;
+  const auto data = test_data(size_t(1)<<20);
+
+  // Check values ("123456789" catalogue checks)
+  test_expect( sw::crc32::calculate("123456789") == 0xcbf43926u );
+  test_expect( sw::crc32c::calculate("123456789") == 0xe3069283u );
+  test_expect( sw::crc16::calculate("123456789") == 0xb4c8u );
+  test_expect( js.eval<unsigned>("sys.hash.crc32c('123456789')") == 0xe3069283u );
+
+  // All kernels must be bit identical to the bytewise reference for all
+  // lengths around the block sizes and unaligned start addresses.
+  test_note( "crc32 pclmul kernel available: " << crc32k::have_pclmul() );
+  test_note( "crc32c sse4.2 kernel available: " << crc32ck::have_sse42() );
+  const bool pclmul = crc32k::have_pclmul(), sse42 = crc32ck::have_sse42();
+  size_t n_mismatch = 0;
+  for(size_t offset=0; offset<8; ++offset) {
+    for(size_t size=0; size<=1100; size += ((size < 300) ? 1 : 13)) {
+      const uint8_t* p = data.data() + offset;
+      const uint32_t r32 = crc32k::bytewise(0xffffffffu, p, size);
+      const uint32_t r32c = crc32ck::bytewise(0xffffffffu, p, size);
+      const uint16_t r16 = crc16k::bytewise(0xffffu, p, size);
+      if(crc32k::slicing8(0xffffffffu, p, size) != r32) ++n_mismatch;
+      if(pclmul && (crc32k::pclmul(0xffffffffu, p, size) != r32)) ++n_mismatch;
+      if(crc32ck::slicing8(0xffffffffu, p, size) != r32c) ++n_mismatch;
+      if(sse42 && (crc32ck::sse42(0xffffffffu, p, size) != r32c)) ++n_mismatch;
+      if(crc16k::slicing8(0xffffu, p, size) != r16) ++n_mismatch;
+    }
+  }
+  test_expect( n_mismatch == 0 );
+
+  // Incremental updates equal one-shot calculation.
+  {
+    uint32_t crc = sw::crc32::initial_value();
+    for(size_t i=0; i<data.size(); i += 1000) {
+      crc = sw::crc32::update(crc, data.data()+i, std::min(size_t(1000), data.size()-i));
+    }
+    test_expect( (crc ^ sw::crc32::final_xor()) == sw::crc32::calculate(data.data(), data.size()) );
+  }
+
+  benchmark("crc32 bytewise", data, [](const void* p, size_t n){ return crc32k::bytewise(0, p, n); });
+  benchmark("crc32 slicing-by-8", data, [](const void* p, size_t n){ return crc32k::slicing8(0, p, n); });
+  if(pclmul) benchmark("crc32 pclmul", data, [](const void* p, size_t n){ return crc32k::pclmul(0, p, n); });
+  benchmark("crc32c slicing-by-8", data, [](const void* p, size_t n){ return crc32ck::slicing8(0, p, n); });
+  if(sse42) benchmark("crc32c sse4.2", data, [](const void* p, size_t n){ return crc32ck::sse42(0, p, n); });
+  benchmark("crc16 slicing-by-8", data, [](const void* p, size_t n){ return crc16k::slicing8(0, p, n); });
+}
+
+void test_xxh3_kernels(duktape::engine& js)
+{
+  using xxh3k = sw::detail::xxh3_kernels;
+  const auto data = test_data(size_t(1)<<20);
+
+  // Reference values (xxhsum -H3 / -H2)
+  test_expect( sw::xxh3::hash64("", 0) == 0x2d06800538d394c2ull );
+  test_expect( sw::xxh3::calculate("abc") == "78af5f94892f3950" );
+  test_expect( sw::xxh3::calculate128("abc", 3) == "06b05ab6733a618578af5f94892f3950" );
+  test_expect( js.eval<std::string>("sys.hash.xxh3('abc')") == "78af5f94892f3950" );
+
+  // Vector kernels bit identical to scalar, streaming identical to one-shot,
+  // for all size classes, block boundaries, seeds and unaligned inputs.
+  test_note( "xxh3 kernels selected: " << xxh3k::best().name );
+  test_expect( (xxh3k::best().accumulate == xxh3k::scalar().accumulate) || xxh3k::have_avx2() );
+  const xxh3k* kernels[] = { &xxh3k::scalar(), &xxh3k::sse2(), &xxh3k::avx2() };
+  size_t n_mismatch = 0;
+  for(uint64_t seed: { uint64_t(0), uint64_t(0x9e3779b97f4a7c15ull) }) {
+    for(size_t size=0; size<=4200; size += ((size < 300) ? 1 : 31)) {
+      const uint8_t* p = data.data() + (size & 7);
+      uint64_t lo, hi;
+      const uint64_t r = sw::xxh3::hash64(p, size, seed, xxh3k::scalar());
+      sw::xxh3::hash128(p, size, lo, hi, seed, xxh3k::scalar());
+      for(const auto* k: kernels) {
+        uint64_t klo, khi;
+        sw::xxh3::hash128(p, size, klo, khi, seed, *k);
+        if(sw::xxh3::hash64(p, size, seed, *k) != r || klo != lo || khi != hi) ++n_mismatch;
+      }
+      for(size_t chunk: { size_t(1), size_t(63), size_t(256), size_t(1000) }) {
+        if(chunk == 1 && size > 1100) continue;
+        sw::xxh3 h(seed);
+        for(size_t i=0; i<size; i += chunk) h.update(p+i, std::min(chunk, size-i));
+        uint64_t slo, shi;
+        h.digest128(slo, shi);
+        if(h.digest64() != r || slo != lo || shi != hi) ++n_mismatch;
+      }
+    }
+  }
+  test_expect( n_mismatch == 0 );
+
+  // Throughput compared to the cryptographic hashes.
+  // SSE2 is not auto-selected, it is only noted here if it would be faster.
+  const double scalar_mbps = benchmark("xxh3 scalar", data, [](const void* p, size_t n){ return sw::xxh3::hash64(p, n, 0, xxh3k::scalar()); });
+  const double sse2_mbps = benchmark("xxh3 sse2", data, [](const void* p, size_t n){ return sw::xxh3::hash64(p, n, 0, xxh3k::sse2()); });
+  test_note( "xxh3 sse2 faster than scalar: " << ((sse2_mbps > scalar_mbps) ? "yes" : "no") );
+  benchmark("xxh3 avx2", data, [](const void* p, size_t n){ return sw::xxh3::hash64(p, n, 0, xxh3k::avx2()); });
+  benchmark("xxh3 streaming", data, [](const void* p, size_t n){ sw::xxh3 h; h.update(p, n); return h.digest64(); });
+  benchmark("md5", data, [](const void* p, size_t n){ return sw::md5::calculate(p, n).size(); });
+  benchmark("sha1", data, [](const void* p, size_t n){ return sw::sha1::calculate(p, n).size(); });
+}
+
+void test_sha_kernels(duktape::engine& js)
+{
+  using sha_ni = sw::detail::sha_ni<>;
+  const auto data = test_data(size_t(1)<<20);
+
+  test_expect( sw::sha256::calculate("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" );
+  test_expect( sw::sha1::calculate("abc") == "a9993e364706816aba3e25717850c26c9cd0d89d" );
+  test_expect( js.eval<std::string>("sys.hash.sha256('abc')") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" );
+
+  // SHA-NI block functions bit identical to the scalar transforms, for
+  // arbitrary states, block counts and unaligned data.
+  test_note( "sha-ni kernels available: " << sha_ni::available() );
+  if(sha_ni::available()) {
+    size_t n_mismatch = 0;
+    for(size_t nblocks=1; nblocks<=9; ++nblocks) {
+      for(size_t offset=0; offset<4; ++offset) {
+        const uint8_t* p = data.data() + offset + 977*nblocks;
+        uint32_t s1[5], r1[5], s256[8], r256[8];
+        for(unsigned i=0; i<5; ++i) s1[i] = r1[i] = uint32_t(data[i] * 0x01010101u + nblocks);
+        for(unsigned i=0; i<8; ++i) s256[i] = r256[i] = uint32_t(data[i+5] * 0x01010101u + nblocks);
+        sha_ni::sha1_blocks(s1, p, nblocks);
+        sha_ni::sha256_blocks(s256, p, nblocks, sw::detail::basic_sha256<>::round_constants());
+        for(size_t b=0; b<nblocks; ++b) sw::sha1::transform_scalar(r1, p+64*b);
+        sw::sha256::transform_scalar(r256, p, nblocks);
+        if(memcmp(s1, r1, sizeof(s1)) || memcmp(s256, r256, sizeof(s256))) ++n_mismatch;
+      }
+    }
+    test_expect( n_mismatch == 0 );
+  }
+
+  benchmark("sha1 scalar", data, [](const void* p, size_t n){ uint32_t s[5]={0}; for(size_t i=0; i+64<=n; i+=64) sw::sha1::transform_scalar(s, (const uint8_t*)p+i); return s[0]; });
+  benchmark("sha256 scalar", data, [](const void* p, size_t n){ uint32_t s[8]={0}; sw::sha256::transform_scalar(s, (const uint8_t*)p, n/64); return s[0]; });
+  if(sha_ni::available()) {
+    benchmark("sha1 sha-ni", data, [](const void* p, size_t n){ uint32_t s[5]={0}; sha_ni::sha1_blocks(s, (const uint8_t*)p, n/64); return s[0]; });
+    benchmark("sha256 sha-ni", data, [](const void* p, size_t n){ uint32_t s[8]={0}; sha_ni::sha256_blocks(s, (const uint8_t*)p, n/64, sw::detail::basic_sha256<>::round_constants()); return s[0]; });
+  }
+}
+
+void test_blake3_kernels(duktape::engine& js)
+{
+  using b3k = sw::detail::blake3_kernels;
+  using blake3 = sw::detail::basic_blake3<>;
+  const auto data = test_data(size_t(1)<<22);
+  std::vector<uint8_t> pattern(102400);
+  for(size_t i=0; i<pattern.size(); ++i) pattern[i] = uint8_t(i % 251);
+
+  // Reference values (b3sum, official test vector input pattern)
+  test_expect( sw::blake3::calculate("") == "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" );
+  test_expect( sw::blake3::calculate("abc") == "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85" );
+  test_expect( sw::blake3::calculate(pattern.data(), 1025) == "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" );
+  test_expect( sw::blake3::calculate(pattern.data(), 102400) == "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" );
+  test_expect( js.eval<std::string>("sys.hash.blake3('abc')") == "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85" );
+
+  // Chunk kernels bit identical to the portable compression, for partial
+  // SIMD groups, unaligned data and chunk counters crossing 32 bits.
+  test_note( "blake3 kernels selected: " << b3k::best().name );
+  const b3k* kernels[] = { &b3k::portable(), &b3k::sse41(), &b3k::avx2() };
+  size_t n_mismatch = 0;
+  for(size_t nchunks=1; nchunks<=19; ++nchunks) {
+    for(size_t offset=0; offset<4; ++offset) {
+      const uint64_t counter = 0xfffffffcull + offset;
+      std::vector<uint32_t> ref(8*nchunks), cvs(8*nchunks);
+      b3k::chunks_portable(data.data()+offset, nchunks, b3k::iv, counter, ref.data());
+      for(const auto* k: kernels) {
+        k->chunks(data.data()+offset, nchunks, b3k::iv, counter, cvs.data());
+        if(cvs != ref) ++n_mismatch;
+      }
+    }
+  }
+  test_expect( n_mismatch == 0 );
+
+  // Streaming and multi-threaded hashing identical to one-shot single
+  // threaded hashing, around chunk, SIMD group and thread split sizes.
+  n_mismatch = 0;
+  for(size_t size: { size_t(0), size_t(1), size_t(64), size_t(1024), size_t(1025), size_t(8*1024), size_t(8*1024+1),
+                     size_t(2048*1024-1), size_t(2048*1024), size_t(2048*1024+1), size_t(3333333), data.size() }) {
+    const std::string r = blake3::calculate(data.data(), size, 1);
+    if(blake3::calculate(data.data(), size, 4) != r) ++n_mismatch;
+    if(blake3::calculate(data.data(), size, 3) != r) ++n_mismatch;
+    for(size_t chunk: { size_t(1000), size_t(65536), size_t(1)<<21 }) {
+      blake3 h(2, b3k::sse41());
+      for(size_t i=0; i<size; i += chunk) h.update(data.data()+i, std::min(chunk, size-i));
+      if(h.final() != r) ++n_mismatch;
+    }
+  }
+  test_expect( n_mismatch == 0 );
+
+  benchmark("blake3 portable", data, [](const void* p, size_t n){ blake3 h(1, b3k::portable()); h.update(p, n); return h.final().size(); });
+  benchmark("blake3 sse4.1", data, [](const void* p, size_t n){ blake3 h(1, b3k::sse41()); h.update(p, n); return h.final().size(); });
+  benchmark("blake3 avx2", data, [](const void* p, size_t n){ blake3 h(1, b3k::avx2()); h.update(p, n); return h.final().size(); });
+  benchmark("blake3 4 threads", data, [](const void* p, size_t n){ return blake3::calculate(p, n, 4).size(); });
+  benchmark("sha256", data, [](const void* p, size_t n){ return sw::sha256::calculate(p, n).size(); });
+}
+
+void test(duktape::engine& js)
+{
+  duktape::mod::system::hash::define_in<>(js);
+  test_crc_kernels(js);
+  test_xxh3_kernels(js);
+  test_sha_kernels(js);
+  test_blake3_kernels(js);
+}
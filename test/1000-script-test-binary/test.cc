@@ -7,6 +7,11 @@
 #include <mod/mod.sys.hh>
 #include <mod/mod.sys.exec.hh>
 #include <mod/mod.sys.hash.hh>
+#include <mod/mod.sys.hash.tree.hh>
+#include <mod/mod.sys.encode.hh>
+#include <mod/mod.eventloop.hh>
+#include <mod/mod.promise.hh>
+#include <mod/mod.coroutine.hh>
 #include <exception>
 #include <stdexcept>
 #include <iostream>
@@ -27,10 +32,16 @@ void test(duktape::engine& js)
   duktape::mod::system::define_in(js);
   duktape::mod::system::exec::define_in(js);
   duktape::mod::system::hash::define_in(js);
+  duktape::mod::system::hash::tree::define_in(js);
+  duktape::mod::system::encode::define_in(js);
+  duktape::mod::eventloop::define_in(js);
+  duktape::mod::promise::define_in(js);
+  duktape::mod::coroutine::define_in(js);
   
   // reset some stdio to to testenv
   js.define("print", ecma_print); // may be overwritten by stdio
   js.define("alert", ecma_warn); // may be overwritten by stdio
   js.define("callstack", ecma_callstack);
   test_include_script(js);
+  duktape::mod::eventloop::run_loop(js);
 }
@@ -5,3 +5,10 @@ test_expect(sys.hash.crc8(plain) == 0x48);
 test_expect(sys.hash.crc8("test crc 8") == 0x7e);
 test_expect(sys.hash.crc8(new Uint8Array([0x01,0x02,0x03,0x04,0x05])) == 0xbc);
 
+
+// inputs longer than 255 bytes, and buffer views (subarray) are hashed without copy
+var data = Uint8Array.allocPlain(1000);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+test_expect(sys.hash.crc8(data) == 0x9f);
+test_expect(sys.hash.crc8(new Uint8Array([0x00,0x01,0x02,0x03,0x04]).subarray(1,4)) == 0x48);
+test_expect_except(sys.hash.crc8(1));
@@ -9,3 +9,16 @@ var path = fs.tmpdir() + fs.directoryseparator + "jstestmd5.tmp";
 fs.writefile(path, "1234567890");
 test_expect(sys.hash.md5(path, true) == "e807f1fcf82d132f9bb018ca6738a19f");
 fs.unlink(path);
+
+// file larger than the file read block size, with non-ASCII bytes and a tail
+var data = Uint8Array.allocPlain((1<<20) + 4099);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+fs.writefile(path, data);
+test_expect(sys.hash.md5(data) == "708de87181fa8ef4c9259afc7824e91e");
+test_expect(sys.hash.md5(path, true) == "708de87181fa8ef4c9259afc7824e91e");
+fs.unlink(path);
+test_expect_except(sys.hash.md5(path, true)); // no such file
+
+// buffer views are hashed in place, only the viewed range
+test_expect(sys.hash.md5(new Uint8Array([0x00,0x01,0x02,0x03,0x04]).subarray(1,4)) == "5289df737df57326fcdd22597afb1fac");
+test_expect(sys.hash.md5("") == "d41d8cd98f00b204e9800998ecf8427e");
@@ -9,3 +9,12 @@ var path = fs.tmpdir() + fs.directoryseparator + "jstestsha1.tmp";
 fs.writefile(path, "1234567890");
 test_expect(sys.hash.sha1(path, true) == "01b307acba4f54f55aafc33bb06bbbf6ca803e9a");
 fs.unlink(path);
+
+// file larger than the file read block size, with non-ASCII bytes and a tail
+var data = Uint8Array.allocPlain((1<<20) + 4099);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+fs.writefile(path, data);
+test_expect(sys.hash.sha1(data) == "98751a7dcb3be8119b8a1f876039325abab82b81");
+test_expect(sys.hash.sha1(path, true) == "98751a7dcb3be8119b8a1f876039325abab82b81");
+fs.unlink(path);
+test_expect_except(sys.hash.sha1(path, true)); // no such file
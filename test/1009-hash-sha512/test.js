@@ -9,3 +9,12 @@ var path = fs.tmpdir() + fs.directoryseparator + "jstestsha512.tmp";
 fs.writefile(path, "1234567890");
 test_expect(sys.hash.sha512(path, true) == "12b03226a6d8be9c6e8cd5e55dc6c7920caaa39df14aab92d5e3ea9340d1c8a4d3d0b8e4314f1f6ef131ba4bf1ceb9186ab87c801af0d5c95b1befb8cedae2b9");
 fs.unlink(path);
+
+// file larger than the file read block size, with non-ASCII bytes and a tail
+var data = Uint8Array.allocPlain((1<<20) + 4099);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+fs.writefile(path, data);
+test_expect(sys.hash.sha512(data) == "5104e5837d83fd314dc4de3b261a271e683147ed07b9ab6c9b7cf791ac924657c3b5302b84a914f80a3adf22ace99e1078d154056488e781de05e3585a645856");
+test_expect(sys.hash.sha512(path, true) == "5104e5837d83fd314dc4de3b261a271e683147ed07b9ab6c9b7cf791ac924657c3b5302b84a914f80a3adf22ace99e1078d154056488e781de05e3585a645856");
+fs.unlink(path);
+test_expect_except(sys.hash.sha512(path, true)); // no such file
@@ -0,0 +1,15 @@
+// note: crc32c kernels are tested in 0102, only the bindings are tested here.
+var plain = Uint8Array.allocPlain(3);
+plain[0] = 0x01; plain[1] = 0x02; plain[2] = 0x03;
+test_note("sys.hash.crc32c([1,2,3])", sprintf("0x%08x", sys.hash.crc32c(plain)));
+test_expect(sys.hash.crc32c("123456789") == 0xE3069283);
+test_expect(sys.hash.crc32c("") == 0);
+test_expect(sys.hash.crc32c(plain) == 0xF130F21E);
+test_expect(sys.hash.crc32c(plain) == sys.hash.crc32c(new Uint8Array([0x00,0x01,0x02,0x03]).subarray(1)));
+test_expect_except(sys.hash.crc32c());
+
+// larger than the vector kernel block sizes, crc32 must be unchanged.
+var data = Uint8Array.allocPlain(4099);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+test_expect(sys.hash.crc32(data) == 0x217E69D4);
+test_expect(sys.hash.crc32c(data) == 0xB49AE695);
@@ -0,0 +1,49 @@
+// incremental hash objects must match the one-shot functions.
+var data = Uint8Array.allocPlain(100000);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+
+var chaining_ok = true;
+function chunked(algo, chunk_size) {
+  var h = sys.hash.create(algo);
+  for(var i=0; i<data.length; i += chunk_size) {
+    if(h.update(data.subarray(i, Math.min(i+chunk_size, data.length))) !== h) chaining_ok = false;
+  }
+  return h.digest();
+}
+
+var algos = ["crc8", "crc16", "crc32", "crc32c", "md5", "sha1", "sha256", "sha512", "blake3"];
+for(var k in algos) {
+  var algo = algos[k];
+  test_note(algo + ": " + sys.hash[algo](data));
+  test_expect(chunked(algo, 1000) === sys.hash[algo](data));
+  test_expect(chunked(algo, 7) === sys.hash[algo](data.subarray(0, 100000)));
+}
+test_expect(chunked("md5", 4096) === "55778fe7139f4f7527c73f2ded2433c0");
+test_expect(chunked("sha1", 333) === "560a96e8e33f4ed6edf2be4548bc63e3c063fb22");
+test_expect(chunked("crc32", 100) === 0xDCBB0F67);
+test_expect(chaining_ok);
+
+// strings, reset after digest(), and reuse
+var h = sys.hash.create("sha1");
+test_expect(h.algorithm === "sha1");
+test_expect(h.update("12345").update("67890").digest() === "01b307acba4f54f55aafc33bb06bbbf6ca803e9a");
+test_expect(h.digest() === sys.hash.sha1(""));
+test_expect(h.update("1234567890").digest() === sys.hash.sha1("1234567890"));
+
+// streamed from a file
+var path = fs.tmpdir() + fs.directoryseparator + "jstesthashcreate.tmp";
+fs.writefile(path, data);
+var f = new fs.file(path, "rb");
+var hf = sys.hash.create("md5");
+var chunk;
+while((chunk = f.read(4096)) !== undefined) hf.update(chunk);
+f.close();
+fs.unlink(path);
+test_expect(hf.digest() === "55778fe7139f4f7527c73f2ded2433c0");
+
+// errors
+test_expect_except(sys.hash.create());
+test_expect_except(sys.hash.create("nonexisting"));
+test_expect_except(sys.hash.create("md5").update());
+test_expect_except(sys.hash.create("md5").update(1));
+test_expect_except(sys.hash.create.prototype.digest.call({}));
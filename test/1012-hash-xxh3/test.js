@@ -0,0 +1,35 @@
+// note: xxh3 c++ code and kernels are tested in 0102, only the bindings are tested here.
+var plain = Uint8Array.allocPlain(3);
+plain[0] = 0x01; plain[1] = 0x02; plain[2] = 0x03;
+test_expect(sys.hash.xxh3("") == "2d06800538d394c2");
+test_expect(sys.hash.xxh3("abc") == "78af5f94892f3950");
+test_expect(sys.hash.xxh3("123456789") == "72dcb18b67a17dff");
+test_expect(sys.hash.xxh3(plain) == "ebce9b7632ae733b");
+test_expect(sys.hash.xxh128("") == "99aa06d3014798d86001c324468d497f");
+test_expect(sys.hash.xxh128("abc") == "06b05ab6733a618578af5f94892f3950");
+test_expect(sys.hash.xxh128(plain) == "ac77eb88cbc4b8d4ebce9b7632ae733b");
+test_expect_except(sys.hash.xxh3());
+test_expect_except(sys.hash.xxh3(1));
+
+// all input size classes (short, mid, long), and buffer views in place
+var data = Uint8Array.allocPlain(1000);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+test_expect(sys.hash.xxh3(data) == "35b90186550dbb50");
+test_expect(sys.hash.xxh128(data) == "e6a06ffc409ddbe635b90186550dbb50");
+test_expect(sys.hash.xxh3(data.subarray(100, 600)) == "f7ea0b52eb0e5164");
+
+// files and streaming
+var path = fs.tmpdir() + fs.directoryseparator + "jstestxxh3.tmp";
+var large = Uint8Array.allocPlain((1<<20) + 4099);
+for(var i=0; i<large.length; ++i) large[i] = (i*37+11) & 0xff;
+fs.writefile(path, large);
+test_expect(sys.hash.xxh3(large) == "4c502b23d4e7b4c5");
+test_expect(sys.hash.xxh3(path, true) == "4c502b23d4e7b4c5");
+test_expect(sys.hash.xxh128(path, true) == "a71568863c66e4024c502b23d4e7b4c5");
+var h = sys.hash.create("xxh3");
+for(var i=0; i<large.length; i += 10007) h.update(large.subarray(i, Math.min(i+10007, large.length)));
+test_expect(h.digest() == "4c502b23d4e7b4c5");
+test_expect(h.update("abc").digest() == "78af5f94892f3950");
+test_expect(sys.hash.create("xxh128").update("a").update("bc").digest() == "06b05ab6733a618578af5f94892f3950");
+fs.unlink(path);
+test_expect_except(sys.hash.xxh3(path, true)); // no such file
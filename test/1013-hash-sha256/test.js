@@ -0,0 +1,28 @@
+// note: sha256 kernels are tested in 0102, only the bindings are tested here.
+var plain = Uint8Array.allocPlain(3);
+plain[0] = 0x01; plain[1] = 0x02; plain[2] = 0x03;
+test_expect(sys.hash.sha256(plain) == "039058c6f2c0cb492c533b0a4d14ef77cc0f78abccced5287d84a1a2011cfb81");
+test_expect(sys.hash.sha256("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+test_expect(sys.hash.sha256("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+test_expect(sys.hash.sha256("1234567890") == "c775e7b757ede630cd0aa1113bd102661ab38829ca52a6422ab782862f268646");
+test_expect(sys.hash.sha256(new Uint8Array([0x00,0x01,0x02,0x03,0x04]).subarray(1,4)) == sys.hash.sha256(plain));
+test_expect_except(sys.hash.sha256());
+
+var path = fs.tmpdir() + fs.directoryseparator + "jstestsha256.tmp";
+fs.writefile(path, "1234567890");
+test_expect(sys.hash.sha256(path, true) == "c775e7b757ede630cd0aa1113bd102661ab38829ca52a6422ab782862f268646");
+fs.unlink(path);
+
+// file larger than the file read block size, with non-ASCII bytes and a tail
+var data = Uint8Array.allocPlain((1<<20) + 4099);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+fs.writefile(path, data);
+test_expect(sys.hash.sha256(data) == "db9de6fa609e5cd8303c5ff6204e6aecbb093aff8bfa943fe226144980805c07");
+test_expect(sys.hash.sha256(path, true) == "db9de6fa609e5cd8303c5ff6204e6aecbb093aff8bfa943fe226144980805c07");
+fs.unlink(path);
+test_expect_except(sys.hash.sha256(path, true)); // no such file
+
+// incremental
+var h = sys.hash.create("sha256");
+for(var i=0; i<data.length; i += 1000) h.update(data.subarray(i, Math.min(i+1000, data.length)));
+test_expect(h.digest() == "db9de6fa609e5cd8303c5ff6204e6aecbb093aff8bfa943fe226144980805c07");
@@ -0,0 +1,58 @@
+// batch hashing must match the single file functions.
+var dir = fs.tmpdir() + fs.directoryseparator + "jstesthashfiles";
+if(fs.isdir(dir)) fs.remove(dir, {recursive:true});
+fs.mkdir(dir);
+var paths = [];
+for(var n=0; n<40; ++n) {
+  var data = Uint8Array.allocPlain(n * 997);
+  for(var i=0; i<data.length; ++i) data[i] = (i*37+n) & 0xff;
+  var path = dir + fs.directoryseparator + "file" + n + ".bin";
+  fs.writefile(path, data);
+  paths.push(path);
+}
+
+var map = sys.hash.files(paths, "sha1", {threads:4});
+var all_match = true;
+for(var n=0; n<paths.length; ++n) {
+  if(map[paths[n]] !== sys.hash.sha1(paths[n], true)) all_match = false;
+}
+test_expect(all_match);
+test_expect(Object.keys(map).length == paths.length);
+
+// ordered array mode, default algorithm sha1, single thread
+var list = sys.hash.files(paths, undefined, {threads:1, array:true});
+var in_order = (list.length == paths.length);
+for(var n=0; n<list.length; ++n) {
+  if(list[n].path !== paths[n] || list[n].digest !== map[paths[n]]) in_order = false;
+}
+test_expect(in_order);
+
+// crc results are numbers like in sys.hash.crc32()
+test_expect(sys.hash.files([paths[3]], "crc32")[paths[3]] === sys.hash.crc32(fs.readfile(paths[3], "binary")));
+
+// directory scan
+var scanned = sys.hash.files(dir, "md5");
+test_expect(Object.keys(scanned).length == paths.length);
+test_expect(scanned[paths[7]] === sys.hash.md5(paths[7], true));
+var scanned_bin = sys.hash.files(dir, "md5", {find:{name:"file1*.bin", type:"f"}});
+test_expect(Object.keys(scanned_bin).length == 11);
+
+// per file errors do not abort the batch
+var missing = dir + fs.directoryseparator + "nonexisting.bin";
+var with_error = sys.hash.files([paths[1], missing, paths[2]], "sha256", {array:true});
+test_expect(with_error.length == 3);
+test_expect(with_error[0].digest === sys.hash.sha256(paths[1], true));
+test_expect(with_error[1].digest === undefined);
+test_expect(typeof(with_error[1].error) === "string");
+test_note("error: " + with_error[1].error);
+test_expect(with_error[2].digest === sys.hash.sha256(paths[2], true));
+test_expect(typeof(sys.hash.files([missing])[missing].error) === "string");
+test_expect(Object.keys(sys.hash.files([])).length == 0);
+
+// argument errors
+test_expect_except(sys.hash.files());
+test_expect_except(sys.hash.files(paths, "nonexisting"));
+test_expect_except(sys.hash.files([1,2]));
+test_expect_except(sys.hash.files(paths, "md5", 4));
+
+fs.remove(dir, {recursive:true});
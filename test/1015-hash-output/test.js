@@ -0,0 +1,71 @@
+// sys.encode / sys.decode round trips
+var bytes = Uint8Array.allocPlain(10);
+for(var i=0; i<bytes.length; ++i) bytes[i] = i;
+test_expect(sys.encode.hex(bytes) === "00010203040506070809");
+test_expect(sys.encode.base64(bytes) === "AAECAwQFBgcICQ==");
+test_expect(sys.encode.base64("1234567890") === "MTIzNDU2Nzg5MA==");
+test_expect(sys.encode.hex("") === "");
+test_expect(sys.encode.base64("") === "");
+test_expect(sys.encode.hex(sys.decode.hex("00ff7F80")) === "00ff7f80");
+test_expect(sys.decode.hex("").length === 0);
+test_expect(sys.encode.hex(sys.decode.base64("AAECAwQFBgcICQ==")) === "00010203040506070809");
+test_expect(sys.encode.hex(sys.decode.base64("AAECAwQFBgcICQ")) === "00010203040506070809");
+test_expect(sys.encode.base64(sys.decode.base64("MTIzNDU2Nzg5MA==")) === "MTIzNDU2Nzg5MA==");
+
+var all = Uint8Array.allocPlain(1000);
+for(var i=0; i<all.length; ++i) all[i] = (i*131+7) & 0xff;
+var hex_all = sys.encode.hex(all);
+var b64_all = sys.encode.base64(all);
+test_expect(hex_all.length === 2000);
+test_expect(sys.encode.hex(sys.decode.hex(hex_all)) === hex_all);
+test_expect(sys.encode.hex(sys.decode.base64(b64_all)) === hex_all);
+
+test_expect_except(sys.decode.hex("abc"));
+test_expect_except(sys.decode.hex("zz"));
+test_expect_except(sys.decode.base64("A"));
+test_expect_except(sys.decode.base64("AA$A"));
+test_expect_except(sys.encode.hex());
+test_expect_except(sys.encode.base64(1));
+
+// digest output formats
+test_expect(sys.hash.sha1("1234567890", {output:"hex"}) === "01b307acba4f54f55aafc33bb06bbbf6ca803e9a");
+test_expect(sys.hash.sha1("1234567890", {output:"base64"}) === "AbMHrLpPVPVar8M7sGu79sqAPpo=");
+test_expect(sys.hash.md5("abc", {output:"base64"}) === "kAFQmDzST7DWlj99KOF/cg==");
+var digest_buffer = sys.hash.sha1("1234567890", {output:"buffer"});
+test_expect(digest_buffer.length === 20);
+test_expect(sys.encode.hex(digest_buffer) === "01b307acba4f54f55aafc33bb06bbbf6ca803e9a");
+test_expect(sys.hash.sha256("abc", {output:"buffer"}).length === 32);
+test_expect(sys.hash.sha512("abc", {output:"buffer"}).length === 64);
+test_expect(sys.hash.xxh128("abc", {output:"hex"}) === sys.hash.xxh128("abc"));
+test_expect(sys.encode.hex(sys.hash.xxh3("abc", {output:"buffer"})) === sys.hash.xxh3("abc"));
+
+// crc values stay numbers by default, formatted big endian otherwise
+test_expect(sys.hash.crc32("123456789") === 0xcbf43926);
+test_expect(sys.hash.crc32("123456789", {output:"hex"}) === "cbf43926");
+test_expect(sys.hash.crc32("123456789", {output:"buffer"}).length === 4);
+test_expect(sys.hash.crc16("123456789", {output:"hex"}).length === 4);
+test_expect(sys.hash.crc8("123456789", {output:"hex"}).length === 2);
+
+// files and incremental objects
+var path = fs.tmpdir() + fs.directoryseparator + "jstesthashoutput.tmp";
+fs.writefile(path, all);
+test_expect(sys.encode.hex(sys.hash.sha1(path, {file:true, output:"buffer"})) === sys.hash.sha1(path, true));
+test_expect(sys.hash.md5(path, {file:true, output:"base64"}) === sys.encode.base64(sys.decode.hex(sys.hash.md5(path, true))));
+test_expect(sys.hash.files([path], "sha256", {output:"base64"})[path] === sys.hash.sha256(path, {file:true, output:"base64"}));
+fs.unlink(path);
+test_expect(sys.encode.hex(sys.hash.create("sha256").update("abc").digest("buffer")) === sys.hash.sha256("abc"));
+test_expect(sys.hash.create("sha1").update("1234567890").digest("base64") === "AbMHrLpPVPVar8M7sGu79sqAPpo=");
+test_expect(sys.hash.create("crc32").update("123456789").digest("hex") === "cbf43926");
+
+// invalid formats
+test_expect_except(sys.hash.sha1("abc", {output:"nonexisting"}));
+test_expect_except(sys.hash.crc32("abc", {output:1}));
+test_expect_except(sys.hash.create("md5").digest("nonexisting"));
+test_expect_except(sys.hash.files([], "md5", {output:"nonexisting"}));
+
+// extra arguments which are not options objects are ignored
+test_expect(["abc","def"].map(sys.hash.md5).join() === sys.hash.md5("abc") + "," + sys.hash.md5("def"));
+test_expect(["123456789"].map(sys.hash.crc32)[0] === 0xcbf43926);
+test_expect(sys.hash.md5("abc", null) === sys.hash.md5("abc"));
+test_expect(sys.hash.sha256("abc", 1) === sys.hash.sha256("abc"));
+test_expect(sys.hash.crc32("123456789", null) === 0xcbf43926);
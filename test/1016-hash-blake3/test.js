@@ -0,0 +1,45 @@
+// BLAKE3 reference values (b3sum, official test vector input pattern)
+test_expect(sys.hash.blake3("") === "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262");
+test_expect(sys.hash.blake3("abc") === "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85");
+var pattern = Uint8Array.allocPlain(102400);
+for(var i=0; i<pattern.length; ++i) pattern[i] = i % 251;
+test_expect(sys.hash.blake3(pattern) === "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085");
+test_expect(sys.hash.blake3(pattern.subarray(0, 1025)) === "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444");
+test_expect(sys.hash.blake3(pattern, {output:"buffer"}).length === 32);
+
+// multi-threaded tree hashing of larger inputs is identical to one thread
+var data = Uint8Array.allocPlain(3*1024*1024+77);
+for(var i=0; i<data.length; ++i) data[i] = (i*37+11) & 0xff;
+var single = sys.hash.blake3(data, {threads:1});
+test_note("blake3 3MB: " + single);
+test_expect(sys.hash.blake3(data) === single);
+test_expect(sys.hash.blake3(data, {threads:4}) === single);
+test_expect(sys.hash.blake3(data, {threads:3, output:"hex"}) === single);
+
+// incremental
+var chaining_ok = true;
+function chunked(chunk_size) {
+  var h = sys.hash.create("blake3");
+  for(var i=0; i<data.length; i += chunk_size) {
+    if(h.update(data.subarray(i, Math.min(i+chunk_size, data.length))) !== h) chaining_ok = false;
+  }
+  return h.digest();
+}
+test_expect(chunked(1000) === single);
+test_expect(chunked(1024*1024) === single);
+test_expect(chaining_ok);
+test_expect(sys.hash.create("blake3").update("a").update("bc").digest() === sys.hash.blake3("abc"));
+
+// files
+var path = fs.tmpdir() + fs.directoryseparator + "jstesthashblake3.tmp";
+fs.writefile(path, data);
+test_expect(sys.hash.blake3(path, true) === single);
+test_expect(sys.hash.blake3(path, {file:true, threads:4}) === single);
+test_expect(sys.hash.files([path], "blake3")[path] === single);
+fs.unlink(path);
+
+// errors
+test_expect_except(sys.hash.blake3());
+test_expect_except(sys.hash.blake3(1));
+test_expect_except(sys.hash.blake3(path, true));
+test_expect_except(sys.hash.blake3("abc", {output:"nonexisting"}));
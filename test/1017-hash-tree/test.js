@@ -0,0 +1,81 @@
+// directory tree digest with re-hash cache
+var sep = fs.directoryseparator;
+var dir = fs.tmpdir() + sep + "jstesthashtree";
+var cache = fs.tmpdir() + sep + "jstesthashtree.cache";
+if(fs.isdir(dir)) fs.remove(dir, {recursive:true});
+if(fs.exists(cache)) fs.unlink(cache);
+fs.mkdir(dir);
+fs.mkdir(dir + sep + "sub");
+fs.mkdir(dir + sep + "sub" + sep + "deep");
+fs.mkdir(dir + sep + "empty");
+fs.mkdir(dir + sep + ".git");
+fs.writefile(dir + sep + "a.txt", "file a");
+fs.writefile(dir + sep + "b.bin", "file b");
+fs.writefile(dir + sep + "sub" + sep + "c.txt", "file c");
+fs.writefile(dir + sep + "sub" + sep + "deep" + sep + "d.txt", "file d");
+fs.writefile(dir + sep + ".git" + sep + "index", "excluded");
+fs.writefile(dir + sep + "run.log", "excluded");
+fs.symlink("a.txt", dir + sep + "link");
+
+// Files modified within the last seconds are not cached (timestamp granularity).
+var past = new Date(Date.now() - 3600*1000);
+var all_files = ["a.txt", "b.bin", "sub/c.txt", "sub/deep/d.txt"];
+for(var i in all_files) fs.utime(dir + sep + all_files[i], past, past);
+
+var options = {algo:"sha256", exclude:["*.log", ".git"], cache:cache, files:true};
+var r1 = sys.hash.tree(dir, options);
+test_note("tree digest: " + r1.digest);
+test_expect(r1.hashed === 4);
+test_expect(r1.cached === 0);
+test_expect(Object.keys(r1.files).length === 4);
+test_expect(r1.files["sub/deep/d.txt"] === sys.hash.sha256("file d"));
+test_expect(r1.files["run.log"] === undefined);
+test_expect(r1.files[".git/index"] === undefined);
+test_expect(fs.isfile(cache));
+
+// Unchanged tree: same digest, nothing read again.
+var r2 = sys.hash.tree(dir, options);
+test_expect(r2.digest === r1.digest);
+test_expect(r2.hashed === 0);
+test_expect(r2.cached === 4);
+test_expect(sys.hash.tree(dir, {algo:"sha256", exclude:["*.log", ".git"]}).digest === r1.digest);
+
+// Excluded files, timestamps and other algorithms in the cache.
+fs.writefile(dir + sep + "other.log", "excluded");
+fs.utime(dir + sep + "a.txt", new Date(Date.now() - 7200*1000));
+var r3 = sys.hash.tree(dir, options);
+test_expect(r3.digest === r1.digest);
+test_expect(r3.hashed === 1);
+test_expect(sys.hash.tree(dir, {algo:"md5", cache:cache, exclude:"*.log"}).cached === 0);
+test_expect(sys.hash.tree(dir, options).hashed === 4); // cache was replaced with md5 digests
+test_expect(sys.hash.tree(dir, {exclude:["*.log", ".git"]}).digest === sys.hash.tree(dir, {algo:"sha1", exclude:["*.log", ".git"]}).digest);
+
+// Content, names and structure changes change the root digest.
+fs.writefile(dir + sep + "sub" + sep + "c.txt", "file C");
+fs.utime(dir + sep + "sub" + sep + "c.txt", new Date(past.getTime() - 60000));
+var r4 = sys.hash.tree(dir, options);
+test_expect(r4.digest !== r1.digest);
+test_expect(r4.hashed === 1);
+test_expect(r4.files["sub/c.txt"] === sys.hash.sha256("file C"));
+fs.rename(dir + sep + "b.bin", dir + sep + "b2.bin");
+test_expect(sys.hash.tree(dir, options).digest !== r4.digest);
+fs.rename(dir + sep + "b2.bin", dir + sep + "b.bin");
+test_expect(sys.hash.tree(dir, options).digest === r4.digest);
+fs.rmdir(dir + sep + "empty");
+test_expect(sys.hash.tree(dir, options).digest !== r4.digest);
+fs.mkdir(dir + sep + "empty");
+test_expect(sys.hash.tree(dir, options).digest === r4.digest);
+
+// output formats
+test_expect(sys.hash.tree(dir, {algo:"sha256", exclude:["*.log", ".git"], output:"buffer"}).digest.length === 32);
+
+// errors
+test_expect_except(sys.hash.tree());
+test_expect_except(sys.hash.tree(dir + sep + "nonexisting"));
+test_expect_except(sys.hash.tree(dir + sep + "a.txt"));
+test_expect_except(sys.hash.tree(dir, {algo:"nonexisting"}));
+test_expect_except(sys.hash.tree(dir, {exclude:1}));
+test_expect_except(sys.hash.tree(dir, 1));
+
+fs.remove(dir, {recursive:true});
+fs.unlink(cache);
@@ -0,0 +1,33 @@
+// Timers run after the main script, in expiry order.
+var order = [];
+var t0 = Date.now();
+setTimeout(function(){ order.push("t30"); }, 30);
+setTimeout(function(){ order.push("t10"); }, 10);
+setTimeout(function(a, b){ order.push("t0:" + a + b); }, 0, "x", "y");
+var immediate_arg = 0;
+setImmediate(function(a){ immediate_arg = a; }, 1);
+var cancelled = setTimeout(function(){ order.push("cancelled"); }, 5);
+clearTimeout(cancelled);
+clearTimeout(123456);
+var cancelled_immediate = setImmediate(function(){ order.push("cancelled immediate"); });
+clearImmediate(cancelled_immediate);
+test_expect(order.length === 0);
+test_expect(typeof(cancelled) === "number");
+test_expect_except(setTimeout("no function", 1));
+
+// Intervals run until cleared.
+var ticks = 0;
+var iv = setInterval(function(step){ ticks += step; if(ticks >= 5) clearInterval(iv); }, 5, 1);
+
+// Timers scheduled from callbacks.
+setTimeout(function(){
+  setTimeout(function(){ order.push("nested"); }, 1);
+}, 40);
+
+setTimeout(function(){
+  test_note("order: " + order.join(","));
+  test_expect(order.join(",") === "t0:xy,t10,t30,nested");
+  test_expect(immediate_arg === 1);
+  test_expect(ticks === 5);
+  test_expect(Date.now() - t0 >= 60);
+}, 60);
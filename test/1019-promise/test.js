@@ -0,0 +1,56 @@
+// Reactions run asynchronously, after the current script, in FIFO order.
+var log = [];
+var p1 = new Promise(function(resolve, reject) { log.push("executor"); resolve(1); });
+p1.then(function(v){ log.push("a" + v); return v + 1; })
+  .then(function(v){ log.push("b" + v); throw new Error("c"); })
+  .then(function(){ log.push("skipped"); })
+  .catch(function(e){ log.push("catch:" + e.message); return "d"; })
+  .finally(function(){ log.push("finally"); return "ignored"; })
+  .then(function(v){ log.push("e:" + v); });
+Promise.resolve(2).then(function(v){ log.push("f" + v); });
+log.push("sync");
+test_expect(log.join(",") === "executor,sync");
+test_expect(p1 instanceof Promise);
+test_expect(p1.constructor === Promise);
+test_expect_except(Promise(function(){}));
+test_expect_except(new Promise(1));
+
+// Rejections, thenables, first resolution wins.
+var results = {};
+new Promise(function(resolve, reject) { reject("r"); resolve("ignored"); }).then(null, function(r){ results.rejected = r; });
+new Promise(function() { throw "thrown"; }).catch(function(r){ results.thrown = r; });
+Promise.resolve({ then: function(res) { res("thenable"); } }).then(function(v){ results.thenable = v; });
+Promise.resolve(Promise.resolve("nested")).then(function(v){ results.nested = v; });
+Promise.reject("rej").finally(function(){ results.finally_called = true; }).catch(function(r){ results.finally_passed = r; });
+var self_p = Promise.resolve().then(function(){ return self_p; });
+self_p.catch(function(e){ results.self = (e instanceof TypeError); });
+
+// Combinators
+Promise.all([1, Promise.resolve(2), new Promise(function(res){ setTimeout(function(){ res(3); }, 5); })]).then(function(v){ results.all = v.join(","); });
+Promise.all([]).then(function(v){ results.all_empty = v.length; });
+Promise.all([Promise.resolve(1), Promise.reject("no")]).catch(function(r){ results.all_rejected = r; });
+Promise.race([new Promise(function(res){ setTimeout(function(){ res("slow"); }, 20); }), new Promise(function(res){ setTimeout(function(){ res("fast"); }, 1); })]).then(function(v){ results.race = v; });
+Promise.allSettled([Promise.resolve(1), Promise.reject(2)]).then(function(v){
+  results.settled = v[0].status + ":" + v[0].value + "," + v[1].status + ":" + v[1].reason;
+});
+
+// Microtasks run before timers.
+setTimeout(function(){ results.timer_after = (log.length === 8); }, 0);
+
+setTimeout(function(){
+  test_note("log: " + log.join(","));
+  test_expect(log.join(",") === "executor,sync,a1,f2,b2,catch:c,finally,e:d");
+  test_expect(results.rejected === "r");
+  test_expect(results.thrown === "thrown");
+  test_expect(results.thenable === "thenable");
+  test_expect(results.nested === "nested");
+  test_expect(results.finally_called === true);
+  test_expect(results.finally_passed === "rej");
+  test_expect(results.self === true);
+  test_expect(results.all === "1,2,3");
+  test_expect(results.all_empty === 0);
+  test_expect(results.all_rejected === "no");
+  test_expect(results.race === "fast");
+  test_expect(results.settled === "fulfilled:1,rejected:2");
+  test_expect(results.timer_after === true);
+}, 40);
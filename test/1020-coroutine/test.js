@@ -0,0 +1,46 @@
+// Sequential code in coroutines, processes run concurrently.
+var order = [];
+var a = coroutine.spawn(function() {
+  order.push("a start");
+  var r = await_exec("sh", ["-c", "sleep 0.05; echo a"]);
+  order.push("a done");
+  return r.stdout + r.exitcode;
+});
+var b = coroutine.spawn(function(arg) {
+  order.push("b start " + arg);
+  var r = await_exec("sh", ["-c", "echo b >&2; exit 2"]);
+  order.push("b done");
+  return r.stderr + r.exitcode;
+}, "x");
+var c = coroutine.spawn(function() {
+  var s = await_exec("cat", { stdin: "from stdin" }).stdout;
+  return s + ":" + coroutine.join(a) + ":" + coroutine.join(b);
+});
+// Output pipes closed before the process exits.
+var d = coroutine.spawn(function() {
+  return await_exec("sh", ["-c", "exec >&- 2>&-; sleep 0.1; exit 3"]).exitcode;
+});
+// Options are parsed like sys.exec(): stdin file, environment.
+var stdin_path = fs.tmpdir() + fs.directoryseparator + "jstestcoroutine.txt";
+fs.writefile(stdin_path, "from file");
+var e = coroutine.spawn(function() {
+  return await_exec("sh", ["-c", "cat; echo :$CO_VAR"], { stdin: {file: stdin_path}, env: {CO_VAR: "x"} }).stdout;
+});
+var f = coroutine.spawn(function() {
+  try { await_exec("true", { env: ["invalid"] }); } catch(ex) { return ex.message; }
+});
+test_expect(order.length === 0);
+test_expect(a.done === false);
+
+setTimeout(function() {
+  test_note("order: " + order.join(","));
+  test_expect(order.join(",") === "a start,b start x,b done,a done");
+  test_expect(a.result === "a\n0");
+  test_expect(b.result === "b\n2");
+  test_expect(c.result === "from stdin:a\n0:b\n2");
+  test_expect(c.done && !c.failed);
+  test_expect(d.result === 3);
+  test_expect(e.result === "from file:x\n");
+  test_expect(f.result === "await_exec(): Environment must be passed as plain object.");
+  fs.remove(stdin_path);
+}, 500);